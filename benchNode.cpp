@@ -0,0 +1,767 @@
+/***********************************************************************
+ * Program:
+ *    Benchmark
+ * Summary:
+ *    Timings for the concurrent lists built on node.h.  This has its own
+ *    main() so it is not part of the unit test project; build it with
+ *    optimizations on, for example:
+ *       g++ -std=c++20 -O2 -pthread benchNode.cpp -o benchNode
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell
+ ************************************************************************/
+
+#include <atomic>       // for std::atomic
+#include <chrono>       // for std::chrono::steady_clock
+#include <cmath>        // for std::sqrt
+#include <cstdio>       // for std::remove
+#include <filesystem>   // for std::filesystem::temp_directory_path
+#include <fstream>      // for std::ofstream
+#include <iomanip>      // for std::setw
+#include <iostream>     // for std::cout
+#include <map>          // for std::map
+#include <sstream>      // for std::ostringstream
+#include <mutex>        // for std::mutex
+#include <thread>       // for std::thread
+#include <utility>      // for std::make_pair
+#include <vector>       // for std::vector
+#include "combining.h"  // for CombiningList
+#include "compressed.h" // for CompressedList
+#include "journal.h"    // for JournaledList
+#include "node.h"       // for Node
+#include "parallel.h"   // for parallelForEach
+#include "parse.h"      // for parse
+#include "queue.h"      // for MPSCQueue
+#include "rcu.h"        // for RCUList
+#include "serialize.h"  // for serialize
+#include "sharded.h"    // for ShardedList
+#include "skiplist.h"   // for SkipList
+#include "writer.h"     // for AsyncWriter
+
+using std::cout;
+using std::setw;
+
+/**********************************************************************
+ * THREAD COUNTS
+ * 1, 2, 4, ... up to the number of cores
+ ***********************************************************************/
+std::vector <unsigned> threadCounts()
+{
+   unsigned numCores = std::thread::hardware_concurrency();
+   std::vector <unsigned> counts;
+   for (unsigned n = 1; n < numCores; n *= 2)
+      counts.push_back(n);
+   counts.push_back(numCores ? numCores : 1);
+   return counts;
+}
+
+/**********************************************************************
+ * RUN FOR
+ * Start numThreads copies of work(), let them go for the given time,
+ * and return the total number of operations they report per second
+ ***********************************************************************/
+template <class Work>
+double runFor(unsigned numThreads, std::chrono::milliseconds duration, Work work)
+{
+   std::atomic <bool> stop(false);
+   std::atomic <unsigned long long> total(0);
+   std::vector <std::thread> threads;
+
+   auto begin = std::chrono::steady_clock::now();
+   for (unsigned i = 0; i < numThreads; i++)
+      threads.emplace_back([&]() { total += work(stop); });
+   std::this_thread::sleep_for(duration);
+   stop = true;
+   for (auto & thread : threads)
+      thread.join();
+   std::chrono::duration <double> seconds = std::chrono::steady_clock::now() - begin;
+
+   return (double)total / seconds.count();
+}
+
+/**********************************************************************
+ * BENCH RCU
+ * Readers walk a 64 node list while one writer replaces a node every
+ * millisecond.  RCU readers should scale with the cores; readers behind
+ * a mutex should not.
+ ***********************************************************************/
+void benchRCU()
+{
+   const int numNodes = 64;
+   const auto duration = std::chrono::milliseconds(500);
+
+   cout << "RCU list: full traversals per second, " << numNodes << " nodes\n";
+   cout << setw(10) << "threads" << setw(16) << "rcu" << setw(16) << "mutex" << "\n";
+
+   for (unsigned numThreads : threadCounts())
+   {
+      // RCU readers
+      RCUDomain domain;
+      RCUList <int> rcuList(domain);
+      for (int i = 0; i < numNodes; i++)
+         rcuList.insert(nullptr, i);
+      std::atomic <bool> stopWriter(false);
+      std::thread writer([&]()
+      {
+         while (!stopWriter)
+         {
+            rcuList.replace(rcuList.head(), 0);
+            domain.reclaim();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+         }
+      });
+      double rcu = runFor(numThreads, duration, [&](std::atomic <bool> & stop)
+      {
+         RCUReader reader(domain);
+         unsigned long long num = 0;
+         long long sum = 0;
+         while (!stop)
+         {
+            for (auto p = rcuList.head(); p; p = rcuNext(p))
+               sum += p->data;
+            reader.quiescent();
+            num++;
+         }
+         return num + (sum == -1);
+      });
+      stopWriter = true;
+      writer.join();
+
+      // the same list behind a mutex
+      std::mutex mutex;
+      Node <int> * pHead = nullptr;
+      for (int i = 0; i < numNodes; i++)
+         pHead = insert(pHead, i);
+      double locked = runFor(numThreads, duration, [&](std::atomic <bool> & stop)
+      {
+         unsigned long long num = 0;
+         long long sum = 0;
+         while (!stop)
+         {
+            std::lock_guard <std::mutex> lock(mutex);
+            for (auto p = pHead; p; p = p->pNext)
+               sum += p->data;
+            num++;
+         }
+         return num + (sum == -1);
+      });
+      clear(pHead);
+
+      cout << setw(10) << numThreads
+           << setw(16) << (unsigned long long)rcu
+           << setw(16) << (unsigned long long)locked << "\n";
+   }
+}
+
+/**********************************************************************
+ * BENCH PARALLEL
+ * CPU heavy work on every node of a long list, on pools of 1..N threads.
+ * Time should drop close to 1/N.
+ ***********************************************************************/
+void benchParallel()
+{
+   const int numNodes = 2000000;
+
+   Node <double> * pHead = nullptr;
+   Node <double> * pTail = nullptr;
+   for (int i = 0; i < numNodes; i++)
+   {
+      pTail = insert(pTail, (double)i, true);
+      if (pHead == nullptr)
+         pHead = pTail;
+   }
+
+   cout << "parallelForEach: milliseconds for " << numNodes << " nodes\n";
+   cout << setw(10) << "threads" << setw(16) << "ms" << setw(16) << "speedup" << "\n";
+
+   double single = 0.0;
+   for (unsigned numThreads : threadCounts())
+   {
+      ThreadPool pool(numThreads);
+      auto begin = std::chrono::steady_clock::now();
+      parallelForEach(pHead, [](double & value)
+      {
+         for (int i = 0; i < 50; i++)
+            value = std::sqrt(value + i);
+      }, pool);
+      std::chrono::duration <double, std::milli> ms = std::chrono::steady_clock::now() - begin;
+      if (numThreads == 1)
+         single = ms.count();
+
+      cout << setw(10) << numThreads
+           << setw(16) << (unsigned long long)ms.count()
+           << setw(16) << single / ms.count() << "\n";
+   }
+
+   clear(pHead);
+}
+
+/**********************************************************************
+ * BENCH SHARDED
+ * Every thread appends as fast as it can.  A sharded list should scale
+ * with the writers; one list behind one mutex should not.
+ ***********************************************************************/
+void benchSharded()
+{
+   const auto duration = std::chrono::milliseconds(500);
+
+   cout << "Appends per second\n";
+   cout << setw(10) << "threads" << setw(16) << "sharded" << setw(16) << "mutex" << "\n";
+
+   for (unsigned numThreads : threadCounts())
+   {
+      // one chain per writer
+      ShardedList <int> shardedList(numThreads);
+      double sharded = runFor(numThreads, duration, [&](std::atomic <bool> & stop)
+      {
+         unsigned long long num = 0;
+         while (!stop)
+            shardedList.pushBack((int)num++);
+         return num;
+      });
+
+      // one tail for everybody
+      std::mutex mutex;
+      Node <int> * pHead = nullptr;
+      Node <int> * pTail = nullptr;
+      double locked = runFor(numThreads, duration, [&](std::atomic <bool> & stop)
+      {
+         unsigned long long num = 0;
+         while (!stop)
+         {
+            Node <int> * pNew = new Node <int>((int)num++);
+            std::lock_guard <std::mutex> lock(mutex);
+            pNew->pPrev = pTail;
+            if (pTail)
+               pTail->pNext = pNew;
+            else
+               pHead = pNew;
+            pTail = pNew;
+         }
+         return num;
+      });
+      clear(pHead);
+
+      cout << setw(10) << numThreads
+           << setw(16) << (unsigned long long)sharded
+           << setw(16) << (unsigned long long)locked << "\n";
+   }
+}
+
+/**********************************************************************
+ * BENCH COMBINING
+ * Every thread appends a node and removes it again, as fast as it can.
+ * Flat combining against one mutex, and against the lock-free MPSC
+ * queue, which only has to push (one consumer frees what arrives).
+ ***********************************************************************/
+void benchCombining()
+{
+   const auto duration = std::chrono::milliseconds(500);
+
+   cout << "Insert and remove pairs per second (queue: pushes)\n";
+   cout << setw(10) << "threads" << setw(16) << "combining"
+        << setw(16) << "mutex" << setw(16) << "mpsc" << "\n";
+
+   for (unsigned numThreads : threadCounts())
+   {
+      // flat combining
+      CombiningList <int> combiningList;
+      double combining = runFor(numThreads, duration, [&](std::atomic <bool> & stop)
+      {
+         unsigned long long num = 0;
+         while (!stop)
+         {
+            combiningList.remove(combiningList.insert(nullptr, (int)num, true));
+            num++;
+         }
+         return num;
+      });
+
+      // one mutex
+      std::mutex mutex;
+      Node <int> * pHead = nullptr;
+      Node <int> * pTail = nullptr;
+      double locked = runFor(numThreads, duration, [&](std::atomic <bool> & stop)
+      {
+         unsigned long long num = 0;
+         while (!stop)
+         {
+            Node <int> * p;
+            {
+               std::lock_guard <std::mutex> lock(mutex);
+               p = pTail = insert(pTail, (int)num, true);
+               if (pHead == nullptr)
+                  pHead = p;
+            }
+            {
+               std::lock_guard <std::mutex> lock(mutex);
+               if (p == pHead)
+                  pHead = p->pNext;
+               if (p == pTail)
+                  pTail = p->pPrev;
+               remove(p);
+            }
+            num++;
+         }
+         return num;
+      });
+
+      // lock-free producers, one consumer
+      MPSCQueue <int> queue;
+      std::atomic <bool> stopConsumer(false);
+      std::thread consumer([&]()
+      {
+         while (!stopConsumer || !queue.empty())
+            if (Node <int> * p = queue.pop())
+               delete p;
+            else
+               std::this_thread::yield();
+      });
+      double mpsc = runFor(numThreads, duration, [&](std::atomic <bool> & stop)
+      {
+         unsigned long long num = 0;
+         while (!stop)
+            queue.push(new Node <int>((int)num++));
+         return num;
+      });
+      stopConsumer = true;
+      consumer.join();
+
+      cout << setw(10) << numThreads
+           << setw(16) << (unsigned long long)combining
+           << setw(16) << (unsigned long long)locked
+           << setw(16) << (unsigned long long)mpsc << "\n";
+   }
+}
+
+/**********************************************************************
+ * BENCH SKIPLIST
+ * A sorted set of up to 10000 values under a mix of 80% lookups, 10%
+ * inserts, and 10% removes.  The skip list against std::map behind one
+ * mutex.
+ ***********************************************************************/
+void benchSkiplist()
+{
+   const int range = 10000;
+   const auto duration = std::chrono::milliseconds(500);
+
+   cout << "Sorted set operations per second, 80% find\n";
+   cout << setw(10) << "threads" << setw(16) << "skiplist" << setw(16) << "map+mutex" << "\n";
+
+   for (unsigned numThreads : threadCounts())
+   {
+      // the skip list
+      RCUDomain domain;
+      SkipList <int> skipList(domain);
+      for (int i = 0; i < range; i += 2)
+         skipList.insert(i);
+      double lockFree = runFor(numThreads, duration, [&](std::atomic <bool> & stop)
+      {
+         RCUReader reader(domain);
+         unsigned seed = (unsigned)(uintptr_t)&reader;
+         unsigned long long num = 0;
+         while (!stop)
+         {
+            seed = seed * 1103515245 + 12345;
+            int value = (seed >> 8) % range;
+            unsigned op = (seed >> 4) % 10;
+            if (op == 0)
+               skipList.insert(value);
+            else if (op == 1)
+               skipList.remove(value);
+            else
+               skipList.contains(value);
+            reader.quiescent();
+            if (++num % 4096 == 0)
+            {
+               reader.offline();
+               domain.reclaim();
+               reader.online();
+            }
+         }
+         return num;
+      });
+
+      // std::map behind a mutex
+      std::mutex mutex;
+      std::map <int, bool> map;
+      for (int i = 0; i < range; i += 2)
+         map[i] = true;
+      double locked = runFor(numThreads, duration, [&](std::atomic <bool> & stop)
+      {
+         unsigned seed = (unsigned)(uintptr_t)&mutex ^ (unsigned)(uintptr_t)&seed;
+         unsigned long long num = 0;
+         bool found = false;
+         while (!stop)
+         {
+            seed = seed * 1103515245 + 12345;
+            int value = (seed >> 8) % range;
+            unsigned op = (seed >> 4) % 10;
+            std::lock_guard <std::mutex> lock(mutex);
+            if (op == 0)
+               map.emplace(value, true);
+            else if (op == 1)
+               map.erase(value);
+            else
+               found ^= map.count(value) != 0;
+            num++;
+         }
+         return num + found * 0;
+      });
+
+      cout << setw(10) << numThreads
+           << setw(16) << (unsigned long long)lockFree
+           << setw(16) << (unsigned long long)locked << "\n";
+   }
+}
+
+/**********************************************************************
+ * BENCH SERIALIZE
+ * A checkpoint of a long list: the binary frame both ways, against the
+ * text that operator << writes.
+ ***********************************************************************/
+void benchSerialize()
+{
+   const int numNodes = 4000000;
+
+   Node <int> * pHead = nullptr;
+   Node <int> * pTail = nullptr;
+   for (int i = 0; i < numNodes; i++)
+   {
+      pTail = insert(pTail, i * 7, true);
+      if (pHead == nullptr)
+         pHead = pTail;
+   }
+
+   auto time = [](auto work)
+   {
+      auto begin = std::chrono::steady_clock::now();
+      work();
+      std::chrono::duration <double, std::milli> ms = std::chrono::steady_clock::now() - begin;
+      return (unsigned long long)ms.count();
+   };
+
+   std::vector <char> buffer;
+   NodePool <int> pool;
+   Node <int> * pCopy = nullptr;
+   std::ostringstream text;
+
+   cout << "serialize: milliseconds for " << numNodes << " nodes\n";
+   cout << setw(16) << "serialize" << setw(16) << time([&]() { serialize((const Node <int> *)pHead, buffer); })
+        << "\n";
+   cout << setw(16) << "deserialize" << setw(16) << time([&]() { pCopy = deserialize(buffer.data(), buffer.size(), pool); })
+        << "\n";
+   cout << setw(16) << "operator <<" << setw(16) << time([&]() { text << (const Node <int> *)pHead; })
+        << "\n";
+
+   pool.clear(pCopy);
+   clear(pHead);
+}
+
+/**********************************************************************
+ * BENCH DISPLAY
+ * operator << on a long list of numbers, against writing each value
+ * through the stream as it used to
+ ***********************************************************************/
+template <class T>
+void benchDisplay(const char * name, T step)
+{
+   const int numNodes = 4000000;
+
+   Node <T> * pHead = nullptr;
+   Node <T> * pTail = nullptr;
+   for (int i = 0; i < numNodes; i++)
+   {
+      pTail = insert(pTail, (T)(i * step), true);
+      if (pHead == nullptr)
+         pHead = pTail;
+   }
+
+   std::ostringstream fast;
+   auto begin = std::chrono::steady_clock::now();
+   fast << (const Node <T> *)pHead;
+   std::chrono::duration <double, std::milli> msFast = std::chrono::steady_clock::now() - begin;
+
+   std::ostringstream slow;
+   begin = std::chrono::steady_clock::now();
+   for (const Node <T> * p = pHead; p; p = p->pNext)
+   {
+      if (p != pHead)
+         slow << ", ";
+      slow << p->data;
+   }
+   std::chrono::duration <double, std::milli> msSlow = std::chrono::steady_clock::now() - begin;
+
+   cout << "operator << : milliseconds for " << numNodes << " " << name
+        << (fast.str() == slow.str() ? "" : " (OUTPUT DIFFERS)") << "\n";
+   cout << setw(16) << "to_chars" << setw(16) << (unsigned long long)msFast.count() << "\n";
+   cout << setw(16) << "stream" << setw(16) << (unsigned long long)msSlow.count() << "\n";
+
+   clear(pHead);
+}
+
+/**********************************************************************
+ * BENCH PARSE
+ * Reading back what operator << wrote: from_chars into a pool, on one
+ * thread and on many, against >> and insert() for every value.
+ ***********************************************************************/
+void benchParse()
+{
+   const int numNodes = 4000000;
+
+   std::string text;
+   {
+      Node <int> * pHead = nullptr;
+      Node <int> * pTail = nullptr;
+      for (int i = 0; i < numNodes; i++)
+      {
+         pTail = insert(pTail, i * 7 - numNodes, true);
+         if (pHead == nullptr)
+            pHead = pTail;
+      }
+      std::ostringstream out;
+      out << (const Node <int> *)pHead;
+      text = out.str();
+      clear(pHead);
+   }
+
+   auto time = [](auto work)
+   {
+      auto begin = std::chrono::steady_clock::now();
+      work();
+      std::chrono::duration <double, std::milli> ms = std::chrono::steady_clock::now() - begin;
+      return (unsigned long long)ms.count();
+   };
+
+   cout << "parse: milliseconds for " << numNodes << " ints (" << text.size() / 1000000 << " MB)\n";
+
+   cout << setw(16) << ">> and insert" << setw(16) << time([&]()
+   {
+      std::istringstream in(text);
+      Node <int> * pHead = nullptr;
+      Node <int> * pTail = nullptr;
+      int value;
+      char comma;
+      while (in >> value)
+      {
+         pTail = insert(pTail, value, true);
+         if (pHead == nullptr)
+            pHead = pTail;
+         in >> comma;
+      }
+      clear(pHead);
+   }) << "\n";
+
+   cout << setw(16) << "stream" << setw(16) << time([&]()
+   {
+      std::istringstream in(text);
+      NodePool <int> pool(4096);
+      Node <int> * pHead = parse(in, pool);
+      pool.clear(pHead);
+   }) << "\n";
+
+   for (unsigned numThreads : threadCounts())
+   {
+      ThreadPool threads(numThreads);
+      cout << setw(10) << numThreads << " thr" << setw(16) << time([&]()
+      {
+         NodePool <int> pool(4096);
+         Node <int> * pHead = parallelParse(text, pool, threads);
+         pool.clear(pHead);
+      }) << "\n";
+   }
+}
+
+/**********************************************************************
+ * BENCH COMPRESSED
+ * Sorted IDs a few apart: the memory a list of nodes takes against the
+ * compressed list, and the time to sum each front to back.
+ ***********************************************************************/
+void benchCompressed()
+{
+   const int numNodes = 4000000;
+
+   Node <int> * pHead = nullptr;
+   Node <int> * pTail = nullptr;
+   for (int i = 0; i < numNodes; i++)
+   {
+      pTail = insert(pTail, 1000000 + i * 5, true);
+      if (pHead == nullptr)
+         pHead = pTail;
+   }
+   CompressedList <int> list(pHead);
+
+   auto time = [](auto work)
+   {
+      auto begin = std::chrono::steady_clock::now();
+      long long sum = work();
+      std::chrono::duration <double, std::milli> ms = std::chrono::steady_clock::now() - begin;
+      return std::make_pair((unsigned long long)ms.count(), sum);
+   };
+   auto nodes = time([&]()
+   {
+      long long sum = 0;
+      for (const Node <int> * p = pHead; p; p = p->pNext)
+         sum += p->data;
+      return sum;
+   });
+   auto compressed = time([&]()
+   {
+      long long sum = 0;
+      for (int value : list)
+         sum += value;
+      return sum;
+   });
+
+   cout << "compressed: " << numNodes << " sorted ints\n";
+   cout << setw(16) << "" << setw(16) << "MB" << setw(16) << "walk ms" << "\n";
+   cout << setw(16) << "Node" << setw(16) << numNodes * sizeof(Node <int>) / 1000000
+        << setw(16) << nodes.first << "\n";
+   cout << setw(16) << "CompressedList" << setw(16) << list.numBytes() / 1000000
+        << setw(16) << compressed.first << (nodes.second == compressed.second ? "" : "  wrong!") << "\n";
+
+   clear(pHead);
+}
+
+#ifndef _WIN32
+/**********************************************************************
+ * BENCH WRITER
+ * A list to a file: serialize() then one write to a stream, against
+ * AsyncWriter through the page cache and around it, and how long the
+ * owner of a SharedList is held up by checkpointAsync().
+ ***********************************************************************/
+void benchWriter()
+{
+   const int numNodes = 16000000;
+   std::string path = (std::filesystem::temp_directory_path() / "benchWriter").string();
+
+   Node <int> * pHead = nullptr;
+   Node <int> * pTail = nullptr;
+   for (int i = 0; i < numNodes; i++)
+   {
+      pTail = insert(pTail, i * 7, true);
+      if (pHead == nullptr)
+         pHead = pTail;
+   }
+
+   auto time = [](auto work)
+   {
+      auto begin = std::chrono::steady_clock::now();
+      work();
+      std::chrono::duration <double, std::milli> ms = std::chrono::steady_clock::now() - begin;
+      return (unsigned long long)ms.count();
+   };
+
+   cout << "writer: milliseconds to write " << numNodes << " ints to a file\n";
+   cout << setw(16) << "ofstream" << setw(16) << time([&]()
+   {
+      std::ofstream out(path, std::ios::binary);
+      serialize((const Node <int> *)pHead, out);
+      out.flush();
+   }) << "\n";
+   for (bool direct : { false, true })
+      cout << setw(16) << (direct ? "async direct" : "async") << setw(16) << time([&]()
+      {
+         AsyncWriter out(path, 1 << 20, direct);
+         writeList((const Node <int> *)pHead, out);
+         out.finish();
+      }) << "\n";
+
+   SharedList <int> list(pHead);
+   std::future <uint64_t> done;
+   cout << setw(16) << "checkpoint" << setw(16) << time([&]() { done = checkpointAsync(list, path); })
+        << "  (the owner's wait)\n";
+   cout << setw(16) << "first change" << setw(16) << time([&]() { list.insert(list.head(), -1); })
+        << "  (copies the list)\n";
+   done.get();
+   std::remove(path.c_str());
+}
+
+/**********************************************************************
+ * BENCH JOURNAL
+ * Logging a list as it is built, then rebuilding it: from the journal
+ * alone, and from a checkpoint, against parsing a text dump of it.
+ ***********************************************************************/
+void benchJournal()
+{
+   const int numNodes = 4000000;
+   std::string path = (std::filesystem::temp_directory_path() / "benchJournal").string();
+
+   auto time = [](auto work)
+   {
+      auto begin = std::chrono::steady_clock::now();
+      work();
+      std::chrono::duration <double, std::milli> ms = std::chrono::steady_clock::now() - begin;
+      return (unsigned long long)ms.count();
+   };
+
+   std::string text;
+   cout << "journal: milliseconds for " << numNodes << " ints\n";
+   cout << setw(16) << "log and commit" << setw(16) << time([&]()
+   {
+      JournaledList <int> list(path);
+      for (int i = 0; i < numNodes; i++)
+         list.insert(nullptr, i * 7 - numNodes, true);
+      list.commit();
+   }) << "\n";
+   cout << setw(16) << "replay journal" << setw(16) << time([&]() { JournaledList <int> list(path); }) << "\n";
+   cout << setw(16) << "compact" << setw(16) << time([&]()
+   {
+      JournaledList <int> list(path);
+      list.compact().get();
+      std::ostringstream out;
+      out << list.head();
+      text = out.str();
+   }) << "\n";
+   cout << setw(16) << "checkpoint" << setw(16) << time([&]() { JournaledList <int> list(path); }) << "\n";
+   cout << setw(16) << "parse text" << setw(16) << time([&]()
+   {
+      NodePool <int> pool(4096);
+      Node <int> * pHead = parse(text, pool);
+      pool.clear(pHead);
+   }) << "\n";
+   cout << setw(16) << ">> and insert" << setw(16) << time([&]()
+   {
+      std::istringstream in(text);
+      Node <int> * pHead = nullptr;
+      Node <int> * pTail = nullptr;
+      int value;
+      char comma;
+      while (in >> value)
+      {
+         pTail = insert(pTail, value, true);
+         if (pHead == nullptr)
+            pHead = pTail;
+         in >> comma;
+      }
+      clear(pHead);
+   }) << "\n";
+
+   std::string prefix = std::filesystem::path(path).filename().string() + ".";
+   for (const auto & entry : std::filesystem::directory_iterator(std::filesystem::path(path).parent_path()))
+      if (entry.path().filename().string().compare(0, prefix.size(), prefix) == 0)
+         std::filesystem::remove(entry.path());
+}
+#endif // _WIN32
+
+/**********************************************************************
+ * MAIN
+ * Run every benchmark
+ ***********************************************************************/
+int main()
+{
+   benchRCU();
+   benchParallel();
+   benchSharded();
+   benchCombining();
+   benchSkiplist();
+   benchSerialize();
+   benchDisplay("ints", 7);
+   benchDisplay("doubles", 0.37);
+   benchParse();
+   benchCompressed();
+#ifndef _WIN32
+   benchWriter();
+   benchJournal();
+#endif // _WIN32
+   return 0;
+}
@@ -0,0 +1,292 @@
+/***********************************************************************
+ * Header:
+ *    COMBINING
+ * Summary:
+ *    Flat combining.  Instead of every thread taking a lock and touching
+ *    the list itself, each thread writes what it wants into its own slot
+ *    of a publication array.  Whichever thread gets the lock becomes the
+ *    combiner and carries out every request it finds in one pass, while
+ *    the list is hot in its cache; the rest just wait for their answer.
+ *    Under heavy contention this moves the list's cache lines far less
+ *    than a plain mutex does.
+ *
+ *    This will contain the class definition of:
+ *        CombiningList : insert, remove, and size through a combiner
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell
+ ************************************************************************/
+
+#pragma once
+
+#include <atomic>      // for std::atomic
+#include <cassert>     // for ASSERT
+#include <exception>   // for std::exception_ptr
+#include <mutex>       // for std::mutex
+#include <thread>      // for std::this_thread::yield
+#include "pool.h"      // for NodePool
+
+/*************************************************
+ * COMBINING LIST
+ * A list any number of threads can change at once.
+ * Nodes come from a NodePool only the combiner
+ * touches, so the inserts of one pass are carved
+ * from the same block instead of each going to the
+ * heap.  A node pointer stays good until some thread
+ * removes that node.
+ *************************************************/
+template <class T>
+class CombiningList
+{
+public:
+   enum { MAX_SLOTS = 128 };
+
+   //
+   // Construct
+   //
+   CombiningList(size_t numPerBlock = 1024) :
+      pool(numPerBlock), pHead(nullptr), pTail(nullptr), num(0), numSlots(0) { }
+   CombiningList(const CombiningList &) = delete;
+   CombiningList & operator = (const CombiningList &) = delete;
+   ~CombiningList() { pool.clear(pHead); }
+
+   //
+   // The node.h operations, from any thread.  A NULL pCurrent means
+   // the front of the list, or the back when after is set.
+   //
+   Node <T> * insert(Node <T> * pCurrent, const T & t, bool after = false);
+   Node <T> * remove(Node <T> * pRemove);
+   size_t size();
+
+   //
+   // Only while no other thread is using the list
+   //
+   Node <T> * head() const { return pHead; }
+
+private:
+   enum Op    { INSERT, REMOVE, SIZE };
+   enum State { IDLE, PENDING, DONE };
+
+   // one request, on a cache line of its own
+   struct alignas(64) Slot
+   {
+      std::atomic <bool> busy { false };    // claimed by a thread
+      std::atomic <int> state { IDLE };
+      Op op = SIZE;
+      Node <T> * pNode = nullptr;           // where, or what to remove
+      const T * pValue = nullptr;
+      bool after = false;
+      Node <T> * pResult = nullptr;
+      size_t numResult = 0;
+      std::exception_ptr error;             // thrown while applying it
+   };
+
+   Slot & publish(Op op, Node <T> * pNode, const T * pValue, bool after);
+   void combine();
+   void apply(Slot & slot);
+
+   // hand the slot back once its answer has been read
+   static void finish(Slot & slot)
+   {
+      slot.state.store(IDLE, std::memory_order_relaxed);
+      slot.busy.store(false, std::memory_order_release);
+   }
+
+   Slot slots[MAX_SLOTS];
+   std::mutex mutexCombiner;
+   NodePool <T> pool;                       // only the combiner touches these
+   Node <T> * pHead;
+   Node <T> * pTail;
+   size_t num;
+   std::atomic <size_t> numSlots;           // slots ever claimed: all the combiner scans
+};
+
+/***********************************************
+ * COMBINING LIST :: PUBLISH
+ * Claim a slot, fill it in, and wait until some
+ * combiner, possibly us, has carried it out
+ *   OUTPUT : the slot, DONE and still ours, unless
+ *            the request threw: then it throws too
+ **********************************************/
+template <class T>
+typename CombiningList <T>::Slot & CombiningList <T> :: publish(Op op, Node <T> * pNode,
+                                                                const T * pValue, bool after)
+{
+   // start where this thread found a slot last time
+   thread_local size_t hint = 0;
+   size_t i = hint % MAX_SLOTS;
+   for (;; i = (i + 1) % MAX_SLOTS)
+   {
+      bool expected = false;
+      if (!slots[i].busy.load(std::memory_order_relaxed) &&
+          slots[i].busy.compare_exchange_strong(expected, true, std::memory_order_acquire))
+         break;
+   }
+   hint = i;
+
+   size_t seen = numSlots.load(std::memory_order_relaxed);
+   while (seen <= i && !numSlots.compare_exchange_weak(seen, i + 1))
+      ;
+
+   Slot & slot = slots[i];
+   slot.op = op;
+   slot.pNode = pNode;
+   slot.pValue = pValue;
+   slot.after = after;
+   slot.state.store(PENDING, std::memory_order_release);
+
+   while (slot.state.load(std::memory_order_acquire) != DONE)
+   {
+      if (mutexCombiner.try_lock())
+      {
+         combine();
+         mutexCombiner.unlock();
+      }
+      else
+         std::this_thread::yield();
+   }
+
+   if (slot.error)
+   {
+      std::exception_ptr error = slot.error;
+      slot.error = nullptr;
+      finish(slot);
+      std::rethrow_exception(error);
+   }
+   return slot;
+}
+
+/***********************************************
+ * COMBINING LIST :: COMBINE
+ * One pass over the publication array, carrying out
+ * every pending request.  Holds the combiner lock.
+ * What one request throws goes back to its thread.
+ *   COST   : O(slots + requests)
+ **********************************************/
+template <class T>
+void CombiningList <T> :: combine()
+{
+   size_t numScan = numSlots.load(std::memory_order_acquire);
+   for (size_t i = 0; i < numScan; i++)
+      if (slots[i].state.load(std::memory_order_acquire) == PENDING)
+      {
+         try
+         {
+            apply(slots[i]);
+         }
+         catch (...)
+         {
+            slots[i].error = std::current_exception();
+         }
+         slots[i].state.store(DONE, std::memory_order_release);
+      }
+}
+
+/***********************************************
+ * COMBINING LIST :: APPLY
+ * Carry out one request, just as node.h would
+ **********************************************/
+template <class T>
+void CombiningList <T> :: apply(Slot & slot)
+{
+   if (slot.op == SIZE)
+   {
+      slot.numResult = num;
+   }
+   else if (slot.op == INSERT)
+   {
+      Node <T> * pNew = pool.acquire(*slot.pValue);
+      Node <T> * pCurrent = slot.pNode;
+      if (pCurrent == nullptr)
+         pCurrent = slot.after ? pTail : pHead;
+
+      if (pCurrent && slot.after)
+      {
+         pNew->pPrev = pCurrent;
+         pNew->pNext = pCurrent->pNext;
+         if (pCurrent->pNext)
+            pCurrent->pNext->pPrev = pNew;
+         pCurrent->pNext = pNew;
+      }
+      else if (pCurrent)
+      {
+         pNew->pNext = pCurrent;
+         pNew->pPrev = pCurrent->pPrev;
+         if (pCurrent->pPrev)
+            pCurrent->pPrev->pNext = pNew;
+         pCurrent->pPrev = pNew;
+      }
+      if (pNew->pPrev == nullptr)
+         pHead = pNew;
+      if (pNew->pNext == nullptr)
+         pTail = pNew;
+      num++;
+      slot.pResult = pNew;
+   }
+   else
+   {
+      Node <T> * pRemove = slot.pNode;
+      if (pRemove == nullptr)
+      {
+         slot.pResult = nullptr;
+         return;
+      }
+      if (pRemove->pPrev)
+         pRemove->pPrev->pNext = pRemove->pNext;
+      else
+         pHead = pRemove->pNext;
+      if (pRemove->pNext)
+         pRemove->pNext->pPrev = pRemove->pPrev;
+      else
+         pTail = pRemove->pPrev;
+      slot.pResult = pRemove->pPrev ? pRemove->pPrev : pRemove->pNext;
+      pool.release(pRemove);
+      num--;
+   }
+}
+
+/***********************************************
+ * COMBINING LIST :: INSERT
+ * Insert a new node with the value t
+ *   INPUT  : pCurrent - where, NULL for an end
+ *            t - the value
+ *            after - whether to go after pCurrent
+ *   OUTPUT : the new node
+ **********************************************/
+template <class T>
+Node <T> * CombiningList <T> :: insert(Node <T> * pCurrent, const T & t, bool after)
+{
+   Slot & slot = publish(INSERT, pCurrent, &t, after);
+   Node <T> * pResult = slot.pResult;
+   finish(slot);
+   return pResult;
+}
+
+/***********************************************
+ * COMBINING LIST :: REMOVE
+ * Remove a node from the list and give it back to
+ * the pool
+ *   INPUT  : the node to be removed
+ *   OUTPUT : the pointer to the parent node, as node.h
+ **********************************************/
+template <class T>
+Node <T> * CombiningList <T> :: remove(Node <T> * pRemove)
+{
+   Slot & slot = publish(REMOVE, pRemove, nullptr, false);
+   Node <T> * pResult = slot.pResult;
+   finish(slot);
+   return pResult;
+}
+
+/***********************************************
+ * COMBINING LIST :: SIZE
+ * The number of nodes, in order with every other
+ * request
+ **********************************************/
+template <class T>
+size_t CombiningList <T> :: size()
+{
+   Slot & slot = publish(SIZE, nullptr, nullptr, false);
+   size_t numResult = slot.numResult;
+   finish(slot);
+   return numResult;
+}
@@ -0,0 +1,491 @@
+/***********************************************************************
+ * Header:
+ *    COMPRESSED
+ * Summary:
+ *    A list of integers in a fraction of the memory.  A Node <int> costs
+ *    24 bytes for every 4-byte value; here values are packed into blocks
+ *    of a few hundred bytes, and the blocks are what is linked with Node.
+ *    A block keeps its first value as it is and every value after that
+ *    as the difference from the one before, zigzag encoded so small
+ *    negative steps stay small, in a varint: seven bits a byte, high bit
+ *    set when more bytes follow.  Sorted IDs that are close together
+ *    cost a byte or two each.
+ *
+ *    Walking the list decodes as it goes.  insert() and remove() decode
+ *    one block, change it, and encode it again; a block that overflows
+ *    is split in two, and one that empties is unlinked.
+ *
+ *    This will contain the class definition of:
+ *        CompressedBlock : The values of one block, packed
+ *        CompressedList  : A list of integers made of blocks
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell
+ ************************************************************************/
+
+#pragma once
+
+#include <cstddef>     // for std::ptrdiff_t
+#include <cstdint>     // for uint32_t
+#include <iterator>    // for std::forward_iterator_tag
+#include <type_traits> // for std::make_unsigned
+#include "node.h"      // for Node
+
+/*************************************************
+ * COMPRESSED BLOCK
+ * One value as it is, then the steps to the rest
+ *************************************************/
+template <class T>
+struct CompressedBlock
+{
+   static constexpr size_t NUM_BYTES = 240;
+   static constexpr size_t MAX_VALUES = NUM_BYTES + 1;    // one byte a step at best
+
+   T first;                          // the first value
+   T last;                           // the last value, so appending need not decode
+   uint32_t num;                     // values, counting first
+   uint32_t numBytes;                // how much of bytes is used
+   unsigned char bytes[NUM_BYTES];   // a varint for each step after first
+};
+
+/*************************************************
+ * COMPRESSED LIST
+ * Integers packed into linked blocks.  pushBack()
+ * works on any list; insert(), remove(), and
+ * contains() expect it sorted smallest first.
+ *************************************************/
+template <class T>
+class CompressedList
+{
+   static_assert(std::is_integral <T>::value && !std::is_same <T, bool>::value && sizeof(T) >= sizeof(int),
+                 "a compressed list holds int, long, or long long, signed or not");
+
+   using U     = std::make_unsigned_t <T>;
+   using S     = std::make_signed_t <T>;
+   using Block = CompressedBlock <T>;
+   static constexpr size_t MAX_VARINT = (sizeof(T) * 8 + 6) / 7;
+
+public:
+   //
+   // Walk it front to back
+   //
+   class iterator
+   {
+   public:
+      using iterator_category = std::forward_iterator_tag;
+      using value_type        = T;
+      using difference_type   = std::ptrdiff_t;
+      using reference         = T;
+
+      iterator() : pBlock(nullptr), index(0), offset(0), value(0) { }
+      explicit iterator(const Node <Block> * pBlock) : pBlock(pBlock), index(0), offset(0),
+                                                       value(pBlock ? pBlock->data.first : 0) { }
+
+      T operator * () const { return value; }
+      iterator & operator ++ ();
+      iterator operator ++ (int) { iterator old(*this); ++*this; return old; }
+      bool operator == (const iterator & rhs) const { return pBlock == rhs.pBlock && index == rhs.index; }
+
+   private:
+      const Node <Block> * pBlock;   // the block we are in, NULL at the end
+      uint32_t index;                // which value of it
+      uint32_t offset;               // where the next step starts
+      T value;                       // the value we are on
+   };
+
+   //
+   // Construct
+   //
+   CompressedList() : pHead(nullptr), pTail(nullptr), num(0), numBlock(0) { }
+   explicit CompressedList(const Node <T> * pSource);
+   CompressedList(const CompressedList &) = delete;
+   CompressedList & operator = (const CompressedList &) = delete;
+   ~CompressedList() { clear(); }
+
+   //
+   // Access
+   //
+   iterator begin() const { return iterator(pHead); }
+   iterator end()   const { return iterator();      }
+   Node <T> * copy() const;
+   bool contains(T t) const;
+
+   //
+   // Change
+   //
+   void pushBack(T t);
+   void insert(T t);
+   bool remove(T t);
+   void clear();
+
+   //
+   // Status
+   //
+   size_t size()      const { return num;       }
+   bool empty()       const { return num == 0;  }
+   size_t numBlocks() const { return numBlock;  }
+   size_t numBytes()  const { return numBlock * sizeof(Node <Block>); }
+
+private:
+   // the step from prev to t, zigzagged so it is small either way
+   static U encodeStep(T prev, T t)
+   {
+      S step = (S)(U)((U)t - (U)prev);
+      return ((U)step << 1) ^ (U)(step >> (sizeof(T) * 8 - 1));
+   }
+   static T decodeStep(T prev, U zigzag)
+   {
+      U step = (zigzag >> 1) ^ (U)(0 - (zigzag & 1));
+      return (T)((U)prev + step);
+   }
+
+   static size_t putVarint(unsigned char * p, U u);
+   static U getVarint(const unsigned char * p, uint32_t & offset);
+
+   static size_t decode(const Block & block, T * values);
+   static size_t encode(Block & block, const T * values, size_t numValues);
+   Node <Block> * findBlock(T t) const;
+   Node <Block> * newBlockAfter(Node <Block> * pBlock);
+
+   Node <Block> * pHead;     // the first block
+   Node <Block> * pTail;     // the last block
+   size_t num;               // values in all the blocks
+   size_t numBlock;          // blocks in the list
+};
+
+/***********************************************
+ * COMPRESSED LIST :: ITERATOR :: INCREMENT
+ * Decode the next step, or move to the next block
+ *   COST   : O(1)
+ **********************************************/
+template <class T>
+typename CompressedList <T> :: iterator & CompressedList <T> :: iterator :: operator ++ ()
+{
+   if (++index < pBlock->data.num)
+   {
+      value = decodeStep(value, getVarint(pBlock->data.bytes, offset));
+   }
+   else
+   {
+      pBlock = pBlock->pNext;
+      index = 0;
+      offset = 0;
+      value = pBlock ? pBlock->data.first : 0;
+   }
+   return *this;
+}
+
+/***********************************************
+ * COMPRESSED LIST :: PUT VARINT
+ * Seven bits a byte, low bits first
+ *   INPUT  : where to put it, and the number
+ *   OUTPUT : how many bytes it took
+ **********************************************/
+template <class T>
+size_t CompressedList <T> :: putVarint(unsigned char * p, U u)
+{
+   size_t num = 0;
+   while (u >= 0x80)
+   {
+      p[num++] = (unsigned char)(u | 0x80);
+      u >>= 7;
+   }
+   p[num++] = (unsigned char)u;
+   return num;
+}
+
+/***********************************************
+ * COMPRESSED LIST :: GET VARINT
+ * The number at offset, moving offset past it
+ *   INPUT  : the bytes, and where it starts
+ *   OUTPUT : the number
+ **********************************************/
+template <class T>
+typename CompressedList <T> :: U CompressedList <T> :: getVarint(const unsigned char * p, uint32_t & offset)
+{
+   U u = 0;
+   for (int shift = 0; ; shift += 7)
+   {
+      unsigned char byte = p[offset++];
+      u |= (U)(byte & 0x7f) << shift;
+      if (!(byte & 0x80))
+         return u;
+   }
+}
+
+/***********************************************
+ * COMPRESSED LIST :: DECODE
+ * Every value of a block
+ *   INPUT  : the block, and room for MAX_VALUES
+ *   OUTPUT : how many there were
+ **********************************************/
+template <class T>
+size_t CompressedList <T> :: decode(const Block & block, T * values)
+{
+   uint32_t offset = 0;
+   values[0] = block.first;
+   for (uint32_t i = 1; i < block.num; i++)
+      values[i] = decodeStep(values[i - 1], getVarint(block.bytes, offset));
+   return block.num;
+}
+
+/***********************************************
+ * COMPRESSED LIST :: ENCODE
+ * Fill a block with as many of the values as fit
+ *   INPUT  : the block, and the values, of which
+ *            there is at least one
+ *   OUTPUT : how many went in
+ **********************************************/
+template <class T>
+size_t CompressedList <T> :: encode(Block & block, const T * values, size_t numValues)
+{
+   unsigned char buffer[MAX_VARINT];
+   block.first = block.last = values[0];
+   block.num = 1;
+   block.numBytes = 0;
+   for (size_t i = 1; i < numValues; i++)
+   {
+      size_t size = putVarint(buffer, encodeStep(values[i - 1], values[i]));
+      if (block.numBytes + size > Block::NUM_BYTES)
+         break;
+      for (size_t j = 0; j < size; j++)
+         block.bytes[block.numBytes + j] = buffer[j];
+      block.numBytes += (uint32_t)size;
+      block.last = values[i];
+      block.num++;
+   }
+   return block.num;
+}
+
+/***********************************************
+ * COMPRESSED LIST :: CONSTRUCTOR
+ * Pack the values of a list
+ *   INPUT  : the list
+ *   COST   : O(n)
+ **********************************************/
+template <class T>
+CompressedList <T> :: CompressedList(const Node <T> * pSource) :
+   pHead(nullptr), pTail(nullptr), num(0), numBlock(0)
+{
+   for (const Node <T> * p = pSource; p; p = p->pNext)
+      pushBack(p->data);
+}
+
+/***********************************************
+ * COMPRESSED LIST :: COPY
+ * The values, unpacked into a list
+ *   OUTPUT : the new list
+ *   COST   : O(n)
+ **********************************************/
+template <class T>
+Node <T> * CompressedList <T> :: copy() const
+{
+   Node <T> * pNewHead = nullptr;
+   Node <T> * pNewTail = nullptr;
+   for (T t : *this)
+   {
+      pNewTail = ::insert(pNewTail, t, true);
+      if (pNewHead == nullptr)
+         pNewHead = pNewTail;
+   }
+   return pNewHead;
+}
+
+/***********************************************
+ * COMPRESSED LIST :: NEW BLOCK AFTER
+ * Link an empty block after pBlock, or at the front
+ * when there is none
+ *   INPUT  : the block to follow
+ *   OUTPUT : the new block
+ **********************************************/
+template <class T>
+Node <CompressedBlock <T>> * CompressedList <T> :: newBlockAfter(Node <Block> * pBlock)
+{
+   Block empty;
+   empty.first = empty.last = 0;
+   empty.num = 0;
+   empty.numBytes = 0;
+
+   Node <Block> * pNew;
+   if (pBlock)
+      pNew = ::insert(pBlock, empty, true);
+   else
+   {
+      pNew = ::insert(pHead, empty, false);
+      pHead = pNew;
+   }
+   if (pBlock == pTail)
+      pTail = pNew;
+   numBlock++;
+   return pNew;
+}
+
+/***********************************************
+ * COMPRESSED LIST :: PUSH BACK
+ * Add t to the end of the last block, or of a new
+ * one if it is full
+ *   INPUT  : t
+ *   COST   : O(1)
+ **********************************************/
+template <class T>
+void CompressedList <T> :: pushBack(T t)
+{
+   if (pTail == nullptr || pTail->data.numBytes + MAX_VARINT > Block::NUM_BYTES)
+   {
+      Node <Block> * pBlock = newBlockAfter(pTail);
+      pBlock->data.first = pBlock->data.last = t;
+      pBlock->data.num = 1;
+      num++;
+      return;
+   }
+
+   Block & block = pTail->data;
+   block.numBytes += (uint32_t)putVarint(block.bytes + block.numBytes, encodeStep(block.last, t));
+   block.last = t;
+   block.num++;
+   num++;
+}
+
+/***********************************************
+ * COMPRESSED LIST :: FIND BLOCK
+ * The block where t belongs in a sorted list: the
+ * last one whose first value is not above t
+ *   INPUT  : t
+ *   OUTPUT : the block, or NULL if t comes before
+ *            every block
+ *   COST   : O(blocks)
+ **********************************************/
+template <class T>
+Node <CompressedBlock <T>> * CompressedList <T> :: findBlock(T t) const
+{
+   Node <Block> * pFound = nullptr;
+   for (Node <Block> * p = pHead; p && !(t < p->data.first); p = p->pNext)
+      pFound = p;
+   return pFound;
+}
+
+/***********************************************
+ * COMPRESSED LIST :: CONTAINS
+ * Is t in the sorted list?
+ *   INPUT  : t
+ *   COST   : O(blocks + block)
+ **********************************************/
+template <class T>
+bool CompressedList <T> :: contains(T t) const
+{
+   const Node <Block> * pBlock = findBlock(t);
+   if (pBlock == nullptr || pBlock->data.last < t)
+      return false;
+
+   T value = pBlock->data.first;
+   for (uint32_t i = 1, offset = 0; value < t && i < pBlock->data.num; i++)
+      value = decodeStep(value, getVarint(pBlock->data.bytes, offset));
+   return value == t;
+}
+
+/***********************************************
+ * COMPRESSED LIST :: INSERT
+ * Put t in its place in the sorted list.  Only its
+ * block is decoded and encoded again; if it no
+ * longer fits, the overflow goes into new blocks
+ * after it.
+ *   INPUT  : t
+ *   COST   : O(blocks + block)
+ **********************************************/
+template <class T>
+void CompressedList <T> :: insert(T t)
+{
+   Node <Block> * pBlock = findBlock(t);
+   if (pBlock == nullptr)
+      pBlock = pHead;
+   if (pBlock == nullptr)
+   {
+      pushBack(t);
+      return;
+   }
+
+   T values[Block::MAX_VALUES + 1];
+   size_t numValues = decode(pBlock->data, values);
+   size_t i = numValues;
+   while (i > 0 && t < values[i - 1])
+   {
+      values[i] = values[i - 1];
+      i--;
+   }
+   values[i] = t;
+   numValues++;
+
+   // a full block splits in half, so the next insert has room
+   size_t done = encode(pBlock->data, values, numValues);
+   if (done < numValues)
+      done = encode(pBlock->data, values, numValues / 2);
+   while (done < numValues)
+   {
+      pBlock = newBlockAfter(pBlock);
+      done += encode(pBlock->data, values + done, numValues - done);
+   }
+   num++;
+}
+
+/***********************************************
+ * COMPRESSED LIST :: REMOVE
+ * Take one t out of the sorted list.  Only its
+ * block is decoded and encoded again; a block left
+ * with nothing in it is unlinked.
+ *   INPUT  : t
+ *   OUTPUT : was it there?
+ *   COST   : O(blocks + block)
+ **********************************************/
+template <class T>
+bool CompressedList <T> :: remove(T t)
+{
+   Node <Block> * pBlock = findBlock(t);
+   if (pBlock == nullptr || pBlock->data.last < t)
+      return false;
+
+   T values[Block::MAX_VALUES];
+   size_t numValues = decode(pBlock->data, values);
+   size_t i = 0;
+   while (i < numValues && values[i] != t)
+      i++;
+   if (i == numValues)
+      return false;
+
+   num--;
+   if (numValues == 1)
+   {
+      if (pBlock == pHead)
+         pHead = pBlock->pNext;
+      if (pBlock == pTail)
+         pTail = pBlock->pPrev;
+      ::remove(pBlock);
+      numBlock--;
+      return true;
+   }
+
+   // the steps on either side become one, which is never longer, but
+   // should the rest not fit they go on in new blocks as insert() does
+   for (; i + 1 < numValues; i++)
+      values[i] = values[i + 1];
+   numValues--;
+   size_t done = encode(pBlock->data, values, numValues);
+   while (done < numValues)
+   {
+      pBlock = newBlockAfter(pBlock);
+      done += encode(pBlock->data, values + done, numValues - done);
+   }
+   return true;
+}
+
+/***********************************************
+ * COMPRESSED LIST :: CLEAR
+ * Free every block
+ *   COST   : O(blocks)
+ **********************************************/
+template <class T>
+void CompressedList <T> :: clear()
+{
+   ::clear(pHead);
+   pTail = nullptr;
+   num = 0;
+   numBlock = 0;
+}
@@ -0,0 +1,284 @@
+/***********************************************************************
+ * Header:
+ *    COW
+ * Summary:
+ *    Copy-on-write lists.  Copying a handle shares the nodes and bumps
+ *    a reference count, so a snapshot nobody changes costs O(1) instead
+ *    of the n allocations of copy().  The first change through a handle
+ *    that shares its nodes gives it its own copy.
+ *
+ *    Because every node points back at its neighbor, two lists cannot
+ *    share a tail; the copy on first write is the whole list, made in
+ *    the same pass as the change so a removed node is never copied and
+ *    an assigned list is never copied at all.
+ *
+ *    This will contain the class definition of:
+ *        SharedList   : A copy-on-write handle to a list of Node
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell
+ ************************************************************************/
+
+#pragma once
+
+#include <atomic>      // for std::atomic
+#include <cassert>     // for ASSERT
+#include "node.h"      // for Node
+
+/*************************************************
+ * SHARED LIST
+ * A handle to a list that may be shared with other
+ * handles.  Node pointers handed out by one handle
+ * are only good for that handle, and only until its
+ * next change.  Handles may be copied and dropped on
+ * different threads; one handle is not thread safe.
+ *************************************************/
+template <class T>
+class SharedList
+{
+public:
+   //
+   // Construct
+   //
+   SharedList() : pShared(nullptr) { }
+   SharedList(Node <T> * pHead) : pShared(pHead ? new Shared(pHead) : nullptr) { }
+   SharedList(const SharedList & rhs) : pShared(rhs.pShared) { acquire(); }
+   SharedList(SharedList && rhs) noexcept : pShared(rhs.pShared) { rhs.pShared = nullptr; }
+   ~SharedList() { release(); }
+
+   SharedList & operator = (const SharedList & rhs)
+   {
+      if (pShared != rhs.pShared)
+      {
+         release();
+         pShared = rhs.pShared;
+         acquire();
+      }
+      return *this;
+   }
+   SharedList & operator = (SharedList && rhs) noexcept
+   {
+      if (this != &rhs)
+      {
+         release();
+         pShared = rhs.pShared;
+         rhs.pShared = nullptr;
+      }
+      return *this;
+   }
+
+   //
+   // Read
+   //
+   const Node <T> * head() const { return pShared ? pShared->pHead : nullptr; }
+   size_t size()           const { return ::size(head()); }
+   bool isShared()         const { return pShared && pShared->refs.load(std::memory_order_acquire) > 1; }
+
+   //
+   // Write: these copy the nodes first if anybody else can see them
+   //
+   const Node <T> * insert(const Node <T> * pCurrent, const T & t, bool after = false);
+   const Node <T> * remove(const Node <T> * pRemove);
+   void assign(const Node <T> * pSource);
+   Node <T> * mutableHead();
+
+private:
+   struct Shared
+   {
+      Shared(Node <T> * pHead) : refs(1), pHead(pHead) { }
+      ~Shared() { clear(pHead); }
+      std::atomic <size_t> refs;
+      Node <T> * pHead;
+   };
+
+   void acquire()
+   {
+      if (pShared)
+         pShared->refs.fetch_add(1, std::memory_order_relaxed);
+   }
+   void release()
+   {
+      if (pShared && pShared->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+         delete pShared;
+      pShared = nullptr;
+   }
+   Node <T> * own(const Node <T> * pFind, const Node <T> * pSkip, Node <T> * & pFound);
+
+   Shared * pShared;
+};
+
+/***********************************************
+ * SHARED LIST :: OWN
+ * Make sure we are the only handle on our nodes.  If
+ * we share them, copy every node but pSkip into a list
+ * of our own and let the others keep the original.
+ *   INPUT  : pFind - a node whose copy we want back
+ *            pSkip - a node not to copy (or NULL)
+ *   OUTPUT : pFound - pFind's counterpart in our list
+ *            returns our head
+ *   COST   : O(1) if we own them, O(n) otherwise
+ **********************************************/
+template <class T>
+Node <T> * SharedList <T> :: own(const Node <T> * pFind, const Node <T> * pSkip, Node <T> * & pFound)
+{
+   pFound = const_cast <Node <T> *> (pFind);
+   if (!isShared())
+   {
+      if (pSkip && pShared)
+      {
+         Node <T> * pReturn = ::remove(pSkip);
+         if (pSkip == pShared->pHead)
+            pShared->pHead = pReturn;
+         pFound = pReturn;
+      }
+      return pShared ? pShared->pHead : nullptr;
+   }
+
+   // the copy is ours until the others are let go, so a throw frees it
+   Node <T> * pHead = nullptr;
+   Node <T> * pTail = nullptr;
+   Shared * pMine;
+   pFound = nullptr;
+   try
+   {
+      for (const Node <T> * p = pShared->pHead; p; p = p->pNext)
+      {
+         if (p == pSkip)
+         {
+            // what remove() would have returned: the previous node, else the next
+            if (pTail == nullptr && p->pNext)
+               pFind = p->pNext;
+            else
+               pFound = pTail;
+            continue;
+         }
+         pTail = ::insert(pTail, p->data, true /* after */);
+         if (pHead == nullptr)
+            pHead = pTail;
+         if (p == pFind)
+            pFound = pTail;
+      }
+      pMine = new Shared(pHead);
+   }
+   catch (...)
+   {
+      clear(pHead);
+      throw;
+   }
+
+   release();
+   pShared = pMine;
+   return pHead;
+}
+
+/***********************************************
+ * SHARED LIST :: INSERT
+ * insert() from node.h, copying first if shared
+ *   INPUT  : pCurrent - a node from this handle's
+ *               head(), or NULL for the front
+ *            t, after - as in insert()
+ *   OUTPUT : the new node
+ *   COST   : O(1) if we own the nodes, O(n) otherwise
+ **********************************************/
+template <class T>
+const Node <T> * SharedList <T> :: insert(const Node <T> * pCurrent, const T & t, bool after)
+{
+   Node <T> * pMine;
+   Node <T> * pHead = own(pCurrent, nullptr, pMine);
+   assert(pCurrent == nullptr || pMine != nullptr);   // pCurrent is not ours
+   if (pCurrent == nullptr)
+   {
+      pMine = pHead;
+      after = false;
+   }
+
+   if (pShared == nullptr)
+   {
+      Node <T> * pNew = new Node <T>(t);
+      try
+      {
+         pShared = new Shared(pNew);
+      }
+      catch (...)
+      {
+         delete pNew;
+         throw;
+      }
+      return pNew;
+   }
+
+   Node <T> * pNew = ::insert(pMine, t, after);
+   if (!after && pMine == pShared->pHead)
+      pShared->pHead = pNew;
+   return pNew;
+}
+
+/***********************************************
+ * SHARED LIST :: REMOVE
+ * remove() from node.h.  When the nodes are shared,
+ * the removed one is simply left out of our copy.
+ *   INPUT  : a node from this handle's head()
+ *   OUTPUT : the node before it, else the one after
+ *   COST   : O(1) if we own the nodes, O(n) otherwise
+ **********************************************/
+template <class T>
+const Node <T> * SharedList <T> :: remove(const Node <T> * pRemove)
+{
+   if (pRemove == nullptr || pShared == nullptr)
+      return nullptr;
+
+   Node <T> * pReturn;
+   own(nullptr, pRemove, pReturn);
+   if (pShared->pHead == nullptr)
+      release();
+   return pReturn;
+}
+
+/***********************************************
+ * SHARED LIST :: ASSIGN
+ * assign() from node.h.  Our own nodes are reused;
+ * shared ones are left alone and never copied.
+ *   INPUT  : the list to copy the values from
+ *   COST   : O(n)
+ **********************************************/
+template <class T>
+void SharedList <T> :: assign(const Node <T> * pSource)
+{
+   if (isShared() || pShared == nullptr)
+   {
+      Node <T> * pHead = copy(pSource);
+      Shared * pMine = nullptr;
+      if (pHead)
+      {
+         try
+         {
+            pMine = new Shared(pHead);
+         }
+         catch (...)
+         {
+            clear(pHead);
+            throw;
+         }
+      }
+      release();
+      pShared = pMine;
+      return;
+   }
+
+   ::assign(pShared->pHead, pSource);
+   if (pShared->pHead == nullptr)
+      release();
+}
+
+/***********************************************
+ * SHARED LIST :: MUTABLE HEAD
+ * The head of a list only we can see, for changing
+ * values in place or handing to node.h functions
+ * that do not change the head
+ *   COST   : O(1) if we own the nodes, O(n) otherwise
+ **********************************************/
+template <class T>
+Node <T> * SharedList <T> :: mutableHead()
+{
+   Node <T> * pUnused;
+   return own(nullptr, nullptr, pUnused);
+}
@@ -0,0 +1,119 @@
+/***********************************************************************
+ * Header:
+ *    CURSOR
+ * Summary:
+ *    copy() must finish in one call.  A copy cursor does the same work
+ *    a slice at a time so a single-threaded event loop can snapshot a
+ *    long list between other jobs.
+ *
+ *    The source may change between slices:
+ *      - nodes already copied can be changed, added around, or removed;
+ *        the copy keeps what they held when they were copied
+ *      - nodes not copied yet are copied as they are when reached, so
+ *        inserts and updates ahead of the cursor show up in the copy
+ *      - before removing the node the cursor is waiting on (next()),
+ *        call skip() with it, or the cursor is left pointing at freed
+ *        memory
+ *
+ *    This will contain the class definition of:
+ *        CopyCursor   : A resumable copy()
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell
+ ************************************************************************/
+
+#pragma once
+
+#include <chrono>      // for std::chrono::steady_clock
+#include "node.h"      // for Node
+
+/*************************************************
+ * COPY CURSOR
+ * Copy a list a few nodes at a time
+ *************************************************/
+template <class T>
+class CopyCursor
+{
+public:
+   //
+   // Construct
+   //
+   CopyCursor(const Node <T> * pSource) :
+      pNext(pSource), pHead(nullptr), pTail(nullptr), numCopied(0) { }
+   CopyCursor(const CopyCursor &) = delete;
+   CopyCursor & operator = (const CopyCursor &) = delete;
+
+   // a copy nobody took is freed
+   ~CopyCursor() { clear(pHead); }
+
+   //
+   // Copy some more
+   //
+   size_t step(size_t maxNodes,
+               std::chrono::microseconds maxTime = std::chrono::microseconds(0));
+
+   //
+   // The source is about to lose pRemove
+   //
+   void skip(const Node <T> * pRemove)
+   {
+      if (pRemove == pNext)
+         pNext = pNext->pNext;
+   }
+
+   //
+   // Take the copy, finished or not.  The cursor is then done.
+   //
+   Node <T> * release()
+   {
+      Node <T> * pCopy = pHead;
+      pHead = pTail = nullptr;
+      pNext = nullptr;
+      return pCopy;
+   }
+
+   //
+   // Status
+   //
+   bool done() const               { return pNext == nullptr; }
+   const Node <T> * next() const   { return pNext;            }
+   size_t size() const             { return numCopied;        }
+
+private:
+   const Node <T> * pNext;    // the next source node to copy
+   Node <T> * pHead;          // the copy so far
+   Node <T> * pTail;
+   size_t numCopied;
+};
+
+/***********************************************
+ * COPY CURSOR :: STEP
+ * Copy up to maxNodes more nodes, stopping early if
+ * maxTime passes.  With a time limit the clock is
+ * read after every node, so one copy is the most it
+ * can run over.
+ *   INPUT  : the budget for this slice; zero time
+ *            means no time limit
+ *   OUTPUT : how many nodes were copied
+ *   COST   : O(maxNodes)
+ **********************************************/
+template <class T>
+size_t CopyCursor <T> :: step(size_t maxNodes, std::chrono::microseconds maxTime)
+{
+   auto deadline = std::chrono::steady_clock::now() + maxTime;
+   size_t num = 0;
+
+   while (num < maxNodes && pNext != nullptr)
+   {
+      pTail = insert(pTail, pNext->data, true /* after */);
+      if (pHead == nullptr)
+         pHead = pTail;
+      pNext = pNext->pNext;
+      num++;
+
+      if (maxTime.count() && std::chrono::steady_clock::now() >= deadline)
+         break;
+   }
+
+   numCopied += num;
+   return num;
+}
@@ -0,0 +1,293 @@
+/***********************************************************************
+ * Header:
+ *    GENERATOR
+ * Summary:
+ *    Lazy sequences over Node lists with C++20 coroutines.  A generator
+ *    produces one element each time it is asked and then waits, so a
+ *    pipeline such as
+ *       for (int v : values(pHead) | filter(isOdd) | map(square) | take(10))
+ *    walks the list once, passing each element through every stage
+ *    before looking at the next node.  Nothing is copied into a
+ *    temporary list; each stage costs one coroutine frame, not one
+ *    allocation per element.
+ *
+ *    This will contain the class definition of:
+ *        Generator    : A lazily produced sequence
+ *    and the functions:
+ *        nodes        : Every node of a list
+ *        values       : Every value of a list, by reference
+ *        filter, map, take, chunk : Stages, joined with |
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell
+ ************************************************************************/
+
+#pragma once
+
+#include <cassert>     // for ASSERT
+#include <coroutine>   // for std::coroutine_handle
+#include <cstddef>     // for std::ptrdiff_t
+#include <exception>   // for std::exception_ptr
+#include <iterator>    // for std::default_sentinel_t
+#include <memory>      // for std::addressof
+#include <type_traits> // for std::remove_cvref_t
+#include <utility>     // for std::exchange
+#include <vector>      // for std::vector
+#include "node.h"      // for Node
+
+/*************************************************
+ * GENERATOR
+ * A sequence of Ref produced by a coroutine that
+ * uses co_yield.  Ref may be a reference, in which
+ * case nothing is copied.  It can be walked once,
+ * front to back, with a range-based for.
+ *************************************************/
+template <class Ref>
+class Generator
+{
+public:
+   using value_type = std::remove_cvref_t <Ref>;
+   using reference  = std::add_lvalue_reference_t <Ref>;
+   using pointer    = std::remove_reference_t <reference> *;
+
+   //
+   // What the compiler needs to build the coroutine
+   //
+   struct promise_type
+   {
+      pointer pValue = nullptr;           // the element last yielded
+      std::exception_ptr error;
+
+      Generator get_return_object()
+      {
+         return Generator(std::coroutine_handle <promise_type>::from_promise(*this));
+      }
+      std::suspend_always initial_suspend() noexcept { return {}; }
+      std::suspend_always final_suspend() noexcept   { return {}; }
+
+      // a yielded temporary lives until we are resumed, so pointing
+      // at it is safe for as long as the caller can see it
+      std::suspend_always yield_value(std::remove_reference_t <reference> &  value) noexcept
+      {
+         pValue = std::addressof(value);
+         return {};
+      }
+      std::suspend_always yield_value(std::remove_reference_t <reference> && value) noexcept
+      {
+         pValue = std::addressof(value);
+         return {};
+      }
+
+      void return_void() { }
+      void unhandled_exception() { error = std::current_exception(); }
+   };
+
+   //
+   // Walk it once
+   //
+   class iterator
+   {
+   public:
+      using iterator_category = std::input_iterator_tag;
+      using difference_type   = std::ptrdiff_t;
+      using value_type        = typename Generator::value_type;
+
+      iterator() : handle(nullptr) { }
+      explicit iterator(std::coroutine_handle <promise_type> handle) : handle(handle) { }
+
+      reference operator * () const { return static_cast <reference> (*handle.promise().pValue); }
+      iterator & operator ++ ()       { resume(handle); return *this; }
+      void operator ++ (int)          { ++*this; }
+      bool operator == (std::default_sentinel_t) const { return !handle || handle.done(); }
+
+   private:
+      std::coroutine_handle <promise_type> handle;
+   };
+
+   iterator begin()
+   {
+      if (handle)
+         resume(handle);
+      return iterator(handle);
+   }
+   std::default_sentinel_t end() const { return std::default_sentinel; }
+
+   //
+   // Construct: move only, since the coroutine can only be run once
+   //
+   Generator(Generator && rhs) noexcept : handle(std::exchange(rhs.handle, nullptr)) { }
+   Generator & operator = (Generator && rhs) noexcept
+   {
+      if (this != &rhs)
+      {
+         if (handle)
+            handle.destroy();
+         handle = std::exchange(rhs.handle, nullptr);
+      }
+      return *this;
+   }
+   Generator(const Generator &) = delete;
+   Generator & operator = (const Generator &) = delete;
+   ~Generator()
+   {
+      if (handle)
+         handle.destroy();
+   }
+
+private:
+   explicit Generator(std::coroutine_handle <promise_type> handle) : handle(handle) { }
+
+   // run to the next co_yield; what the coroutine threw, we throw
+   static void resume(std::coroutine_handle <promise_type> handle)
+   {
+      handle.resume();
+      if (handle.promise().error)
+         std::rethrow_exception(std::exchange(handle.promise().error, nullptr));
+   }
+
+   std::coroutine_handle <promise_type> handle;
+};
+
+/***********************************************
+ * NODES
+ * Every node, front to back.  The next link is read
+ * before a node is handed out, so the caller may
+ * remove or free the node it was given.
+ *   INPUT  : pointer to the head of the linked list
+ *   OUTPUT : each node in turn
+ **********************************************/
+template <class T>
+Generator <Node <T> *> nodes(Node <T> * pHead)
+{
+   for (Node <T> * p = pHead; p; )
+   {
+      Node <T> * pNext = p->pNext;
+      co_yield p;
+      p = pNext;
+   }
+}
+
+template <class T>
+Generator <const Node <T> *> nodes(const Node <T> * pHead)
+{
+   for (const Node <T> * p = pHead; p; p = p->pNext)
+      co_yield p;
+}
+
+/***********************************************
+ * VALUES
+ * Every value, front to back, by reference
+ *   INPUT  : pointer to the head of the linked list
+ *   OUTPUT : each value in turn; changing it changes
+ *            the list
+ **********************************************/
+template <class T>
+Generator <T &> values(Node <T> * pHead)
+{
+   for (Node <T> * p = pHead; p; p = p->pNext)
+      co_yield p->data;
+}
+
+template <class T>
+Generator <const T &> values(const Node <T> * pHead)
+{
+   for (const Node <T> * p = pHead; p; p = p->pNext)
+      co_yield p->data;
+}
+
+/***********************************************
+ * STAGES
+ * What goes on the right of |.  Each holds what its
+ * coroutine will need.
+ **********************************************/
+template <class Pred>
+struct FilterStage { Pred pred; };
+
+template <class F>
+struct MapStage    { F f; };
+
+struct TakeStage   { size_t num; };
+
+struct ChunkStage  { size_t size; };
+
+template <class Pred>
+inline FilterStage <Pred> filter(Pred pred) { return FilterStage <Pred> { std::move(pred) }; }
+
+template <class F>
+inline MapStage <F> map(F f)                { return MapStage <F> { std::move(f) }; }
+
+inline TakeStage take(size_t num)           { return TakeStage { num };  }
+
+inline ChunkStage chunk(size_t size)        { return ChunkStage { size }; }
+
+/***********************************************
+ * FILTER
+ * Only the elements pred accepts
+ **********************************************/
+template <class Ref, class Pred>
+Generator <Ref> operator | (Generator <Ref> source, FilterStage <Pred> stage)
+{
+   for (auto && element : source)
+      if (stage.pred(element))
+         co_yield element;
+}
+
+/***********************************************
+ * MAP
+ * f of each element.  When f returns a reference,
+ * so does the stage; otherwise it yields the value
+ * f returned, which the caller may move from.
+ **********************************************/
+template <class Ref, class F>
+Generator <std::invoke_result_t <F &, typename Generator <Ref>::reference>>
+operator | (Generator <Ref> source, MapStage <F> stage)
+{
+   for (auto && element : source)
+      co_yield stage.f(element);
+}
+
+/***********************************************
+ * TAKE
+ * The first num elements.  The source is not asked
+ * for one more than that.
+ **********************************************/
+template <class Ref>
+Generator <Ref> operator | (Generator <Ref> source, TakeStage stage)
+{
+   if (stage.num == 0)
+      co_return;
+
+   size_t num = 0;
+   for (auto && element : source)
+   {
+      co_yield element;
+      if (++num == stage.num)
+         co_return;
+   }
+}
+
+/***********************************************
+ * CHUNK
+ * Copies of the elements in groups of size; the last
+ * group may be short.  The same vector is reused for
+ * every group, so move out of it what you keep.
+ **********************************************/
+template <class Ref>
+Generator <std::vector <typename Generator <Ref>::value_type> &>
+operator | (Generator <Ref> source, ChunkStage stage)
+{
+   assert(stage.size > 0);
+   std::vector <typename Generator <Ref>::value_type> group;
+   group.reserve(stage.size);
+
+   for (auto && element : source)
+   {
+      group.push_back(element);
+      if (group.size() == stage.size)
+      {
+         co_yield group;
+         group.clear();
+      }
+   }
+   if (!group.empty())
+      co_yield group;
+}
@@ -0,0 +1,222 @@
+/***********************************************************************
+ * Header:
+ *    ITERATOR
+ * Summary:
+ *    Iterators over Node lists, so the standard algorithms, the ranges
+ *    library, and range-based for work on them directly.  Stepping an
+ *    iterator is p = p->pNext, and reaching the end is p == NULL, so a
+ *    loop over a NodeRange compiles to the same loop everybody writes
+ *    by hand.
+ *
+ *    NodeIterator is bidirectional, and pays for it with a second
+ *    pointer: the node it last stepped off, so the end it walks to can
+ *    step back onto the tail.  It is two pointers wide, and a loop that
+ *    never steps back lets the compiler drop the second one.  Where a
+ *    bare node pointer has to stand in for an iterator, as with an end
+ *    of NULL, NodeForwardIterator is one pointer and goes forward only.
+ *
+ *    This will contain the class definition of:
+ *        NodeForwardIterator : A forward iterator over the values
+ *        NodeIterator        : A bidirectional one, from a NodeRange
+ *        NodeSentinel        : The end of every list
+ *        NodeRange           : A view of a list from its head
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell
+ ************************************************************************/
+
+#pragma once
+
+#include <cstddef>     // for std::ptrdiff_t
+#include <iterator>    // for std::forward_iterator_tag
+#include <ranges>      // for std::ranges::view_interface
+#include <type_traits> // for std::conditional_t
+#include "node.h"      // for Node
+
+/*************************************************
+ * NODE SENTINEL
+ * Where every list ends: the NULL after the tail
+ *************************************************/
+struct NodeSentinel { };
+
+/*************************************************
+ * NODE FORWARD ITERATOR
+ * Walks the values of a list front to back.  The
+ * end of every list is NodeForwardIterator(), so a
+ * pair of them can be made from bare node pointers
+ * and handed to any algorithm that only goes forward.
+ * That end does not know which list it ends, so it
+ * cannot be stepped back; NodeIterator can.
+ * NodeForwardIterator <const T> is the read-only kind.
+ *************************************************/
+template <class T>
+class NodeForwardIterator
+{
+public:
+   using NodeType          = std::conditional_t <std::is_const_v <T>,
+                                                 const Node <std::remove_const_t <T>>, Node <T>>;
+   using iterator_category = std::forward_iterator_tag;
+   using value_type        = std::remove_const_t <T>;
+   using difference_type   = std::ptrdiff_t;
+   using pointer           = T *;
+   using reference         = T &;
+
+   //
+   // Construct: the default is past the end of any list
+   //
+   NodeForwardIterator()                      : p(nullptr) { }
+   explicit NodeForwardIterator(NodeType * p) : p(p)       { }
+
+   // any iterator can be used where a read-only one is wanted
+   template <class U, class = std::enable_if_t <std::is_same_v <const U, T> && !std::is_same_v <U, T>>>
+   NodeForwardIterator(const NodeForwardIterator <U> & rhs) : p(rhs.node()) { }
+
+   //
+   // Access
+   //
+   reference operator * () const { return p->data;  }
+   pointer  operator -> () const { return &p->data; }
+   NodeType * node() const       { return p;        }   // for insert() and remove()
+
+   //
+   // Move
+   //
+   NodeForwardIterator & operator ++ ()
+   {
+      p = p->pNext;
+      return *this;
+   }
+   NodeForwardIterator operator ++ (int)
+   {
+      NodeForwardIterator old(*this);
+      ++*this;
+      return old;
+   }
+
+   //
+   // Compare: only where they point matters
+   //
+   bool operator == (const NodeForwardIterator & rhs) const { return p == rhs.p;   }
+   bool operator == (NodeSentinel) const             { return p == nullptr; }
+
+private:
+   NodeType * p;         // where we are, NULL past the end
+};
+
+/*************************************************
+ * NODE ITERATOR
+ * Walks the values of a list in either direction.
+ * It only comes from NodeRange::begin(), so the only
+ * way past the end is to walk there, and it remembers
+ * the node it last stepped off: every end it reaches
+ * can be stepped back onto that list's tail.  That
+ * costs a second pointer, which a loop that never
+ * steps back never reads, and the compiler drops it.
+ * It converts to a NodeForwardIterator.  NodeIterator
+ * <const T> is the read-only kind.
+ *************************************************/
+template <class T>
+class NodeIterator
+{
+   template <class U>
+   friend class NodeRange;
+
+public:
+   using NodeType          = typename NodeForwardIterator <T>::NodeType;
+   using iterator_category = std::bidirectional_iterator_tag;
+   using value_type        = std::remove_const_t <T>;
+   using difference_type   = std::ptrdiff_t;
+   using pointer           = T *;
+   using reference         = T &;
+
+   //
+   // Construct: the default is only good for assigning to
+   //
+   NodeIterator() : p(nullptr), pLast(nullptr) { }
+
+   // any iterator can be used where a read-only one is wanted
+   template <class U, class = std::enable_if_t <std::is_same_v <const U, T> && !std::is_same_v <U, T>>>
+   NodeIterator(const NodeIterator <U> & rhs) : p(rhs.node()), pLast(rhs.last()) { }
+   template <class U, class = std::enable_if_t <std::is_same_v <U, T> || std::is_same_v <U, const T>>>
+   operator NodeForwardIterator <U> () const { return NodeForwardIterator <U>(p); }
+
+   //
+   // Access
+   //
+   reference operator * () const { return p->data;  }
+   pointer  operator -> () const { return &p->data; }
+   NodeType * node() const       { return p;        }   // for insert() and remove()
+   NodeType * last() const       { return pLast;    }
+
+   //
+   // Move
+   //
+   NodeIterator & operator ++ ()
+   {
+      pLast = p;
+      p = p->pNext;
+      return *this;
+   }
+   NodeIterator operator ++ (int)
+   {
+      NodeIterator old(*this);
+      ++*this;
+      return old;
+   }
+   NodeIterator & operator -- ()
+   {
+      p = p ? p->pPrev : pLast;
+      return *this;
+   }
+   NodeIterator operator -- (int)
+   {
+      NodeIterator old(*this);
+      --*this;
+      return old;
+   }
+
+   //
+   // Compare: only where they point matters
+   //
+   bool operator == (const NodeIterator & rhs) const { return p == rhs.p;   }
+   bool operator == (NodeSentinel) const                  { return p == nullptr; }
+
+private:
+   explicit NodeIterator(NodeType * p) : p(p), pLast(nullptr) { }
+
+   NodeType * p;         // where we are, NULL past the end
+   NodeType * pLast;     // where we were before the last ++
+};
+
+/*************************************************
+ * NODE RANGE
+ * A list seen from its head, for range-based for and
+ * the ranges library.  It owns nothing and copies in
+ * O(1).  NodeRange(pHead) picks the read-only kind for
+ * a const list.
+ *************************************************/
+template <class T>
+class NodeRange : public std::ranges::view_interface <NodeRange <T>>
+{
+public:
+   using NodeType = typename NodeIterator <T>::NodeType;
+
+   NodeRange() : pHead(nullptr) { }
+   explicit NodeRange(NodeType * pHead) : pHead(pHead) { }
+
+   NodeIterator <T> begin() const { return NodeIterator <T>(pHead); }
+   NodeSentinel          end()   const { return NodeSentinel();               }
+   NodeType * head()             const { return pHead;                        }
+
+private:
+   NodeType * pHead;
+};
+
+template <class T>
+NodeRange(Node <T> *) -> NodeRange <T>;
+
+template <class T>
+NodeRange(const Node <T> *) -> NodeRange <const T>;
+
+// a NodeRange does not own the nodes, so its iterators outlive it
+template <class T>
+inline constexpr bool std::ranges::enable_borrowed_range <NodeRange <T>> = true;
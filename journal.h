@@ -0,0 +1,1380 @@
+/***********************************************************************
+ * Header:
+ *    JOURNAL
+ * Summary:
+ *    A list that survives a crash.  Every insert() and remove() is
+ *    logged as a small binary record: an op byte, the id of the node it
+ *    is relative to as a varint, and the value.  Records collect in
+ *    memory and a background thread appends them to the journal as one
+ *    group, with one fdatasync(), whenever someone calls commit(), a
+ *    group grows past GROUP_BYTES, or the group window runs out; every
+ *    change logged before a commit() shares that one sync.
+ *
+ *    Nodes are named by ids handed out in order, so replaying the same
+ *    records hands out the same ids.  On open, the list is the last
+ *    checkpoint plus whatever journal came after it:
+ *
+ *       path.checkpoint    the values as a serialize.h frame, then the
+ *                          ids of the nodes as runs of consecutive
+ *                          ids, and the last segment in it
+ *       path.journal.N     segment N: groups of records, each group
+ *                          with its length and a checksum
+ *
+ *    A group cut short by a crash fails its checksum and is dropped, so
+ *    a commit() that returned is never lost and one that did not is all
+ *    or nothing.  A segment is made by the first group written to it,
+ *    and its directory is synced before that group is.  compact()
+ *    starts a new segment and, on another thread, replays the old
+ *    checkpoint and the segments before it into a list of its own,
+ *    writes that as the new checkpoint, and deletes those segments once
+ *    the rename is synced; the live list is never touched.
+ *
+ *    Loading a checkpoint maps it and builds each node in place in one
+ *    array in one pass, with no parsing and no allocation per node.
+ *    Segments are read a piece at a time and replayed in one pass with
+ *    no lookup table: a record naming a node from the checkpoint finds
+ *    it in the runs, and one naming a node from the journal finds it
+ *    from where its id put it.  POSIX only.
+ *
+ *    This will contain the class definition of:
+ *        JournalImage  : A list with an id for every node
+ *        JournaledList : A list whose changes are journaled
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell
+ ************************************************************************/
+
+#pragma once
+
+#ifndef _WIN32
+
+#include <algorithm>          // for std::sort
+#include <bit>                // for std::bit_ceil
+#include <cerrno>             // for errno
+#include <charconv>           // for std::from_chars
+#include <chrono>             // for std::chrono::milliseconds
+#include <condition_variable> // for std::condition_variable
+#include <cstdint>            // for uint64_t
+#include <cstdio>             // for std::rename and std::remove
+#include <cstdlib>            // for std::aligned_alloc
+#include <cstring>            // for memcpy
+#include <filesystem>         // for std::filesystem::directory_iterator
+#include <functional>         // for std::less
+#include <future>             // for std::shared_future
+#include <memory>             // for std::allocator and std::destroy_at
+#include <mutex>              // for std::mutex
+#include <new>                // for placement new
+#include <stdexcept>          // for std::runtime_error
+#include <string>             // for std::string
+#include <system_error>       // for std::system_error
+#include <thread>             // for std::thread
+#include <type_traits>        // for std::is_default_constructible
+#include <vector>             // for std::vector
+#include <fcntl.h>            // for open
+#include <sys/mman.h>         // for mmap
+#include <sys/stat.h>         // for fstat
+#include <unistd.h>           // for write
+#include "node.h"             // for Node
+#include "serialize.h"        // for SerialHeader
+#include "writer.h"           // for AsyncWriter
+
+/*************************************************
+ * JOURNAL CHECKPOINT HEADER
+ * The first 32 bytes of a checkpoint
+ *************************************************/
+struct JournalCheckpointHeader
+{
+   static constexpr uint32_t MAGIC = 0x504b434a;   // "JCKP"
+
+   uint32_t magic;
+   uint32_t size;        // sizeof(T), to catch the wrong T
+   uint64_t segment;     // every segment up to this one is in here
+   uint64_t nextId;      // the id the next insert gets
+   uint64_t reserved;
+};
+static_assert(sizeof(JournalCheckpointHeader) == 32);
+
+/*************************************************
+ * JOURNAL SEGMENT HEADER
+ * The first 8 bytes of a segment
+ *************************************************/
+struct JournalSegmentHeader
+{
+   static constexpr uint32_t MAGIC = 0x4745534a;   // "JSEG"
+
+   uint32_t magic;
+   uint32_t size;        // sizeof(T), to catch the wrong T
+};
+
+/*************************************************
+ * JOURNAL GROUP
+ * In front of every group of records
+ *************************************************/
+struct JournalGroup
+{
+   uint32_t numBytes;    // of records after this
+   uint32_t checksum;    // of those bytes
+};
+
+/***********************************************
+ * JOURNAL CHECKSUM
+ * FNV-1a taken eight bytes at a time, with a
+ * shift to bring the high bits down; enough to
+ * spot a group the crash cut off
+ *   INPUT  : the bytes
+ *   OUTPUT : their checksum
+ **********************************************/
+inline uint32_t journalChecksum(const char * p, size_t num)
+{
+   const uint64_t PRIME = 0x100000001b3ull;
+   uint64_t hash = 0xcbf29ce484222325ull ^ num;
+   size_t i = 0;
+   for (; i + sizeof(uint64_t) <= num; i += sizeof(uint64_t))
+   {
+      hash = (hash ^ loadRaw <uint64_t>(p + i)) * PRIME;
+      hash ^= hash >> 29;
+   }
+   for (; i < num; i++)
+      hash = (hash ^ (unsigned char)p[i]) * PRIME;
+   return (uint32_t)(hash ^ (hash >> 32));
+}
+
+/*************************************************
+ * JOURNAL RUN
+ * Ids in a checkpoint: count nodes in a row, with
+ * the ids first, first + 1, and so on
+ *************************************************/
+struct JournalRun
+{
+   uint64_t first;
+   uint64_t count;
+};
+
+/*************************************************
+ * JOURNAL IMAGE
+ * A list where every node has an id.  The nodes a
+ * checkpoint held sit in one array, built in one
+ * pass, with their ids kept as the runs they came
+ * in; the usual checkpoint is one run, and then the
+ * id of a node is its index.  Nodes inserted since
+ * come from chunks aligned to their own size, so
+ * the id of any node is found from its address with
+ * no lookup table: a chunk filled in id order has
+ * only its first id, and one that is not also has
+ * the id of each node at the front.  Removing a node from the array
+ * destroys its value and unlinks it; the memory comes
+ * back at clear() or the next open.
+ *************************************************/
+template <class T>
+class JournalImage
+{
+   static constexpr size_t CHUNK_BYTES =
+      std::max <size_t> (1 << 20, std::bit_ceil((sizeof(uint64_t) + sizeof(Node <T>)) * 64));
+   static constexpr size_t NUM_SLOTS =
+      (CHUNK_BYTES - 2 * sizeof(uint64_t) - alignof(Node <T>)) / (sizeof(uint64_t) + sizeof(Node <T>));
+
+   // an unused slot is threaded on the free list, a used one holds a node
+   union Slot
+   {
+      Slot * pNextFree;
+      alignas(Node <T>) unsigned char storage[sizeof(Node <T>)];
+   };
+
+   // the ids are only written once a slot is used out of order; until
+   // then slot i holds firstId + i and those pages are never touched
+   struct Chunk
+   {
+      uint64_t firstId;
+      bool hasIds;
+      uint64_t ids[NUM_SLOTS];
+      Slot slots[NUM_SLOTS];
+   };
+   static_assert(sizeof(Chunk) <= CHUNK_BYTES);
+
+   // a run of the checkpoint, and where its nodes start in the array
+   struct BaseRun
+   {
+      uint64_t first;
+      uint64_t count;
+      size_t index;
+   };
+
+public:
+   JournalImage() : pHead(nullptr), pTail(nullptr), num(0), nextId(1), inOrder(false), base(nullptr),
+                    numBase(0), pFree(nullptr), pFresh(nullptr), pFreshEnd(nullptr) { }
+   JournalImage(const JournalImage &) = delete;
+   JournalImage & operator = (const JournalImage &) = delete;
+   ~JournalImage() { clear(); }
+
+   JournalCheckpointHeader load(const char * buffer, size_t size);
+   Node <T> * insert(Node <T> * pCurrent, const T & t, bool after);
+   Node <T> * remove(Node <T> * pRemove);
+   void clear();
+
+   uint64_t idOf(const Node <T> * p) const
+   {
+      if (isBase(p))
+      {
+         size_t index = p - base;
+         return baseIds.empty() ? runs[0].first + index : baseIds[index];
+      }
+      const Chunk * pChunk = chunkOf(p);
+      size_t slot = reinterpret_cast <const Slot *> (p) - pChunk->slots;
+      return pChunk->hasIds ? pChunk->ids[slot] : pChunk->firstId + slot;
+   }
+
+   Node <T> * find(uint64_t id);
+
+   Node <T> * pHead;
+   Node <T> * pTail;
+   size_t num;                               // nodes in the list
+   uint64_t nextId;                          // the id the next insert gets
+   bool inOrder;                             // fresh slots only, so find() works
+
+private:
+   bool isBase(const Node <T> * p) const
+   {
+      std::less <const Node <T> *> less;
+      return numBase && !less(p, base) && less(p, base + numBase);
+   }
+   // a node removed from the array is not the head and has nothing before it
+   bool isLinked(const Node <T> * p) const
+   {
+      return p == pHead || p->pPrev;
+   }
+   static Chunk * chunkOf(const void * p)
+   {
+      return reinterpret_cast <Chunk *> ((uintptr_t)p & ~(uintptr_t)(CHUNK_BYTES - 1));
+   }
+   Node <T> * allocate(const T & t);
+   void release(Node <T> * p);
+   void writeIds(Chunk * pChunk);
+   Node <T> * findBase(uint64_t id);
+
+   Node <T> * base;                          // from the checkpoint
+   size_t numBase;
+   std::vector <BaseRun> runs;               // their ids, by first id
+   std::vector <uint64_t> baseIds;           // the id of each, unless one run
+   std::vector <Chunk *> chunks;             // for inserts since
+   Slot * pFree;                             // the slots freed in them
+   Slot * pFresh;                            // the slots never used in the last
+   Slot * pFreshEnd;
+};
+
+/***********************************************
+ * JOURNAL IMAGE :: ALLOCATE
+ * A node holding t, with the next id beside it.
+ * A freed slot is used first, unless inOrder is
+ * set, then the next fresh one, carving a new
+ * chunk when there is none.
+ *   INPUT  : t
+ *   OUTPUT : the node, not in the list yet
+ *   COST   : O(1) amortized
+ **********************************************/
+template <class T>
+Node <T> * JournalImage <T> :: allocate(const T & t)
+{
+   bool reused = pFree != nullptr && !inOrder;
+   if (reused && pFresh != pFreshEnd)
+      writeIds(chunks.back());     // its fresh slots no longer get the ids in order
+   if (!reused && pFresh == pFreshEnd)
+   {
+      Chunk * pChunk = static_cast <Chunk *> (std::aligned_alloc(CHUNK_BYTES, CHUNK_BYTES));
+      if (pChunk == nullptr)
+         throw std::bad_alloc();
+      try
+      {
+         chunks.push_back(pChunk);
+      }
+      catch (...)
+      {
+         std::free(pChunk);
+         throw;
+      }
+      pChunk->firstId = nextId;
+      pChunk->hasIds = false;
+      pFresh = pChunk->slots;
+      pFreshEnd = pChunk->slots + NUM_SLOTS;
+   }
+
+   // a copy that throws leaves the slot free, but its link overwritten
+   Slot * pSlot = reused ? pFree : pFresh;
+   Slot * pNextFree = reused ? pSlot->pNextFree : nullptr;
+   Node <T> * pNode;
+   try
+   {
+      pNode = new (pSlot->storage) Node <T>(t);
+   }
+   catch (...)
+   {
+      if (reused)
+         pSlot->pNextFree = pNextFree;
+      throw;
+   }
+   if (reused)
+      pFree = pNextFree;
+   else
+      pFresh++;
+
+   Chunk * pChunk = chunkOf(pSlot);
+   if (pChunk->hasIds)
+      pChunk->ids[pSlot - pChunk->slots] = nextId;
+   nextId++;
+   return pNode;
+}
+
+/***********************************************
+ * JOURNAL IMAGE :: RELEASE
+ * Destroy a node from a chunk and free its slot.
+ * No node has id 0, so that marks the slot free.
+ **********************************************/
+template <class T>
+void JournalImage <T> :: release(Node <T> * p)
+{
+   p->~Node();
+   Slot * pSlot = reinterpret_cast <Slot *> (p);
+   Chunk * pChunk = chunkOf(pSlot);
+   writeIds(pChunk);
+   pChunk->ids[pSlot - pChunk->slots] = 0;
+   pSlot->pNextFree = pFree;
+   pFree = pSlot;
+}
+
+/***********************************************
+ * JOURNAL IMAGE :: WRITE IDS
+ * Give a chunk filled in order the id of each node
+ * it has handed out, so its slots can hold others
+ *   INPUT  : the chunk
+ *   COST   : O(slots) the first time, O(1) after
+ **********************************************/
+template <class T>
+void JournalImage <T> :: writeIds(Chunk * pChunk)
+{
+   if (pChunk->hasIds)
+      return;
+   size_t numUsed = pChunk == chunks.back() ? pFresh - pChunk->slots : NUM_SLOTS;
+   for (size_t i = 0; i < numUsed; i++)
+      pChunk->ids[i] = pChunk->firstId + i;
+   pChunk->hasIds = true;
+}
+
+/***********************************************
+ * JOURNAL IMAGE :: LOAD
+ * Fill an empty image from a checkpoint.  Each node
+ * is built in place, links and all, in one pass.
+ *   INPUT  : the whole checkpoint file
+ *   OUTPUT : its header
+ *   COST   : O(n + runs log runs), one allocation
+ **********************************************/
+template <class T>
+JournalCheckpointHeader JournalImage <T> :: load(const char * buffer, size_t size)
+{
+   JournalCheckpointHeader header;
+   if (size < sizeof(header))
+      throw std::runtime_error("journal: checkpoint is cut short");
+   memcpy(&header, buffer, sizeof(header));
+   if (header.magic != JournalCheckpointHeader::MAGIC)
+      throw std::runtime_error("journal: not a checkpoint");
+   if (header.size != sizeof(T))
+      throw std::runtime_error("journal: checkpoint holds some other type");
+
+   // the ids, checked before anything is built
+   const char * pFrame = buffer + sizeof(header);
+   SerialHeader frame = readSerialHeader <T>(pFrame, size - sizeof(header));
+   const char * pPayload = pFrame + sizeof(SerialHeader);
+   const char * pRuns = pPayload + frame.numBytes;
+   size_t numRuns = (size_t)(buffer + size - pRuns) / sizeof(JournalRun);
+   if ((size_t)(buffer + size - pRuns) % sizeof(JournalRun) != 0)
+      throw std::runtime_error("journal: checkpoint has the wrong length");
+   uint64_t numIds = 0;
+   for (size_t i = 0; i < numRuns; i++)
+   {
+      JournalRun run = loadRaw <JournalRun>(pRuns + i * sizeof(JournalRun));
+      if (run.count == 0 || run.count > frame.num - numIds)
+         throw std::runtime_error("journal: checkpoint has the wrong number of ids");
+      runs.push_back(BaseRun { run.first, run.count, (size_t)numIds });
+      numIds += run.count;
+   }
+   if (numIds != frame.num)
+      throw std::runtime_error("journal: checkpoint has the wrong number of ids");
+   if (runs.size() > 1)
+   {
+      baseIds.resize(frame.num);
+      for (const BaseRun & run : runs)
+         for (uint64_t i = 0; i < run.count; i++)
+            baseIds[run.index + i] = run.first + i;
+      std::sort(runs.begin(), runs.end(), [](const BaseRun & lhs, const BaseRun & rhs)
+      {
+         return lhs.first < rhs.first;
+      });
+   }
+
+   // the nodes
+   Node <T> * pBase = std::allocator <Node <T>>().allocate(frame.num);
+   size_t i = 0;
+   try
+   {
+      ByteReader in(pPayload, pRuns);
+      for (; i < frame.num; i++)
+      {
+         if constexpr (isRawSerial <T>)
+            new (pBase + i) Node <T>(loadRaw <T>(pPayload + i * sizeof(T)));
+         else
+            new (pBase + i) Node <T>(Serializer <T>::read(in));
+         pBase[i].pPrev = i ? pBase + i - 1 : nullptr;
+         pBase[i].pNext = i + 1 < frame.num ? pBase + i + 1 : nullptr;
+      }
+   }
+   catch (...)
+   {
+      while (i-- > 0)
+         pBase[i].~Node();
+      std::allocator <Node <T>>().deallocate(pBase, frame.num);
+      runs.clear();
+      baseIds.clear();
+      throw;
+   }
+
+   base = pBase;
+   numBase = frame.num;
+   pHead = numBase ? &base[0] : nullptr;
+   pTail = numBase ? &base[numBase - 1] : nullptr;
+   num = numBase;
+   nextId = header.nextId;
+   return header;
+}
+
+/***********************************************
+ * JOURNAL IMAGE :: FIND BASE
+ * The node from the checkpoint with an id
+ *   INPUT  : the id
+ *   OUTPUT : its node, or null if there is none or
+ *            it has been removed
+ *   COST   : O(log runs)
+ **********************************************/
+template <class T>
+Node <T> * JournalImage <T> :: findBase(uint64_t id)
+{
+   auto it = std::upper_bound(runs.begin(), runs.end(), id, [](uint64_t id, const BaseRun & run)
+   {
+      return id < run.first;
+   });
+   if (it == runs.begin() || id - (--it)->first >= it->count)
+      return nullptr;
+
+   Node <T> * p = base + it->index + (id - it->first);
+   return isLinked(p) ? p : nullptr;
+}
+
+/***********************************************
+ * JOURNAL IMAGE :: FIND
+ * The node with an id.  Only good while inOrder
+ * has been set since the chunks were empty: then
+ * the node with each id since is in the slot that
+ * many along, or it has been removed and the slot
+ * has id 0.
+ *   INPUT  : the id
+ *   OUTPUT : its node, or null if there is none
+ *   COST   : O(1), O(log runs) from the checkpoint
+ **********************************************/
+template <class T>
+Node <T> * JournalImage <T> :: find(uint64_t id)
+{
+   if (chunks.empty() || id < chunks[0]->firstId)
+      return findBase(id);
+
+   uint64_t offset = id - chunks[0]->firstId;
+   uint64_t numUsed = (chunks.size() - 1) * NUM_SLOTS + (pFresh - chunks.back()->slots);
+   if (offset >= numUsed)
+      return nullptr;
+   Node <T> * p = reinterpret_cast <Node <T> *> (chunks[offset / NUM_SLOTS]->slots[offset % NUM_SLOTS].storage);
+   return idOf(p) == id ? p : nullptr;
+}
+
+/***********************************************
+ * JOURNAL IMAGE :: INSERT
+ * Insert t before current, or after it, and give it
+ * the next id.  With no current, t goes on the front,
+ * or on the back when after is set.
+ *   INPUT  : current, t, and which side
+ *   OUTPUT : the new node
+ *   COST   : O(1)
+ **********************************************/
+template <class T>
+Node <T> * JournalImage <T> :: insert(Node <T> * pCurrent, const T & t, bool after)
+{
+   if (pCurrent == nullptr)
+   {
+      pCurrent = after ? pTail : pHead;
+      if (pCurrent == nullptr)
+         after = false;
+   }
+
+   Node <T> * pNew = allocate(t);
+   num++;
+
+   if (pCurrent == nullptr)
+      pHead = pTail = pNew;
+   else if (after)
+   {
+      pNew->pPrev = pCurrent;
+      pNew->pNext = pCurrent->pNext;
+      if (pNew->pNext)
+         pNew->pNext->pPrev = pNew;
+      else
+         pTail = pNew;
+      pCurrent->pNext = pNew;
+   }
+   else
+   {
+      pNew->pNext = pCurrent;
+      pNew->pPrev = pCurrent->pPrev;
+      if (pNew->pPrev)
+         pNew->pPrev->pNext = pNew;
+      else
+         pHead = pNew;
+      pCurrent->pPrev = pNew;
+   }
+   return pNew;
+}
+
+/***********************************************
+ * JOURNAL IMAGE :: REMOVE
+ * Unlink a node
+ *   INPUT  : the node
+ *   OUTPUT : the node before it, or the one after it
+ *            if it was the head, as node.h does
+ *   COST   : O(1)
+ **********************************************/
+template <class T>
+Node <T> * JournalImage <T> :: remove(Node <T> * pRemove)
+{
+   if (pRemove->pPrev)
+      pRemove->pPrev->pNext = pRemove->pNext;
+   else
+      pHead = pRemove->pNext;
+   if (pRemove->pNext)
+      pRemove->pNext->pPrev = pRemove->pPrev;
+   else
+      pTail = pRemove->pPrev;
+
+   Node <T> * pReturn = pRemove->pPrev ? pRemove->pPrev : pRemove->pNext;
+   num--;
+   if (isBase(pRemove))
+   {
+      // the value goes now; the node waits for the array, unlinked, which marks it dead
+      std::destroy_at(&pRemove->data);
+      pRemove->pNext = pRemove->pPrev = nullptr;
+   }
+   else
+      release(pRemove);
+   return pReturn;
+}
+
+/***********************************************
+ * JOURNAL IMAGE :: CLEAR
+ * Free every node.  The chunks and the array go
+ * back whole, so the nodes are only visited when
+ * the values have destructors to run.  Ids are
+ * never handed out twice, so nextId stays where
+ * it is.
+ *   COST   : O(n), O(chunks) for trivial values
+ **********************************************/
+template <class T>
+void JournalImage <T> :: clear()
+{
+   if constexpr (!std::is_trivially_destructible_v <T>)
+   {
+      for (Node <T> * p = pHead; p; )
+      {
+         Node <T> * pNext = p->pNext;
+         if (!isBase(p))
+            p->~Node();
+         p = pNext;
+      }
+      for (size_t i = 0; i < numBase; i++)
+         if (isLinked(base + i))
+            base[i].~Node();
+   }
+   for (Chunk * pChunk : chunks)
+      std::free(pChunk);
+   chunks.clear();
+   pFree = pFresh = pFreshEnd = nullptr;
+
+   if (base)
+      std::allocator <Node <T>>().deallocate(base, numBase);
+   base = nullptr;
+   runs.clear();
+   baseIds.clear();
+   numBase = 0;
+   pHead = pTail = nullptr;
+   num = 0;
+}
+
+/*************************************************
+ * JOURNALED LIST
+ * A list whose changes are logged so it can be
+ * rebuilt after a crash.  Like Node, it is not
+ * thread safe, and only one JournaledList may have
+ * a path open.  Node pointers it hands out are good
+ * until that node is removed.
+ *************************************************/
+template <class T>
+class JournaledList
+{
+   static_assert((HasSerializer <T> || std::is_trivially_copyable <T>::value) &&
+                 std::is_default_constructible <T>::value,
+                 "T needs a Serializer <T> and a default constructor");
+
+public:
+   static constexpr size_t GROUP_BYTES = 1 << 16;   // write a group this big without waiting
+
+   //
+   // Construct: rebuild the list from path.checkpoint and the
+   // segments after it; the first group written starts a new one
+   //
+   JournaledList(const std::string & path,
+                 std::chrono::milliseconds window = std::chrono::milliseconds(2));
+   JournaledList(const JournaledList &) = delete;
+   JournaledList & operator = (const JournaledList &) = delete;
+   ~JournaledList();
+
+   //
+   // Read
+   //
+   const Node <T> * head() const { return image.pHead;    }
+   const Node <T> * tail() const { return image.pTail;    }
+   size_t size()           const { return image.num;      }
+   bool empty()            const { return image.num == 0; }
+
+   //
+   // Change, as MappedList does it; each is one record
+   //
+   const Node <T> * insert(const Node <T> * pCurrent, const T & t, bool after = false);
+   const Node <T> * remove(const Node <T> * pRemove);
+   void clear();
+
+   //
+   // Durability
+   //
+   void commit();
+   std::shared_future <size_t> compact();
+
+   //
+   // Status
+   //
+   uint64_t segment() const { return numSegment; }
+   size_t numGroups() const
+   {
+      std::lock_guard <std::mutex> lock(mutex);
+      return groups;
+   }
+
+private:
+   enum Op { INSERT_BEFORE = 1, INSERT_AFTER, REMOVE, CLEAR };
+   static constexpr size_t PIECE_BYTES = 1 << 20;   // read a segment this much at a time
+
+   void log(uint8_t op, uint64_t ref, const T * pValue);
+   int openSegment(uint64_t segment);
+   void work();
+
+   static uint64_t recover(const std::string & path, uint64_t lastSegment, JournalImage <T> & image);
+   static uint64_t loadCheckpoint(const std::string & file, JournalImage <T> & image);
+   static void replaySegment(const std::string & file, JournalImage <T> & image);
+   static void replay(const char * p, const char * pEnd, JournalImage <T> & image);
+   static T getValue(ByteReader & in);
+   static size_t writeCheckpoint(const std::string & path, uint64_t segment, const JournalImage <T> & image);
+   static std::vector <uint64_t> findSegments(const std::string & path);
+   static std::string segmentPath(const std::string & path, uint64_t segment)
+   {
+      return path + ".journal." + std::to_string(segment);
+   }
+   static void putVarint(std::vector <char> & buffer, uint64_t u);
+   static uint64_t getVarint(ByteReader & in);
+
+   std::string path;
+   JournalImage <T> image;
+   uint64_t numSegment;                    // the segment being appended to
+   std::shared_future <size_t> compaction; // the last compact()
+
+   // shared with the thread
+   mutable std::mutex mutex;
+   std::condition_variable wake;
+   std::condition_variable committed;
+   std::vector <char> pending;             // a group not yet written
+   uint64_t numLogged;                     // records handed to pending
+   uint64_t numDurable;                    // records written and synced
+   size_t groups;                          // groups written
+   bool wanted;                            // is commit() waiting?
+   bool stop;
+   int error;                              // errno of the first failure
+   int fd;                                 // the segment
+   std::chrono::milliseconds window;
+   std::thread thread;
+};
+
+/***********************************************
+ * JOURNALED LIST :: CONSTRUCTOR
+ * Recover what is on disk and start logging
+ *   INPUT  : the path the files are named after,
+ *            and how long a record may wait for
+ *            its group to be written
+ *   COST   : O(checkpoint + journal)
+ **********************************************/
+template <class T>
+JournaledList <T> :: JournaledList(const std::string & path, std::chrono::milliseconds window) :
+   path(path), numSegment(0), numLogged(0), numDurable(0), groups(0),
+   wanted(false), stop(false), error(0), fd(-1), window(window)
+{
+   numSegment = recover(path, (uint64_t)-1, image) + 1;
+   thread = std::thread([this]() { work(); });
+}
+
+/***********************************************
+ * JOURNALED LIST :: DESTRUCTOR
+ * Commit what is left.  An error then has nowhere to
+ * go; call commit() to hear about it.
+ **********************************************/
+template <class T>
+JournaledList <T> :: ~JournaledList()
+{
+   if (compaction.valid())
+      compaction.wait();
+   try
+   {
+      commit();
+   }
+   catch (...)
+   {
+   }
+
+   {
+      std::lock_guard <std::mutex> lock(mutex);
+      stop = true;
+   }
+   wake.notify_all();
+   thread.join();
+   if (fd >= 0)
+      ::close(fd);
+}
+
+/***********************************************
+ * JOURNALED LIST :: PUT VARINT / GET VARINT
+ * Seven bits a byte, low bits first
+ **********************************************/
+template <class T>
+void JournaledList <T> :: putVarint(std::vector <char> & buffer, uint64_t u)
+{
+   while (u >= 0x80)
+   {
+      buffer.push_back((char)(u | 0x80));
+      u >>= 7;
+   }
+   buffer.push_back((char)u);
+}
+
+template <class T>
+uint64_t JournaledList <T> :: getVarint(ByteReader & in)
+{
+   uint64_t u = 0;
+   for (int shift = 0; shift < 64; shift += 7)
+   {
+      uint8_t byte = in.get <uint8_t>();
+      u |= (uint64_t)(byte & 0x7f) << shift;
+      if (!(byte & 0x80))
+         return u;
+   }
+   throw SerializeError("journal: varint is too long");
+}
+
+/***********************************************
+ * JOURNALED LIST :: LOG
+ * Add one record to the group being collected.  If
+ * this throws, none of the record is in the group.
+ *   INPUT  : the op, the id it is relative to, and
+ *            the value for an insert
+ *   COST   : O(1)
+ **********************************************/
+template <class T>
+void JournaledList <T> :: log(uint8_t op, uint64_t ref, const T * pValue)
+{
+   std::lock_guard <std::mutex> lock(mutex);
+   if (error)
+      throw std::system_error(error, std::generic_category(), "journal: write");
+
+   size_t sizeOld = pending.size();
+   try
+   {
+      if (pending.empty())
+         pending.resize(sizeof(JournalGroup));
+      pending.push_back((char)op);
+      putVarint(pending, ref);
+      if (pValue)
+      {
+         if constexpr (isRawSerial <T>)
+            pending.insert(pending.end(), (const char *)pValue, (const char *)pValue + sizeof(T));
+         else
+         {
+            ByteWriter out(pending);
+            Serializer <T>::write(out, *pValue);
+         }
+      }
+   }
+   catch (...)
+   {
+      pending.resize(sizeOld);
+      throw;
+   }
+   numLogged++;
+
+   if (pending.size() >= GROUP_BYTES)
+      wake.notify_one();
+}
+
+/***********************************************
+ * JOURNALED LIST :: WORK
+ * Write each group and sync it, waking whoever is
+ * waiting in commit()
+ **********************************************/
+template <class T>
+void JournaledList <T> :: work()
+{
+   std::vector <char> writing;
+   std::unique_lock <std::mutex> lock(mutex);
+   for (;;)
+   {
+      wake.wait_for(lock, window, [this]() { return stop || wanted || pending.size() >= GROUP_BYTES; });
+      if (pending.empty())
+      {
+         // a commit() whose records went out in the last group
+         wanted = false;
+         if (stop)
+            return;
+         continue;
+      }
+
+      writing.swap(pending);
+      uint64_t target = numLogged;
+      uint64_t segment = numSegment;
+      int fdWrite = fd;
+      wanted = false;
+      lock.unlock();
+
+      // the first group of a segment creates it, and its name must be
+      // durable before any group in it is
+      int result = 0;
+      if (fdWrite < 0)
+      {
+         try
+         {
+            fdWrite = openSegment(segment);
+         }
+         catch (const std::system_error & e)
+         {
+            result = e.code().value();
+         }
+         catch (...)
+         {
+            result = ENOMEM;
+         }
+      }
+
+      JournalGroup group;
+      group.numBytes = (uint32_t)(writing.size() - sizeof(JournalGroup));
+      group.checksum = journalChecksum(writing.data() + sizeof(JournalGroup), group.numBytes);
+      memcpy(writing.data(), &group, sizeof(JournalGroup));
+
+      for (const char * p = writing.data(), * pEnd = p + writing.size(); p != pEnd && !result; )
+      {
+         ssize_t done = ::write(fdWrite, p, pEnd - p);
+         if (done > 0)
+            p += done;
+         else if (done == 0 || errno != EINTR)
+            result = done < 0 ? errno : EIO;
+      }
+#ifdef __APPLE__
+      if (!result && ::fsync(fdWrite) != 0)
+#else
+      if (!result && ::fdatasync(fdWrite) != 0)
+#endif // __APPLE__
+         result = errno;
+      writing.clear();
+
+      lock.lock();
+      fd = fdWrite;
+      if (result && !error)
+         error = result;
+      if (!result)
+      {
+         numDurable = target;
+         groups++;
+      }
+      committed.notify_all();
+   }
+}
+
+/***********************************************
+ * JOURNALED LIST :: COMMIT
+ * Wait until every change so far is on disk.  All
+ * the changes since the last group share one sync.
+ *   COST   : one group write and sync at most
+ **********************************************/
+template <class T>
+void JournaledList <T> :: commit()
+{
+   std::unique_lock <std::mutex> lock(mutex);
+   uint64_t target = numLogged;
+   if (numDurable < target && !error)
+   {
+      wanted = true;
+      wake.notify_one();
+      committed.wait(lock, [this, target]() { return numDurable >= target || error; });
+   }
+   if (error)
+      throw std::system_error(error, std::generic_category(), "journal: write");
+}
+
+/***********************************************
+ * JOURNALED LIST :: INSERT
+ * Do the insert, then log it.  Doing it first
+ * means a copy that throws never leaves a record
+ * behind to hand out an id the list did not; if
+ * logging throws, the insert is undone.
+ *   INPUT  : current, t, and which side; with no
+ *            current, the front, or the back when
+ *            after is set
+ *   OUTPUT : the new node
+ *   COST   : O(1)
+ **********************************************/
+template <class T>
+const Node <T> * JournaledList <T> :: insert(const Node <T> * pCurrent, const T & t, bool after)
+{
+   uint64_t ref = pCurrent ? image.idOf(pCurrent) : 0;
+   Node <T> * pNew = image.insert(const_cast <Node <T> *> (pCurrent), t, after);
+   try
+   {
+      log(after ? INSERT_AFTER : INSERT_BEFORE, ref, &t);
+   }
+   catch (...)
+   {
+      image.remove(pNew);
+      image.nextId--;
+      throw;
+   }
+   return pNew;
+}
+
+/***********************************************
+ * JOURNALED LIST :: REMOVE
+ * Log the remove, then do it
+ *   INPUT  : the node
+ *   OUTPUT : the node before it, or the one after it
+ *            if it was the head, as node.h does
+ *   COST   : O(1)
+ **********************************************/
+template <class T>
+const Node <T> * JournaledList <T> :: remove(const Node <T> * pRemove)
+{
+   if (pRemove == nullptr)
+      return nullptr;
+   log(REMOVE, image.idOf(pRemove), nullptr);
+   return image.remove(const_cast <Node <T> *> (pRemove));
+}
+
+/***********************************************
+ * JOURNALED LIST :: CLEAR
+ * One record, however long the list
+ *   COST   : O(n)
+ **********************************************/
+template <class T>
+void JournaledList <T> :: clear()
+{
+   log(CLEAR, 0, nullptr);
+   image.clear();
+}
+
+/***********************************************
+ * JOURNALED LIST :: OPEN SEGMENT
+ * Create a segment, write its header, and sync its
+ * directory so the segment outlives a crash.  The
+ * thread does this before the first group in it.
+ *   INPUT  : which segment
+ *   OUTPUT : the open file, appending
+ **********************************************/
+template <class T>
+int JournaledList <T> :: openSegment(uint64_t segment)
+{
+   std::string file = segmentPath(path, segment);
+   int fdNew = ::open(file.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+   if (fdNew < 0)
+      throw std::system_error(errno, std::generic_category(), "journal: open " + file);
+
+   JournalSegmentHeader header = { JournalSegmentHeader::MAGIC, sizeof(T) };
+   if (::write(fdNew, &header, sizeof(header)) != (ssize_t)sizeof(header))
+   {
+      int result = errno;
+      ::close(fdNew);
+      throw std::system_error(result, std::generic_category(), "journal: write " + file);
+   }
+   try
+   {
+      syncDirectory(file);
+   }
+   catch (...)
+   {
+      ::close(fdNew);
+      throw;
+   }
+   return fdNew;
+}
+
+/***********************************************
+ * JOURNALED LIST :: COMPACT
+ * Fold the journal so far into a new checkpoint.
+ * The segment being written is closed and a new
+ * one started; the checkpoint is rebuilt from the
+ * files on another thread.  One compaction runs at
+ * a time: this waits for the last one first.
+ *   OUTPUT : a future holding the size of the list
+ *            in the new checkpoint, or the error
+ *   COST   : one commit here, O(n) on the other thread
+ **********************************************/
+template <class T>
+std::shared_future <size_t> JournaledList <T> :: compact()
+{
+   if (compaction.valid())
+      compaction.wait();
+   commit();
+
+   // everything logged is in the segment; nothing more is until we return
+   uint64_t sealed = numSegment;
+   int fdOld;
+   {
+      std::lock_guard <std::mutex> lock(mutex);
+      fdOld = fd;
+      fd = -1;
+      numSegment = sealed + 1;
+   }
+   if (fdOld >= 0)
+      ::close(fdOld);
+
+   std::string path = this->path;
+   compaction = std::async(std::launch::async, [path, sealed]()
+   {
+      JournalImage <T> image;
+      recover(path, sealed, image);
+      size_t num = writeCheckpoint(path, sealed, image);
+      for (uint64_t segment : findSegments(path))
+         if (segment <= sealed)
+            std::remove(segmentPath(path, segment).c_str());
+      return num;
+   }).share();
+   return compaction;
+}
+
+/***********************************************
+ * JOURNALED LIST :: FIND SEGMENTS
+ * The numbers of the segments on disk
+ *   INPUT  : the path the files are named after
+ *   OUTPUT : the segment numbers, smallest first
+ **********************************************/
+template <class T>
+std::vector <uint64_t> JournaledList <T> :: findSegments(const std::string & path)
+{
+   std::filesystem::path directory = std::filesystem::path(path).parent_path();
+   std::string prefix = std::filesystem::path(path).filename().string() + ".journal.";
+   std::vector <uint64_t> segments;
+
+   for (const auto & entry : std::filesystem::directory_iterator(directory.empty() ? "." : directory))
+   {
+      std::string name = entry.path().filename().string();
+      if (name.size() <= prefix.size() || name.compare(0, prefix.size(), prefix) != 0)
+         continue;
+      uint64_t segment;
+      const char * pLast = name.data() + name.size();
+      std::from_chars_result result = std::from_chars(name.data() + prefix.size(), pLast, segment);
+      if (result.ec == std::errc() && result.ptr == pLast)
+         segments.push_back(segment);
+   }
+   std::sort(segments.begin(), segments.end());
+   return segments;
+}
+
+/***********************************************
+ * JOURNALED LIST :: LOAD CHECKPOINT
+ * Fill an empty image from a checkpoint, mapped
+ * rather than read so its pages are not copied
+ *   INPUT  : the file, and the image
+ *   OUTPUT : the last segment in it, or 0 if it is
+ *            not there or empty
+ *   COST   : O(n)
+ **********************************************/
+template <class T>
+uint64_t JournaledList <T> :: loadCheckpoint(const std::string & file, JournalImage <T> & image)
+{
+   int fdIn = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+   if (fdIn < 0)
+   {
+      if (errno == ENOENT)
+         return 0;
+      throw std::system_error(errno, std::generic_category(), "journal: cannot open " + file);
+   }
+
+   struct stat status;
+   if (::fstat(fdIn, &status) != 0)
+   {
+      int errorStat = errno;
+      ::close(fdIn);
+      throw std::system_error(errorStat, std::generic_category(), "journal: cannot read " + file);
+   }
+   size_t size = (size_t)status.st_size;
+   if (size == 0)
+   {
+      ::close(fdIn);
+      return 0;
+   }
+   void * p = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fdIn, 0);
+   int errorMap = errno;
+   ::close(fdIn);
+   if (p == MAP_FAILED)
+      throw std::system_error(errorMap, std::generic_category(), "journal: cannot map " + file);
+
+   uint64_t segment;
+   try
+   {
+      segment = image.load(static_cast <const char *> (p), size).segment;
+   }
+   catch (...)
+   {
+      ::munmap(p, size);
+      throw;
+   }
+   ::munmap(p, size);
+   return segment;
+}
+
+/***********************************************
+ * JOURNALED LIST :: REPLAY SEGMENT
+ * Apply every whole group in a segment to an image,
+ * reading it a piece at a time.  The first group
+ * that is cut short or fails its checksum is where
+ * the crash was; it and anything after it are
+ * dropped.
+ *   INPUT  : the file, and the image
+ *   COST   : O(records), in PIECE_BYTES of memory
+ *            or the biggest group
+ **********************************************/
+template <class T>
+void JournaledList <T> :: replaySegment(const std::string & file, JournalImage <T> & image)
+{
+   int fdIn = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+   if (fdIn < 0)
+   {
+      if (errno == ENOENT)
+         return;
+      throw std::system_error(errno, std::generic_category(), "journal: cannot open " + file);
+   }
+
+   try
+   {
+      struct stat status;
+      if (::fstat(fdIn, &status) != 0)
+         throw std::system_error(errno, std::generic_category(), "journal: cannot read " + file);
+
+      // the bytes from begin to end are read and not used yet
+      std::vector <char> buffer(std::min <size_t> (PIECE_BYTES, (size_t)status.st_size));
+      size_t begin = 0;
+      size_t end = 0;
+      auto hold = [&](size_t num) -> bool
+      {
+         if (end - begin >= num)
+            return true;
+         memmove(buffer.data(), buffer.data() + begin, end - begin);
+         end -= begin;
+         begin = 0;
+         if (buffer.size() < num)
+            buffer.resize(num);
+         while (end < num)
+         {
+            ssize_t numRead = ::read(fdIn, buffer.data() + end, buffer.size() - end);
+            if (numRead < 0 && errno == EINTR)
+               continue;
+            if (numRead < 0)
+               throw std::system_error(errno, std::generic_category(), "journal: cannot read " + file);
+            if (numRead == 0)
+               return false;
+            end += (size_t)numRead;
+         }
+         return true;
+      };
+
+      // a crash can leave a segment with nothing in it yet
+      JournalSegmentHeader header;
+      if (hold(sizeof(header)))
+      {
+         memcpy(&header, buffer.data(), sizeof(header));
+         begin += sizeof(header);
+         if (header.magic != JournalSegmentHeader::MAGIC)
+            throw std::runtime_error("journal: " + file + " is not a journal");
+         if (header.size != sizeof(T))
+            throw std::runtime_error("journal: " + file + " holds some other type");
+
+         JournalGroup group;
+         while (hold(sizeof(group)))
+         {
+            memcpy(&group, buffer.data() + begin, sizeof(group));
+            if (group.numBytes > (uint64_t)status.st_size || !hold(sizeof(group) + group.numBytes))
+               break;
+            const char * p = buffer.data() + begin + sizeof(group);
+            if (journalChecksum(p, group.numBytes) != group.checksum)
+               break;
+            replay(p, p + group.numBytes, image);
+            begin += sizeof(group) + group.numBytes;
+         }
+      }
+   }
+   catch (...)
+   {
+      ::close(fdIn);
+      throw;
+   }
+   ::close(fdIn);
+}
+
+/***********************************************
+ * JOURNALED LIST :: GET VALUE
+ * The value of an insert record
+ **********************************************/
+template <class T>
+T JournaledList <T> :: getValue(ByteReader & in)
+{
+   if constexpr (isRawSerial <T>)
+      return in.get <T>();
+   else
+      return Serializer <T>::read(in);
+}
+
+/***********************************************
+ * JOURNALED LIST :: REPLAY
+ * Apply the records of one group to an image.  The
+ * node a record names is found from its id with no
+ * table: the checkpoint's by its runs, the rest by
+ * where they sit while recover() has the image fill
+ * its chunks in id order.
+ *   INPUT  : the records, and the image
+ *   COST   : O(records log runs)
+ **********************************************/
+template <class T>
+void JournaledList <T> :: replay(const char * p, const char * pEnd, JournalImage <T> & image)
+{
+   auto find = [&image](uint64_t id) -> Node <T> *
+   {
+      Node <T> * pFound = image.find(id);
+      if (pFound == nullptr)
+         throw std::runtime_error("journal: a record names a node that is not there");
+      return pFound;
+   };
+
+   ByteReader in(p, pEnd);
+   while (in.remaining())
+   {
+      uint8_t op = in.get <uint8_t>();
+      uint64_t ref = getVarint(in);
+      switch (op)
+      {
+         case INSERT_BEFORE:
+         case INSERT_AFTER:
+            image.insert(ref ? find(ref) : nullptr, getValue(in), op == INSERT_AFTER);
+            break;
+         case REMOVE:
+            image.remove(find(ref));
+            break;
+         case CLEAR:
+            image.clear();
+            break;
+         default:
+            throw std::runtime_error("journal: a record has an unknown op");
+      }
+   }
+}
+
+/***********************************************
+ * JOURNALED LIST :: RECOVER
+ * Build an image from the checkpoint and the
+ * segments after it
+ *   INPUT  : the path the files are named after, the
+ *            last segment to read, and an empty image
+ *   OUTPUT : the last segment on disk, or in the
+ *            checkpoint if there are none after it
+ *   COST   : O(checkpoint + journal)
+ **********************************************/
+template <class T>
+uint64_t JournaledList <T> :: recover(const std::string & path, uint64_t lastSegment, JournalImage <T> & image)
+{
+   uint64_t last = loadCheckpoint(path + ".checkpoint", image);
+
+   // nothing is inserted yet, so the chunks can fill in id order
+   image.inOrder = true;
+   uint64_t covered = last;
+   for (uint64_t segment : findSegments(path))
+   {
+      if (segment > lastSegment)
+         break;
+      last = std::max(last, segment);
+      if (segment > covered)
+         replaySegment(segmentPath(path, segment), image);
+   }
+   image.inOrder = false;
+   return last;
+}
+
+/***********************************************
+ * JOURNALED LIST :: WRITE CHECKPOINT
+ * Write an image to path.checkpoint.tmp, then
+ * rename it over path.checkpoint
+ *   INPUT  : the path the files are named after, the
+ *            last segment in the image, and the image
+ *   OUTPUT : the number of nodes written
+ *   COST   : O(n)
+ **********************************************/
+template <class T>
+size_t JournaledList <T> :: writeCheckpoint(const std::string & path, uint64_t segment,
+                                            const JournalImage <T> & image)
+{
+   std::string pathTemp = path + ".checkpoint.tmp";
+   try
+   {
+      AsyncWriter out(pathTemp);
+      out.put(JournalCheckpointHeader { JournalCheckpointHeader::MAGIC, sizeof(T), segment, image.nextId, 0 });
+      writeList((const Node <T> *)image.pHead, out);
+      JournalRun run = { 0, 0 };
+      for (const Node <T> * p = image.pHead; p; p = p->pNext)
+      {
+         uint64_t id = image.idOf(p);
+         if (run.count && id == run.first + run.count)
+            run.count++;
+         else
+         {
+            if (run.count)
+               out.put(run);
+            run = JournalRun { id, 1 };
+         }
+      }
+      if (run.count)
+         out.put(run);
+      out.finish();
+   }
+   catch (...)
+   {
+      std::remove(pathTemp.c_str());
+      throw;
+   }
+
+   // the segments go once this returns, so the new name must be on disk first
+   std::string pathFinal = path + ".checkpoint";
+   if (std::rename(pathTemp.c_str(), pathFinal.c_str()) != 0)
+      throw std::system_error(errno, std::generic_category(), "journal: rename " + pathTemp);
+   syncDirectory(pathFinal);
+   return image.num;
+}
+
+#endif // _WIN32
@@ -0,0 +1,465 @@
+/***********************************************************************
+ * Header:
+ *    MAPPED
+ * Summary:
+ *    A list that lives in a memory-mapped file, so it is still there
+ *    after the program exits and is ready the moment the file is mapped
+ *    again: opening a list of any length costs one mmap, not a pass
+ *    over every node.
+ *
+ *    Pointers are different each time a file is mapped, so nodes link
+ *    to each other by their offset from the start of the file, with 0
+ *    standing in for NULL.  The file looks like this:
+ *
+ *       +--------+--------+--------+--------+-----
+ *       | header | slot 0 | slot 1 | slot 2 | ...
+ *       +--------+--------+--------+--------+-----
+ *
+ *    The header holds the head, the tail, and a free list of removed
+ *    slots.  When every slot is used the file doubles and is mapped
+ *    again, which moves it in memory; offsets stay good, references
+ *    from at() do not.
+ *
+ *    Changes reach the file whenever the kernel writes the pages back.
+ *    sync() waits until they are on disk; that is the durability point.
+ *    A crash between syncs can leave the file half updated.  POSIX only.
+ *
+ *    This will contain the class definition of:
+ *        MappedNode   : One slot in the file
+ *        MappedList   : A list in a memory-mapped file
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell
+ ************************************************************************/
+
+#pragma once
+
+#ifndef _WIN32
+
+#include <cerrno>       // for errno
+#include <cstdint>      // for uint64_t and SIZE_MAX
+#include <stdexcept>    // for std::runtime_error and std::overflow_error
+#include <string>       // for std::string
+#include <system_error> // for std::system_error
+#include <type_traits>  // for std::is_trivially_copyable
+#include <fcntl.h>      // for open
+#include <sys/mman.h>   // for mmap
+#include <sys/stat.h>   // for fstat
+#include <unistd.h>     // for ftruncate
+#include "node.h"       // for Node
+
+/*************************************************
+ * MAPPED NODE
+ * A node whose links are offsets into the file
+ *************************************************/
+template <class T>
+struct MappedNode
+{
+   T data;
+   uint64_t next;        // offset of the next node, 0 for none
+   uint64_t prev;        // offset of the previous node, 0 for none
+};
+
+/*************************************************
+ * MAPPED HEADER
+ * The first 64 bytes of the file
+ *************************************************/
+struct MappedHeader
+{
+   static constexpr uint32_t MAGIC = 0x4c50414d;   // "MAPL"
+
+   uint32_t magic;
+   uint32_t size;        // sizeof(T), to catch the wrong T
+   uint64_t capacity;    // slots in the file
+   uint64_t numUsed;     // slots ever handed out; the rest are untouched
+   uint64_t head;
+   uint64_t tail;
+   uint64_t free;        // removed slots, linked through next
+   uint64_t num;         // nodes in the list
+   uint64_t reserved;
+};
+static_assert(sizeof(MappedHeader) == 64);
+
+/*************************************************
+ * MAPPED LIST
+ * A list in a file.  Nodes are named by offset; ask
+ * at() for the value.  Like Node, it is not thread
+ * safe, and only one MappedList may have a file open.
+ *************************************************/
+template <class T>
+class MappedList
+{
+   static_assert(std::is_trivially_copyable <T>::value,
+                 "a mapped list holds raw bytes, not objects that own memory");
+
+public:
+   using Offset = uint64_t;
+
+   //
+   // Construct: open the file, creating it if it is
+   // empty or missing
+   //
+   MappedList(const std::string & path, size_t capacity = 1024);
+   MappedList(const MappedList &) = delete;
+   MappedList & operator = (const MappedList &) = delete;
+   ~MappedList();
+
+   //
+   // Walk
+   //
+   Offset head()                const { return header().head;       }
+   Offset tail()                const { return header().tail;       }
+   Offset next(Offset p)        const { return node(p).next;        }
+   Offset prev(Offset p)        const { return node(p).prev;        }
+   T & at(Offset p)                   { return node(p).data;        }
+   const T & at(Offset p)       const { return node(p).data;        }
+
+   //
+   // Change, as node.h does it
+   //
+   Offset insert(Offset current, const T & t, bool after = false);
+   Offset remove(Offset p);
+   void clear();
+   void assign(const Node <T> * pSource);
+   Node <T> * copy() const;
+
+   //
+   // Durability
+   //
+   void sync();
+
+   //
+   // Status
+   //
+   size_t size()     const { return header().num;      }
+   bool empty()      const { return header().num == 0; }
+   size_t capacity() const { return header().capacity; }
+
+private:
+   static constexpr Offset FIRST = sizeof(MappedHeader);
+
+   MappedHeader & header() const { return *reinterpret_cast <MappedHeader *> (pBase); }
+   MappedNode <T> & node(Offset p) const
+   {
+      if (!isSlot(p))
+         throw std::runtime_error("mapped: a link points outside the list");
+      return *reinterpret_cast <MappedNode <T> *> (pBase + p);
+   }
+
+   // the start of a slot that has been handed out
+   bool isSlot(Offset p) const
+   {
+      return p >= FIRST && p - FIRST < header().numUsed * sizeof(MappedNode <T>) &&
+             (p - FIRST) % sizeof(MappedNode <T>) == 0;
+   }
+
+   Offset allocate();
+   void map(size_t length);
+   static size_t lengthFor(uint64_t capacity)
+   {
+      if (capacity > (SIZE_MAX - FIRST) / sizeof(MappedNode <T>))
+         throw std::overflow_error("mapped: no file can hold that many nodes");
+      return FIRST + capacity * sizeof(MappedNode <T>);
+   }
+
+   int fd;               // the open file
+   char * pBase;         // where it is mapped
+   size_t length;        // how much of it is mapped
+};
+
+/***********************************************
+ * MAPPED LIST :: CONSTRUCTOR
+ * Map the file.  A new file gets a header and room
+ * for capacity nodes; an old one has its header
+ * checked and is used as it is.  The links between
+ * nodes are checked as they are followed, so a
+ * corrupt one throws rather than reading outside
+ * the file.
+ *   INPUT  : the path, and how many nodes a new file
+ *            has room for
+ *   COST   : O(1)
+ **********************************************/
+template <class T>
+MappedList <T> :: MappedList(const std::string & path, size_t capacity) : fd(-1), pBase(nullptr), length(0)
+{
+   fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+   if (fd < 0)
+      throw std::system_error(errno, std::generic_category(), "mapped: open " + path);
+
+   try
+   {
+      struct stat info;
+      if (::fstat(fd, &info) != 0)
+         throw std::system_error(errno, std::generic_category(), "mapped: fstat " + path);
+
+      if (info.st_size == 0)
+      {
+         capacity = capacity ? capacity : 1;
+         if (::ftruncate(fd, lengthFor(capacity)) != 0)
+            throw std::system_error(errno, std::generic_category(), "mapped: ftruncate " + path);
+         map(lengthFor(capacity));
+         header() = MappedHeader { MappedHeader::MAGIC, sizeof(T), capacity, 0, 0, 0, 0, 0, 0 };
+         return;
+      }
+
+      if ((size_t)info.st_size < sizeof(MappedHeader))
+         throw std::runtime_error("mapped: " + path + " is not a list");
+      map(info.st_size);
+      if (header().magic != MappedHeader::MAGIC)
+         throw std::runtime_error("mapped: " + path + " is not a list");
+      if (header().size != sizeof(T))
+         throw std::runtime_error("mapped: " + path + " holds some other type");
+      const MappedHeader & h = header();
+      if (lengthFor(h.capacity) > length)
+         throw std::runtime_error("mapped: " + path + " is cut short");
+      if (h.numUsed > h.capacity || h.num > h.numUsed ||
+          (h.head == 0) != (h.num == 0) || (h.tail == 0) != (h.num == 0) ||
+          (h.head && !isSlot(h.head)) || (h.tail && !isSlot(h.tail)) || (h.free && !isSlot(h.free)))
+         throw std::runtime_error("mapped: " + path + " is corrupt");
+   }
+   catch (...)
+   {
+      if (pBase)
+         ::munmap(pBase, length);
+      ::close(fd);
+      throw;
+   }
+}
+
+/***********************************************
+ * MAPPED LIST :: DESTRUCTOR
+ * Unmap the file.  What was written stays in it,
+ * but only what came before the last sync() is sure
+ * to survive a crash.
+ **********************************************/
+template <class T>
+MappedList <T> :: ~MappedList()
+{
+   ::munmap(pBase, length);
+   ::close(fd);
+}
+
+/***********************************************
+ * MAPPED LIST :: MAP
+ * Map the first length bytes of the file, in place
+ * of whatever was mapped before
+ *   INPUT  : how many bytes
+ **********************************************/
+template <class T>
+void MappedList <T> :: map(size_t length)
+{
+   void * p = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   if (p == MAP_FAILED)
+      throw std::system_error(errno, std::generic_category(), "mapped: mmap");
+
+   if (pBase)
+      ::munmap(pBase, this->length);
+   pBase = (char *)p;
+   this->length = length;
+}
+
+/***********************************************
+ * MAPPED LIST :: ALLOCATE
+ * A slot for a new node: a removed one if there is
+ * one, otherwise the next untouched one, doubling
+ * the file when there are none left
+ *   OUTPUT : the offset of the slot
+ *   COST   : O(1) amortized
+ **********************************************/
+template <class T>
+typename MappedList <T> :: Offset MappedList <T> :: allocate()
+{
+   if (header().free)
+   {
+      Offset p = header().free;
+      header().free = node(p).next;
+      return p;
+   }
+
+   if (header().numUsed == header().capacity)
+   {
+      size_t capacity = header().capacity * 2;
+      if (::ftruncate(fd, lengthFor(capacity)) != 0)
+         throw std::system_error(errno, std::generic_category(), "mapped: ftruncate");
+      map(lengthFor(capacity));
+      header().capacity = capacity;
+   }
+
+   return FIRST + header().numUsed++ * sizeof(MappedNode <T>);
+}
+
+/***********************************************
+ * MAPPED LIST :: INSERT
+ * Insert t before current, or after it.  With no
+ * current, t goes on the front, or on the back
+ * when after is set.
+ *   INPUT  : current, t, and which side
+ *   OUTPUT : the offset of the new node
+ *   COST   : O(1) amortized
+ **********************************************/
+template <class T>
+typename MappedList <T> :: Offset MappedList <T> :: insert(Offset current, const T & t, bool after)
+{
+   if (current == 0)
+   {
+      current = after ? header().tail : header().head;
+      if (current == 0)
+         after = false;
+   }
+
+   // a reference to t could be into the file, which may move
+   T value = t;
+   Offset p = allocate();
+   MappedNode <T> & n = node(p);
+   n.data = value;
+   n.next = 0;
+   n.prev = 0;
+
+   // a node is written in full before anything points at it
+   if (current == 0)
+   {
+      header().head = header().tail = p;
+   }
+   else if (after)
+   {
+      n.prev = current;
+      n.next = node(current).next;
+      if (n.next)
+         node(n.next).prev = p;
+      else
+         header().tail = p;
+      node(current).next = p;
+   }
+   else
+   {
+      n.next = current;
+      n.prev = node(current).prev;
+      if (n.prev)
+         node(n.prev).next = p;
+      else
+         header().head = p;
+      node(current).prev = p;
+   }
+
+   header().num++;
+   return p;
+}
+
+/***********************************************
+ * MAPPED LIST :: REMOVE
+ * Unlink a node and put its slot on the free list
+ *   INPUT  : the node
+ *   OUTPUT : the node before it, or the one after it
+ *            if it was the head, as node.h does
+ *   COST   : O(1)
+ **********************************************/
+template <class T>
+typename MappedList <T> :: Offset MappedList <T> :: remove(Offset p)
+{
+   if (p == 0)
+      return 0;
+
+   MappedNode <T> & n = node(p);
+   if (n.prev)
+      node(n.prev).next = n.next;
+   else
+      header().head = n.next;
+   if (n.next)
+      node(n.next).prev = n.prev;
+   else
+      header().tail = n.prev;
+
+   Offset pReturn = n.prev ? n.prev : n.next;
+   n.next = header().free;
+   header().free = p;
+   header().num--;
+   return pReturn;
+}
+
+/***********************************************
+ * MAPPED LIST :: CLEAR
+ * Put every node on the free list
+ *   COST   : O(1)
+ **********************************************/
+template <class T>
+void MappedList <T> :: clear()
+{
+   if (header().tail)
+   {
+      node(header().tail).next = header().free;
+      header().free = header().head;
+   }
+   header().head = header().tail = 0;
+   header().num = 0;
+}
+
+/***********************************************
+ * MAPPED LIST :: ASSIGN
+ * Make the file hold the values of a list in memory,
+ * reusing the nodes already there
+ *   INPUT  : the list to copy
+ *   COST   : O(n)
+ **********************************************/
+template <class T>
+void MappedList <T> :: assign(const Node <T> * pSource)
+{
+   Offset p = header().head;
+   for (; pSource && p; pSource = pSource->pNext, p = node(p).next)
+      node(p).data = pSource->data;
+
+   for (; pSource; pSource = pSource->pNext)
+      insert(0, pSource->data, true);
+
+   while (p)
+   {
+      Offset pNext = node(p).next;
+      remove(p);
+      p = pNext;
+   }
+}
+
+/***********************************************
+ * MAPPED LIST :: COPY
+ * The values in the file, as a list in memory.  A
+ * corrupt link, or more nodes than the header says,
+ * throws, and what was copied so far is freed.
+ *   OUTPUT : the new list
+ *   COST   : O(n)
+ **********************************************/
+template <class T>
+Node <T> * MappedList <T> :: copy() const
+{
+   Node <T> * pHead = nullptr;
+   Node <T> * pTail = nullptr;
+   try
+   {
+      size_t num = 0;
+      for (Offset p = header().head; p; p = node(p).next)
+      {
+         if (num++ == header().num)
+            throw std::runtime_error("mapped: the links go round in a loop");
+         pTail = ::insert(pTail, node(p).data, true);
+         if (pHead == nullptr)
+            pHead = pTail;
+      }
+   }
+   catch (...)
+   {
+      ::clear(pHead);
+      throw;
+   }
+   return pHead;
+}
+
+/***********************************************
+ * MAPPED LIST :: SYNC
+ * Wait until every change so far is on disk
+ *   COST   : one msync
+ **********************************************/
+template <class T>
+void MappedList <T> :: sync()
+{
+   if (::msync(pBase, length, MS_SYNC) != 0)
+      throw std::system_error(errno, std::generic_category(), "mapped: msync");
+}
+
+#endif // _WIN32
@@ -0,0 +1,425 @@
+/***********************************************************************
+ * Header:
+ *    MVCC
+ * Summary:
+ *    Multi-version concurrency control for a list.  Every node carries
+ *    the timestamps between which it is part of the list.  A reader
+ *    takes a snapshot (a timestamp) and sees the list exactly as it was
+ *    then, however long it scans, while writers keep inserting and
+ *    removing.  Writers never wait for readers.
+ *
+ *    A removed node stays linked until no snapshot can see it; the
+ *    collector then unlinks it and frees it through an RCUDomain once
+ *    no reader can be standing on it.
+ *
+ *    This will contain the class definition of:
+ *        VersionedNode : A Node with a lifetime
+ *        MVCCList      : The list, its writers, and its collector
+ *        MVCCSnapshot  : A consistent view for one reader
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell
+ ************************************************************************/
+
+#pragma once
+
+#include <atomic>              // for std::atomic and std::atomic_ref
+#include <cassert>             // for ASSERT
+#include <chrono>              // for std::chrono::milliseconds
+#include <condition_variable>  // for std::condition_variable
+#include <cstdint>             // for uint64_t
+#include <limits>              // for std::numeric_limits
+#include <mutex>               // for std::mutex
+#include <thread>              // for std::thread
+#include "rcu.h"               // for RCUDomain and RCUReader
+
+/*************************************************
+ * VERSIONED NODE
+ * A node that is in the list for the timestamps
+ * [begin, end).  Like Node, but with a lifetime
+ * kept beside the links.
+ *************************************************/
+template <class T>
+class VersionedNode
+{
+public:
+   static constexpr uint64_t FOREVER = std::numeric_limits <uint64_t>::max();
+
+   VersionedNode(const T & data, uint64_t begin) :
+      data(data), pNext(nullptr), pPrev(nullptr), begin(begin), end(FOREVER) { }
+
+   // can a snapshot taken at this timestamp see us?
+   bool visible(uint64_t timestamp) const
+   {
+      return begin <= timestamp && timestamp < end.load(std::memory_order_acquire);
+   }
+
+   T data;                            // user data
+   VersionedNode <T> * pNext;         // pointer to next node
+   VersionedNode <T> * pPrev;         // pointer to previous node
+   const uint64_t begin;              // inserted at
+   std::atomic <uint64_t> end;        // removed at, or FOREVER
+};
+
+template <class T>
+class MVCCSnapshot;
+
+/*************************************************
+ * MVCC LIST
+ * Any number of snapshot readers, one writer at a
+ * time.  Node pointers passed to the writers come
+ * from a snapshot and must still be in the list.
+ *************************************************/
+template <class T>
+class MVCCList
+{
+   friend class MVCCSnapshot <T>;
+
+public:
+   enum { MAX_SNAPSHOTS = 128 };
+
+   //
+   // Construct
+   //
+   MVCCList(RCUDomain & domain);
+   MVCCList(const MVCCList &) = delete;
+   MVCCList & operator = (const MVCCList &) = delete;
+   ~MVCCList();
+
+   //
+   // Writers: each change is one new timestamp
+   //
+   const VersionedNode <T> * insert(const VersionedNode <T> * pCurrent, const T & t, bool after = false);
+   void remove(const VersionedNode <T> * pRemove);
+   const VersionedNode <T> * update(const VersionedNode <T> * pCurrent, const T & t);
+
+   //
+   // Garbage collection
+   //
+   size_t collect();
+   void startCollector(std::chrono::milliseconds interval);
+   void stopCollector();
+
+   //
+   // Status
+   //
+   uint64_t now() const   { return clock.load(std::memory_order_acquire); }
+   size_t numVersions();  // nodes physically in the chain
+
+private:
+   void link(VersionedNode <T> * pNew, VersionedNode <T> * pCurrent, bool after);
+   void publish(VersionedNode <T> * & pLink, VersionedNode <T> * pNode)
+   {
+      std::atomic_ref <VersionedNode <T> *> (pLink).store(pNode, std::memory_order_release);
+   }
+   VersionedNode <T> * first() const
+   {
+      return std::atomic_ref <VersionedNode <T> * const> (pHead).load(std::memory_order_acquire);
+   }
+   static VersionedNode <T> * next(const VersionedNode <T> * p)
+   {
+      return std::atomic_ref <VersionedNode <T> * const> (p->pNext).load(std::memory_order_acquire);
+   }
+
+   RCUDomain & domain;
+   std::atomic <uint64_t> clock;                       // last committed timestamp
+   std::atomic <uint64_t> snapshots[MAX_SNAPSHOTS];    // 0 is a free slot
+   std::mutex mutexWrite;                              // one writer at a time
+   VersionedNode <T> * pHead;
+
+   std::thread collector;
+   std::mutex mutexCollector;
+   std::condition_variable wakeCollector;
+   bool stopping;
+};
+
+/*************************************************
+ * MVCC SNAPSHOT
+ * The list as of one moment.  Walk it with
+ *    for (auto p = snap.first(); p; p = snap.next(p))
+ * Hold one only as long as the scan; old versions
+ * cannot be collected while it exists.
+ *************************************************/
+template <class T>
+class MVCCSnapshot
+{
+public:
+   MVCCSnapshot(MVCCList <T> & list);
+   MVCCSnapshot(const MVCCSnapshot &) = delete;
+   MVCCSnapshot & operator = (const MVCCSnapshot &) = delete;
+   ~MVCCSnapshot() { pSlot->store(0, std::memory_order_release); }
+
+   const VersionedNode <T> * first() const { return skip(list.first()); }
+   const VersionedNode <T> * next(const VersionedNode <T> * p) const { return skip(list.next(p)); }
+   uint64_t timestamp() const { return stamp; }
+   size_t size() const;
+
+private:
+   const VersionedNode <T> * skip(const VersionedNode <T> * p) const
+   {
+      while (p && !p->visible(stamp))
+         p = list.next(p);
+      return p;
+   }
+
+   MVCCList <T> & list;
+   RCUReader reader;                // keeps what we stand on from being freed
+   std::atomic <uint64_t> * pSlot;  // keeps what we can see from being collected
+   uint64_t stamp;
+};
+
+/***********************************************
+ * MVCC SNAPSHOT :: CONSTRUCTOR
+ * Claim a slot with a timestamp no newer than the one
+ * we read, then read it again after a fence.  If the
+ * collector missed our slot, that second read is at
+ * least as new as anything the collector kept.
+ **********************************************/
+template <class T>
+MVCCSnapshot <T> :: MVCCSnapshot(MVCCList <T> & list) :
+   list(list), reader(list.domain), pSlot(nullptr), stamp(0)
+{
+   uint64_t early = list.now();
+   for (auto & slot : list.snapshots)
+   {
+      uint64_t expected = 0;
+      if (slot.compare_exchange_strong(expected, early))
+      {
+         pSlot = &slot;
+         break;
+      }
+   }
+   assert(pSlot != nullptr);   // more than MAX_SNAPSHOTS at once
+   std::atomic_thread_fence(std::memory_order_seq_cst);
+   stamp = list.now();
+}
+
+/***********************************************
+ * MVCC SNAPSHOT :: SIZE
+ * How many nodes this snapshot sees
+ *   COST   : O(versions)
+ **********************************************/
+template <class T>
+size_t MVCCSnapshot <T> :: size() const
+{
+   size_t num = 0;
+   for (auto p = first(); p; p = next(p))
+      num++;
+   return num;
+}
+
+/***********************************************
+ * MVCC LIST :: CONSTRUCTOR / DESTRUCTOR
+ **********************************************/
+template <class T>
+MVCCList <T> :: MVCCList(RCUDomain & domain) :
+   domain(domain), clock(1), pHead(nullptr), stopping(false)
+{
+   for (auto & slot : snapshots)
+      slot.store(0, std::memory_order_relaxed);
+}
+
+template <class T>
+MVCCList <T> :: ~MVCCList()
+{
+   stopCollector();
+   domain.reclaim();
+   while (pHead)
+   {
+      VersionedNode <T> * pDelete = pHead;
+      pHead = pHead->pNext;
+      delete pDelete;
+   }
+}
+
+/***********************************************
+ * MVCC LIST :: LINK
+ * Put pNew in the chain next to pCurrent (or at the
+ * front).  The one store readers can see comes last.
+ **********************************************/
+template <class T>
+void MVCCList <T> :: link(VersionedNode <T> * pNew, VersionedNode <T> * pCurrent, bool after)
+{
+   if (pCurrent == nullptr)
+   {
+      pNew->pNext = pHead;
+      if (pHead)
+         pHead->pPrev = pNew;
+      publish(pHead, pNew);
+   }
+   else if (after)
+   {
+      pNew->pPrev = pCurrent;
+      pNew->pNext = pCurrent->pNext;
+      if (pCurrent->pNext)
+         pCurrent->pNext->pPrev = pNew;
+      publish(pCurrent->pNext, pNew);
+   }
+   else
+   {
+      pNew->pPrev = pCurrent->pPrev;
+      pNew->pNext = pCurrent;
+      pCurrent->pPrev = pNew;
+      publish(pNew->pPrev ? pNew->pPrev->pNext : pHead, pNew);
+   }
+}
+
+/***********************************************
+ * MVCC LIST :: INSERT
+ * A new node, visible from the next timestamp on
+ *   INPUT  : pCurrent - where, NULL for the front
+ *            t - the value
+ *            after - whether to go after pCurrent
+ *   OUTPUT : the new node
+ *   COST   : O(1)
+ **********************************************/
+template <class T>
+const VersionedNode <T> * MVCCList <T> :: insert(const VersionedNode <T> * pCurrent,
+                                                 const T & t, bool after)
+{
+   std::lock_guard <std::mutex> lock(mutexWrite);
+   uint64_t stamp = clock.load(std::memory_order_relaxed) + 1;
+
+   VersionedNode <T> * pNew = new VersionedNode <T>(t, stamp);
+   link(pNew, const_cast <VersionedNode <T> *> (pCurrent), after);
+
+   clock.store(stamp, std::memory_order_release);
+   return pNew;
+}
+
+/***********************************************
+ * MVCC LIST :: REMOVE
+ * End a node's lifetime.  It stays in the chain for
+ * the snapshots that can still see it.
+ *   COST   : O(1)
+ **********************************************/
+template <class T>
+void MVCCList <T> :: remove(const VersionedNode <T> * pRemove)
+{
+   if (pRemove == nullptr)
+      return;
+
+   std::lock_guard <std::mutex> lock(mutexWrite);
+   uint64_t stamp = clock.load(std::memory_order_relaxed) + 1;
+
+   auto p = const_cast <VersionedNode <T> *> (pRemove);
+   assert(p->end.load(std::memory_order_relaxed) == VersionedNode <T>::FOREVER);
+   p->end.store(stamp, std::memory_order_release);
+
+   clock.store(stamp, std::memory_order_release);
+}
+
+/***********************************************
+ * MVCC LIST :: UPDATE
+ * Replace a value: the old node ends and a new one
+ * begins at the same timestamp, so every snapshot
+ * sees exactly one of them
+ *   OUTPUT : the new node
+ *   COST   : O(1)
+ **********************************************/
+template <class T>
+const VersionedNode <T> * MVCCList <T> :: update(const VersionedNode <T> * pCurrent, const T & t)
+{
+   std::lock_guard <std::mutex> lock(mutexWrite);
+   uint64_t stamp = clock.load(std::memory_order_relaxed) + 1;
+
+   auto pOld = const_cast <VersionedNode <T> *> (pCurrent);
+   assert(pOld->end.load(std::memory_order_relaxed) == VersionedNode <T>::FOREVER);
+   VersionedNode <T> * pNew = new VersionedNode <T>(t, stamp);
+   link(pNew, pOld, true /* after */);
+   pOld->end.store(stamp, std::memory_order_release);
+
+   clock.store(stamp, std::memory_order_release);
+   return pNew;
+}
+
+/***********************************************
+ * MVCC LIST :: COLLECT
+ * Unlink every node that no snapshot, present or
+ * future, can see, and free them once no reader can
+ * be standing on them.  Never call it while this
+ * thread holds a snapshot: it would wait for itself.
+ *   OUTPUT : how many nodes were freed
+ *   COST   : O(versions) plus a grace period
+ **********************************************/
+template <class T>
+size_t MVCCList <T> :: collect()
+{
+   {
+      std::lock_guard <std::mutex> lock(mutexWrite);
+
+      // the oldest timestamp anybody can still be reading at
+      uint64_t horizon = clock.load(std::memory_order_acquire);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      for (auto & slot : snapshots)
+      {
+         uint64_t stamp = slot.load(std::memory_order_acquire);
+         if (stamp != 0 && stamp < horizon)
+            horizon = stamp;
+      }
+
+      for (VersionedNode <T> * p = pHead; p; )
+      {
+         VersionedNode <T> * pNext = p->pNext;
+         if (p->end.load(std::memory_order_relaxed) <= horizon)
+         {
+            if (p->pNext)
+               p->pNext->pPrev = p->pPrev;
+            publish(p->pPrev ? p->pPrev->pNext : pHead, p->pNext);
+            domain.retire(p, [](void * pDead) { delete static_cast <VersionedNode <T> *> (pDead); });
+         }
+         p = pNext;
+      }
+   }
+
+   // wait for the readers outside the lock so writers do not
+   return domain.reclaim();
+}
+
+/***********************************************
+ * MVCC LIST :: START COLLECTOR / STOP COLLECTOR
+ * Run collect() in the background every interval
+ **********************************************/
+template <class T>
+void MVCCList <T> :: startCollector(std::chrono::milliseconds interval)
+{
+   stopCollector();
+   stopping = false;
+   collector = std::thread([this, interval]()
+   {
+      std::unique_lock <std::mutex> lock(mutexCollector);
+      while (!wakeCollector.wait_for(lock, interval, [this]() { return stopping; }))
+      {
+         lock.unlock();
+         collect();
+         lock.lock();
+      }
+   });
+}
+
+template <class T>
+void MVCCList <T> :: stopCollector()
+{
+   if (!collector.joinable())
+      return;
+   {
+      std::lock_guard <std::mutex> lock(mutexCollector);
+      stopping = true;
+   }
+   wakeCollector.notify_all();
+   collector.join();
+}
+
+/***********************************************
+ * MVCC LIST :: NUM VERSIONS
+ * Every node in the chain, visible or not
+ *   COST   : O(versions)
+ **********************************************/
+template <class T>
+size_t MVCCList <T> :: numVersions()
+{
+   std::lock_guard <std::mutex> lock(mutexWrite);
+   size_t num = 0;
+   for (auto p = pHead; p; p = p->pNext)
+      num++;
+   return num;
+}
@@ -20,7 +20,10 @@
 #pragma once
 
 #include <cassert>     // for ASSERT
+#include <charconv>    // for std::to_chars
 #include <iostream>    // for NULL
+#include <locale>      // for std::locale
+#include <type_traits> // for std::is_arithmetic
 
 /*************************************************
  * NODE
@@ -222,6 +225,93 @@ inline size_t size(const Node <T> * pHead)
     return size(pHead->pNext) + 1;
 }
 
+/***********************************************
+ * IS FAST DISPLAY
+ * Numbers the stream would print the way to_chars
+ * does.  Characters and bool print as something
+ * else, so they are left to the stream.
+ **********************************************/
+template <class T>
+inline constexpr bool isFastDisplay =
+       std::is_arithmetic <T>::value
+   && !std::is_same <T, bool>::value
+   && !std::is_same <T, char>::value
+   && !std::is_same <T, signed char>::value
+   && !std::is_same <T, unsigned char>::value
+   && !std::is_same <T, wchar_t>::value
+   && !std::is_same <T, char8_t>::value
+   && !std::is_same <T, char16_t>::value
+   && !std::is_same <T, char32_t>::value;
+
+/***********************************************
+ * CAN DISPLAY FAST
+ * Is the stream set up the way it is out of the box,
+ * so that to_chars writes exactly what it would?
+ * Any width, base, sign, case, or locale of its own
+ * and the stream must do the formatting.
+ *    INPUT  : the output stream, and whether the
+ *             values are floating point
+ *    OUTPUT : true when to_chars can stand in for it
+ **********************************************/
+inline bool canDisplayFast(const std::ostream & out, bool isFloat)
+{
+   std::ios_base::fmtflags flags = out.flags();
+   std::ios_base::fmtflags base = flags & std::ios_base::basefield;
+
+   if (out.width() != 0)
+      return false;
+   if (base != std::ios_base::dec && base != std::ios_base::fmtflags(0))
+      return false;
+   if (flags & (std::ios_base::showpos | std::ios_base::showbase |
+                std::ios_base::showpoint | std::ios_base::uppercase))
+      return false;
+   if (isFloat && ((flags & std::ios_base::floatfield) || out.precision() < 0 || out.precision() > 64))
+      return false;
+   return out.getloc() == std::locale::classic();
+}
+
+/***********************************************
+ * DISPLAY FAST
+ * Display the list with to_chars into a buffer on the
+ * stack, writing the buffer to the stream each time
+ * it fills.  Floating point values use the general
+ * format at the stream's precision, as the stream does.
+ *    INPUT  : the output stream
+ *             pointer to the linked list
+ *    OUTPUT : the same characters operator << writes
+ *    COST   : O(n)
+ **********************************************/
+template <class T>
+std::ostream & displayFast(std::ostream & out, const Node <T> * pHead)
+{
+   const int MAX_VALUE = 128;             // longer than any one number and separator
+   char buffer[16384];
+   char * pOut = buffer;
+   char * const pEnd = buffer + sizeof(buffer);
+   const int precision = (int)out.precision();
+
+   for (const Node <T> * p = pHead; p; p = p->pNext)
+   {
+      if (pEnd - pOut < MAX_VALUE)
+      {
+         out.write(buffer, pOut - buffer);
+         pOut = buffer;
+      }
+      if (p != pHead)
+      {
+         *pOut++ = ',';
+         *pOut++ = ' ';
+      }
+      if constexpr (std::is_floating_point <T>::value)
+         pOut = std::to_chars(pOut, pEnd, p->data, std::chars_format::general, precision).ptr;
+      else
+         pOut = std::to_chars(pOut, pEnd, p->data).ptr;
+   }
+
+   out.write(buffer, pOut - buffer);
+   return out;
+}
+
 /***********************************************
  * DISPLAY
  * Display all the items in the linked list from here on back
@@ -233,14 +323,16 @@ inline size_t size(const Node <T> * pHead)
 template <class T>
 inline std::ostream & operator << (std::ostream & out, const Node <T> * pHead)
 {
-    // I don't think this contributes to our %
+    // numbers on a plain stream skip the stream's formatting
+    if constexpr (isFastDisplay <T>)
+        if (canDisplayFast(out, std::is_floating_point <T>::value))
+            return displayFast(out, pHead);
+
     for (auto p = pHead; p; p = p->pNext) {
-        if (p->pNext != nullptr) {
-            out << p->data << ", "; // comma separation in case there are multiple
-        }
-        else {
-            out << p->data; // if one value, just return 1
+        if (p != pHead) {
+            out << ", "; // comma separation in case there are multiple
         }
+        out << p->data;
     }
     return out;
 }
@@ -0,0 +1,494 @@
+/***********************************************************************
+ * Header:
+ *    PARALLEL
+ * Summary:
+ *    Parallel algorithms over a linked list.  A list has no middle to
+ *    split at, so one cheap pass finds evenly spaced chunk boundaries and
+ *    the chunks run on a work-stealing thread pool.  This pays off when
+ *    the work per element costs much more than following pNext.
+ *
+ *    This will contain the class definition of:
+ *        ThreadPool   : Worker threads that steal from each other
+ *    and the functions:
+ *        split                : Evenly spaced boundaries in one pass
+ *        parallelForEach      : f(data) on every node
+ *        parallelTransform    : data = op(data) on every node
+ *        parallelReduce       : Fold the list with an associative op
+ *        parallelCountIf      : Count the nodes that match
+ *        parallelCopy         : copy() with every thread copying a piece
+ *        parallelClear        : clear() with every thread freeing a piece
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell
+ ************************************************************************/
+
+#pragma once
+
+#include <algorithm>           // for std::for_each
+#include <atomic>              // for std::atomic
+#include <concepts>            // for std::convertible_to
+#include <condition_variable>  // for std::condition_variable
+#include <deque>               // for std::deque
+#include <exception>           // for std::exception_ptr
+#include <functional>          // for std::function
+#include <memory>              // for std::unique_ptr
+#include <mutex>               // for std::mutex
+#include <thread>              // for std::thread
+#include <type_traits>         // for std::is_invocable_r_v
+#include <vector>              // for std::vector
+#include "iterator.h"          // for NodeForwardIterator
+#include "node.h"              // for Node
+
+/*************************************************
+ * THREAD POOL
+ * Each thread has its own deque of tasks.  It works
+ * from the back of its own and, when that runs dry,
+ * steals from the front of somebody else's.  The
+ * thread that calls run() pitches in too.
+ *************************************************/
+class ThreadPool
+{
+public:
+   ThreadPool(unsigned numThreads = 0);
+   ThreadPool(const ThreadPool &) = delete;
+   ThreadPool & operator = (const ThreadPool &) = delete;
+   ~ThreadPool();
+
+   // how many threads work on a run(), counting the caller
+   unsigned size() const { return (unsigned)queues.size(); }
+
+   // call task(i) for every i in [0, numTasks) and wait for them all
+   template <class Task>
+   void run(size_t numTasks, Task task);
+
+private:
+   struct alignas(64) Queue
+   {
+      std::mutex mutex;
+      std::deque <std::function <void()>> tasks;
+   };
+
+   bool runOne(unsigned self);
+   void work(unsigned self);
+   unsigned whoAmI() const;
+
+   std::vector <std::unique_ptr <Queue>> queues;   // [0] belongs to callers
+   std::vector <std::thread> workers;
+   std::atomic <size_t> numQueued;
+   std::mutex mutexSleep;
+   std::condition_variable wake;
+   bool stop;
+};
+
+/***********************************************
+ * DEFAULT POOL
+ * One pool for everybody, sized to the machine
+ **********************************************/
+inline ThreadPool & defaultPool()
+{
+   static ThreadPool pool;
+   return pool;
+}
+
+/***********************************************
+ * THREAD POOL :: CONSTRUCTOR
+ * Start numThreads - 1 workers (the caller is the
+ * last one).  Zero means one per core.
+ **********************************************/
+inline ThreadPool :: ThreadPool(unsigned numThreads) : numQueued(0), stop(false)
+{
+   if (numThreads == 0)
+      numThreads = std::thread::hardware_concurrency();
+   if (numThreads == 0)
+      numThreads = 1;
+
+   for (unsigned i = 0; i < numThreads; i++)
+      queues.push_back(std::unique_ptr <Queue> (new Queue));
+   for (unsigned i = 1; i < numThreads; i++)
+      workers.emplace_back([this, i]() { work(i); });
+}
+
+/***********************************************
+ * THREAD POOL :: DESTRUCTOR
+ * Wake everybody up and wait for them to leave
+ **********************************************/
+inline ThreadPool :: ~ThreadPool()
+{
+   {
+      std::lock_guard <std::mutex> lock(mutexSleep);
+      stop = true;
+   }
+   wake.notify_all();
+   for (auto & worker : workers)
+      worker.join();
+}
+
+/***********************************************
+ * THREAD POOL :: WHO AM I
+ * The queue that belongs to this thread: a worker's
+ * own, or 0 for anybody from outside the pool
+ **********************************************/
+inline unsigned ThreadPool :: whoAmI() const
+{
+   static thread_local const ThreadPool * pPool = nullptr;
+   static thread_local unsigned self = 0;
+   if (pPool != this)
+   {
+      pPool = this;
+      self = 0;
+      std::thread::id id = std::this_thread::get_id();
+      for (unsigned i = 0; i < workers.size(); i++)
+         if (workers[i].get_id() == id)
+            self = i + 1;
+   }
+   return self;
+}
+
+/***********************************************
+ * THREAD POOL :: RUN ONE
+ * Take one task from our own queue or steal one
+ *   INPUT  : our queue
+ *   OUTPUT : false if there was nothing to do
+ **********************************************/
+inline bool ThreadPool :: runOne(unsigned self)
+{
+   std::function <void()> task;
+
+   for (unsigned i = 0; i < queues.size() && !task; i++)
+   {
+      Queue & queue = *queues[(self + i) % queues.size()];
+      std::lock_guard <std::mutex> lock(queue.mutex);
+      if (queue.tasks.empty())
+         continue;
+      if (i == 0)
+      {
+         task = std::move(queue.tasks.back());
+         queue.tasks.pop_back();
+      }
+      else
+      {
+         task = std::move(queue.tasks.front());
+         queue.tasks.pop_front();
+      }
+   }
+
+   if (!task)
+      return false;
+   numQueued--;
+   task();
+   return true;
+}
+
+/***********************************************
+ * THREAD POOL :: WORK
+ * What a worker does until the pool goes away
+ **********************************************/
+inline void ThreadPool :: work(unsigned self)
+{
+   for (;;)
+   {
+      if (runOne(self))
+         continue;
+
+      std::unique_lock <std::mutex> lock(mutexSleep);
+      wake.wait(lock, [this]() { return stop || numQueued > 0; });
+      if (stop)
+         return;
+   }
+}
+
+/***********************************************
+ * THREAD POOL :: RUN
+ * Deal the tasks out round robin, then help until
+ * every one of them is done.  Safe to call from
+ * inside a task.  The first exception a task throws
+ * is thrown again here.
+ *   INPUT  : how many tasks, and task(i) to run them
+ *   COST   : O(numTasks / size()) if they balance
+ **********************************************/
+template <class Task>
+void ThreadPool :: run(size_t numTasks, Task task)
+{
+   if (numTasks == 0)
+      return;
+
+   std::atomic <size_t> numLeft(numTasks);
+   std::exception_ptr error;
+   std::mutex mutexError;
+   unsigned self = whoAmI();
+
+   for (size_t i = 0; i < numTasks; i++)
+   {
+      Queue & queue = *queues[(self + i) % queues.size()];
+      std::lock_guard <std::mutex> lock(queue.mutex);
+      queue.tasks.push_back([&, i]()
+      {
+         try
+         {
+            task(i);
+         }
+         catch (...)
+         {
+            std::lock_guard <std::mutex> lockError(mutexError);
+            if (!error)
+               error = std::current_exception();
+         }
+         numLeft--;
+      });
+      numQueued++;
+   }
+   {
+      std::lock_guard <std::mutex> lock(mutexSleep);
+   }
+   wake.notify_all();
+
+   while (numLeft > 0)
+      if (!runOne(self))
+         std::this_thread::yield();
+
+   if (error)
+      std::rethrow_exception(error);
+}
+
+/***********************************************
+ * SPLIT
+ * Find up to numChunks evenly spaced nodes in one
+ * pass without knowing the size up front.  Keep a
+ * boundary every "stride" nodes; whenever there are
+ * too many, double the stride and drop every other.
+ *   INPUT  : the list and how many chunks we want
+ *   OUTPUT : the first node of each chunk; a chunk
+ *            ends where the next one starts
+ *   COST   : O(n) pointer chasing, O(numChunks) space
+ **********************************************/
+template <class T>
+std::vector <Node <T> *> split(Node <T> * pHead, size_t numChunks)
+{
+   std::vector <Node <T> *> starts;
+   if (numChunks == 0)
+      numChunks = 1;
+
+   size_t stride = 1;
+   size_t index = 0;
+   for (Node <T> * p = pHead; p; p = p->pNext, index++)
+   {
+      if (index % stride)
+         continue;
+      if (starts.size() == 2 * numChunks)
+      {
+         for (size_t i = 0; i < numChunks; i++)
+            starts[i] = starts[2 * i];
+         starts.resize(numChunks);
+         stride *= 2;
+         if (index % stride)
+            continue;
+      }
+      starts.push_back(p);
+   }
+
+   // pair up the leftovers so we end with at most numChunks
+   if (starts.size() > numChunks)
+   {
+      size_t step = (starts.size() + numChunks - 1) / numChunks;
+      std::vector <Node <T> *> fewer;
+      for (size_t i = 0; i < starts.size(); i += step)
+         fewer.push_back(starts[i]);
+      starts.swap(fewer);
+   }
+   return starts;
+}
+
+/***********************************************
+ * CHUNKS PER THREAD
+ * More chunks than threads gives thieves something
+ * to steal when one chunk is slower than the rest
+ **********************************************/
+inline size_t numChunksFor(const ThreadPool & pool)
+{
+   return pool.size() == 1 ? 1 : pool.size() * 8;
+}
+
+/***********************************************
+ * PARALLEL FOR EACH
+ * Call f(data) for every node in the list.  The order
+ * is unspecified, so f must be safe to run at the same
+ * time on different nodes.
+ *   INPUT  : the list, f, and where to run it
+ *   COST   : O(n / threads) + O(n) to split
+ **********************************************/
+template <class T, class F>
+void parallelForEach(Node <T> * pHead, F f, ThreadPool & pool = defaultPool())
+{
+   std::vector <Node <T> *> starts = split(pHead, numChunksFor(pool));
+   pool.run(starts.size(), [&](size_t i)
+   {
+      Node <T> * pEnd = (i + 1 < starts.size() ? starts[i + 1] : nullptr);
+      std::for_each(NodeForwardIterator <T>(starts[i]), NodeForwardIterator <T>(pEnd), std::ref(f));
+   });
+}
+
+/***********************************************
+ * PARALLEL TRANSFORM
+ * Replace every value with op(value), in place
+ *   INPUT  : the list, op, and where to run it
+ *   COST   : O(n / threads) + O(n) to split
+ **********************************************/
+template <class T, class Op>
+void parallelTransform(Node <T> * pHead, Op op, ThreadPool & pool = defaultPool())
+{
+   parallelForEach(pHead, [&op](T & t) { t = op(t); }, pool);
+}
+
+/***********************************************
+ * PARALLEL REDUCE
+ * init op d0 op d1 op ... op dn.  Each chunk is folded
+ * on its own, starting from its first value, and the
+ * chunks are combined in order, so op must be
+ * associative but need not be commutative.  Both the
+ * values and the partial results go through op, so it
+ * must take two Us and the values must convert to U;
+ * a fold like U(U, T) is refused rather than folded
+ * wrong.
+ *   INPUT  : the list, the starting value, op, and
+ *            where to run it
+ *   OUTPUT : the folded value
+ *   COST   : O(n / threads) + O(n) to split
+ **********************************************/
+template <class T, class U, class Op>
+   requires std::convertible_to <const T &, U> && std::is_invocable_r_v <U, Op &, const U &, const U &>
+U parallelReduce(const Node <T> * pHead, U init, Op op, ThreadPool & pool = defaultPool())
+{
+   std::vector <Node <T> *> starts = split(const_cast <Node <T> *> (pHead), numChunksFor(pool));
+   std::vector <std::unique_ptr <U>> partial(starts.size());
+
+   pool.run(starts.size(), [&](size_t i)
+   {
+      const Node <T> * pEnd = (i + 1 < starts.size() ? starts[i + 1] : nullptr);
+      const Node <T> * p = starts[i];
+      U value = U(p->data);
+      for (p = p->pNext; p != pEnd; p = p->pNext)
+         value = op(value, p->data);
+      partial[i].reset(new U(std::move(value)));
+   });
+
+   for (auto & value : partial)
+      init = op(init, *value);
+   return init;
+}
+
+/***********************************************
+ * PARALLEL COUNT IF
+ * How many nodes hold a value that pred accepts
+ *   INPUT  : the list, pred, and where to run it
+ *   OUTPUT : the count
+ *   COST   : O(n / threads) + O(n) to split
+ **********************************************/
+template <class T, class Pred>
+size_t parallelCountIf(const Node <T> * pHead, Pred pred, ThreadPool & pool = defaultPool())
+{
+   std::vector <Node <T> *> starts = split(const_cast <Node <T> *> (pHead), numChunksFor(pool));
+   std::vector <size_t> counts(starts.size(), 0);
+
+   pool.run(starts.size(), [&](size_t i)
+   {
+      const Node <T> * pEnd = (i + 1 < starts.size() ? starts[i + 1] : nullptr);
+      counts[i] = std::count_if(NodeForwardIterator <const T>(starts[i]), NodeForwardIterator <const T>(pEnd),
+                                std::ref(pred));
+   });
+
+   size_t total = 0;
+   for (size_t count : counts)
+      total += count;
+   return total;
+}
+
+/***********************************************
+ * PARALLEL COPY
+ * Copy the list from pSource and return the new list,
+ * just like copy() in node.h.  Every chunk is copied by
+ * one thread into a list of its own, allocating from
+ * that thread's heap arena, and then the chunks are
+ * stitched together with one link per chunk.  The new
+ * list is ordinary: clear() frees it.
+ *   INPUT  : the list to be copied and where to run it
+ *   OUTPUT : return the new list
+ *   COST   : O(n / threads) + O(n) to split
+ **********************************************/
+template <class T>
+Node <T> * parallelCopy(const Node <T> * pSource, ThreadPool & pool = defaultPool())
+{
+   std::vector <Node <T> *> starts = split(const_cast <Node <T> *> (pSource), numChunksFor(pool));
+   std::vector <Node <T> *> heads(starts.size(), nullptr);
+   std::vector <Node <T> *> tails(starts.size(), nullptr);
+
+   try
+   {
+      pool.run(starts.size(), [&](size_t i)
+      {
+         const Node <T> * pEnd = (i + 1 < starts.size() ? starts[i + 1] : nullptr);
+         try
+         {
+            for (const Node <T> * p = starts[i]; p != pEnd; p = p->pNext)
+            {
+               tails[i] = insert(tails[i], p->data, true /* after */);
+               if (heads[i] == nullptr)
+                  heads[i] = tails[i];
+            }
+         }
+         catch (...)
+         {
+            clear(heads[i]);
+            throw;
+         }
+      });
+   }
+   catch (...)
+   {
+      for (auto & pHead : heads)
+         clear(pHead);
+      throw;
+   }
+
+   // stitch the chunks together
+   for (size_t i = 1; i < heads.size(); i++)
+   {
+      tails[i - 1]->pNext = heads[i];
+      heads[i]->pPrev = tails[i - 1];
+   }
+   return heads.empty() ? nullptr : heads[0];
+}
+
+/*****************************************************
+ * PARALLEL CLEAR
+ * Free all the data in the linked list, every thread
+ * destroying one chunk.  Worth it when T has a costly
+ * destructor; the split itself is one pass.
+ *   INPUT   : pointer to the head of the linked list
+ *             and where to run it
+ *   OUTPUT  : pHead set to NULL, the number freed
+ *   COST    : O(n / threads) + O(n) to split
+ ****************************************************/
+template <class T>
+size_t parallelClear(Node <T> * & pHead, ThreadPool & pool = defaultPool())
+{
+   std::vector <Node <T> *> starts = split(pHead, numChunksFor(pool));
+   std::vector <size_t> counts(starts.size(), 0);
+   pHead = nullptr;
+
+   pool.run(starts.size(), [&](size_t i)
+   {
+      Node <T> * pEnd = (i + 1 < starts.size() ? starts[i + 1] : nullptr);
+      Node <T> * p = starts[i];
+      while (p != pEnd)
+      {
+         Node <T> * pDelete = p;
+         p = p->pNext;
+         delete pDelete;
+         counts[i]++;
+      }
+   });
+
+   size_t total = 0;
+   for (size_t count : counts)
+      total += count;
+   return total;
+}
@@ -0,0 +1,262 @@
+/***********************************************************************
+ * Header:
+ *    PARSE
+ * Summary:
+ *    Build a list of numbers from text in the form operator << writes:
+ *       11, 26, 31
+ *    Values are read with from_chars, straight out of big buffers, and
+ *    the nodes come from a NodePool, so there is no stream formatting
+ *    and no call to new for each value.  A large block of text can be
+ *    split at commas and the pieces parsed on different threads, each
+ *    into a pool of its own; the pieces are then spliced together and
+ *    the pools merged, both in O(pieces).
+ *
+ *    This will contain the class definition of:
+ *        ParseError    : What text that is not a list throws
+ *    and the functions:
+ *        parse         : A list from a string or a stream
+ *        parallelParse : A list from a string, on a thread pool
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell
+ ************************************************************************/
+
+#pragma once
+
+#include <algorithm>   // for std::min
+#include <charconv>    // for std::from_chars
+#include <cstring>     // for memmove
+#include <istream>     // for std::istream
+#include <memory>      // for std::unique_ptr
+#include <stdexcept>   // for std::runtime_error
+#include <string>      // for std::string
+#include <string_view> // for std::string_view
+#include <vector>      // for std::vector
+#include "node.h"      // for Node
+#include "parallel.h"  // for ThreadPool
+#include "pool.h"      // for NodePool
+
+/*************************************************
+ * PARSE ERROR
+ * Text that is not a list of T, and how far into
+ * it the trouble is
+ *************************************************/
+class ParseError : public std::runtime_error
+{
+public:
+   ParseError(const std::string & what, size_t position) :
+      std::runtime_error(what + " at offset " + std::to_string(position)), where(position) { }
+
+   size_t position() const { return where; }
+
+private:
+   size_t where;
+};
+
+/***********************************************
+ * SKIP SPACE
+ * Past any blanks and line breaks
+ *   INPUT  : the text
+ *   OUTPUT : the first character that is not one
+ **********************************************/
+inline const char * skipSpace(const char * p, const char * pLast)
+{
+   while (p != pLast && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+      p++;
+   return p;
+}
+
+/***********************************************
+ * PARSE VALUES
+ * Append the values in the text to the end of a list.
+ * Text with nothing in it is fine only when a value
+ * is not required.
+ *   INPUT  : the text, the pool for the nodes, the
+ *            list, whether there must be a value,
+ *            and where the text starts in the whole
+ *            input, for errors
+ *   OUTPUT : pHead and pTail grown by the values
+ *   COST   : O(n)
+ **********************************************/
+template <class T>
+void parseValues(const char * pFirst, const char * pLast, NodePool <T> & pool,
+                 Node <T> * & pHead, Node <T> * & pTail, bool required, size_t base)
+{
+   static_assert(isFastDisplay <T>, "parse reads numbers; build other lists with insert()");
+
+   const char * p = skipSpace(pFirst, pLast);
+   if (p == pLast && !required)
+      return;
+
+   for (;;)
+   {
+      T value;
+      std::from_chars_result result = std::from_chars(p, pLast, value);
+      if (result.ec == std::errc::result_out_of_range)
+         throw ParseError("parse: value out of range", base + (p - pFirst));
+      if (result.ec != std::errc())
+         throw ParseError("parse: expected a number", base + (p - pFirst));
+
+      Node <T> * pNode = pool.acquire(value);
+      pNode->pPrev = pTail;
+      if (pTail)
+         pTail->pNext = pNode;
+      else
+         pHead = pNode;
+      pTail = pNode;
+
+      p = skipSpace(result.ptr, pLast);
+      if (p == pLast)
+         return;
+      if (*p != ',')
+         throw ParseError("parse: expected a comma", base + (p - pFirst));
+      p = skipSpace(p + 1, pLast);
+   }
+}
+
+/***********************************************
+ * PARSE
+ * A list from text already in memory
+ *   INPUT  : the text, and the pool for the nodes
+ *   OUTPUT : the head of the new list, from the pool
+ *   COST   : O(n)
+ **********************************************/
+template <class T>
+Node <T> * parse(std::string_view text, NodePool <T> & pool)
+{
+   Node <T> * pHead = nullptr;
+   Node <T> * pTail = nullptr;
+   try
+   {
+      parseValues(text.data(), text.data() + text.size(), pool, pHead, pTail, false, 0);
+   }
+   catch (...)
+   {
+      pool.clear(pHead);
+      throw;
+   }
+   return pHead;
+}
+
+/***********************************************
+ * PARSE
+ * A list from a stream, read a buffer at a time.
+ * Each buffer is parsed up to its last comma and the
+ * rest is carried to the front of the next one.
+ *   INPUT  : the stream, the pool for the nodes, and
+ *            how much to read at once
+ *   OUTPUT : the head of the new list, from the pool
+ *   COST   : O(n)
+ **********************************************/
+template <class T>
+Node <T> * parse(std::istream & in, NodePool <T> & pool, size_t bufferSize = 1 << 20)
+{
+   std::vector <char> buffer(bufferSize < 64 ? 64 : bufferSize);
+   size_t numCarried = 0;          // bytes at the front left from last time
+   size_t numDone = 0;             // bytes before the buffer
+   Node <T> * pHead = nullptr;
+   Node <T> * pTail = nullptr;
+
+   try
+   {
+      for (;;)
+      {
+         // a single value longer than the whole buffer
+         if (numCarried == buffer.size())
+            buffer.resize(buffer.size() * 2);
+
+         in.read(buffer.data() + numCarried, buffer.size() - numCarried);
+         size_t num = numCarried + in.gcount();
+         const char * pData = buffer.data();
+
+         // the end: what is left had better be a value, unless
+         // there was nothing at all
+         if (!in)
+         {
+            parseValues(pData, pData + num, pool, pHead, pTail, numDone != 0, numDone);
+            break;
+         }
+
+         const char * pComma = pData + num;
+         while (pComma != pData && pComma[-1] != ',')
+            pComma--;
+         if (pComma == pData)
+         {
+            numCarried = num;
+            continue;
+         }
+
+         parseValues(pData, pComma - 1, pool, pHead, pTail, true, numDone);
+         numCarried = pData + num - pComma;
+         numDone += pComma - pData;
+         memmove(buffer.data(), pComma, numCarried);
+      }
+   }
+   catch (...)
+   {
+      pool.clear(pHead);
+      throw;
+   }
+   return pHead;
+}
+
+/***********************************************
+ * PARALLEL PARSE
+ * A list from text in memory, in pieces.  The text
+ * is cut just after a comma near each even split,
+ * every piece is parsed into a pool of its own, and
+ * then the pieces are joined in order and the pools
+ * handed to the caller's.
+ *   INPUT  : the text, the pool for the nodes, and
+ *            where to run it
+ *   OUTPUT : the head of the new list, from the pool
+ *   COST   : O(n / threads) + O(pieces)
+ **********************************************/
+template <class T>
+Node <T> * parallelParse(std::string_view text, NodePool <T> & pool, ThreadPool & threads = defaultPool())
+{
+   const size_t MIN_PIECE = 1 << 16;           // not worth a task for less
+   size_t numPieces = std::min(numChunksFor(threads), text.size() / MIN_PIECE);
+   if (numPieces <= 1)
+      return parse(text, pool);
+
+   // cut: piece i is text[starts[i], ends[i])
+   std::vector <size_t> starts(1, 0);
+   std::vector <size_t> ends;
+   for (size_t i = 1; i < numPieces; i++)
+   {
+      size_t comma = text.find(',', std::max(i * text.size() / numPieces, starts.back()));
+      if (comma == std::string_view::npos)
+         break;
+      ends.push_back(comma);
+      starts.push_back(comma + 1);
+   }
+   ends.push_back(text.size());
+
+   // parse
+   struct Piece
+   {
+      std::unique_ptr <NodePool <T>> pool;
+      Node <T> * pHead = nullptr;
+      Node <T> * pTail = nullptr;
+   };
+   std::vector <Piece> pieces(starts.size());
+   threads.run(pieces.size(), [&](size_t i)
+   {
+      pieces[i].pool.reset(new NodePool <T>(4096));
+      parseValues(text.data() + starts[i], text.data() + ends[i], *pieces[i].pool,
+                  pieces[i].pHead, pieces[i].pTail, true, starts[i]);
+   });
+
+   // splice
+   Node <T> * pHead = pieces[0].pHead;
+   for (size_t i = 0; i < pieces.size(); i++)
+   {
+      if (i + 1 < pieces.size())
+      {
+         pieces[i].pTail->pNext = pieces[i + 1].pHead;
+         pieces[i + 1].pHead->pPrev = pieces[i].pTail;
+      }
+      pool.adopt(*pieces[i].pool);
+   }
+   return pHead;
+}
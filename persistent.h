@@ -0,0 +1,509 @@
+/***********************************************************************
+ * Header:
+ *    PERSISTENT
+ * Summary:
+ *    An immutable list where every change makes a new version and the
+ *    old versions stay valid.  Versions share every cell they have in
+ *    common, so keeping a version costs the size of the change, not the
+ *    size of the list.
+ *
+ *    A version is a prefix stack for prepend, in front of a real-time
+ *    queue (Hood and Melville, as in Okasaki) for append and drop-front.
+ *    The queue is a front stack, in order, and a rear stack, reversed.
+ *    When the rear outgrows the front, the two are rotated into a new
+ *    front a couple of cells per operation, so no single call turns a
+ *    long rear around.  Every change makes at most five cells and
+ *    nothing is cached on shared cells: versions that branch off the
+ *    same ancestor each pay only for their own few steps.
+ *
+ *    A TransientList builds a version in place, without a new version
+ *    object per step, and is frozen into a PersistentList when done.
+ *
+ *    This will contain the class definition of:
+ *        PersistentList : One version of an immutable list
+ *        TransientList  : A mutable builder for a PersistentList
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell
+ ************************************************************************/
+
+#pragma once
+
+#include <atomic>      // for std::atomic
+#include <cassert>     // for ASSERT
+#include <utility>     // for std::swap
+#include <vector>      // for std::vector
+#include "node.h"      // for Node
+
+template <class T>
+class TransientList;
+
+/*************************************************
+ * PERSISTENT LIST
+ * One version of a list.  Copying a version is O(1);
+ * versions may be shared between threads.
+ *************************************************/
+template <class T>
+class PersistentList
+{
+   friend class TransientList <T>;
+
+   // a singly linked cell shared by every version that contains it
+   struct Cell
+   {
+      Cell(const T & data) : data(data), pNext(nullptr), refs(1) { }
+      T data;
+      const Cell * pNext;
+      mutable std::atomic <size_t> refs;
+   };
+
+   // one counted reference to a chain of cells
+   class Chain
+   {
+   public:
+      Chain() : p(nullptr) { }
+      explicit Chain(const Cell * p) : p(p) { }   // takes over a reference
+      Chain(const Chain & rhs) : p(acquire(rhs.p)) { }
+      Chain(Chain && rhs) noexcept : p(rhs.p) { rhs.p = nullptr; }
+      ~Chain() { release(p); }
+      Chain & operator = (Chain rhs) noexcept
+      {
+         std::swap(p, rhs.p);
+         return *this;
+      }
+
+      const Cell * get() const { return p;       }
+      const T & top()    const { return p->data; }
+      Chain next()       const { return Chain(acquire(p->pNext)); }
+      Chain push(const T & t) const;
+      const Cell * detach()
+      {
+         const Cell * pOld = p;
+         p = nullptr;
+         return pOld;
+      }
+
+   private:
+      const Cell * p;
+   };
+
+   // where the queue is in turning its rear into a new front
+   enum Rotation { IDLE, REVERSING, APPENDING, DONE };
+
+public:
+   //
+   // Construct
+   //
+   PersistentList() : numPrefix(0), numFront(0), numRear(0), rotation(IDLE), numValid(0) { }
+
+   //
+   // New versions
+   //
+   PersistentList pushFront(const T & t) const;
+   PersistentList pushBack(const T & t) const;
+   PersistentList popFront() const;
+
+   //
+   // Read
+   //
+   const T & front() const;
+   size_t size() const { return numPrefix + numFront + numRear; }
+   bool empty()  const { return size() == 0;                    }
+   template <class F>
+   void forEach(F f) const;
+
+   //
+   // To and from node.h lists
+   //
+   Node <T> * toNodes() const;
+   static PersistentList fromNodes(const Node <T> * pHead);
+
+private:
+   static const Cell * acquire(const Cell * p)
+   {
+      if (p)
+         p->refs.fetch_add(1, std::memory_order_relaxed);
+      return p;
+   }
+   static void release(const Cell * p);
+
+   void check();
+   void step();
+   void invalidate();
+
+   Chain prefix;          // prepended since, first one first
+   Chain queueFront;      // the queue's first elements, in order
+   Chain queueRear;       // the queue's last elements, last one first
+   size_t numPrefix;
+   size_t numFront;       // includes whatever a rotation is bringing in
+   size_t numRear;
+
+   // a rotation of an old front F and rear R into F ++ reverse(R)
+   Rotation rotation;
+   size_t numValid;       // cells of F that are still in the list
+   Chain turnFront;       // REVERSING: what is left of F
+   Chain turnFrontBack;   // F so far, backwards
+   Chain turnRear;        // REVERSING: what is left of R
+   Chain turnResult;      // the new front, built from the back
+};
+
+/***********************************************
+ * PERSISTENT LIST :: RELEASE
+ * Drop one reference to a chain, freeing every cell
+ * nobody else is using.  A loop, not recursion, so a
+ * long chain cannot blow the stack.
+ **********************************************/
+template <class T>
+void PersistentList <T> :: release(const Cell * p)
+{
+   while (p && p->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+   {
+      const Cell * pNext = p->pNext;
+      delete p;
+      p = pNext;
+   }
+}
+
+/***********************************************
+ * PERSISTENT LIST :: CHAIN :: PUSH
+ * A chain with t on top of this one.  The cell is
+ * made before the link is taken, so a throwing copy
+ * of t leaves every count where it was.
+ *   COST   : O(1), one new cell
+ **********************************************/
+template <class T>
+typename PersistentList <T>::Chain PersistentList <T> :: Chain :: push(const T & t) const
+{
+   Cell * pCell = new Cell(t);
+   pCell->pNext = acquire(p);
+   return Chain(pCell);
+}
+
+/***********************************************
+ * PERSISTENT LIST :: STEP
+ * One step of the rotation: move a cell of F and a
+ * cell of R while reversing, then put the cells of F
+ * still in the list on top of reverse(R)
+ *   COST   : O(1), at most two new cells
+ **********************************************/
+template <class T>
+void PersistentList <T> :: step()
+{
+   if (rotation == REVERSING)
+   {
+      if (turnFront.get())
+      {
+         turnFrontBack = turnFrontBack.push(turnFront.top());
+         turnFront = turnFront.next();
+         numValid++;
+      }
+      else
+      {
+         assert(turnRear.get() && turnRear.get()->pNext == nullptr);
+         rotation = APPENDING;
+      }
+      turnResult = turnResult.push(turnRear.top());
+      turnRear = turnRear.next();
+   }
+   else if (rotation == APPENDING)
+   {
+      if (numValid == 0)
+         rotation = DONE;
+      else
+      {
+         turnResult = turnResult.push(turnFrontBack.top());
+         turnFrontBack = turnFrontBack.next();
+         numValid--;
+      }
+   }
+}
+
+/***********************************************
+ * PERSISTENT LIST :: INVALIDATE
+ * The queue's first element is gone; make sure the
+ * rotation does not bring it back
+ *   COST   : O(1)
+ **********************************************/
+template <class T>
+void PersistentList <T> :: invalidate()
+{
+   if (rotation == REVERSING)
+   {
+      assert(numValid > 0);
+      numValid--;
+   }
+   else if (rotation == APPENDING)
+   {
+      if (numValid == 0)
+      {
+         turnResult = turnResult.next();
+         rotation = DONE;
+      }
+      else
+         numValid--;
+   }
+}
+
+/***********************************************
+ * PERSISTENT LIST :: CHECK
+ * Start a rotation once the rear is longer than the
+ * front, and move any rotation along by two steps,
+ * which is enough for it to finish before the front
+ * runs out
+ *   COST   : O(1), at most four new cells
+ **********************************************/
+template <class T>
+void PersistentList <T> :: check()
+{
+   if (numRear > numFront)
+   {
+      assert(rotation == IDLE);
+      rotation = REVERSING;
+      numValid = 0;
+      turnFront = queueFront;
+      turnRear = std::move(queueRear);
+      numFront += numRear;
+      numRear = 0;
+   }
+
+   step();
+   step();
+
+   if (rotation == DONE)
+   {
+      queueFront = std::move(turnResult);
+      turnFrontBack = Chain();
+      rotation = IDLE;
+   }
+}
+
+/***********************************************
+ * PERSISTENT LIST :: PUSH FRONT / PUSH BACK
+ * A version with one more element
+ *   COST   : O(1), one new cell in front, at most
+ *            five in back
+ **********************************************/
+template <class T>
+PersistentList <T> PersistentList <T> :: pushFront(const T & t) const
+{
+   PersistentList list(*this);
+   list.prefix = prefix.push(t);
+   list.numPrefix++;
+   return list;
+}
+
+template <class T>
+PersistentList <T> PersistentList <T> :: pushBack(const T & t) const
+{
+   PersistentList list(*this);
+   list.queueRear = queueRear.push(t);
+   list.numRear++;
+   list.check();
+   return list;
+}
+
+/***********************************************
+ * PERSISTENT LIST :: POP FRONT
+ * A version without the first element
+ *   COST   : O(1), at most four new cells
+ **********************************************/
+template <class T>
+PersistentList <T> PersistentList <T> :: popFront() const
+{
+   assert(!empty());
+   PersistentList list(*this);
+   if (numPrefix)
+   {
+      list.prefix = prefix.next();
+      list.numPrefix--;
+      return list;
+   }
+
+   list.queueFront = queueFront.next();
+   list.numFront--;
+   list.invalidate();
+   list.check();
+   return list;
+}
+
+/***********************************************
+ * PERSISTENT LIST :: FRONT
+ * The first element
+ *   COST   : O(1)
+ **********************************************/
+template <class T>
+const T & PersistentList <T> :: front() const
+{
+   assert(!empty());
+   return numPrefix ? prefix.top() : queueFront.top();
+}
+
+/***********************************************
+ * PERSISTENT LIST :: FOR EACH
+ * Call f(data) on every element in order: the prefix,
+ * the front, the part of a rotation that is R, then
+ * the rear backwards
+ *   COST   : O(n), plus O(rear) space
+ **********************************************/
+template <class T>
+template <class F>
+void PersistentList <T> :: forEach(F f) const
+{
+   for (const Cell * p = prefix.get(); p; p = p->pNext)
+      f(p->data);
+
+   size_t numSeen = 0;
+   for (const Cell * p = queueFront.get(); p; p = p->pNext, numSeen++)
+      f(p->data);
+
+   std::vector <const Cell *> back;
+   if (rotation == REVERSING)
+   {
+      // reverse(R) is what is left of R backwards, then what is done
+      for (const Cell * p = turnRear.get(); p; p = p->pNext)
+         back.push_back(p);
+      for (auto it = back.rbegin(); it != back.rend(); ++it)
+         f((*it)->data);
+      for (const Cell * p = turnResult.get(); p; p = p->pNext)
+         f(p->data);
+      back.clear();
+   }
+   else if (rotation == APPENDING)
+   {
+      // reverse(R) is under the cells of F already put back
+      size_t numSkip = 0;
+      for (const Cell * p = turnResult.get(); p; p = p->pNext)
+         numSkip++;
+      numSkip -= numFront - numSeen;
+      for (const Cell * p = turnResult.get(); p; p = p->pNext)
+         if (numSkip)
+            numSkip--;
+         else
+            f(p->data);
+   }
+
+   back.reserve(numRear);
+   for (const Cell * p = queueRear.get(); p; p = p->pNext)
+      back.push_back(p);
+   for (auto it = back.rbegin(); it != back.rend(); ++it)
+      f((*it)->data);
+}
+
+/***********************************************
+ * PERSISTENT LIST :: TO NODES
+ * A node.h list holding this version's elements
+ *   OUTPUT : a new list; the caller must clear() it
+ *   COST   : O(n)
+ **********************************************/
+template <class T>
+Node <T> * PersistentList <T> :: toNodes() const
+{
+   Node <T> * pHead = nullptr;
+   Node <T> * pTail = nullptr;
+   forEach([&](const T & t)
+   {
+      pTail = insert(pTail, t, true /* after */);
+      if (pHead == nullptr)
+         pHead = pTail;
+   });
+   return pHead;
+}
+
+/***********************************************
+ * PERSISTENT LIST :: FROM NODES
+ * A version holding the elements of a node.h list
+ *   COST   : O(n)
+ **********************************************/
+template <class T>
+PersistentList <T> PersistentList <T> :: fromNodes(const Node <T> * pHead)
+{
+   TransientList <T> builder;
+   for (const Node <T> * p = pHead; p; p = p->pNext)
+      builder.pushBack(p->data);
+   return builder.persistent();
+}
+
+/*************************************************
+ * TRANSIENT LIST
+ * Builds a version by changing it in place.  Appends
+ * to cells the builder made itself go straight on the
+ * end of the front; nothing is shared until persistent()
+ * freezes it.  A builder belongs to one thread.
+ *************************************************/
+template <class T>
+class TransientList
+{
+   typedef typename PersistentList <T>::Cell  Cell;
+   typedef typename PersistentList <T>::Chain Chain;
+
+public:
+   //
+   // Construct, empty or from an existing version
+   //
+   TransientList() : pTail(nullptr) { }
+   TransientList(const PersistentList <T> & base) : version(base), pTail(nullptr) { }
+   TransientList(const TransientList &) = delete;
+   TransientList & operator = (const TransientList &) = delete;
+
+   //
+   // Change in place
+   //
+   void pushFront(const T & t);
+   void pushBack(const T & t);
+
+   //
+   // Freeze; the builder starts over empty
+   //
+   PersistentList <T> persistent()
+   {
+      PersistentList <T> done;
+      std::swap(done, version);
+      pTail = nullptr;
+      return done;
+   }
+
+   size_t size() const { return version.size(); }
+
+private:
+   PersistentList <T> version;   // what we have so far
+   Cell * pTail;                 // the last front cell, when only we can see it
+};
+
+/***********************************************
+ * TRANSIENT LIST :: PUSH FRONT
+ * Put t first
+ *   COST   : O(1)
+ **********************************************/
+template <class T>
+void TransientList <T> :: pushFront(const T & t)
+{
+   Cell * pCell = new Cell(t);
+   pCell->pNext = version.prefix.detach();   // takes over our reference
+   version.prefix = Chain(pCell);
+   version.numPrefix++;
+}
+
+/***********************************************
+ * TRANSIENT LIST :: PUSH BACK
+ * Put t last: in place on the end of the front if
+ * we made that cell and the queue has no rear,
+ * otherwise as a new version would
+ *   COST   : O(1)
+ **********************************************/
+template <class T>
+void TransientList <T> :: pushBack(const T & t)
+{
+   if (version.numRear == 0 && version.rotation == PersistentList <T>::IDLE &&
+       (pTail || version.queueFront.get() == nullptr))
+   {
+      Cell * pCell = new Cell(t);
+      if (pTail)
+         pTail->pNext = pCell;
+      else
+         version.queueFront = Chain(pCell);
+      pTail = pCell;
+      version.numFront++;
+      return;
+   }
+
+   version = version.pushBack(t);
+}
@@ -0,0 +1,187 @@
+/***********************************************************************
+ * Header:
+ *    POOL
+ * Summary:
+ *    A pool of Node objects.  Nodes are carved out of large blocks and
+ *    recycled through a free list instead of going back to the heap
+ *    every time one is removed from a list.
+ *
+ *    This will contain the class definition of:
+ *        NodePool     : A free list of nodes allocated in blocks
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell
+ ************************************************************************/
+
+#pragma once
+
+#include <cassert>     // for ASSERT
+#include <memory>      // for std::unique_ptr
+#include <new>         // for placement new
+#include <utility>     // for std::move
+#include <vector>      // for std::vector
+#include "node.h"      // for Node
+
+/*************************************************
+ * NODE POOL
+ * Hand out nodes from big blocks of memory and take
+ * them back when they are done.  Nodes from a pool
+ * must go back to that pool: never call delete or
+ * clear() from node.h on them.  A pool is not thread
+ * safe; give each thread its own.
+ *************************************************/
+template <class T>
+class NodePool
+{
+public:
+   //
+   // Construct
+   //
+   NodePool(size_t numPerBlock = 1024) : numPerBlock(numPerBlock ? numPerBlock : 1), pFree(nullptr) { }
+   NodePool(const NodePool &) = delete;
+   NodePool & operator = (const NodePool &) = delete;
+
+   // every node must have been released by now. The blocks go away, but
+   // the destructor of any T still checked out will never be called
+   ~NodePool() { }
+
+   //
+   // Acquire a node holding t, not attached to any list
+   //
+   Node <T> * acquire(const T &  t) { return new (allocate()) Node <T>(t);            }
+   Node <T> * acquire(      T && t) { return new (allocate()) Node <T>(std::move(t)); }
+
+   //
+   // Release one node or a whole list back to the pool
+   //
+   void release(Node <T> * pNode);
+   void clear(Node <T> * & pHead);
+
+   //
+   // Take over another pool's blocks, so the nodes it
+   // handed out now belong to this one
+   //
+   void adopt(NodePool & rhs);
+
+   //
+   // Status
+   //
+   size_t numBlocks() const { return blocks.size(); }
+   size_t numFree()   const;
+
+private:
+   // an unused slot is threaded on the free list, a used one holds a node
+   union Slot
+   {
+      Slot * pNextFree;
+      alignas(Node <T>) unsigned char storage[sizeof(Node <T>)];
+   };
+
+   void * allocate();
+
+   size_t numPerBlock;                          // slots per block
+   Slot * pFree;                                // the free list
+   std::vector <std::unique_ptr <Slot[]>> blocks;  // everything we own
+};
+
+/***********************************************
+ * NODE POOL :: ALLOCATE
+ * Pop a slot off the free list, carving a new
+ * block if the free list is empty
+ *   COST   : O(1) amortized
+ **********************************************/
+template <class T>
+void * NodePool <T> :: allocate()
+{
+   if (pFree == nullptr)
+   {
+      std::unique_ptr <Slot[]> block(new Slot[numPerBlock]);
+      for (size_t i = 0; i < numPerBlock; i++)
+         block[i].pNextFree = (i + 1 < numPerBlock ? &block[i + 1] : nullptr);
+      pFree = &block[0];
+      blocks.push_back(std::move(block));
+   }
+
+   Slot * pSlot = pFree;
+   pFree = pFree->pNextFree;
+   return pSlot->storage;
+}
+
+/***********************************************
+ * NODE POOL :: RELEASE
+ * Destroy one node and put its slot on the free list
+ *   INPUT  : the node, which must not be in a list
+ *   COST   : O(1)
+ **********************************************/
+template <class T>
+void NodePool <T> :: release(Node <T> * pNode)
+{
+   if (pNode == nullptr)
+      return;
+
+   pNode->~Node();
+   Slot * pSlot = reinterpret_cast <Slot *> (pNode);
+   pSlot->pNextFree = pFree;
+   pFree = pSlot;
+}
+
+/***********************************************
+ * NODE POOL :: CLEAR
+ * Release every node in the list, just like clear()
+ * in node.h does for nodes from the heap
+ *   INPUT  : pointer to the head of the linked list
+ *   OUTPUT : pHead set to NULL
+ *   COST   : O(n)
+ **********************************************/
+template <class T>
+void NodePool <T> :: clear(Node <T> * & pHead)
+{
+   while (pHead != nullptr)
+   {
+      Node <T> * pDelete = pHead;
+      pHead = pHead->pNext;
+      release(pDelete);
+   }
+}
+
+/***********************************************
+ * NODE POOL :: ADOPT
+ * Move every block of rhs into this pool, along with
+ * its free slots.  Nodes rhs handed out are released
+ * here from now on, and rhs is left empty.
+ *   INPUT  : the other pool
+ *   COST   : O(blocks + free in rhs)
+ **********************************************/
+template <class T>
+void NodePool <T> :: adopt(NodePool & rhs)
+{
+   if (&rhs == this)
+      return;
+
+   for (auto & block : rhs.blocks)
+      blocks.push_back(std::move(block));
+   rhs.blocks.clear();
+
+   if (rhs.pFree)
+   {
+      Slot * pLast = rhs.pFree;
+      while (pLast->pNextFree)
+         pLast = pLast->pNextFree;
+      pLast->pNextFree = pFree;
+      pFree = rhs.pFree;
+      rhs.pFree = nullptr;
+   }
+}
+
+/***********************************************
+ * NODE POOL :: NUM FREE
+ * How many slots are waiting on the free list
+ *   COST   : O(free)
+ **********************************************/
+template <class T>
+size_t NodePool <T> :: numFree() const
+{
+   size_t num = 0;
+   for (const Slot * p = pFree; p; p = p->pNextFree)
+      num++;
+   return num;
+}
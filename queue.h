@@ -0,0 +1,310 @@
+/***********************************************************************
+ * Header:
+ *    QUEUE
+ * Summary:
+ *    Lock-free queues built out of Node so one stage of a pipeline can
+ *    hand work to the next without a mutex around insert() and remove().
+ *
+ *    This will contain the class definition of:
+ *        MPSCQueue    : Many producers, one consumer (intrusive)
+ *        SPSCQueue    : One producer, one consumer, wait-free
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell
+ ************************************************************************/
+
+#pragma once
+
+#include <atomic>      // for std::atomic and std::atomic_ref
+#include <cassert>     // for ASSERT
+#include "node.h"      // for Node
+
+/***********************************************
+ * LOAD NEXT / STORE NEXT
+ * Node::pNext is a plain pointer so the rest of node.h
+ * stays the same.  When two threads share a link we
+ * go through atomic_ref to get acquire/release.
+ **********************************************/
+template <class T>
+inline Node <T> * loadNext(Node <T> * pNode)
+{
+   return std::atomic_ref <Node <T> *> (pNode->pNext).load(std::memory_order_acquire);
+}
+
+template <class T>
+inline void storeNext(Node <T> * pNode, Node <T> * pNext)
+{
+   std::atomic_ref <Node <T> *> (pNode->pNext).store(pNext, std::memory_order_release);
+}
+
+/*************************************************
+ * MPSC QUEUE
+ * Dmitry Vyukov's intrusive multi-producer single-consumer
+ * queue.  Producers hand in nodes they allocated
+ * themselves (with new or from their own NodePool) and
+ * push never waits.  Only one thread may pop.  T must
+ * be default constructible for the stub node.
+ *************************************************/
+template <class T>
+class MPSCQueue
+{
+public:
+   //
+   // Construct
+   //
+   MPSCQueue() : pBack(&stub), pFront(&stub) { }
+   MPSCQueue(const MPSCQueue &) = delete;
+   MPSCQueue & operator = (const MPSCQueue &) = delete;
+
+   // the queue does not own the nodes: drain it before it goes away
+   ~MPSCQueue() { assert(empty()); }
+
+   //
+   // Producers: any thread, any time
+   //
+   void push(Node <T> * pNode);
+
+   //
+   // Consumer: one thread only
+   //
+   Node <T> * pop();
+   Node <T> * pop(size_t max, size_t & num);
+   bool empty() const { return pFront == &stub && loadNext(const_cast <Node <T> *> (&stub)) == nullptr; }
+
+private:
+   Node <T> stub;                                 // always somewhere in the chain
+   alignas(64) std::atomic <Node <T> *> pBack;    // producers swap themselves in here
+   alignas(64) Node <T> * pFront;                 // only the consumer touches this
+};
+
+/***********************************************
+ * MPSC QUEUE :: PUSH
+ * Add a node to the back of the queue
+ *   INPUT  : a node not in any list
+ *   COST   : O(1), one atomic exchange
+ **********************************************/
+template <class T>
+void MPSCQueue <T> :: push(Node <T> * pNode)
+{
+   assert(pNode != nullptr);
+   pNode->pNext = nullptr;
+   pNode->pPrev = nullptr;
+   Node <T> * pPrevious = pBack.exchange(pNode, std::memory_order_acq_rel);
+   // between the exchange and this store the chain is briefly broken;
+   // pop() sees that as "nothing yet", never as a lost node
+   storeNext(pPrevious, pNode);
+}
+
+/***********************************************
+ * MPSC QUEUE :: POP
+ * Take the node off the front of the queue
+ *   OUTPUT : the node, detached, or NULL if there is
+ *            nothing ready yet
+ *   COST   : O(1)
+ **********************************************/
+template <class T>
+Node <T> * MPSCQueue <T> :: pop()
+{
+   Node <T> * pFirst = pFront;
+   Node <T> * pNext = loadNext(pFirst);
+
+   // skip over the stub
+   if (pFirst == &stub)
+   {
+      if (pNext == nullptr)
+         return nullptr;
+      pFront = pFirst = pNext;
+      pNext = loadNext(pNext);
+   }
+
+   // the common case: there is something behind us
+   if (pNext != nullptr)
+   {
+      pFront = pNext;
+      pFirst->pNext = nullptr;
+      return pFirst;
+   }
+
+   // a producer is half way through push()
+   if (pFirst != pBack.load(std::memory_order_acquire))
+      return nullptr;
+
+   // pFirst is the last node; put the stub behind it so we can let it go
+   push(&stub);
+   pNext = loadNext(pFirst);
+   if (pNext != nullptr)
+   {
+      pFront = pNext;
+      pFirst->pNext = nullptr;
+      return pFirst;
+   }
+   return nullptr;
+}
+
+/***********************************************
+ * MPSC QUEUE :: POP
+ * Take up to max nodes off the front of the queue
+ *   INPUT  : the most nodes to take
+ *   OUTPUT : a detached doubly linked list in queue
+ *            order, and how many nodes are in it
+ *   COST   : O(max)
+ **********************************************/
+template <class T>
+Node <T> * MPSCQueue <T> :: pop(size_t max, size_t & num)
+{
+   Node <T> * pHead = nullptr;
+   Node <T> * pTail = nullptr;
+   Node <T> * pNode;
+
+   for (num = 0; num < max && (pNode = pop()) != nullptr; num++)
+   {
+      pNode->pPrev = pTail;
+      if (pTail)
+         pTail->pNext = pNode;
+      else
+         pHead = pNode;
+      pTail = pNode;
+   }
+   return pHead;
+}
+
+/*************************************************
+ * SPSC QUEUE
+ * Vyukov's unbounded single-producer single-consumer
+ * queue.  Both push and pop are wait-free.  Nodes the
+ * consumer is done with stay in the chain and the
+ * producer reuses them, so a queue in steady state
+ * never touches the heap.
+ *************************************************/
+template <class T>
+class SPSCQueue
+{
+public:
+   //
+   // Construct
+   //
+   SPSCQueue();
+   SPSCQueue(const SPSCQueue &) = delete;
+   SPSCQueue & operator = (const SPSCQueue &) = delete;
+   ~SPSCQueue() { clear(pFirst); }
+
+   //
+   // Producer: one thread only
+   //
+   void push(const T &  t) { publish(acquire(t));            }
+   void push(      T && t) { publish(acquire(std::move(t))); }
+
+   //
+   // Consumer: one thread only
+   //
+   bool pop(T & t);
+   size_t pop(T * pOut, size_t max);
+   bool empty() const { return loadNext(pTail.load(std::memory_order_relaxed)) == nullptr; }
+
+private:
+   template <class U>
+   Node <T> * acquire(U && t);
+   void publish(Node <T> * pNode);
+
+   // consumer side: the last node consumed, which is the dummy
+   alignas(64) std::atomic <Node <T> *> pTail;
+
+   // producer side: the last node produced, the oldest node that can
+   // be recycled, and how far the consumer had gotten last we looked
+   alignas(64) Node <T> * pHead;
+   Node <T> * pFirst;
+   Node <T> * pTailCopy;
+};
+
+/***********************************************
+ * SPSC QUEUE :: CONSTRUCTOR
+ * Start with a dummy node that is both ends
+ **********************************************/
+template <class T>
+SPSCQueue <T> :: SPSCQueue()
+{
+   Node <T> * pDummy = new Node <T>;
+   pTail.store(pDummy, std::memory_order_relaxed);
+   pHead = pFirst = pTailCopy = pDummy;
+}
+
+/***********************************************
+ * SPSC QUEUE :: ACQUIRE
+ * Find a node for the producer, reusing one the
+ * consumer has passed if there is one
+ *   COST   : O(1)
+ **********************************************/
+template <class T>
+template <class U>
+Node <T> * SPSCQueue <T> :: acquire(U && t)
+{
+   if (pFirst == pTailCopy)
+      pTailCopy = pTail.load(std::memory_order_acquire);
+
+   if (pFirst != pTailCopy)
+   {
+      Node <T> * pNode = pFirst;
+      pFirst = pFirst->pNext;
+      pNode->data = std::forward <U> (t);
+      pNode->pNext = nullptr;
+      return pNode;
+   }
+
+   return new Node <T>(std::forward <U> (t));
+}
+
+/***********************************************
+ * SPSC QUEUE :: PUBLISH
+ * Hang a filled node on the end of the chain
+ *   COST   : O(1)
+ **********************************************/
+template <class T>
+void SPSCQueue <T> :: publish(Node <T> * pNode)
+{
+   storeNext(pHead, pNode);
+   pHead = pNode;
+}
+
+/***********************************************
+ * SPSC QUEUE :: POP
+ * Move the front value out of the queue
+ *   OUTPUT : t, and false if the queue was empty
+ *   COST   : O(1)
+ **********************************************/
+template <class T>
+bool SPSCQueue <T> :: pop(T & t)
+{
+   Node <T> * pDummy = pTail.load(std::memory_order_relaxed);
+   Node <T> * pNext = loadNext(pDummy);
+   if (pNext == nullptr)
+      return false;
+
+   // pNext becomes the dummy; the old dummy goes back to the producer
+   t = std::move(pNext->data);
+   pTail.store(pNext, std::memory_order_release);
+   return true;
+}
+
+/***********************************************
+ * SPSC QUEUE :: POP
+ * Move up to max values out of the queue, handing
+ * the nodes back to the producer once at the end
+ *   INPUT  : where to put them and how many fit
+ *   OUTPUT : how many we got
+ *   COST   : O(max)
+ **********************************************/
+template <class T>
+size_t SPSCQueue <T> :: pop(T * pOut, size_t max)
+{
+   Node <T> * pDummy = pTail.load(std::memory_order_relaxed);
+   size_t num = 0;
+
+   for (Node <T> * pNext; num < max && (pNext = loadNext(pDummy)) != nullptr; num++)
+   {
+      pOut[num] = std::move(pNext->data);
+      pDummy = pNext;
+   }
+
+   if (num)
+      pTail.store(pDummy, std::memory_order_release);
+   return num;
+}
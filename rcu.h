@@ -0,0 +1,385 @@
+/***********************************************************************
+ * Header:
+ *    RCU
+ * Summary:
+ *    Read-copy-update for lists that are read all the time and changed
+ *    once in a while.  Readers walk the list with consume loads and never
+ *    wait; writers publish changes with release stores and free the old
+ *    nodes only after every reader has moved on (a grace period).
+ *
+ *    This is quiescent-state based RCU: a reader announces that it holds
+ *    no pointers into any list by calling quiescent(), typically once per
+ *    request, or by going offline() while it is idle.
+ *
+ *    This will contain the class definition of:
+ *        RCUDomain    : Tracks readers and the nodes waiting to be freed
+ *        RCUReader    : One reading thread's registration
+ *        RCUList      : A doubly linked list of Node with RCU readers
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell
+ ************************************************************************/
+
+#pragma once
+
+#include <atomic>      // for std::atomic and std::atomic_ref
+#include <cstdint>     // for uint64_t
+#include <mutex>       // for std::mutex
+#include <stdexcept>   // for std::runtime_error
+#include <thread>      // for std::this_thread::yield
+#include <vector>      // for std::vector
+#include "node.h"      // for Node
+
+/*************************************************
+ * RCU DOMAIN
+ * The readers who must be waited for and the memory
+ * waiting on them.  One domain can serve many lists
+ * (and the other structures that reclaim through it).
+ *************************************************/
+class RCUDomain
+{
+public:
+   enum { MAX_READERS = 128 };
+
+   RCUDomain() : gracePeriod(1) { }
+   RCUDomain(const RCUDomain &) = delete;
+   RCUDomain & operator = (const RCUDomain &) = delete;
+   ~RCUDomain() { reclaim(); }
+
+   //
+   // Writers
+   //
+   void synchronize();
+   void retire(void * p, void (*destroy)(void *));
+   size_t reclaim();
+   size_t numRetired()
+   {
+      std::lock_guard <std::mutex> lock(mutexRetired);
+      return retired.size();
+   }
+
+private:
+   friend class RCUReader;
+
+   // what a reader last told us: 0 is offline, otherwise the grace
+   // period it has seen.  Each gets its own cache line.
+   struct alignas(64) Slot
+   {
+      std::atomic <uint64_t> seen { 0 };
+      std::atomic <bool>     used { false };
+   };
+
+   // memory that cannot be freed until the grace period passes
+   struct Retired
+   {
+      void * p;
+      void (*destroy)(void *);
+   };
+
+   alignas(64) std::atomic <uint64_t> gracePeriod;
+   Slot slots[MAX_READERS];
+   std::mutex mutexRetired;
+   std::vector <Retired> retired;
+};
+
+/*************************************************
+ * RCU READER
+ * A thread that reads RCU lists holds one of these
+ * for as long as it runs.  Readers start online.
+ *************************************************/
+class RCUReader
+{
+public:
+   RCUReader(RCUDomain & domain);
+   RCUReader(const RCUReader &) = delete;
+   RCUReader & operator = (const RCUReader &) = delete;
+   ~RCUReader()
+   {
+      pSlot->seen.store(0, std::memory_order_release);
+      pSlot->used.store(false, std::memory_order_release);
+   }
+
+   // I hold no pointers into any list right now
+   void quiescent()
+   {
+      pSlot->seen.store(domain.gracePeriod.load(std::memory_order_acquire),
+                        std::memory_order_release);
+   }
+
+   // I am going idle: do not wait for me
+   void offline() { pSlot->seen.store(0, std::memory_order_release); }
+
+   // I am about to read again
+   void online()
+   {
+      pSlot->seen.store(domain.gracePeriod.load(std::memory_order_relaxed),
+                        std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+   }
+
+   RCUDomain & getDomain() const { return domain; }
+
+private:
+   RCUDomain & domain;
+   RCUDomain::Slot * pSlot;
+};
+
+/***********************************************
+ * RCU READER :: CONSTRUCTOR
+ * Claim a free slot in the domain
+ *   THROWS : std::runtime_error if MAX_READERS
+ *            readers already hold one
+ **********************************************/
+inline RCUReader :: RCUReader(RCUDomain & domain) : domain(domain), pSlot(nullptr)
+{
+   for (auto & slot : domain.slots)
+   {
+      bool expected = false;
+      if (slot.used.compare_exchange_strong(expected, true))
+      {
+         pSlot = &slot;
+         break;
+      }
+   }
+   if (pSlot == nullptr)
+      throw std::runtime_error("rcu: more than MAX_READERS readers");
+   online();
+}
+
+/***********************************************
+ * RCU DOMAIN :: SYNCHRONIZE
+ * Wait until every online reader has been quiescent
+ * at least once since we started.  Never call this
+ * while holding your own reader online: it would
+ * wait for itself.
+ *   COST   : O(readers) plus however long they take
+ **********************************************/
+inline void RCUDomain :: synchronize()
+{
+   uint64_t target = gracePeriod.fetch_add(1, std::memory_order_seq_cst) + 1;
+
+   for (auto & slot : slots)
+   {
+      if (!slot.used.load(std::memory_order_acquire))
+         continue;
+      for (;;)
+      {
+         uint64_t seen = slot.seen.load(std::memory_order_acquire);
+         if (seen == 0 || seen >= target)
+            break;
+         std::this_thread::yield();
+      }
+   }
+}
+
+/***********************************************
+ * RCU DOMAIN :: RETIRE
+ * Free p once no reader can still see it
+ *   INPUT  : the memory and how to free it
+ *   COST   : O(1)
+ **********************************************/
+inline void RCUDomain :: retire(void * p, void (*destroy)(void *))
+{
+   std::lock_guard <std::mutex> lock(mutexRetired);
+   retired.push_back(Retired { p, destroy });
+}
+
+/***********************************************
+ * RCU DOMAIN :: RECLAIM
+ * Wait for a grace period and free everything that
+ * was retired before it started
+ *   OUTPUT : how many were freed
+ *   COST   : O(retired) plus a grace period
+ **********************************************/
+inline size_t RCUDomain :: reclaim()
+{
+   std::vector <Retired> ready;
+   {
+      std::lock_guard <std::mutex> lock(mutexRetired);
+      ready.swap(retired);
+   }
+   if (ready.empty())
+      return 0;
+
+   synchronize();
+   for (auto & r : ready)
+      r.destroy(r.p);
+   return ready.size();
+}
+
+/***********************************************
+ * RCU NEXT
+ * Follow a link that a writer may be changing.  The
+ * reader only needs the node the link points at to be
+ * published, which is what consume orders.  Compilers
+ * treat consume as acquire today: a plain load on x86,
+ * LDAR on ARM64.  Either way there is no fence and no
+ * read-modify-write; that is all a reader pays.
+ **********************************************/
+template <class T>
+inline const Node <T> * rcuNext(const Node <T> * p)
+{
+   return std::atomic_ref <Node <T> * const> (p->pNext).load(std::memory_order_consume);
+}
+
+/*************************************************
+ * RCU LIST
+ * A list with any number of readers and one writer
+ * at a time.  Readers go front to back only:
+ *    for (auto p = list.head(); p; p = rcuNext(p))
+ * and must not keep a pointer past quiescent().
+ *************************************************/
+template <class T>
+class RCUList
+{
+public:
+   //
+   // Construct
+   //
+   RCUList(RCUDomain & domain) : domain(domain), pHead(nullptr) { }
+   RCUList(const RCUList &) = delete;
+   RCUList & operator = (const RCUList &) = delete;
+   ~RCUList();
+
+   //
+   // Readers
+   //
+   const Node <T> * head() const
+   {
+      return std::atomic_ref <Node <T> * const> (pHead).load(std::memory_order_consume);
+   }
+
+   //
+   // Writers
+   //
+   const Node <T> * insert(const Node <T> * pCurrent, const T & t, bool after = false);
+   const Node <T> * replace(const Node <T> * pCurrent, const T & t);
+   void remove(const Node <T> * pRemove);
+   size_t size();
+
+private:
+   void publish(Node <T> * & pLink, Node <T> * pNode)
+   {
+      std::atomic_ref <Node <T> *> (pLink).store(pNode, std::memory_order_release);
+   }
+   void retire(Node <T> * pNode)
+   {
+      domain.retire(pNode, [](void * p) { delete static_cast <Node <T> *> (p); });
+   }
+
+   RCUDomain & domain;
+   std::mutex mutexWrite;     // one writer at a time
+   Node <T> * pHead;
+};
+
+/***********************************************
+ * RCU LIST :: DESTRUCTOR
+ * No reader may be looking any more
+ **********************************************/
+template <class T>
+RCUList <T> :: ~RCUList()
+{
+   domain.reclaim();
+   clear(pHead);
+}
+
+/***********************************************
+ * RCU LIST :: INSERT
+ * Insert a new node before (or after) pCurrent.  The
+ * node is complete before the one store that makes
+ * it visible to readers.
+ *   INPUT  : pCurrent - where, NULL for the front
+ *            t - the value
+ *            after - whether to go after pCurrent
+ *   OUTPUT : the new node
+ *   COST   : O(1)
+ **********************************************/
+template <class T>
+const Node <T> * RCUList <T> :: insert(const Node <T> * pCurrent, const T & t, bool after)
+{
+   std::lock_guard <std::mutex> lock(mutexWrite);
+   Node <T> * pNew = new Node <T>(t);
+   Node <T> * p = const_cast <Node <T> *> (pCurrent);
+
+   if (p == nullptr)
+   {
+      pNew->pNext = pHead;
+      if (pHead)
+         pHead->pPrev = pNew;
+      publish(pHead, pNew);
+   }
+   else if (after)
+   {
+      pNew->pPrev = p;
+      pNew->pNext = p->pNext;
+      if (p->pNext)
+         p->pNext->pPrev = pNew;
+      publish(p->pNext, pNew);
+   }
+   else
+   {
+      pNew->pPrev = p->pPrev;
+      pNew->pNext = p;
+      p->pPrev = pNew;
+      publish(pNew->pPrev ? pNew->pPrev->pNext : pHead, pNew);
+   }
+   return pNew;
+}
+
+/***********************************************
+ * RCU LIST :: REPLACE
+ * Give pCurrent a new value by swapping in a copy;
+ * readers see either the old node or the new one
+ *   OUTPUT : the new node
+ *   COST   : O(1)
+ **********************************************/
+template <class T>
+const Node <T> * RCUList <T> :: replace(const Node <T> * pCurrent, const T & t)
+{
+   std::lock_guard <std::mutex> lock(mutexWrite);
+   Node <T> * pOld = const_cast <Node <T> *> (pCurrent);
+   Node <T> * pNew = new Node <T>(t);
+
+   pNew->pPrev = pOld->pPrev;
+   pNew->pNext = pOld->pNext;
+   if (pOld->pNext)
+      pOld->pNext->pPrev = pNew;
+   publish(pOld->pPrev ? pOld->pPrev->pNext : pHead, pNew);
+
+   retire(pOld);
+   return pNew;
+}
+
+/***********************************************
+ * RCU LIST :: REMOVE
+ * Unlink a node.  A reader standing on it can still
+ * walk off its pNext, so it is only retired here;
+ * domain.reclaim() frees it after a grace period.
+ *   COST   : O(1)
+ **********************************************/
+template <class T>
+void RCUList <T> :: remove(const Node <T> * pRemove)
+{
+   if (pRemove == nullptr)
+      return;
+
+   std::lock_guard <std::mutex> lock(mutexWrite);
+   Node <T> * p = const_cast <Node <T> *> (pRemove);
+
+   if (p->pNext)
+      p->pNext->pPrev = p->pPrev;
+   publish(p->pPrev ? p->pPrev->pNext : pHead, p->pNext);
+
+   retire(p);
+}
+
+/***********************************************
+ * RCU LIST :: SIZE
+ * Count the nodes as the writers see them
+ *   COST   : O(n)
+ **********************************************/
+template <class T>
+size_t RCUList <T> :: size()
+{
+   std::lock_guard <std::mutex> lock(mutexWrite);
+   return ::size(pHead);
+}
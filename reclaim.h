@@ -0,0 +1,290 @@
+/***********************************************************************
+ * Header:
+ *    RECLAIM
+ * Summary:
+ *    Freeing a long list takes as long as building it, and when T has
+ *    an expensive destructor that time lands on whoever calls clear().
+ *    These take the list away from the caller in O(1) and destroy the
+ *    nodes somewhere else.
+ *
+ *    This will contain the class definition of:
+ *        Reclaimer    : A background thread that destroys lists
+ *        IncrementalReclaimer : Destroys lists a few nodes at a time
+ *    and the function:
+ *        clearAsync   : clear() on the background thread
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell
+ ************************************************************************/
+
+#pragma once
+
+#include <atomic>              // for std::atomic
+#include <chrono>              // for std::chrono::steady_clock
+#include <condition_variable>  // for std::condition_variable
+#include <deque>               // for std::deque
+#include <functional>          // for std::function
+#include <future>              // for std::future and std::promise
+#include <memory>              // for std::shared_ptr
+#include <mutex>               // for std::mutex
+#include <thread>              // for std::thread
+#include <vector>              // for std::vector
+#include "node.h"              // for Node
+
+/*************************************************
+ * RECLAIMER
+ * One thread that destroys lists handed to it, in
+ * the order they arrive.  Every list comes with a
+ * future that says how many nodes it held once
+ * they are all gone.
+ *************************************************/
+class Reclaimer
+{
+public:
+   Reclaimer();
+   Reclaimer(const Reclaimer &) = delete;
+   Reclaimer & operator = (const Reclaimer &) = delete;
+   ~Reclaimer();
+
+   //
+   // Hand over a list; pHead is NULL when this returns
+   //
+   template <class T>
+   std::future <size_t> clear(Node <T> * & pHead);
+
+   //
+   // Status
+   //
+   void wait();                                        // until everything is freed
+   size_t numPending() const { return pending;       } // lists not yet freed
+   size_t numFreed()   const { return freed;         } // nodes freed so far
+
+private:
+   void work();
+
+   std::thread thread;
+   std::mutex mutex;
+   std::condition_variable wake;
+   std::condition_variable idle;
+   std::deque <std::function <void()>> jobs;
+   std::atomic <size_t> pending;
+   std::atomic <size_t> freed;
+   bool stop;
+};
+
+/***********************************************
+ * DEFAULT RECLAIMER
+ * One background thread for everybody
+ **********************************************/
+inline Reclaimer & defaultReclaimer()
+{
+   static Reclaimer reclaimer;
+   return reclaimer;
+}
+
+/***********************************************
+ * RECLAIMER :: CONSTRUCTOR / DESTRUCTOR
+ * The destructor finishes what is queued first
+ **********************************************/
+inline Reclaimer :: Reclaimer() : pending(0), freed(0), stop(false)
+{
+   thread = std::thread([this]() { work(); });
+}
+
+inline Reclaimer :: ~Reclaimer()
+{
+   {
+      std::lock_guard <std::mutex> lock(mutex);
+      stop = true;
+   }
+   wake.notify_all();
+   thread.join();
+}
+
+/***********************************************
+ * RECLAIMER :: WORK
+ * Run jobs until told to stop and there are none
+ **********************************************/
+inline void Reclaimer :: work()
+{
+   std::unique_lock <std::mutex> lock(mutex);
+   for (;;)
+   {
+      wake.wait(lock, [this]() { return stop || !jobs.empty(); });
+      if (jobs.empty())
+         return;
+
+      std::function <void()> job = std::move(jobs.front());
+      jobs.pop_front();
+      lock.unlock();
+      job();
+      lock.lock();
+      pending--;
+      idle.notify_all();
+   }
+}
+
+/***********************************************
+ * RECLAIMER :: WAIT
+ * Block until every list handed over so far is freed
+ **********************************************/
+inline void Reclaimer :: wait()
+{
+   std::unique_lock <std::mutex> lock(mutex);
+   idle.wait(lock, [this]() { return pending == 0; });
+}
+
+/***********************************************
+ * RECLAIMER :: CLEAR
+ * Detach the list from the caller and queue it to be
+ * destroyed on the background thread
+ *   INPUT  : pointer to the head of the linked list
+ *   OUTPUT : pHead set to NULL, and a future holding
+ *            the number of nodes once they are freed
+ *   COST   : O(1) for the caller
+ **********************************************/
+template <class T>
+std::future <size_t> Reclaimer :: clear(Node <T> * & pHead)
+{
+   auto pDone = std::make_shared <std::promise <size_t>> ();
+   std::future <size_t> future = pDone->get_future();
+
+   Node <T> * pDetached = pHead;
+   pHead = nullptr;
+   if (pDetached == nullptr)
+   {
+      pDone->set_value(0);
+      return future;
+   }
+
+   {
+      std::lock_guard <std::mutex> lock(mutex);
+      pending++;
+      jobs.push_back([this, pDetached, pDone]() mutable
+      {
+         size_t num = 0;
+         while (pDetached != nullptr)
+         {
+            Node <T> * pDelete = pDetached;
+            pDetached = pDetached->pNext;
+            delete pDelete;
+            num++;
+         }
+         freed += num;
+         pDone->set_value(num);
+      });
+   }
+   wake.notify_one();
+   return future;
+}
+
+/*****************************************************
+ * CLEAR ASYNC
+ * Free all the data in the linked list on another thread
+ *   INPUT   : pointer to the head of the linked list
+ *   OUTPUT  : pHead set to NULL, and a future holding the
+ *             number of nodes once they are freed
+ *   COST    : O(1) here, O(n) on the reclaimer
+ ****************************************************/
+template <class T>
+inline std::future <size_t> clearAsync(Node <T> * & pHead, Reclaimer & reclaimer = defaultReclaimer())
+{
+   return reclaimer.clear(pHead);
+}
+
+/*************************************************
+ * INCREMENTAL RECLAIMER
+ * clear() takes the list away in O(1); the nodes are
+ * destroyed a few at a time by tick(), which stops
+ * after maxNodes nodes or maxTime, whichever is first.
+ * insert() through the reclaimer ticks once before it
+ * allocates, so a program that keeps allocating pays
+ * for old lists in small, bounded installments.  Not
+ * thread safe: it belongs to one thread.
+ *************************************************/
+template <class T>
+class IncrementalReclaimer
+{
+public:
+   //
+   // Construct with the budget insert() uses; zero time means no limit
+   //
+   IncrementalReclaimer(size_t maxNodes = 32,
+                        std::chrono::microseconds maxTime = std::chrono::microseconds(0)) :
+      maxNodes(maxNodes), maxTime(maxTime), freed(0) { }
+   IncrementalReclaimer(const IncrementalReclaimer &) = delete;
+   IncrementalReclaimer & operator = (const IncrementalReclaimer &) = delete;
+
+   // whatever is left goes now
+   ~IncrementalReclaimer() { tick((size_t)-1, std::chrono::microseconds(0)); }
+
+   //
+   // Hand over a list; pHead is NULL when this returns
+   //
+   void clear(Node <T> * & pHead)
+   {
+      if (pHead)
+         backlog.push_back(pHead);
+      pHead = nullptr;
+   }
+
+   //
+   // Pay some of the debt
+   //
+   size_t tick(size_t maxNodes, std::chrono::microseconds maxTime);
+   size_t tick() { return tick(maxNodes, maxTime); }
+
+   //
+   // insert() from node.h, after paying one installment
+   //
+   Node <T> * insert(Node <T> * pCurrent, const T & t, bool after = false)
+   {
+      tick();
+      return ::insert(pCurrent, t, after);
+   }
+
+   //
+   // Status
+   //
+   bool empty() const      { return backlog.empty(); }
+   size_t numFreed() const { return freed;           }
+
+private:
+   size_t maxNodes;                      // budget per tick() for insert()
+   std::chrono::microseconds maxTime;
+   std::vector <Node <T> *> backlog;     // lists waiting to be destroyed
+   size_t freed;                         // nodes destroyed so far
+};
+
+/***********************************************
+ * INCREMENTAL RECLAIMER :: TICK
+ * Destroy nodes until the budget runs out.  With a
+ * time limit the clock is read after every delete,
+ * so one destructor is the most it can run over.
+ *   INPUT  : at most this many nodes, and at most
+ *            this long (zero for no time limit)
+ *   OUTPUT : how many nodes were destroyed
+ *   COST   : O(maxNodes)
+ **********************************************/
+template <class T>
+size_t IncrementalReclaimer <T> :: tick(size_t maxNodes, std::chrono::microseconds maxTime)
+{
+   auto deadline = std::chrono::steady_clock::now() + maxTime;
+   size_t num = 0;
+
+   while (num < maxNodes && !backlog.empty())
+   {
+      Node <T> * & pHead = backlog.back();
+      Node <T> * pDelete = pHead;
+      pHead = pHead->pNext;
+      delete pDelete;
+      num++;
+
+      if (pHead == nullptr)
+         backlog.pop_back();
+      if (maxTime.count() && std::chrono::steady_clock::now() >= deadline)
+         break;
+   }
+
+   freed += num;
+   return num;
+}
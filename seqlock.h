@@ -0,0 +1,338 @@
+/***********************************************************************
+ * Header:
+ *    SEQLOCK
+ * Summary:
+ *    A small list that many threads read and few threads change.  A
+ *    writer makes a sequence number odd while it works and even again
+ *    when it is done.  A reader notes the number, reads the list without
+ *    taking any lock, and starts over if the number moved: it saw the
+ *    list halfway through a change.  Readers write nothing shared, so
+ *    they do not slow each other down, and a read costs about what the
+ *    copy does.
+ *
+ *    Because a reader can be looking at a node while it is being changed
+ *    or reused, nodes are never handed back to the heap while the list
+ *    lives, and T must be trivially copyable: a torn copy is thrown away,
+ *    never used.
+ *
+ *    This will contain the class definition of:
+ *        SeqlockList  : A bounded list with optimistic readers
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell
+ ************************************************************************/
+
+#pragma once
+
+#include <atomic>      // for std::atomic and std::atomic_ref
+#include <cstdint>     // for uintptr_t
+#include <cstring>     // for std::memcpy
+#include <mutex>       // for std::mutex
+#include <new>         // for std::launder
+#include <type_traits> // for std::is_trivially_copyable
+#include "pool.h"      // for NodePool
+
+/***********************************************
+ * RACY LOAD / RACY STORE
+ * Copy a value that another thread may be changing,
+ * a word at a time when T is made of whole words and
+ * a byte at a time otherwise.  The result may be
+ * torn; the sequence number says whether to keep it.
+ **********************************************/
+template <class T>
+inline void racyLoad(T & des, const T & src)
+{
+   if constexpr (sizeof(T) % sizeof(uintptr_t) == 0 && alignof(T) >= alignof(uintptr_t))
+   {
+      uintptr_t words[sizeof(T) / sizeof(uintptr_t)];
+      auto pSrc = reinterpret_cast <uintptr_t *> (const_cast <T *> (&src));
+      for (size_t i = 0; i < sizeof(T) / sizeof(uintptr_t); i++)
+         words[i] = std::atomic_ref <uintptr_t> (pSrc[i]).load(std::memory_order_relaxed);
+      std::memcpy(&des, words, sizeof(T));
+   }
+   else
+   {
+      unsigned char bytes[sizeof(T)];
+      auto pSrc = reinterpret_cast <unsigned char *> (const_cast <T *> (&src));
+      for (size_t i = 0; i < sizeof(T); i++)
+         bytes[i] = std::atomic_ref <unsigned char> (pSrc[i]).load(std::memory_order_relaxed);
+      std::memcpy(&des, bytes, sizeof(T));
+   }
+}
+
+template <class T>
+inline void racyStore(T & des, const T & src)
+{
+   if constexpr (sizeof(T) % sizeof(uintptr_t) == 0 && alignof(T) >= alignof(uintptr_t))
+   {
+      uintptr_t words[sizeof(T) / sizeof(uintptr_t)];
+      std::memcpy(words, &src, sizeof(T));
+      auto pDes = reinterpret_cast <uintptr_t *> (&des);
+      for (size_t i = 0; i < sizeof(T) / sizeof(uintptr_t); i++)
+         std::atomic_ref <uintptr_t> (pDes[i]).store(words[i], std::memory_order_relaxed);
+   }
+   else
+   {
+      unsigned char bytes[sizeof(T)];
+      std::memcpy(bytes, &src, sizeof(T));
+      auto pDes = reinterpret_cast <unsigned char *> (&des);
+      for (size_t i = 0; i < sizeof(T); i++)
+         std::atomic_ref <unsigned char> (pDes[i]).store(bytes[i], std::memory_order_relaxed);
+   }
+}
+
+/*************************************************
+ * SEQLOCK LIST
+ * At most capacity nodes.  Writers take a mutex and
+ * bump the sequence number; readers only load.
+ * Node pointers from insert() are for writers: a
+ * reader only ever sees copies.
+ *************************************************/
+template <class T>
+class SeqlockList
+{
+   static_assert(std::is_trivially_copyable <T>::value,
+                 "readers copy values that may be changing under them");
+
+public:
+   enum { MAX_CAPACITY = 63 };
+
+   //
+   // Construct
+   //
+   SeqlockList(size_t capacity = MAX_CAPACITY) :
+      capacity(capacity < MAX_CAPACITY ? capacity : (size_t)MAX_CAPACITY),
+      pool(this->capacity),
+      sequence(0), pHead(nullptr), pFree(nullptr), num(0) { }
+   SeqlockList(const SeqlockList &) = delete;
+   SeqlockList & operator = (const SeqlockList &) = delete;
+   ~SeqlockList();
+
+   //
+   // Writers: NULL when the list is full
+   //
+   Node <T> * insert(Node <T> * pCurrent, const T & t, bool after = false);
+   Node <T> * remove(Node <T> * pRemove);
+   void update(Node <T> * pNode, const T & t);
+
+   //
+   // Readers: each returns what the list held at one moment
+   //
+   size_t copy(T * out, size_t max) const;
+   template <class U, class Fold>
+   U reduce(U init, Fold fold) const;
+   size_t size() const;
+
+private:
+   void beginWrite();
+   void endWrite();
+   static Node <T> * loadNext(const Node <T> * p)
+   {
+      return std::atomic_ref <Node <T> * const> (p->pNext).load(std::memory_order_acquire);
+   }
+   static void storeLink(Node <T> * & pLink, Node <T> * p)
+   {
+      std::atomic_ref <Node <T> *> (pLink).store(p, std::memory_order_release);
+   }
+
+   size_t capacity;
+   NodePool <T> pool;                  // nodes stay put until we go
+   alignas(64) std::atomic <unsigned long long> sequence;   // odd while writing
+   Node <T> * pHead;
+   Node <T> * pFree;                   // removed nodes, waiting to be reused
+   std::atomic <size_t> num;           // only writers change it
+   std::mutex mutexWrite;
+};
+
+/***********************************************
+ * SEQLOCK LIST :: DESTRUCTOR
+ * Hand every node, in the list or not, back
+ **********************************************/
+template <class T>
+SeqlockList <T> :: ~SeqlockList()
+{
+   pool.clear(pHead);
+   pool.clear(pFree);
+}
+
+/***********************************************
+ * SEQLOCK LIST :: BEGIN WRITE / END WRITE
+ * Odd while we work.  The fence keeps our changes
+ * from being seen before the number goes odd.
+ **********************************************/
+template <class T>
+void SeqlockList <T> :: beginWrite()
+{
+   sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+   std::atomic_thread_fence(std::memory_order_release);
+}
+
+template <class T>
+void SeqlockList <T> :: endWrite()
+{
+   sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+/***********************************************
+ * SEQLOCK LIST :: INSERT
+ * Insert a new node with the value t
+ *   INPUT  : pCurrent - where, NULL for the front
+ *            t - the value
+ *            after - whether to go after pCurrent
+ *   OUTPUT : the new node, or NULL when full
+ *   COST   : O(1)
+ **********************************************/
+template <class T>
+Node <T> * SeqlockList <T> :: insert(Node <T> * pCurrent, const T & t, bool after)
+{
+   std::lock_guard <std::mutex> lock(mutexWrite);
+   size_t numNow = num.load(std::memory_order_relaxed);
+   if (numNow == capacity)
+      return nullptr;
+
+   // a node from the pool has never been seen, so it can be built
+   // normally; a reused one may have a reader looking at it
+   Node <T> * pNew = pFree;
+   if (pNew == nullptr)
+      pNew = pool.acquire(t);
+   beginWrite();
+   if (pNew == pFree)
+   {
+      pFree = pFree->pNext;
+      racyStore(pNew->data, t);
+   }
+
+   if (pCurrent == nullptr)
+      pCurrent = pHead, after = false;
+   Node <T> * pPrev = pCurrent == nullptr ? nullptr : (after ? pCurrent : pCurrent->pPrev);
+   Node <T> * pNext = pCurrent == nullptr ? nullptr : (after ? pCurrent->pNext : pCurrent);
+   storeLink(pNew->pPrev, pPrev);
+   storeLink(pNew->pNext, pNext);
+   if (pNext)
+      storeLink(pNext->pPrev, pNew);
+   storeLink(pPrev ? pPrev->pNext : pHead, pNew);
+   num.store(numNow + 1, std::memory_order_relaxed);
+
+   endWrite();
+   return pNew;
+}
+
+/***********************************************
+ * SEQLOCK LIST :: REMOVE
+ * Take a node out; it waits on our free list
+ *   INPUT  : the node to be removed
+ *   OUTPUT : the pointer to the parent node, as node.h
+ *   COST   : O(1)
+ **********************************************/
+template <class T>
+Node <T> * SeqlockList <T> :: remove(Node <T> * pRemove)
+{
+   if (pRemove == nullptr)
+      return nullptr;
+
+   std::lock_guard <std::mutex> lock(mutexWrite);
+   beginWrite();
+
+   Node <T> * pPrev = pRemove->pPrev;
+   Node <T> * pNext = pRemove->pNext;
+   storeLink(pPrev ? pPrev->pNext : pHead, pNext);
+   if (pNext)
+      storeLink(pNext->pPrev, pPrev);
+   storeLink(pRemove->pPrev, nullptr);
+   storeLink(pRemove->pNext, pFree);
+   pFree = pRemove;
+   num.store(num.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+
+   endWrite();
+   return pPrev ? pPrev : pNext;
+}
+
+/***********************************************
+ * SEQLOCK LIST :: UPDATE
+ * Change the value in one node in place
+ *   COST   : O(1)
+ **********************************************/
+template <class T>
+void SeqlockList <T> :: update(Node <T> * pNode, const T & t)
+{
+   std::lock_guard <std::mutex> lock(mutexWrite);
+   beginWrite();
+   racyStore(pNode->data, t);
+   endWrite();
+}
+
+/***********************************************
+ * SEQLOCK LIST :: REDUCE
+ * Fold every value, front to back, into init.  A pass
+ * that overlapped a write is thrown away and done
+ * again from init, so fold must not have side effects
+ * of its own.  A torn pNext can send a pass around in
+ * circles, so a pass longer than the capacity is
+ * thrown away too.
+ *   INPUT  : init, and fold(U, const T &) returning U
+ *   OUTPUT : the fold of one consistent pass
+ *   COST   : O(n) per pass
+ **********************************************/
+template <class T>
+template <class U, class Fold>
+U SeqlockList <T> :: reduce(U init, Fold fold) const
+{
+   for (;;)
+   {
+      unsigned long long before = sequence.load(std::memory_order_acquire);
+      if (before % 2 == 0)
+      {
+         U result = init;
+         size_t numSeen = 0;
+         const Node <T> * p = std::atomic_ref <Node <T> * const> (pHead).load(std::memory_order_acquire);
+         for (; p && numSeen <= capacity; p = loadNext(p), numSeen++)
+         {
+            // raw storage, so T needs no default constructor
+            alignas(T) unsigned char storage[sizeof(T)];
+            T * pValue = reinterpret_cast <T *> (storage);
+            racyLoad(*pValue, p->data);
+            result = fold(result, *std::launder(pValue));
+         }
+
+         std::atomic_thread_fence(std::memory_order_acquire);
+         if (p == nullptr && sequence.load(std::memory_order_relaxed) == before)
+            return result;
+      }
+   }
+}
+
+/***********************************************
+ * SEQLOCK LIST :: COPY
+ * Copy out the values of one consistent pass
+ *   INPUT  : where, and room for at most max
+ *   OUTPUT : how many were copied
+ *   COST   : O(n) per pass
+ **********************************************/
+template <class T>
+size_t SeqlockList <T> :: copy(T * out, size_t max) const
+{
+   size_t numSeen = reduce((size_t)0, [out, max](size_t i, const T & value)
+   {
+      if (i < max)
+         out[i] = value;
+      return i + 1;
+   });
+   return numSeen < max ? numSeen : max;
+}
+
+/***********************************************
+ * SEQLOCK LIST :: SIZE
+ * The number of nodes at one moment
+ *   COST   : O(1) per pass
+ **********************************************/
+template <class T>
+size_t SeqlockList <T> :: size() const
+{
+   for (;;)
+   {
+      unsigned long long before = sequence.load(std::memory_order_acquire);
+      size_t result = num.load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (before % 2 == 0 && sequence.load(std::memory_order_relaxed) == before)
+         return result;
+   }
+}
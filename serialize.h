@@ -0,0 +1,448 @@
+/***********************************************************************
+ * Header:
+ *    SERIALIZE
+ * Summary:
+ *    A compact binary form of a Node list, for checkpoints on disk and
+ *    for sending a list somewhere else.  Each list becomes one frame:
+ *
+ *       +-------+------+-----+----------+----------+----------------+
+ *       | magic | size | num | numBytes | reserved | payload ...    |
+ *       +-------+------+-----+----------+----------+----------------+
+ *         4       4      8     8          8          numBytes
+ *
+ *    When T is trivially copyable the payload is the values themselves,
+ *    back to back, size bytes apiece, copied with memcpy.  Any other T
+ *    needs a Serializer <T> that writes and reads one value; its frames
+ *    have a size of 0.  Numbers are in the byte order of the machine
+ *    that wrote them.
+ *
+ *    Reading a frame builds the list in a NodePool, so a million values
+ *    cost a handful of block allocations, not a million calls to new.
+ *
+ *    This will contain the class definition of:
+ *        SerializeError : What a bad frame throws
+ *        ByteWriter     : Appends bytes to a buffer
+ *        ByteReader     : Reads bytes from a buffer, checking the end
+ *        Serializer     : How to write and read a value that is not
+ *                         trivially copyable
+ *        FlatListView   : The values of a raw frame, read where they lie
+ *    and the functions:
+ *        serialize      : A list to a frame
+ *        deserialize    : A frame to a list
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell
+ ************************************************************************/
+
+#pragma once
+
+#include <algorithm>   // for std::min
+#include <bit>         // for std::bit_cast
+#include <concepts>    // for std::convertible_to
+#include <cstddef>     // for std::ptrdiff_t
+#include <cstdint>     // for uint64_t
+#include <cstring>     // for memcpy
+#include <iterator>    // for std::bidirectional_iterator_tag
+#include <istream>     // for std::istream
+#include <ostream>     // for std::ostream
+#include <stdexcept>   // for std::runtime_error
+#include <string>      // for std::string
+#include <type_traits> // for std::is_trivially_copyable
+#include <vector>      // for std::vector
+#include "node.h"      // for Node
+#include "pool.h"      // for NodePool
+
+/*************************************************
+ * SERIALIZE ERROR
+ * A frame that is not one, is cut short, or holds
+ * some other type
+ *************************************************/
+class SerializeError : public std::runtime_error
+{
+public:
+   explicit SerializeError(const std::string & what) : std::runtime_error(what) { }
+};
+
+/*************************************************
+ * SERIAL HEADER
+ * The start of every frame.  It is 32 bytes, so a
+ * payload in an aligned buffer is aligned too.
+ *************************************************/
+struct SerialHeader
+{
+   static constexpr uint32_t MAGIC = 0x5453494c;   // "LIST"
+
+   uint32_t magic;
+   uint32_t size;        // bytes per value when stored raw, 0 otherwise
+   uint64_t num;         // how many values
+   uint64_t numBytes;    // how long the payload is
+   uint64_t reserved;
+};
+static_assert(sizeof(SerialHeader) == 32);
+
+/***********************************************
+ * LOAD RAW
+ * The value whose bytes are at p, which need not
+ * be aligned for U
+ *   INPUT  : where the bytes are
+ *   OUTPUT : the value
+ **********************************************/
+template <class U>
+inline U loadRaw(const char * p)
+{
+   static_assert(std::is_trivially_copyable <U>::value, "read the parts one by one");
+   struct Raw { alignas(U) char bytes[sizeof(U)]; } raw;
+   memcpy(raw.bytes, p, sizeof(U));
+   return std::bit_cast <U> (raw);
+}
+
+/*************************************************
+ * BYTE WRITER
+ * Appends to the end of a buffer
+ *************************************************/
+class ByteWriter
+{
+public:
+   explicit ByteWriter(std::vector <char> & buffer) : buffer(buffer) { }
+
+   void put(const void * p, size_t num)
+   {
+      buffer.insert(buffer.end(), (const char *)p, (const char *)p + num);
+   }
+
+   template <class U>
+   void put(const U & u)
+   {
+      static_assert(std::is_trivially_copyable <U>::value, "write the parts one by one");
+      put(&u, sizeof(U));
+   }
+
+private:
+   std::vector <char> & buffer;
+};
+
+/*************************************************
+ * BYTE READER
+ * Reads from the front of a buffer.  Reading past
+ * the end throws rather than reading garbage.
+ *************************************************/
+class ByteReader
+{
+public:
+   ByteReader(const char * p, const char * pEnd) : p(p), pEnd(pEnd) { }
+
+   void get(void * pOut, size_t num)
+   {
+      if (num > remaining())
+         throw SerializeError("serialize: frame is cut short");
+      memcpy(pOut, p, num);
+      p += num;
+   }
+
+   template <class U>
+   U get()
+   {
+      if (sizeof(U) > remaining())
+         throw SerializeError("serialize: frame is cut short");
+      U u = loadRaw <U>(p);
+      p += sizeof(U);
+      return u;
+   }
+
+   const char * position() const { return p;        }
+   size_t remaining()      const { return pEnd - p; }
+
+private:
+   const char * p;
+   const char * pEnd;
+};
+
+/*************************************************
+ * SERIALIZER
+ * Specialize this for a type that is not trivially
+ * copyable, or to override the raw copy of one that
+ * is.  write() must put at least one byte for each
+ * value, so a frame never claims more values than it
+ * has bytes:
+ *    template <>
+ *    struct Serializer <Widget>
+ *    {
+ *       static void write(ByteWriter & out, const Widget & w);
+ *       static Widget read(ByteReader & in);
+ *    };
+ *************************************************/
+template <class T>
+struct Serializer;
+
+template <class T>
+concept HasSerializer = requires(ByteWriter & out, ByteReader & in, const T & t)
+{
+   Serializer <T>::write(out, t);
+   { Serializer <T>::read(in) } -> std::convertible_to <T>;
+};
+
+// stored as the values themselves, with nothing in between
+template <class T>
+inline constexpr bool isRawSerial = !HasSerializer <T> && std::is_trivially_copyable <T>::value;
+
+/*************************************************
+ * SERIALIZER : STRING
+ * The length, then the characters
+ *************************************************/
+template <>
+struct Serializer <std::string>
+{
+   static void write(ByteWriter & out, const std::string & s)
+   {
+      out.put((uint64_t)s.size());
+      out.put(s.data(), s.size());
+   }
+
+   static std::string read(ByteReader & in)
+   {
+      uint64_t num = in.get <uint64_t>();
+      if (num > in.remaining())
+         throw SerializeError("serialize: frame is cut short");
+      std::string s(num, '\0');
+      in.get(s.data(), num);
+      return s;
+   }
+};
+
+/***********************************************
+ * SERIALIZE
+ * Append the list to the buffer as one frame
+ *   INPUT  : pointer to the head of the linked list,
+ *            and the buffer to append to
+ *   COST   : O(n)
+ **********************************************/
+template <class T>
+void serialize(const Node <T> * pHead, std::vector <char> & buffer)
+{
+   static_assert(HasSerializer <T> || std::is_trivially_copyable <T>::value,
+                 "T needs a Serializer <T>");
+
+   size_t start = buffer.size();
+   SerialHeader header = { SerialHeader::MAGIC, 0, 0, 0, 0 };
+   buffer.resize(start + sizeof(SerialHeader));
+
+   if constexpr (isRawSerial <T>)
+   {
+      // one resize, then one memcpy per node
+      for (const Node <T> * p = pHead; p; p = p->pNext)
+         header.num++;
+      header.size = sizeof(T);
+      header.numBytes = header.num * sizeof(T);
+      buffer.resize(start + sizeof(SerialHeader) + header.numBytes);
+
+      char * pOut = buffer.data() + start + sizeof(SerialHeader);
+      for (const Node <T> * p = pHead; p; p = p->pNext, pOut += sizeof(T))
+         memcpy(pOut, &p->data, sizeof(T));
+   }
+   else
+   {
+      ByteWriter out(buffer);
+      for (const Node <T> * p = pHead; p; p = p->pNext)
+      {
+         Serializer <T>::write(out, p->data);
+         header.num++;
+      }
+      header.numBytes = buffer.size() - start - sizeof(SerialHeader);
+   }
+
+   memcpy(buffer.data() + start, &header, sizeof(SerialHeader));
+}
+
+/***********************************************
+ * SERIALIZE
+ * Write the list to a stream as one frame
+ *   INPUT  : pointer to the head of the linked list,
+ *            and the stream, which should be binary
+ *   COST   : O(n)
+ **********************************************/
+template <class T>
+void serialize(const Node <T> * pHead, std::ostream & out)
+{
+   std::vector <char> buffer;
+   serialize(pHead, buffer);
+   out.write(buffer.data(), buffer.size());
+}
+
+/***********************************************
+ * READ SERIAL HEADER
+ * The header at the front of the buffer, checked
+ * against what a frame of T must look like
+ *   INPUT  : the buffer, and how much of it there is
+ *   OUTPUT : the header
+ **********************************************/
+template <class T>
+SerialHeader readSerialHeader(const char * buffer, size_t size)
+{
+   SerialHeader header;
+   if (size < sizeof(SerialHeader))
+      throw SerializeError("serialize: frame is cut short");
+   memcpy(&header, buffer, sizeof(SerialHeader));
+
+   if (header.magic != SerialHeader::MAGIC)
+      throw SerializeError("serialize: not a list frame");
+   if (header.size != (isRawSerial <T> ? sizeof(T) : 0))
+      throw SerializeError("serialize: frame holds some other type");
+   if (header.numBytes > size - sizeof(SerialHeader))
+      throw SerializeError("serialize: frame is cut short");
+   if (isRawSerial <T> && (header.numBytes % sizeof(T) != 0 || header.numBytes / sizeof(T) != header.num))
+      throw SerializeError("serialize: frame has the wrong length");
+   if (!isRawSerial <T> && header.num > header.numBytes)
+      throw SerializeError("serialize: frame has the wrong length");   // a byte a value, at least
+   return header;
+}
+
+/***********************************************
+ * DESERIALIZE
+ * Build a list from the frame at the front of the
+ * buffer.  On error nothing is left in the pool.
+ *   INPUT  : the buffer, how much of it there is,
+ *            and the pool to build the list in
+ *   OUTPUT : the head of the new list, from the pool
+ *   COST   : O(n)
+ **********************************************/
+template <class T>
+Node <T> * deserialize(const char * buffer, size_t size, NodePool <T> & pool)
+{
+   static_assert(HasSerializer <T> || std::is_trivially_copyable <T>::value,
+                 "T needs a Serializer <T>");
+
+   SerialHeader header = readSerialHeader <T>(buffer, size);
+   const char * pPayload = buffer + sizeof(SerialHeader);
+   ByteReader in(pPayload, pPayload + header.numBytes);
+
+   Node <T> * pHead = nullptr;
+   Node <T> * pTail = nullptr;
+   try
+   {
+      for (uint64_t i = 0; i < header.num; i++)
+      {
+         Node <T> * pNode;
+         if constexpr (isRawSerial <T>)
+            pNode = pool.acquire(in.get <T>());
+         else
+            pNode = pool.acquire(Serializer <T>::read(in));
+
+         pNode->pPrev = pTail;
+         if (pTail)
+            pTail->pNext = pNode;
+         else
+            pHead = pNode;
+         pTail = pNode;
+      }
+      if (in.remaining() != 0)
+         throw SerializeError("serialize: frame has the wrong length");
+   }
+   catch (...)
+   {
+      pool.clear(pHead);
+      throw;
+   }
+   return pHead;
+}
+
+/***********************************************
+ * DESERIALIZE
+ * Build a list from the next frame in a stream.  The
+ * length in the header is not trusted: the payload
+ * is read a piece at a time, so a corrupt length
+ * runs out of stream, not out of memory.
+ *   INPUT  : the stream, which should be binary,
+ *            and the pool to build the list in
+ *   OUTPUT : the head of the new list, from the pool
+ *   COST   : O(n)
+ **********************************************/
+template <class T>
+Node <T> * deserialize(std::istream & in, NodePool <T> & pool)
+{
+   std::vector <char> buffer(sizeof(SerialHeader));
+   if (!in.read(buffer.data(), sizeof(SerialHeader)))
+      throw SerializeError("serialize: frame is cut short");
+
+   SerialHeader header = readSerialHeader <T>(buffer.data(), (size_t)-1);
+   const size_t PIECE = 1 << 20;
+   for (uint64_t numRead = 0; numRead < header.numBytes; )
+   {
+      size_t num = (size_t)std::min <uint64_t> (PIECE, header.numBytes - numRead);
+      buffer.resize(buffer.size() + num);
+      if (!in.read(buffer.data() + buffer.size() - num, num))
+         throw SerializeError("serialize: frame is cut short");
+      numRead += num;
+   }
+
+   return deserialize(buffer.data(), buffer.size(), pool);
+}
+
+/*************************************************
+ * FLAT LIST VIEW
+ * The values of a raw frame, iterated in the buffer
+ * that holds it: a file read into memory, an mmap,
+ * a network message.  Nothing is allocated and no
+ * nodes are built; each value is copied out as it
+ * is read, so the buffer need not be aligned.  The
+ * buffer must outlive the view.
+ *************************************************/
+template <class T>
+class FlatListView
+{
+   static_assert(isRawSerial <T>, "only a frame of raw values can be read in place");
+
+public:
+   //
+   // Walk it either way
+   //
+   class iterator
+   {
+   public:
+      using iterator_category = std::bidirectional_iterator_tag;
+      using value_type        = T;
+      using difference_type   = std::ptrdiff_t;
+      using reference         = T;
+
+      iterator() : p(nullptr) { }
+      explicit iterator(const char * p) : p(p) { }
+
+      T operator * () const            { return loadRaw <T>(p); }
+      iterator & operator ++ ()        { p += sizeof(T); return *this; }
+      iterator & operator -- ()        { p -= sizeof(T); return *this; }
+      iterator operator ++ (int)       { iterator old(*this); ++*this; return old; }
+      iterator operator -- (int)       { iterator old(*this); --*this; return old; }
+      bool operator == (const iterator & rhs) const { return p == rhs.p; }
+
+   private:
+      const char * p;
+   };
+
+   //
+   // Construct: from the frame at the front of a buffer
+   //
+   FlatListView() : pValues(nullptr), num(0) { }
+   FlatListView(const char * buffer, size_t size)
+   {
+      SerialHeader header = readSerialHeader <T>(buffer, size);
+      pValues = buffer + sizeof(SerialHeader);
+      num = header.num;
+   }
+   explicit FlatListView(const std::vector <char> & buffer) : FlatListView(buffer.data(), buffer.size()) { }
+
+   //
+   // Access
+   //
+   iterator begin()  const { return iterator(pValues);                     }
+   iterator end()    const { return iterator(pValues + num * sizeof(T));   }
+   size_t size()     const { return num;                                   }
+   bool empty()      const { return num == 0;                              }
+   T front()         const { return loadRaw <T>(pValues);                  }
+   T back()          const { return loadRaw <T>(pValues + (num - 1) * sizeof(T)); }
+   T operator [] (size_t i) const { return loadRaw <T>(pValues + i * sizeof(T)); }
+
+   // how far the frame goes, so the next one can be found
+   size_t numBytes() const { return sizeof(SerialHeader) + num * sizeof(T); }
+
+private:
+   const char * pValues;   // the first value, just after the header
+   size_t num;             // how many there are
+};
@@ -0,0 +1,216 @@
+/***********************************************************************
+ * Header:
+ *    SHARDED
+ * Summary:
+ *    When many threads append to one list they all fight over the same
+ *    tail pointer, and the cache line holding it bounces between cores.
+ *    A sharded list gives each thread its own chain to append to, so
+ *    appends from different threads do not touch the same memory.  The
+ *    chains are visited one after another, and collect() splices them
+ *    into one ordinary list without touching the nodes in between.
+ *
+ *    This will contain the class definition of:
+ *        ShardedList  : One Node chain per shard
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell
+ ************************************************************************/
+
+#pragma once
+
+#include <atomic>      // for std::atomic
+#include <cassert>     // for ASSERT
+#include <memory>      // for std::unique_ptr
+#include <mutex>       // for std::mutex
+#include <thread>      // for std::thread::hardware_concurrency
+#include "node.h"      // for Node
+
+/*************************************************
+ * SHARDED LIST
+ * Appends go to the calling thread's shard.  Each
+ * shard has its own lock, which only another thread
+ * on the same shard, forEach(), or collect() will
+ * ever contend for.  Order is kept within a shard,
+ * not across shards.
+ *************************************************/
+template <class T>
+class ShardedList
+{
+public:
+   //
+   // Construct with one shard per core by default
+   //
+   ShardedList(size_t numShards = 0);
+   ShardedList(const ShardedList &) = delete;
+   ShardedList & operator = (const ShardedList &) = delete;
+   ~ShardedList();
+
+   //
+   // Append to this thread's shard, or to a given one
+   //
+   Node <T> * pushBack(const T & t)                { return pushBack(myShard(), t); }
+   Node <T> * pushBack(size_t shard, const T & t);
+
+   //
+   // Visit every node, a shard at a time
+   //
+   template <class Visit>
+   void forEach(Visit visit);
+
+   //
+   // Take everything as one list; the shards are left empty
+   //
+   Node <T> * collect();
+
+   //
+   // Status
+   //
+   size_t size() const;
+   bool empty() const         { return size() == 0;        }
+   size_t numShards() const   { return num;                }
+   size_t myShard() const;
+
+private:
+   // a cache line each so neighbouring shards do not share one
+   struct alignas(64) Shard
+   {
+      std::mutex mutex;
+      Node <T> * pHead = nullptr;
+      Node <T> * pTail = nullptr;
+      std::atomic <size_t> size { 0 };
+   };
+
+   size_t num;
+   std::unique_ptr <Shard[]> shards;
+};
+
+/***********************************************
+ * SHARDED LIST :: CONSTRUCTOR / DESTRUCTOR
+ **********************************************/
+template <class T>
+ShardedList <T> :: ShardedList(size_t numShards) : num(numShards)
+{
+   if (num == 0)
+      num = std::thread::hardware_concurrency();
+   if (num == 0)
+      num = 1;
+   shards.reset(new Shard[num]);
+}
+
+template <class T>
+ShardedList <T> :: ~ShardedList()
+{
+   for (size_t i = 0; i < num; i++)
+      clear(shards[i].pHead);
+}
+
+/***********************************************
+ * SHARDED LIST :: MY SHARD
+ * Threads are numbered in the order they first ask,
+ * so the first numShards threads never share
+ **********************************************/
+template <class T>
+size_t ShardedList <T> :: myShard() const
+{
+   static std::atomic <size_t> numThreads(0);
+   thread_local size_t id = numThreads++;
+   return id % num;
+}
+
+/***********************************************
+ * SHARDED LIST :: PUSH BACK
+ * Add to the end of one shard.  The node is built
+ * before the lock is taken.
+ *   INPUT  : the shard and the value
+ *   OUTPUT : the new node
+ *   COST   : O(1)
+ **********************************************/
+template <class T>
+Node <T> * ShardedList <T> :: pushBack(size_t shard, const T & t)
+{
+   assert(shard < num);
+   Shard & s = shards[shard];
+   Node <T> * pNew = new Node <T>(t);
+
+   std::lock_guard <std::mutex> lock(s.mutex);
+   pNew->pPrev = s.pTail;
+   if (s.pTail)
+      s.pTail->pNext = pNew;
+   else
+      s.pHead = pNew;
+   s.pTail = pNew;
+   s.size.fetch_add(1, std::memory_order_relaxed);
+   return pNew;
+}
+
+/***********************************************
+ * SHARDED LIST :: FOR EACH
+ * Visit every node, shard 0 first.  Each shard is
+ * locked only while it is being visited, so appends
+ * to the others carry on.
+ *   INPUT  : visit(T &)
+ *   COST   : O(n)
+ **********************************************/
+template <class T>
+template <class Visit>
+void ShardedList <T> :: forEach(Visit visit)
+{
+   for (size_t i = 0; i < num; i++)
+   {
+      std::lock_guard <std::mutex> lock(shards[i].mutex);
+      for (Node <T> * p = shards[i].pHead; p; p = p->pNext)
+         visit(p->data);
+   }
+}
+
+/***********************************************
+ * SHARDED LIST :: COLLECT
+ * Splice the shards end to end.  Every shard is
+ * locked at once so the result is one moment's list.
+ *   OUTPUT : the head of the combined list
+ *   COST   : O(shards)
+ **********************************************/
+template <class T>
+Node <T> * ShardedList <T> :: collect()
+{
+   for (size_t i = 0; i < num; i++)
+      shards[i].mutex.lock();
+
+   Node <T> * pHead = nullptr;
+   Node <T> * pTail = nullptr;
+   for (size_t i = 0; i < num; i++)
+   {
+      Shard & s = shards[i];
+      if (s.pHead)
+      {
+         if (pTail)
+         {
+            pTail->pNext = s.pHead;
+            s.pHead->pPrev = pTail;
+         }
+         else
+            pHead = s.pHead;
+         pTail = s.pTail;
+      }
+      s.pHead = s.pTail = nullptr;
+      s.size.store(0, std::memory_order_relaxed);
+   }
+
+   for (size_t i = num; i > 0; i--)
+      shards[i - 1].mutex.unlock();
+   return pHead;
+}
+
+/***********************************************
+ * SHARDED LIST :: SIZE
+ * The sum of the shard sizes.  Appends racing with
+ * this may or may not be counted.
+ *   COST   : O(shards)
+ **********************************************/
+template <class T>
+size_t ShardedList <T> :: size() const
+{
+   size_t total = 0;
+   for (size_t i = 0; i < num; i++)
+      total += shards[i].size.load(std::memory_order_relaxed);
+   return total;
+}
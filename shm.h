@@ -0,0 +1,353 @@
+/***********************************************************************
+ * Header:
+ *    SHM
+ * Summary:
+ *    A list in POSIX shared memory, so other processes can walk it in
+ *    place instead of having it serialized and piped to them.  One
+ *    process creates the segment and appends; any number of others open
+ *    it by name and read, with no locks and no copies.
+ *
+ *    Each process maps the segment somewhere different, so nodes link
+ *    by offset from the start of the segment, the same as MappedList.
+ *    A node is written in full before the link to it is stored with
+ *    release; a reader loads each link with acquire, so it never sees
+ *    half a node.  Nothing is ever removed, so a node a reader is on
+ *    stays valid.  The segment does not grow: it holds capacity nodes.
+ *    Readers map it read-only, so a stray write in a reader faults
+ *    instead of corrupting the list for everyone.
+ *
+ *    A reader that opens the name in the moment between the appender
+ *    creating it and writing its header gets std::system_error with
+ *    EAGAIN: the segment is not ready yet, and trying again shortly
+ *    will work.  Any other failure is permanent.  POSIX only.
+ *
+ *    This will contain the class definition of:
+ *        ShmList      : An append-only list other processes can read
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell
+ ************************************************************************/
+
+#pragma once
+
+#ifndef _WIN32
+
+#include <atomic>       // for std::atomic
+#include <cassert>      // for ASSERT
+#include <cerrno>       // for errno
+#include <cstdint>      // for uint64_t
+#include <new>          // for placement new
+#include <stdexcept>    // for std::runtime_error
+#include <string>       // for std::string
+#include <system_error> // for std::system_error
+#include <type_traits>  // for std::is_trivially_copyable
+#include <fcntl.h>      // for O_CREAT
+#include <sys/mman.h>   // for shm_open
+#include <sys/stat.h>   // for fstat
+#include <unistd.h>     // for ftruncate
+#include "mapped.h"     // for MappedNode
+#include "node.h"       // for Node
+
+/*************************************************
+ * SHARED HEADER
+ * The first 64 bytes of the segment.  Only head,
+ * tail, and num change once readers are attached.
+ *************************************************/
+struct ShmHeader
+{
+   static constexpr uint32_t MAGIC = 0x4c524853;   // "SHRL"
+
+   uint32_t magic;
+   uint32_t size;                    // sizeof(T), to catch the wrong T
+   uint64_t capacity;                // slots in the segment
+   std::atomic <uint64_t> head;      // offset of the first node, 0 for none
+   std::atomic <uint64_t> tail;      // offset of the last node, 0 for none
+   std::atomic <uint64_t> num;       // nodes appended so far
+   uint64_t reserved[3];
+};
+static_assert(sizeof(ShmHeader) == 64);
+static_assert(std::atomic <uint64_t>::is_always_lock_free,
+              "atomics in shared memory must not hide a lock in this process");
+
+/*************************************************
+ * SHARED LIST
+ * Whoever creates it appends; whoever opens it reads.
+ * Offsets are good in every process that has it
+ * open; at() turns one into a value.
+ *************************************************/
+template <class T>
+class ShmList
+{
+   static_assert(std::is_trivially_copyable <T>::value,
+                 "a shared list holds raw bytes, not objects that own memory");
+
+public:
+   using Offset = uint64_t;
+
+   //
+   // Construct: create a new segment and be its appender,
+   // or open one that another process created
+   //
+   ShmList(const std::string & name, size_t capacity, bool replace = false);
+   explicit ShmList(const std::string & name);
+   ShmList(const ShmList &) = delete;
+   ShmList & operator = (const ShmList &) = delete;
+   ~ShmList();
+
+   //
+   // Append: only the process that created the list
+   //
+   Offset pushBack(const T & t);
+
+   //
+   // Read: any process
+   //
+   Offset head() const               { return header().head.load(std::memory_order_acquire); }
+   Offset next(Offset p) const;
+   Offset prev(Offset p) const       { return node(p).prev; }
+   const T & at(Offset p) const      { return node(p).data; }
+
+   template <class Visit>
+   size_t forEach(Visit visit) const;
+   Node <T> * copy() const;
+
+   //
+   // Status
+   //
+   size_t size()     const { return header().num.load(std::memory_order_acquire); }
+   bool empty()      const { return size() == 0;                                  }
+   size_t capacity() const { return header().capacity;                            }
+   bool isAppender() const { return appender;                                     }
+
+private:
+   static constexpr Offset FIRST = sizeof(ShmHeader);
+
+   ShmHeader & header() const { return *reinterpret_cast <ShmHeader *> (pBase); }
+   MappedNode <T> & node(Offset p) const { return *reinterpret_cast <MappedNode <T> *> (pBase + p); }
+
+   void map(size_t length, int protection);
+   static size_t lengthFor(size_t capacity) { return FIRST + capacity * sizeof(MappedNode <T>); }
+
+   std::string name;     // what the segment is called
+   int fd;               // the open segment
+   char * pBase;         // where it is mapped in this process
+   size_t length;        // how long it is
+   bool appender;        // did we create it?
+   uint64_t numUsed;     // the appender's count of slots handed out
+};
+
+/***********************************************
+ * SHARED LIST :: CONSTRUCTOR
+ * Create a segment with room for capacity nodes.
+ * If the name is taken, another appender may still
+ * own it, so this fails with EEXIST unless replace
+ * says to unlink it first, as after a crash left one
+ * behind.  Readers of a replaced segment keep the
+ * old one until they close it.
+ *   INPUT  : the name, such as "/ticks", the number
+ *            of nodes it will hold, and whether to
+ *            replace a segment already by that name
+ **********************************************/
+template <class T>
+ShmList <T> :: ShmList(const std::string & name, size_t capacity, bool replace) :
+   name(name), fd(-1), pBase(nullptr), length(0), appender(true), numUsed(0)
+{
+   if (replace)
+      ::shm_unlink(name.c_str());
+   fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+   if (fd < 0 && errno == EEXIST)
+      throw std::system_error(errno, std::generic_category(), "shm: " + name + " already exists");
+   if (fd < 0)
+      throw std::system_error(errno, std::generic_category(), "shm: shm_open " + name);
+
+   try
+   {
+      if (::ftruncate(fd, lengthFor(capacity)) != 0)
+         throw std::system_error(errno, std::generic_category(), "shm: ftruncate " + name);
+      map(lengthFor(capacity), PROT_READ | PROT_WRITE);
+   }
+   catch (...)
+   {
+      ::close(fd);
+      ::shm_unlink(name.c_str());
+      throw;
+   }
+
+   ShmHeader * pHeader = new (pBase) ShmHeader;
+   pHeader->size = sizeof(T);
+   pHeader->capacity = capacity;
+   pHeader->head.store(0, std::memory_order_relaxed);
+   pHeader->tail.store(0, std::memory_order_relaxed);
+   pHeader->num.store(0, std::memory_order_relaxed);
+   std::atomic_ref <uint32_t> (pHeader->magic).store(ShmHeader::MAGIC, std::memory_order_release);
+}
+
+/***********************************************
+ * SHARED LIST :: CONSTRUCTOR
+ * Open a segment that the appender has created, and
+ * map it read-only
+ *   INPUT  : its name
+ *   THROWS : std::system_error with EAGAIN if the
+ *            appender has created it but not yet
+ *            written its header; try again
+ **********************************************/
+template <class T>
+ShmList <T> :: ShmList(const std::string & name) :
+   name(name), fd(-1), pBase(nullptr), length(0), appender(false), numUsed(0)
+{
+   fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+   if (fd < 0)
+      throw std::system_error(errno, std::generic_category(), "shm: shm_open " + name);
+
+   try
+   {
+      // the appender sizes the segment, then stores the magic last
+      struct stat info;
+      if (::fstat(fd, &info) != 0)
+         throw std::system_error(errno, std::generic_category(), "shm: fstat " + name);
+      if ((size_t)info.st_size < sizeof(ShmHeader))
+         throw std::system_error(EAGAIN, std::generic_category(), "shm: " + name + " is not ready");
+      map(info.st_size, PROT_READ);
+
+      uint32_t magic = std::atomic_ref <uint32_t> (header().magic).load(std::memory_order_acquire);
+      if (magic == 0)
+         throw std::system_error(EAGAIN, std::generic_category(), "shm: " + name + " is not ready");
+      if (magic != ShmHeader::MAGIC)
+         throw std::runtime_error("shm: " + name + " is not a list");
+      if (header().size != sizeof(T))
+         throw std::runtime_error("shm: " + name + " holds some other type");
+      if (lengthFor(header().capacity) > length)
+         throw std::runtime_error("shm: " + name + " is cut short");
+   }
+   catch (...)
+   {
+      if (pBase)
+         ::munmap(pBase, length);
+      ::close(fd);
+      throw;
+   }
+}
+
+/***********************************************
+ * SHARED LIST :: DESTRUCTOR
+ * Unmap the segment.  The appender also removes the
+ * name, unless another appender has replaced it;
+ * readers that still have it mapped keep reading
+ * until they let go.
+ **********************************************/
+template <class T>
+ShmList <T> :: ~ShmList()
+{
+   if (appender)
+   {
+      int fdNamed = ::shm_open(name.c_str(), O_RDONLY, 0);
+      struct stat ours;
+      struct stat named;
+      if (fdNamed >= 0 && ::fstat(fd, &ours) == 0 && ::fstat(fdNamed, &named) == 0 &&
+          ours.st_dev == named.st_dev && ours.st_ino == named.st_ino)
+         ::shm_unlink(name.c_str());
+      if (fdNamed >= 0)
+         ::close(fdNamed);
+   }
+   ::munmap(pBase, length);
+   ::close(fd);
+}
+
+/***********************************************
+ * SHARED LIST :: MAP
+ * Map the whole segment into this process
+ *   INPUT  : how long it is, and PROT_READ alone
+ *            for a reader
+ **********************************************/
+template <class T>
+void ShmList <T> :: map(size_t length, int protection)
+{
+   void * p = ::mmap(nullptr, length, protection, MAP_SHARED, fd, 0);
+   if (p == MAP_FAILED)
+      throw std::system_error(errno, std::generic_category(), "shm: mmap " + name);
+   pBase = (char *)p;
+   this->length = length;
+}
+
+/***********************************************
+ * SHARED LIST :: PUSH BACK
+ * Append t.  The node is filled in first and then
+ * published, so readers see all of it or none.
+ *   INPUT  : t
+ *   OUTPUT : the offset of the new node, or 0 when
+ *            the segment is full
+ *   COST   : O(1)
+ **********************************************/
+template <class T>
+typename ShmList <T> :: Offset ShmList <T> :: pushBack(const T & t)
+{
+   assert(appender);   // only the process that created the list appends
+   if (numUsed == header().capacity)
+      return 0;
+
+   Offset p = FIRST + numUsed++ * sizeof(MappedNode <T>);
+   Offset pTail = header().tail.load(std::memory_order_relaxed);
+   MappedNode <T> & n = node(p);
+   n.data = t;
+   n.prev = pTail;
+   std::atomic_ref <uint64_t> (n.next).store(0, std::memory_order_relaxed);
+
+   if (pTail)
+      std::atomic_ref <uint64_t> (node(pTail).next).store(p, std::memory_order_release);
+   else
+      header().head.store(p, std::memory_order_release);
+   header().tail.store(p, std::memory_order_release);
+   header().num.fetch_add(1, std::memory_order_release);
+   return p;
+}
+
+/***********************************************
+ * SHARED LIST :: NEXT
+ * The node after p, or 0 if the appender has not
+ * got that far yet
+ *   INPUT  : a node
+ *   OUTPUT : the one after it
+ **********************************************/
+template <class T>
+typename ShmList <T> :: Offset ShmList <T> :: next(Offset p) const
+{
+   return std::atomic_ref <uint64_t> (node(p).next).load(std::memory_order_acquire);
+}
+
+/***********************************************
+ * SHARED LIST :: FOR EACH
+ * Visit every value appended so far, in place
+ *   INPUT  : visit(const T &)
+ *   OUTPUT : how many were visited
+ *   COST   : O(n)
+ **********************************************/
+template <class T>
+template <class Visit>
+size_t ShmList <T> :: forEach(Visit visit) const
+{
+   size_t num = 0;
+   for (Offset p = head(); p; p = next(p), num++)
+      visit(at(p));
+   return num;
+}
+
+/***********************************************
+ * SHARED LIST :: COPY
+ * The values appended so far, as a list in memory
+ *   OUTPUT : the new list
+ *   COST   : O(n)
+ **********************************************/
+template <class T>
+Node <T> * ShmList <T> :: copy() const
+{
+   Node <T> * pHead = nullptr;
+   Node <T> * pTail = nullptr;
+   forEach([&pHead, &pTail](const T & t)
+   {
+      pTail = ::insert(pTail, t, true);
+      if (pHead == nullptr)
+         pHead = pTail;
+   });
+   return pHead;
+}
+
+#endif // _WIN32
@@ -0,0 +1,469 @@
+/***********************************************************************
+ * Header:
+ *    SKIPLIST
+ * Summary:
+ *    A sorted set that any number of threads can search and change at
+ *    once without locks.  Every value sits in a tower of links; the
+ *    bottom link of each tower is the pNext of an ordinary Node, so the
+ *    bottom level is a sorted node.h list and the levels above it are
+ *    express lanes for finding a place in it.
+ *
+ *    A value is removed in two steps: its links are marked (the low bit
+ *    of each pointer is set), which removes it logically and stops
+ *    anybody linking after it, and then it is unlinked by whoever next
+ *    walks past it.  A tower can be removed while its inserter is still
+ *    raising it, so both the inserter and the remover hold a claim on
+ *    it; each unlinks it everywhere it can still be before letting go,
+ *    and the last to let go retires it to an RCUDomain.  Every thread
+ *    that touches the list must hold an online RCUReader on that
+ *    domain.
+ *
+ *    While threads are changing the list, pPrev is only a hint and the
+ *    bottom level may hold marked links; when they stop, fixPrev() makes
+ *    the bottom level a well formed doubly linked list again.
+ *
+ *    This will contain the class definition of:
+ *        SkipList     : The set
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell
+ ************************************************************************/
+
+#pragma once
+
+#include <atomic>      // for std::atomic_ref
+#include <cstdint>     // for uintptr_t and uint64_t
+#include <new>         // for placement new
+#include "node.h"      // for Node
+#include "rcu.h"       // for RCUDomain
+
+/*************************************************
+ * SKIPLIST
+ * A set of T, kept in order by operator <.  Node
+ * pointers that come out are good until the thread
+ * calls quiescent() on its RCUReader.
+ *************************************************/
+template <class T>
+class SkipList
+{
+public:
+   enum { MAX_LEVEL = 16 };
+
+   //
+   // Construct
+   //
+   SkipList(RCUDomain & domain);
+   SkipList(const SkipList &) = delete;
+   SkipList & operator = (const SkipList &) = delete;
+   ~SkipList();
+
+   //
+   // Any thread, any time
+   //
+   bool insert(const T & t);
+   bool remove(const T & t);
+   const Node <T> * find(const T & t);
+   bool contains(const T & t) { return find(t) != nullptr; }
+   template <class Visit>
+   size_t scan(const T & low, const T & high, Visit visit);
+   size_t size();
+
+   //
+   // Only while no other thread is using the list
+   //
+   Node <T> * head() const { return unmarked(heads[0]); }
+   void fixPrev();
+
+private:
+   // a Node whose pNext is the bottom of its tower.  The rest of the
+   // tower lives right after it in the same allocation.
+   struct Tower : public Node <T>
+   {
+      static Tower * create(const T & t, int height)
+      {
+         void * p = ::operator new(sizeof(Tower) + (height - 1) * sizeof(Node <T> *));
+         try
+         {
+            return new (p) Tower(t, height);
+         }
+         catch (...)
+         {
+            ::operator delete(p);
+            throw;
+         }
+      }
+      static void destroy(Node <T> * p)
+      {
+         static_cast <Tower *> (p)->~Tower();
+         ::operator delete(static_cast <Tower *> (p));
+      }
+
+      Tower(const T & t, int height) : Node <T>(t), height(height), claims(2),
+         upper(reinterpret_cast <Node <T> **> (this + 1))
+      {
+         for (int level = 1; level < height; level++)
+            new (upper + level - 1) Node <T> * (nullptr);
+      }
+
+      int height;
+      std::atomic <int> claims;   // the inserter and the remover
+      Node <T> ** upper;          // levels 1 .. height - 1
+   };
+
+   // one link of a tower, or of the heads when p is NULL
+   Node <T> * & linkOf(Node <T> * p, int level)
+   {
+      if (p == nullptr)
+         return heads[level];
+      return level == 0 ? p->pNext : static_cast <Tower *> (p)->upper[level - 1];
+   }
+   static std::atomic_ref <Node <T> *> ref(Node <T> * & link) { return std::atomic_ref <Node <T> *> (link); }
+
+   static bool isMarked(Node <T> * p) { return reinterpret_cast <uintptr_t> (p) & 1; }
+   static Node <T> * marked(Node <T> * p)
+   {
+      return reinterpret_cast <Node <T> *> (reinterpret_cast <uintptr_t> (p) | 1);
+   }
+   static Node <T> * unmarked(Node <T> * p)
+   {
+      return reinterpret_cast <Node <T> *> (reinterpret_cast <uintptr_t> (p) & ~(uintptr_t)1);
+   }
+
+   bool search(const T & t, Node <T> * preds[], Node <T> * succs[]);
+   void mark(Node <T> * p, int level);
+   static int randomHeight();
+   void retire(Node <T> * p)
+   {
+      domain.retire(p, [](void * pDead) { Tower::destroy(static_cast <Node <T> *> (pDead)); });
+   }
+   void letGo(Node <T> * p)
+   {
+      if (static_cast <Tower *> (p)->claims.fetch_sub(1, std::memory_order_acq_rel) == 1)
+         retire(p);
+   }
+
+   RCUDomain & domain;
+   Node <T> * heads[MAX_LEVEL];   // the links out of the left edge
+};
+
+/***********************************************
+ * SKIPLIST :: CONSTRUCTOR / DESTRUCTOR
+ * The destructor assumes nobody else is using the
+ * list; what it retired earlier the domain frees.
+ **********************************************/
+template <class T>
+SkipList <T> :: SkipList(RCUDomain & domain) : domain(domain)
+{
+   for (auto & head : heads)
+      head = nullptr;
+}
+
+template <class T>
+SkipList <T> :: ~SkipList()
+{
+   domain.reclaim();
+   Node <T> * p = unmarked(heads[0]);
+   while (p)
+   {
+      Node <T> * pDelete = p;
+      p = unmarked(p->pNext);
+      Tower::destroy(pDelete);
+   }
+}
+
+/***********************************************
+ * SKIPLIST :: RANDOM HEIGHT
+ * One level, and one more with probability 1/4 each
+ * time, so there is a tower of height h for every
+ * 4^(h-1) values
+ **********************************************/
+template <class T>
+int SkipList <T> :: randomHeight()
+{
+   thread_local uint64_t state = 0x9E3779B97F4A7C15ull ^ reinterpret_cast <uintptr_t> (&state);
+   state ^= state << 13;
+   state ^= state >> 7;
+   state ^= state << 17;
+
+   int height = 1;
+   for (uint64_t bits = state; height < MAX_LEVEL && (bits & 3) == 0; bits >>= 2)
+      height++;
+   return height;
+}
+
+/***********************************************
+ * SKIPLIST :: SEARCH
+ * Find, at every level, the last node before t and
+ * the first node not before it, unlinking any marked
+ * node in the way
+ *   INPUT  : t
+ *   OUTPUT : preds - the node before, NULL for the heads
+ *            succs - the node after, or NULL
+ *            whether succs[0] holds t
+ *   COST   : O(log n) expected
+ **********************************************/
+template <class T>
+bool SkipList <T> :: search(const T & t, Node <T> * preds[], Node <T> * succs[])
+{
+retry:
+   Node <T> * pPred = nullptr;
+   for (int level = MAX_LEVEL - 1; level >= 0; level--)
+   {
+      Node <T> * pCurr = unmarked(ref(linkOf(pPred, level)).load());
+      while (pCurr)
+      {
+         Node <T> * pSucc = ref(linkOf(pCurr, level)).load();
+         if (isMarked(pSucc))
+         {
+            // pCurr is on its way out: take it out of this level
+            Node <T> * expected = pCurr;
+            if (!ref(linkOf(pPred, level)).compare_exchange_strong(expected, unmarked(pSucc)))
+               goto retry;
+            if (level == 0 && unmarked(pSucc))
+               ref(unmarked(pSucc)->pPrev).store(pPred, std::memory_order_relaxed);
+            pCurr = unmarked(pSucc);
+         }
+         else if (pCurr->data < t)
+         {
+            pPred = pCurr;
+            pCurr = pSucc;
+         }
+         else
+            break;
+      }
+      preds[level] = pPred;
+      succs[level] = pCurr;
+   }
+   return succs[0] && !(t < succs[0]->data);
+}
+
+/***********************************************
+ * SKIPLIST :: INSERT
+ * Link t in at the bottom, which puts it in the set,
+ * then raise the rest of its tower.  If it is removed
+ * meanwhile, stop raising it; a link made after the
+ * remover's search would be missed by it, so search
+ * again before letting go.
+ *   INPUT  : t
+ *   OUTPUT : false if t was already there
+ *   COST   : O(log n) expected
+ **********************************************/
+template <class T>
+bool SkipList <T> :: insert(const T & t)
+{
+   Node <T> * preds[MAX_LEVEL];
+   Node <T> * succs[MAX_LEVEL];
+   int height = randomHeight();
+   Tower * pNew = nullptr;
+
+   for (;;)
+   {
+      if (search(t, preds, succs))
+      {
+         if (pNew)
+            Tower::destroy(pNew);
+         return false;
+      }
+      if (pNew == nullptr)
+         pNew = Tower::create(t, height);
+      for (int level = 0; level < height; level++)
+         ref(linkOf(pNew, level)).store(succs[level], std::memory_order_relaxed);
+      pNew->pPrev = preds[0];
+
+      Node <T> * expected = succs[0];
+      if (ref(linkOf(preds[0], 0)).compare_exchange_strong(expected, pNew))
+         break;
+   }
+   if (succs[0])
+      ref(succs[0]->pPrev).store(pNew, std::memory_order_relaxed);
+
+   bool raising = true;
+   for (int level = 1; raising && level < height && !isMarked(ref(pNew->pNext).load()); level++)
+      for (;;)
+      {
+         // someone removed us while we were still being built
+         Node <T> * pSucc = ref(linkOf(pNew, level)).load();
+         if (isMarked(pSucc))
+         {
+            raising = false;
+            break;
+         }
+         if (pSucc != succs[level] &&
+             !ref(linkOf(pNew, level)).compare_exchange_strong(pSucc, succs[level]))
+            continue;
+
+         Node <T> * expected = succs[level];
+         if (ref(linkOf(preds[level], level)).compare_exchange_strong(expected, pNew))
+            break;
+         search(t, preds, succs);
+         if (succs[0] != pNew)
+         {
+            raising = false;
+            break;
+         }
+      }
+
+   // we link nothing more; a remover that swept before our last link missed it
+   if (isMarked(ref(pNew->pNext).load()))
+      search(t, preds, succs);
+   letGo(pNew);
+   return true;
+}
+
+/***********************************************
+ * SKIPLIST :: MARK
+ * Set the mark on one link of a tower
+ **********************************************/
+template <class T>
+void SkipList <T> :: mark(Node <T> * p, int level)
+{
+   Node <T> * pSucc = ref(linkOf(p, level)).load();
+   while (!isMarked(pSucc))
+      ref(linkOf(p, level)).compare_exchange_weak(pSucc, marked(pSucc));
+}
+
+/***********************************************
+ * SKIPLIST :: REMOVE
+ * Mark t's tower from the top down; whoever marks
+ * the bottom link has removed it.  The winner then
+ * searches once more to unlink it everywhere and
+ * lets go of it; if the inserter still holds it,
+ * the inserter retires it when it is done.
+ *   INPUT  : t
+ *   OUTPUT : false if t was not there
+ *   COST   : O(log n) expected
+ **********************************************/
+template <class T>
+bool SkipList <T> :: remove(const T & t)
+{
+   Node <T> * preds[MAX_LEVEL];
+   Node <T> * succs[MAX_LEVEL];
+   if (!search(t, preds, succs))
+      return false;
+
+   Node <T> * pVictim = succs[0];
+   for (int level = static_cast <Tower *> (pVictim)->height - 1; level > 0; level--)
+      mark(pVictim, level);
+
+   Node <T> * pSucc = ref(pVictim->pNext).load();
+   for (;;)
+   {
+      if (isMarked(pSucc))
+         return false;                   // somebody else got there first
+      if (ref(pVictim->pNext).compare_exchange_strong(pSucc, marked(pSucc)))
+         break;
+   }
+
+   search(t, preds, succs);
+   letGo(pVictim);
+   return true;
+}
+
+/***********************************************
+ * SKIPLIST :: FIND
+ * Walk down without changing anything
+ *   INPUT  : t
+ *   OUTPUT : the node holding t, or NULL
+ *   COST   : O(log n) expected
+ **********************************************/
+template <class T>
+const Node <T> * SkipList <T> :: find(const T & t)
+{
+   Node <T> * pPred = nullptr;
+   Node <T> * pCurr = nullptr;
+   for (int level = MAX_LEVEL - 1; level >= 0; level--)
+   {
+      pCurr = unmarked(ref(linkOf(pPred, level)).load(std::memory_order_acquire));
+      while (pCurr)
+      {
+         Node <T> * pSucc = ref(linkOf(pCurr, level)).load(std::memory_order_acquire);
+         if (isMarked(pSucc) || pCurr->data < t)
+         {
+            if (!isMarked(pSucc))
+               pPred = pCurr;
+            pCurr = unmarked(pSucc);
+         }
+         else
+            break;
+      }
+   }
+
+   if (pCurr && !(t < pCurr->data) && !isMarked(ref(pCurr->pNext).load(std::memory_order_acquire)))
+      return pCurr;
+   return nullptr;
+}
+
+/***********************************************
+ * SKIPLIST :: SCAN
+ * Visit every value in [low, high) in order
+ *   INPUT  : low, high, visit(const T &)
+ *   OUTPUT : how many were visited
+ *   COST   : O(log n + k) expected
+ **********************************************/
+template <class T>
+template <class Visit>
+size_t SkipList <T> :: scan(const T & low, const T & high, Visit visit)
+{
+   Node <T> * preds[MAX_LEVEL];
+   Node <T> * succs[MAX_LEVEL];
+   search(low, preds, succs);
+
+   size_t num = 0;
+   for (Node <T> * p = succs[0]; p && p->data < high; )
+   {
+      Node <T> * pNext = ref(p->pNext).load(std::memory_order_acquire);
+      if (!isMarked(pNext))
+      {
+         visit(p->data);
+         num++;
+      }
+      p = unmarked(pNext);
+   }
+   return num;
+}
+
+/***********************************************
+ * SKIPLIST :: SIZE
+ * Count the values not being removed
+ *   COST   : O(n)
+ **********************************************/
+template <class T>
+size_t SkipList <T> :: size()
+{
+   size_t num = 0;
+   for (Node <T> * p = unmarked(ref(heads[0]).load()); p; )
+   {
+      Node <T> * pNext = ref(p->pNext).load(std::memory_order_acquire);
+      if (!isMarked(pNext))
+         num++;
+      p = unmarked(pNext);
+   }
+   return num;
+}
+
+/***********************************************
+ * SKIPLIST :: FIX PREV
+ * Unlink anything still marked and set every pPrev,
+ * so the bottom level is a plain node.h list
+ *   COST   : O(n)
+ **********************************************/
+template <class T>
+void SkipList <T> :: fixPrev()
+{
+   Node <T> * preds[MAX_LEVEL];
+   Node <T> * succs[MAX_LEVEL];
+   for (Node <T> * p = heads[0]; p; )
+      if (isMarked(p->pNext))
+      {
+         search(p->data, preds, succs);   // unlinks it everywhere
+         p = heads[0];
+      }
+      else
+         p = p->pNext;
+
+   Node <T> * pPrev = nullptr;
+   for (Node <T> * p = heads[0]; p; p = p->pNext)
+   {
+      p->pPrev = pPrev;
+      pPrev = p;
+   }
+}
@@ -0,0 +1,279 @@
+/***********************************************************************
+ * Header:
+ *    TEST COMBINING
+ * Summary:
+ *    Unit tests for the flat-combining list
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "combining.h"  // class under test
+#include "spy.h"        // for Spy
+#include "unitTest.h"   // unit test baseclass
+
+#include <atomic>       // for std::atomic
+#include <stdexcept>    // for std::runtime_error
+#include <string>       // for std::string
+#include <thread>       // for std::thread
+#include <vector>       // for std::vector
+
+/***********************************************
+ * TEST COMBINING
+ * Unit tests for CombiningList
+ ***********************************************/
+class TestCombining : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Insert
+      test_insert_empty();
+      test_insert_standard();
+      test_insert_spy();
+      test_insert_throws();
+
+      // Remove
+      test_remove_nullptr();
+      test_remove_ends();
+      test_remove_spy();
+
+      // Concurrent
+      test_insert_concurrent();
+      test_mixed_concurrent();
+
+      report("Combining");
+   }
+
+   /***************************************
+    * INSERT
+    ***************************************/
+
+   // insert into an empty list
+   void test_insert_empty()
+   {  // setup
+      CombiningList <int> list;
+      // exercise
+      Node <int> * p = list.insert(nullptr, 26);
+      // verify
+      assertUnit(list.head() == p);
+      assertUnit(p && p->data == 26);
+      assertUnit(p && p->pNext == nullptr && p->pPrev == nullptr);
+      assertUnit(list.size() == 1);
+   }  // teardown
+
+   // build the standard fixture front, back, and middle
+   void test_insert_standard()
+   {  // setup
+      CombiningList <int> list;
+      // exercise
+      Node <int> * p26 = list.insert(nullptr, 26);
+      list.insert(nullptr, 31, true /* after */);   // the back
+      Node <int> * p11 = list.insert(nullptr, 11);  // the front
+      list.insert(p26, 20);
+      list.insert(p11, 15, true);
+      // verify
+      //    +----+   +----+   +----+   +----+   +----+
+      //    | 11 | - | 15 | - | 20 | - | 26 | - | 31 |
+      //    +----+   +----+   +----+   +----+   +----+
+      assertUnit(values(list) == "11 15 20 26 31");
+      assertUnit(backwards(list) == "31 26 20 15 11");
+      assertUnit(list.size() == 5);
+   }  // teardown
+
+   // the value is copied once, into a pooled node
+   void test_insert_spy()
+   {  // setup
+      CombiningList <Spy> list;
+      Spy s(26);
+      Spy::reset();
+      // exercise
+      list.insert(nullptr, s);
+      // verify
+      assertUnit(Spy::numCopy() == 1);
+      assertUnit(Spy::numAlloc() == 1);
+      assertUnit(Spy::numDelete() == 0);
+   }  // teardown
+
+   // a throwing copy comes back to the caller and leaves the list alone
+   void test_insert_throws()
+   {  // setup
+      CombiningList <Fussy> list;
+      list.insert(nullptr, Fussy(11));
+      bool caught = false;
+      // exercise
+      try
+      {
+         list.insert(nullptr, Fussy(-1), true);
+      }
+      catch (const std::runtime_error &)
+      {
+         caught = true;
+      }
+      // verify
+      assertUnit(caught);
+      assertUnit(list.size() == 1);
+      assertUnit(list.head() && list.head()->data.value == 11);
+      assertUnit(list.insert(nullptr, Fussy(26), true) != nullptr);   // still usable
+      assertUnit(list.size() == 2);
+   }  // teardown
+
+   /***************************************
+    * REMOVE
+    ***************************************/
+
+   // removing nothing does nothing
+   void test_remove_nullptr()
+   {  // setup
+      CombiningList <int> list;
+      list.insert(nullptr, 26);
+      // exercise
+      Node <int> * p = list.remove(nullptr);
+      // verify
+      assertUnit(p == nullptr);
+      assertUnit(list.size() == 1);
+   }  // teardown
+
+   // removing the front and back moves the ends
+   void test_remove_ends()
+   {  // setup
+      CombiningList <int> list;
+      Node <int> * p11 = list.insert(nullptr, 11, true);
+      Node <int> * p26 = list.insert(nullptr, 26, true);
+      Node <int> * p31 = list.insert(nullptr, 31, true);
+      // exercise
+      Node <int> * pAfterFront = list.remove(p11);
+      Node <int> * pAfterBack = list.remove(p31);
+      // verify
+      assertUnit(pAfterFront == p26);     // no parent: the next one
+      assertUnit(pAfterBack == p26);      // the parent
+      assertUnit(values(list) == "26");
+      assertUnit(list.head() == p26 && p26->pPrev == nullptr && p26->pNext == nullptr);
+      assertUnit(list.insert(nullptr, 44, true)->pPrev == p26);
+   }  // teardown
+
+   // the value is destroyed exactly once and the node goes back to the pool
+   void test_remove_spy()
+   {  // setup
+      CombiningList <Spy> list;
+      Node <Spy> * p = list.insert(nullptr, Spy(26));
+      Spy::reset();
+      // exercise
+      list.remove(p);
+      // verify
+      assertUnit(Spy::numDestructor() == 1);   // destroy [26]
+      assertUnit(Spy::numDelete() == 1);
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(list.size() == 0);
+      assertUnit(list.head() == nullptr);
+   }  // teardown
+
+   /***************************************
+    * CONCURRENT
+    ***************************************/
+
+   // many threads insert at once; nothing is lost
+   void test_insert_concurrent()
+   {  // setup
+      const int numThreads = 4;
+      const int numEach = 2000;
+      CombiningList <int> list;
+      std::vector <std::thread> threads;
+      // exercise
+      for (int t = 0; t < numThreads; t++)
+         threads.emplace_back([&list, t]()
+         {
+            for (int i = 0; i < numEach; i++)
+               list.insert(nullptr, t * numEach + i, true);
+         });
+      for (auto & thread : threads)
+         thread.join();
+      // verify
+      assertUnit(list.size() == numThreads * numEach);
+      long long sum = 0;
+      size_t num = 0;
+      for (Node <int> * p = list.head(); p; p = p->pNext, num++)
+         sum += p->data;
+      long long n = numThreads * numEach;
+      assertUnit(num == (size_t)n);
+      assertUnit(sum == n * (n - 1) / 2);
+   }  // teardown
+
+   // each thread removes only what it inserted
+   void test_mixed_concurrent()
+   {  // setup
+      const int numThreads = 4;
+      CombiningList <int> list;
+      std::atomic <int> numBad(0);
+      std::vector <std::thread> threads;
+      // exercise
+      for (int t = 0; t < numThreads; t++)
+         threads.emplace_back([&list, &numBad, t]()
+         {
+            std::vector <Node <int> *> mine;
+            for (int i = 0; i < 1000; i++)
+            {
+               mine.push_back(list.insert(nullptr, t, i % 2 == 0));
+               if (i % 3 == 2)
+               {
+                  Node <int> * p = mine.back();
+                  mine.pop_back();
+                  if (p->data != t)
+                     numBad++;
+                  list.remove(p);
+               }
+            }
+         });
+      for (auto & thread : threads)
+         thread.join();
+      // verify
+      assertUnit(numBad == 0);
+      assertUnit(list.size() == numThreads * (1000 - 333));
+      assertUnit(values(list).size() > 0);
+   }  // teardown
+
+   /*************************************************************
+    * FUSSY
+    * Copying a negative one throws
+    *************************************************************/
+   struct Fussy
+   {
+      Fussy(int value) : value(value) { }
+      Fussy(const Fussy & rhs) : value(rhs.value)
+      {
+         if (value < 0)
+            throw std::runtime_error("negative");
+      }
+      int value;
+   };
+
+   /*************************************************************
+    * VALUES / BACKWARDS
+    * The values front to back, or back to front
+    *************************************************************/
+   static std::string values(CombiningList <int> & list)
+   {
+      std::string s;
+      for (Node <int> * p = list.head(); p; p = p->pNext)
+         s += (s.empty() ? "" : " ") + std::to_string(p->data);
+      return s;
+   }
+
+   static std::string backwards(CombiningList <int> & list)
+   {
+      Node <int> * pTail = list.head();
+      while (pTail && pTail->pNext)
+         pTail = pTail->pNext;
+      std::string s;
+      for (Node <int> * p = pTail; p; p = p->pPrev)
+         s += (s.empty() ? "" : " ") + std::to_string(p->data);
+      return s;
+   }
+};
+
+#endif // DEBUG
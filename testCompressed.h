@@ -0,0 +1,262 @@
+/***********************************************************************
+ * Header:
+ *    TEST COMPRESSED
+ * Summary:
+ *    Unit tests for the compressed list of integers
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "compressed.h" // class under test
+#include "unitTest.h"   // unit test baseclass
+
+#include <algorithm>    // for std::sort
+#include <climits>      // for INT_MIN
+#include <string>       // for std::string
+#include <vector>       // for std::vector
+
+/***********************************************
+ * TEST COMPRESSED
+ * Unit tests for CompressedList
+ ***********************************************/
+class TestCompressed : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Append and walk
+      test_construct_empty();
+      test_pushBack_standard();
+      test_pushBack_unsorted();
+      test_pushBack_extremes();
+      test_pushBack_small();
+
+      // Convert
+      test_construct_fromNodes();
+
+      // Insert and remove
+      test_insert_standard();
+      test_insert_split();
+      test_remove_standard();
+      test_remove_emptyBlock();
+
+      report("Compressed");
+   }
+
+   /***************************************
+    * APPEND AND WALK
+    ***************************************/
+
+   // nothing in it, nothing to walk
+   void test_construct_empty()
+   {  // setup
+      // exercise
+      CompressedList <int> list;
+      // verify
+      assertUnit(list.empty());
+      assertUnit(list.size() == 0);
+      assertUnit(list.begin() == list.end());
+      assertUnit(list.numBlocks() == 0);
+      assertUnit(list.copy() == nullptr);
+      assertUnit(!list.contains(0));
+   }  // teardown
+
+   // values come back in the order they went in
+   void test_pushBack_standard()
+   {  // setup
+      CompressedList <int> list;
+      // exercise
+      for (int value : { 11, 26, 31 })
+         list.pushBack(value);
+      // verify
+      assertUnit(values(list) == "11 26 31");
+      assertUnit(list.size() == 3);
+      assertUnit(list.numBlocks() == 1);
+      assertUnit(list.contains(26));
+      assertUnit(!list.contains(27));
+   }  // teardown
+
+   // steps down are as good as steps up
+   void test_pushBack_unsorted()
+   {  // setup
+      CompressedList <int> list;
+      // exercise
+      for (int value : { 5, -3, 1000, 999, -70000, 0 })
+         list.pushBack(value);
+      // verify
+      assertUnit(values(list) == "5 -3 1000 999 -70000 0");
+   }  // teardown
+
+   // the steps wrap around, but the values do not
+   void test_pushBack_extremes()
+   {  // setup
+      CompressedList <int> ints;
+      CompressedList <unsigned long long> bigs;
+      // exercise
+      for (int value : { INT_MIN, INT_MAX, INT_MIN, 0, INT_MAX })
+         ints.pushBack(value);
+      for (unsigned long long value : { 0ull, ~0ull, 1ull, ~0ull - 1 })
+         bigs.pushBack(value);
+      // verify
+      assertUnit(values(ints) == std::to_string(INT_MIN) + " " + std::to_string(INT_MAX) + " "
+                                 + std::to_string(INT_MIN) + " 0 " + std::to_string(INT_MAX));
+      std::vector <unsigned long long> big(bigs.begin(), bigs.end());
+      assertUnit(big == std::vector <unsigned long long>({ 0ull, ~0ull, 1ull, ~0ull - 1 }));
+   }  // teardown
+
+   // close, sorted IDs take a small part of what nodes would
+   void test_pushBack_small()
+   {  // setup
+      CompressedList <int> list;
+      // exercise
+      for (int i = 0; i < 100000; i++)
+         list.pushBack(1000000 + i * 3);
+      // verify
+      assertUnit(list.size() == 100000);
+      assertUnit(list.numBytes() * 10 < 100000 * sizeof(Node <int>));
+      bool inOrder = true;
+      int expected = 1000000;
+      for (int value : list)
+      {
+         inOrder = inOrder && value == expected;
+         expected += 3;
+      }
+      assertUnit(inOrder);
+      assertUnit(expected == 1000000 + 100000 * 3);
+   }  // teardown
+
+   /***************************************
+    * CONVERT
+    ***************************************/
+
+   // from a list of nodes and back to one
+   void test_construct_fromNodes()
+   {  // setup
+      Node <int> * pSource = new Node <int>(11);
+      insert(insert(pSource, 26, true), 31, true);
+      // exercise
+      CompressedList <int> list(pSource);
+      Node <int> * pCopy = list.copy();
+      // verify
+      assertUnit(values(list) == "11 26 31");
+      assertUnit(pCopy && pCopy->data == 11);
+      assertUnit(pCopy && pCopy->pNext && pCopy->pNext->data == 26);
+      assertUnit(pCopy && pCopy->pNext && pCopy->pNext->pNext && pCopy->pNext->pNext->data == 31);
+      assertUnit(pCopy && pCopy->pNext && pCopy->pNext->pNext && pCopy->pNext->pNext->pPrev == pCopy->pNext);
+      assertUnit(size(pCopy) == 3);
+      // teardown
+      clear(pSource);
+      clear(pCopy);
+   }
+
+   /***************************************
+    * INSERT AND REMOVE
+    ***************************************/
+
+   // into the front, the middle, and the back
+   void test_insert_standard()
+   {  // setup
+      CompressedList <int> list;
+      list.pushBack(26);
+      // exercise
+      list.insert(11);
+      list.insert(31);
+      list.insert(27);
+      list.insert(26);
+      // verify
+      assertUnit(values(list) == "11 26 26 27 31");
+      assertUnit(list.size() == 5);
+      assertUnit(list.numBlocks() == 1);
+   }  // teardown
+
+   // a full block splits and the order holds
+   void test_insert_split()
+   {  // setup
+      CompressedList <int> list;
+      std::vector <int> expected;
+      for (int i = 0; i < 2000; i += 2)
+      {
+         list.pushBack(i);
+         expected.push_back(i);
+      }
+      size_t numBlocks = list.numBlocks();
+      // exercise
+      for (int i = 1999; i > 0; i -= 2)
+         list.insert(i);
+      list.insert(-1000000);
+      list.insert(1000000);
+      // verify
+      for (int i = 1; i < 2000; i += 2)
+         expected.push_back(i);
+      expected.push_back(-1000000);
+      expected.push_back(1000000);
+      std::sort(expected.begin(), expected.end());
+      assertUnit(std::vector <int>(list.begin(), list.end()) == expected);
+      assertUnit(list.size() == expected.size());
+      assertUnit(list.numBlocks() > numBlocks);
+   }  // teardown
+
+   // from the front, the middle, the back, and not there
+   void test_remove_standard()
+   {  // setup
+      CompressedList <int> list;
+      for (int value : { 11, 25, 26, 27, 31 })
+         list.pushBack(value);
+      // exercise
+      bool front = list.remove(11);
+      bool middle = list.remove(26);
+      bool back = list.remove(31);
+      bool missing = list.remove(28);
+      bool tooBig = list.remove(99);
+      // verify
+      assertUnit(front && middle && back);
+      assertUnit(!missing && !tooBig);
+      assertUnit(values(list) == "25 27");
+      assertUnit(list.size() == 2);
+   }  // teardown
+
+   // a block with nothing left is unlinked, even the last one
+   void test_remove_emptyBlock()
+   {  // setup
+      CompressedList <int> list;
+      for (int i = 0; i < 1000; i++)
+         list.pushBack(i * 1000);
+      size_t numBlocks = list.numBlocks();
+      // exercise
+      for (int i = 0; i < 1000; i += 2)
+         list.remove(i * 1000);
+      bool allThere = true;
+      for (int i = 1; i < 1000; i += 2)
+         allThere = allThere && list.contains(i * 1000);
+      for (int i = 1; i < 1000; i += 2)
+         list.remove(i * 1000);
+      // verify
+      assertUnit(numBlocks > 1);
+      assertUnit(allThere);
+      assertUnit(list.empty());
+      assertUnit(list.numBlocks() == 0);
+      list.pushBack(26);
+      assertUnit(values(list) == "26");
+   }  // teardown
+
+   /*************************************************************
+    * VALUES
+    * Front to back, separated by spaces
+    *************************************************************/
+   template <class T>
+   static std::string values(const CompressedList <T> & list)
+   {
+      std::string s;
+      for (T value : list)
+         s += (s.empty() ? "" : " ") + std::to_string(value);
+      return s;
+   }
+};
+
+#endif // DEBUG
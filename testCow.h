@@ -0,0 +1,336 @@
+/***********************************************************************
+ * Header:
+ *    TEST COW
+ * Summary:
+ *    Unit tests for the copy-on-write list
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "cow.h"        // class under test
+#include "spy.h"        // for Spy
+#include "unitTest.h"   // unit test baseclass
+
+#include <stdexcept>    // for std::runtime_error
+#include <string>       // for std::string
+
+/***********************************************
+ * TEST COW
+ * Unit tests for SharedList
+ ***********************************************/
+class TestCow : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Copy
+      test_copy_empty();
+      test_copy_standard();
+      test_copy_dropOriginal();
+
+      // Insert
+      test_insert_empty();
+      test_insert_unshared();
+      test_insert_shared();
+      test_insert_nullFront();
+      test_insert_sharedThrows();
+
+      // Remove
+      test_remove_unshared();
+      test_remove_sharedHead();
+      test_remove_sharedMiddle();
+
+      // Assign
+      test_assign_unshared();
+      test_assign_shared();
+
+      report("Cow");
+   }
+
+   /***************************************
+    * COPY
+    ***************************************/
+
+   // copying an empty handle
+   void test_copy_empty()
+   {  // setup
+      SharedList <Spy> original;
+      Spy::reset();
+      // exercise
+      SharedList <Spy> snapshot(original);
+      // verify
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(snapshot.head() == nullptr);
+      assertUnit(!snapshot.isShared());
+   }  // teardown
+
+   // a snapshot shares the nodes: no copies, no allocations
+   void test_copy_standard()
+   {  // setup
+      SharedList <Spy> original(standard());
+      Spy::reset();
+      // exercise
+      SharedList <Spy> snapshot(original);
+      SharedList <Spy> another;
+      another = snapshot;
+      // verify
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numDelete() == 0);
+      assertUnit(snapshot.head() == original.head());
+      assertUnit(another.head() == original.head());
+      assertUnit(original.isShared());
+      assertUnit(values(snapshot.head()) == "11,26,31");
+   }  // teardown
+
+   // the nodes live as long as any handle does
+   void test_copy_dropOriginal()
+   {  // setup
+      SharedList <Spy> * pOriginal = new SharedList <Spy>(standard());
+      SharedList <Spy> snapshot(*pOriginal);
+      Spy::reset();
+      // exercise
+      delete pOriginal;
+      // verify
+      assertUnit(Spy::numDestructor() == 0);
+      assertUnit(!snapshot.isShared());
+      assertUnit(values(snapshot.head()) == "11,26,31");
+   }  // teardown
+
+   /***************************************
+    * INSERT
+    ***************************************/
+
+   // insert into an empty handle
+   void test_insert_empty()
+   {  // setup
+      SharedList <Spy> list;
+      // exercise
+      const Node <Spy> * p = list.insert(nullptr, Spy(26));
+      // verify
+      assertUnit(list.head() == p);
+      assertUnit(values(list.head()) == "26");
+   }  // teardown
+
+   // nobody else sees the nodes: insert in place
+   void test_insert_unshared()
+   {  // setup
+      SharedList <Spy> list(standard());
+      const Node <Spy> * pHead = list.head();
+      Spy s(5);
+      Spy::reset();
+      // exercise
+      list.insert(pHead, s);
+      // verify
+      assertUnit(Spy::numCopy() == 1);        // copy [5] only
+      assertUnit(values(list.head()) == "5,11,26,31");
+      assertUnit(list.head()->pNext == pHead);
+   }  // teardown
+
+   // the first insert into a snapshot copies it, the original is untouched
+   void test_insert_shared()
+   {  // setup
+      SharedList <Spy> original(standard());
+      SharedList <Spy> snapshot(original);
+      const Node <Spy> * p26 = snapshot.head()->pNext;
+      Spy s(27);
+      Spy::reset();
+      // exercise
+      const Node <Spy> * pNew = snapshot.insert(p26, s, true);
+      // verify
+      assertUnit(Spy::numCopy() == 4);        // copy [11][26][31] and [27]
+      assertUnit(values(snapshot.head()) == "11,26,27,31");
+      assertUnit(values(original.head()) == "11,26,31");
+      assertUnit(pNew->pPrev && pNew->pPrev != p26);
+      assertUnit(!snapshot.isShared());
+      assertUnit(!original.isShared());
+   }  // teardown
+
+   // no current node means the front, shared or not
+   void test_insert_nullFront()
+   {  // setup
+      SharedList <Spy> list(standard());
+      SharedList <Spy> snapshot(list);
+      // exercise
+      const Node <Spy> * pList = list.insert(nullptr, Spy(5));
+      const Node <Spy> * pSnapshot = snapshot.insert(nullptr, Spy(6), true);
+      // verify
+      assertUnit(list.head() == pList);
+      assertUnit(snapshot.head() == pSnapshot);
+      assertUnit(values(list.head()) == "5,11,26,31");
+      assertUnit(values(snapshot.head()) == "6,11,26,31");
+   }  // teardown
+
+   // a copy that throws part way leaves nothing behind and the nodes shared
+   void test_insert_sharedThrows()
+   {  // setup
+      Brittle::copiesLeft = -1;
+      SharedList <Brittle> original;
+      for (int i = 0; i < 5; i++)
+         original.insert(nullptr, Brittle());
+      SharedList <Brittle> snapshot(original);
+      int numBefore = Brittle::numLive;
+      bool thrown = false;
+      // exercise
+      Brittle::copiesLeft = 3;
+      try
+      {
+         snapshot.insert(snapshot.head(), Brittle());
+      }
+      catch (const std::runtime_error &)
+      {
+         thrown = true;
+      }
+      Brittle::copiesLeft = -1;
+      // verify
+      assertUnit(thrown);
+      assertUnit(Brittle::numLive == numBefore);
+      assertUnit(snapshot.head() == original.head());
+      assertUnit(snapshot.isShared());
+   }  // teardown
+
+   /***************************************
+    * REMOVE
+    ***************************************/
+
+   // nobody else sees the nodes: remove in place
+   void test_remove_unshared()
+   {  // setup
+      SharedList <Spy> list(standard());
+      Spy::reset();
+      // exercise
+      const Node <Spy> * pReturn = list.remove(list.head()->pNext);
+      // verify
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numDestructor() == 1);  // destroy [26]
+      assertUnit(pReturn == list.head());
+      assertUnit(values(list.head()) == "11,31");
+   }  // teardown
+
+   // removing the head of a snapshot copies the rest
+   void test_remove_sharedHead()
+   {  // setup
+      SharedList <Spy> original(standard());
+      SharedList <Spy> snapshot(original);
+      Spy::reset();
+      // exercise
+      const Node <Spy> * pReturn = snapshot.remove(snapshot.head());
+      // verify
+      assertUnit(Spy::numCopy() == 2);        // copy [26][31], never [11]
+      assertUnit(Spy::numDestructor() == 0);
+      assertUnit(pReturn == snapshot.head());
+      assertUnit(values(snapshot.head()) == "26,31");
+      assertUnit(values(original.head()) == "11,26,31");
+   }  // teardown
+
+   // removing from the middle returns the copy of the previous node
+   void test_remove_sharedMiddle()
+   {  // setup
+      SharedList <Spy> original(standard());
+      SharedList <Spy> snapshot(original);
+      Spy::reset();
+      // exercise
+      const Node <Spy> * pReturn = snapshot.remove(snapshot.head()->pNext);
+      // verify
+      assertUnit(Spy::numCopy() == 2);        // copy [11][31]
+      assertUnit(pReturn == snapshot.head());
+      assertUnit(pReturn != original.head());
+      assertUnit(values(snapshot.head()) == "11,31");
+      assertUnit(values(original.head()) == "11,26,31");
+   }  // teardown
+
+   /***************************************
+    * ASSIGN
+    ***************************************/
+
+   // nobody else sees the nodes: reuse them
+   void test_assign_unshared()
+   {  // setup
+      SharedList <Spy> list(standard());
+      Node <Spy> * pSrc = new Node <Spy>(Spy(99));
+      Spy::reset();
+      // exercise
+      list.assign(pSrc);
+      // verify
+      assertUnit(Spy::numAssign() == 1);      // reuse [11]
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numDestructor() == 2);  // destroy [26][31]
+      assertUnit(values(list.head()) == "99");
+      // teardown
+      clear(pSrc);
+   }
+
+   // assigning to a snapshot never copies the old nodes
+   void test_assign_shared()
+   {  // setup
+      SharedList <Spy> original(standard());
+      SharedList <Spy> snapshot(original);
+      Node <Spy> * pSrc = new Node <Spy>(Spy(99));
+      Spy::reset();
+      // exercise
+      snapshot.assign(pSrc);
+      // verify
+      assertUnit(Spy::numCopy() == 1);        // copy [99] only
+      assertUnit(Spy::numDestructor() == 0);
+      assertUnit(values(snapshot.head()) == "99");
+      assertUnit(values(original.head()) == "11,26,31");
+      // teardown
+      clear(pSrc);
+   }
+
+   /*************************************************************
+    * STANDARD
+    *    +----+   +----+   +----+
+    *    | 11 | - | 26 | - | 31 |
+    *    +----+   +----+   +----+
+    *************************************************************/
+   Node <Spy> * standard()
+   {
+      Node <Spy> * pHead = new Node <Spy>(Spy(11));
+      insert(insert(pHead, Spy(26), true), Spy(31), true);
+      return pHead;
+   }
+
+   /*************************************************************
+    * BRITTLE
+    * Counts the live ones, and its copy throws once
+    * copiesLeft runs out
+    *************************************************************/
+   struct Brittle
+   {
+      static inline int numLive = 0;
+      static inline int copiesLeft = -1;
+
+      Brittle() { numLive++; }
+      Brittle(const Brittle &)
+      {
+         if (copiesLeft == 0)
+            throw std::runtime_error("brittle: copy");
+         if (copiesLeft > 0)
+            copiesLeft--;
+         numLive++;
+      }
+      Brittle & operator = (const Brittle &) = default;
+      ~Brittle() { numLive--; }
+   };
+
+   /*************************************************************
+    * VALUES
+    * The list as "11,26,31"
+    *************************************************************/
+   std::string values(const Node <Spy> * p)
+   {
+      std::string s;
+      for (; p; p = p->pNext)
+         s += std::to_string(p->data.get()) + (p->pNext ? "," : "");
+      return s;
+   }
+};
+
+#endif // DEBUG
@@ -0,0 +1,285 @@
+/***********************************************************************
+ * Header:
+ *    TEST CURSOR
+ * Summary:
+ *    Unit tests for the resumable copy
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "cursor.h"     // class under test
+#include "spy.h"        // for Spy
+#include "unitTest.h"   // unit test baseclass
+
+#include <chrono>       // for std::chrono::milliseconds
+#include <string>       // for std::string
+#include <thread>       // for std::this_thread::sleep_for
+
+/***********************************************
+ * TEST CURSOR
+ * Unit tests for CopyCursor
+ ***********************************************/
+class TestCursor : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Step
+      test_step_nullptr();
+      test_step_standard();
+      test_step_budget();
+      test_step_time();
+      test_step_timeSlow();
+
+      // Source changes
+      test_change_behind();
+      test_change_ahead();
+      test_skip_next();
+
+      // Release
+      test_release_partial();
+      test_destructor_untaken();
+
+      report("Cursor");
+   }
+
+   /***************************************
+    * STEP
+    ***************************************/
+
+   // copying nothing is done at once
+   void test_step_nullptr()
+   {  // setup
+      CopyCursor <Spy> cursor(nullptr);
+      Spy::reset();
+      // exercise
+      size_t num = cursor.step(10);
+      // verify
+      assertUnit(num == 0);
+      assertUnit(cursor.done());
+      assertUnit(cursor.release() == nullptr);
+      assertUnit(Spy::numCopy() == 0);
+   }  // teardown
+
+   // one big step is the same as copy()
+   void test_step_standard()
+   {  // setup
+      //    +----+   +----+   +----+
+      //    | 11 | - | 26 | - | 31 |
+      //    +----+   +----+   +----+
+      Node <Spy> * pSrc = standard();
+      CopyCursor <Spy> cursor(pSrc);
+      Spy::reset();
+      // exercise
+      size_t num = cursor.step(10);
+      // verify
+      assertUnit(num == 3);
+      assertUnit(Spy::numCopy() == 3);        // copy [11][26][31]
+      assertUnit(Spy::numAlloc() == 3);
+      assertUnit(cursor.done());
+      Node <Spy> * pDes = cursor.release();
+      assertUnit(values(pDes) == "11,26,31");
+      assertUnit(pDes && pDes->pNext && pDes->pNext->pPrev == pDes);
+      // teardown
+      clear(pSrc);
+      clear(pDes);
+   }
+
+   // each step copies no more than it is allowed
+   void test_step_budget()
+   {  // setup
+      Node <Spy> * pSrc = standard();
+      CopyCursor <Spy> cursor(pSrc);
+      Spy::reset();
+      // exercise
+      size_t first = cursor.step(2);
+      // verify
+      assertUnit(first == 2);
+      assertUnit(Spy::numCopy() == 2);
+      assertUnit(!cursor.done());
+      assertUnit(cursor.next() == pSrc->pNext->pNext);
+      assertUnit(cursor.step(2) == 1);
+      assertUnit(cursor.done());
+      assertUnit(cursor.size() == 3);
+      // teardown
+      clear(pSrc);
+   }
+
+   // a generous time budget copies everything
+   void test_step_time()
+   {  // setup
+      Node <int> * pSrc = nullptr;
+      for (int i = 0; i < 1000; i++)
+         pSrc = insert(pSrc, i);
+      CopyCursor <int> cursor(pSrc);
+      // exercise
+      size_t num = cursor.step((size_t)-1, std::chrono::microseconds(1000000));
+      // verify
+      assertUnit(num == 1000);
+      assertUnit(cursor.done());
+      // teardown
+      clear(pSrc);
+   }
+
+   // a slow copy ends the step as soon as the time is up
+   void test_step_timeSlow()
+   {  // setup
+      Node <Slow> * pSrc = nullptr;
+      for (int i = 0; i < 20; i++)
+         pSrc = insert(pSrc, Slow());
+      CopyCursor <Slow> cursor(pSrc);
+      Slow::delay = true;
+      // exercise
+      size_t num = cursor.step((size_t)-1, std::chrono::microseconds(1000));
+      // verify
+      Slow::delay = false;
+      assertUnit(num == 1);
+      assertUnit(!cursor.done());
+      // teardown
+      clear(pSrc);
+   }
+
+   /***************************************
+    * SOURCE CHANGES
+    ***************************************/
+
+   // changes behind the cursor do not reach the copy
+   void test_change_behind()
+   {  // setup
+      Node <Spy> * pSrc = standard();
+      CopyCursor <Spy> cursor(pSrc);
+      cursor.step(2);
+      // exercise
+      pSrc->data = Spy(99);
+      insert(pSrc, Spy(5), true);
+      cursor.step(10);
+      // verify
+      Node <Spy> * pDes = cursor.release();
+      assertUnit(values(pDes) == "11,26,31");
+      // teardown
+      clear(pSrc);
+      clear(pDes);
+   }
+
+   // changes ahead of the cursor do
+   void test_change_ahead()
+   {  // setup
+      Node <Spy> * pSrc = standard();
+      CopyCursor <Spy> cursor(pSrc);
+      cursor.step(1);
+      // exercise
+      pSrc->pNext->pNext->data = Spy(99);
+      insert(pSrc->pNext, Spy(27), true);
+      cursor.step(10);
+      // verify
+      Node <Spy> * pDes = cursor.release();
+      assertUnit(values(pDes) == "11,26,27,99");
+      // teardown
+      clear(pSrc);
+      clear(pDes);
+   }
+
+   // removing the node the cursor waits on is safe after skip()
+   void test_skip_next()
+   {  // setup
+      Node <Spy> * pSrc = standard();
+      CopyCursor <Spy> cursor(pSrc);
+      cursor.step(1);
+      // exercise
+      cursor.skip(pSrc->pNext);
+      remove(pSrc->pNext);
+      cursor.step(10);
+      // verify
+      Node <Spy> * pDes = cursor.release();
+      assertUnit(values(pDes) == "11,31");
+      // teardown
+      clear(pSrc);
+      clear(pDes);
+   }
+
+   /***************************************
+    * RELEASE
+    ***************************************/
+
+   // the copy can be taken before it is finished
+   void test_release_partial()
+   {  // setup
+      Node <Spy> * pSrc = standard();
+      CopyCursor <Spy> cursor(pSrc);
+      cursor.step(2);
+      // exercise
+      Node <Spy> * pDes = cursor.release();
+      // verify
+      assertUnit(values(pDes) == "11,26");
+      assertUnit(cursor.done());
+      assertUnit(cursor.step(10) == 0);
+      // teardown
+      clear(pSrc);
+      clear(pDes);
+   }
+
+   // a copy nobody took is freed with the cursor
+   void test_destructor_untaken()
+   {  // setup
+      Node <Spy> * pSrc = standard();
+      {
+         CopyCursor <Spy> cursor(pSrc);
+         cursor.step(3);
+         Spy::reset();
+         // exercise
+      }
+      // verify
+      assertUnit(Spy::numDestructor() == 3);   // destroy the copies
+      assertUnit(Spy::numDelete() == 3);
+      // teardown
+      clear(pSrc);
+   }
+
+   /*************************************************************
+    * STANDARD
+    *    +----+   +----+   +----+
+    *    | 11 | - | 26 | - | 31 |
+    *    +----+   +----+   +----+
+    *************************************************************/
+   Node <Spy> * standard()
+   {
+      Node <Spy> * pHead = new Node <Spy>(Spy(11));
+      insert(insert(pHead, Spy(26), true), Spy(31), true);
+      return pHead;
+   }
+
+   /*************************************************************
+    * VALUES
+    * The list as "11,26,31"
+    *************************************************************/
+   std::string values(const Node <Spy> * p)
+   {
+      std::string s;
+      for (; p; p = p->pNext)
+         s += std::to_string(p->data.get()) + (p->pNext ? "," : "");
+      return s;
+   }
+
+   /*************************************************************
+    * SLOW
+    * A value whose copy takes 2ms while delay is set
+    *************************************************************/
+   struct Slow
+   {
+      static inline bool delay = false;
+      Slow() { }
+      Slow(const Slow &)
+      {
+         if (delay)
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+      }
+   };
+};
+
+#endif // DEBUG
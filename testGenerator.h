@@ -0,0 +1,262 @@
+/***********************************************************************
+ * Header:
+ *    TEST GENERATOR
+ * Summary:
+ *    Unit tests for the coroutine generators and pipeline stages
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "generator.h"  // functions under test
+#include "spy.h"        // for Spy
+#include "unitTest.h"   // unit test baseclass
+
+#include <stdexcept>    // for std::runtime_error
+#include <string>       // for std::string
+#include <vector>       // for std::vector
+
+/***********************************************
+ * TEST GENERATOR
+ * Unit tests for Generator, the sources, and the stages
+ ***********************************************/
+class TestGenerator : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Sources
+      test_nodes_empty();
+      test_nodes_removeCurrent();
+      test_values_standard();
+      test_values_noCopies();
+
+      // Stages
+      test_filter_standard();
+      test_map_standard();
+      test_take_stopsEarly();
+      test_chunk_standard();
+      test_pipeline_fused();
+      test_pipeline_exception();
+
+      report("Generator");
+   }
+
+   /***************************************
+    * SOURCES
+    ***************************************/
+
+   // nothing to walk
+   void test_nodes_empty()
+   {  // setup
+      Node <int> * pHead = nullptr;
+      int num = 0;
+      // exercise
+      for (Node <int> * p : nodes(pHead))
+         num += (p != nullptr);
+      // verify
+      assertUnit(num == 0);
+   }  // teardown
+
+   // the node handed out can be freed without losing our place
+   void test_nodes_removeCurrent()
+   {  // setup
+      Node <int> * pHead = build(5);
+      std::string seen;
+      // exercise
+      for (Node <int> * p : nodes(pHead))
+      {
+         seen += std::to_string(p->data);
+         if (p == pHead)
+            pHead = p->pNext;
+         remove(p);
+      }
+      // verify
+      assertUnit(seen == "01234");
+      assertUnit(pHead == nullptr);
+   }  // teardown
+
+   // values are references into the list
+   void test_values_standard()
+   {  // setup
+      Node <int> * pHead = build(4);
+      // exercise
+      for (int & value : values(pHead))
+         value *= 10;
+      // verify
+      assertUnit(join(values((const Node <int> *)pHead)) == "0 10 20 30");
+      // teardown
+      clear(pHead);
+   }
+
+   // walking the values copies nothing
+   void test_values_noCopies()
+   {  // setup
+      //    +----+   +----+   +----+
+      //    | 11 | - | 26 | - | 31 |
+      //    +----+   +----+   +----+
+      Node <Spy> * pHead = new Node <Spy>(Spy(11));
+      insert(insert(pHead, Spy(26), true), Spy(31), true);
+      Spy::reset();
+      int sum = 0;
+      // exercise
+      for (const Spy & s : values((const Node <Spy> *)pHead))
+         sum += s.get();
+      // verify
+      assertUnit(sum == 68);
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numAlloc() == 0);
+      // teardown
+      clear(pHead);
+   }
+
+   /***************************************
+    * STAGES
+    ***************************************/
+
+   // only the odd ones
+   void test_filter_standard()
+   {  // setup
+      Node <int> * pHead = build(10);
+      // exercise
+      std::string s = join(values(pHead) | filter([](int v) { return v % 2 == 1; }));
+      // verify
+      assertUnit(s == "1 3 5 7 9");
+      // teardown
+      clear(pHead);
+   }
+
+   // a new value for each one, of a new type
+   void test_map_standard()
+   {  // setup
+      Node <int> * pHead = build(4);
+      std::vector <std::string> out;
+      // exercise
+      for (std::string & s : values(pHead) | map([](int v) { return std::string(v, '*'); }))
+         out.push_back(std::move(s));
+      // verify
+      assertUnit(out.size() == 4);
+      assertUnit(out.size() == 4 && out[0] == "" && out[3] == "***");
+      // teardown
+      clear(pHead);
+   }
+
+   // take stops pulling from the list once it has enough
+   void test_take_stopsEarly()
+   {  // setup
+      Node <int> * pHead = build(100);
+      int numPulled = 0;
+      // exercise
+      std::string s = join(values(pHead)
+                           | filter([&numPulled](int) { numPulled++; return true; })
+                           | take(3));
+      std::string none = join(values(pHead) | take(0));
+      // verify
+      assertUnit(s == "0 1 2");
+      assertUnit(numPulled == 3);
+      assertUnit(none == "");
+      // teardown
+      clear(pHead);
+   }
+
+   // groups of three, the last one short
+   void test_chunk_standard()
+   {  // setup
+      Node <int> * pHead = build(7);
+      std::vector <size_t> sizes;
+      int last = -1;
+      // exercise
+      for (std::vector <int> & group : values(pHead) | chunk(3))
+      {
+         sizes.push_back(group.size());
+         last = group.back();
+      }
+      // verify
+      assertUnit(sizes.size() == 3);
+      assertUnit(sizes.size() == 3 && sizes[0] == 3 && sizes[1] == 3 && sizes[2] == 1);
+      assertUnit(last == 6);
+      // teardown
+      clear(pHead);
+   }
+
+   // each value goes all the way through before the next is read
+   void test_pipeline_fused()
+   {  // setup
+      Node <int> * pHead = build(6);
+      std::string trace;
+      // exercise
+      for (int v : values(pHead)
+                   | filter([&trace](int v) { trace += "f" + std::to_string(v); return v % 2 == 0; })
+                   | map([&trace](int v) { trace += "m" + std::to_string(v); return v * v; }))
+         trace += "=" + std::to_string(v) + " ";
+      // verify
+      assertUnit(trace == "f0m0=0 f1f2m2=4 f3f4m4=16 f5");
+      // teardown
+      clear(pHead);
+   }
+
+   // an exception in a stage comes out of the loop
+   void test_pipeline_exception()
+   {  // setup
+      Node <int> * pHead = build(5);
+      bool caught = false;
+      int num = 0;
+      // exercise
+      try
+      {
+         for (int v : values(pHead) | map([](int v)
+                                         {
+                                            if (v == 3)
+                                               throw std::runtime_error("three");
+                                            return v;
+                                         }))
+            num += (v >= 0);
+      }
+      catch (const std::runtime_error &)
+      {
+         caught = true;
+      }
+      // verify
+      assertUnit(caught);
+      assertUnit(num == 3);
+      // teardown
+      clear(pHead);
+   }
+
+   /*************************************************************
+    * BUILD
+    * A list holding 0, 1, ... num - 1
+    *************************************************************/
+   static Node <int> * build(int num)
+   {
+      Node <int> * pHead = nullptr;
+      Node <int> * pTail = nullptr;
+      for (int i = 0; i < num; i++)
+      {
+         pTail = insert(pTail, i, true);
+         if (pHead == nullptr)
+            pHead = pTail;
+      }
+      return pHead;
+   }
+
+   /*************************************************************
+    * JOIN
+    * Every element of a generator, separated by spaces
+    *************************************************************/
+   template <class Ref>
+   static std::string join(Generator <Ref> && generator)
+   {
+      std::string s;
+      for (auto && element : generator)
+         s += (s.empty() ? "" : " ") + std::to_string(element);
+      return s;
+   }
+};
+
+#endif // DEBUG
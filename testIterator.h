@@ -0,0 +1,274 @@
+/***********************************************************************
+ * Header:
+ *    TEST ITERATOR
+ * Summary:
+ *    Unit tests for the list iterators and NodeRange
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "iterator.h"   // classes under test
+#include "spy.h"        // for Spy
+#include "unitTest.h"   // unit test baseclass
+
+#include <algorithm>    // for std::find
+#include <iterator>     // for std::bidirectional_iterator
+#include <numeric>      // for std::accumulate
+#include <ranges>       // for std::views::filter
+#include <string>       // for std::string
+
+// what the standard library needs to see
+static_assert(std::forward_iterator <NodeForwardIterator <int>>);
+static_assert(std::forward_iterator <NodeForwardIterator <const int>>);
+static_assert(!std::bidirectional_iterator <NodeForwardIterator <int>>);   // its end has no tail
+static_assert(std::bidirectional_iterator <NodeIterator <int>>);
+static_assert(std::bidirectional_iterator <NodeIterator <const int>>);
+static_assert(std::sentinel_for <NodeSentinel, NodeForwardIterator <int>>);
+static_assert(std::sentinel_for <NodeSentinel, NodeIterator <int>>);
+static_assert(std::ranges::bidirectional_range <NodeRange <int>>);
+static_assert(std::ranges::view <NodeRange <int>>);
+static_assert(std::ranges::borrowed_range <NodeRange <int>>);
+static_assert(sizeof(NodeRange <int>) == sizeof(Node <int> *));
+static_assert(sizeof(NodeForwardIterator <int>) == sizeof(Node <int> *));
+static_assert(sizeof(NodeIterator <int>) == 2 * sizeof(Node <int> *));   // and the node before the end
+
+/***********************************************
+ * TEST ITERATOR
+ * Unit tests for NodeIterator and NodeRange
+ ***********************************************/
+class TestIterator : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Iterator
+      test_iterator_rangeFor();
+      test_iterator_empty();
+      test_iterator_const();
+      test_iterator_backFromEnd();
+
+      // Algorithms
+      test_find_node();
+      test_countIf_classic();
+      test_accumulate_noCopies();
+
+      // Ranges
+      test_reverse_inPlace();
+      test_reverse_classic();
+      test_views_pipeline();
+
+      report("Iterator");
+   }
+
+   /***************************************
+    * ITERATOR
+    ***************************************/
+
+   // range-based for over a list, changing it as we go
+   void test_iterator_rangeFor()
+   {  // setup
+      Node <int> * pHead = build(4);
+      // exercise
+      for (int & value : NodeRange(pHead))
+         value *= 10;
+      // verify
+      assertUnit(join(pHead) == "0 10 20 30");
+      // teardown
+      clear(pHead);
+   }
+
+   // nothing to walk
+   void test_iterator_empty()
+   {  // setup
+      NodeRange <int> range;
+      // exercise
+      bool empty = range.empty();
+      // verify
+      assertUnit(empty);
+      assertUnit(range.begin() == range.end());
+      assertUnit(std::ranges::distance(range) == 0);
+   }  // teardown
+
+   // a const list gives read-only iterators, and any iterator
+   // converts to one
+   void test_iterator_const()
+   {  // setup
+      Node <int> * pHead = build(3);
+      const Node <int> * pConst = pHead;
+      // exercise
+      auto range = NodeRange(pConst);
+      NodeIterator <const int> it = NodeRange(pHead).begin();
+      // verify
+      static_assert(std::is_same_v <decltype(range), NodeRange <const int>>);
+      static_assert(std::is_same_v <decltype(*it), const int &>);
+      assertUnit(it == range.begin());
+      assertUnit(std::ranges::distance(range) == 3);
+      // teardown
+      clear(pHead);
+   }
+
+   // the end a walk reaches can step back onto the tail
+   void test_iterator_backFromEnd()
+   {  // setup
+      //    +----+   +----+   +----+
+      //    | 11 | - | 26 | - | 31 |
+      //    +----+   +----+   +----+
+      Node <int> * pHead = new Node <int>(11);
+      insert(insert(pHead, 26, true), 31, true);
+      NodeRange range(pHead);
+      // exercise
+      NodeIterator <int> it = std::ranges::next(range.begin(), range.end());
+      // verify
+      assertUnit(it == range.end());
+      --it;
+      assertUnit(*it == 31);
+      --it;
+      assertUnit(*it == 26);
+      assertUnit(it.node() == pHead->pNext);
+      // teardown
+      clear(pHead);
+   }
+
+   /***************************************
+    * ALGORITHMS
+    ***************************************/
+
+   // find hands back where the value is, which node.h can use
+   void test_find_node()
+   {  // setup
+      Node <int> * pHead = build(5);
+      NodeRange range(pHead);
+      // exercise
+      NodeIterator <int> it = std::ranges::find(range, 3);
+      NodeIterator <int> missing = std::ranges::find(range, 9);
+      // verify
+      assertUnit(it != range.end());
+      assertUnit(it.node() && it.node()->data == 3);
+      assertUnit(*std::ranges::prev(it) == 2);
+      assertUnit(missing == range.end());
+      insert(it.node(), 99, true);
+      assertUnit(join(pHead) == "0 1 2 3 99 4");
+      // teardown
+      clear(pHead);
+   }
+
+   // the algorithms that want two iterators of the same type
+   // use the default one as the end
+   void test_countIf_classic()
+   {  // setup
+      Node <int> * pHead = build(10);
+      // exercise
+      auto num = std::count_if(NodeForwardIterator <int>(pHead), NodeForwardIterator <int>(),
+                               [](int v) { return v % 3 == 0; });
+      // verify
+      assertUnit(num == 4);
+      // teardown
+      clear(pHead);
+   }
+
+   // walking the values copies nothing
+   void test_accumulate_noCopies()
+   {  // setup
+      //    +----+   +----+   +----+
+      //    | 11 | - | 26 | - | 31 |
+      //    +----+   +----+   +----+
+      Node <Spy> * pHead = new Node <Spy>(Spy(11));
+      insert(insert(pHead, Spy(26), true), Spy(31), true);
+      const Node <Spy> * pConst = pHead;
+      Spy::reset();
+      // exercise
+      int sum = std::accumulate(NodeForwardIterator <const Spy>(pConst), NodeForwardIterator <const Spy>(), 0,
+                                [](int sum, const Spy & s) { return sum + s.get(); });
+      // verify
+      assertUnit(sum == 68);
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numAlloc() == 0);
+      // teardown
+      clear(pHead);
+   }
+
+   /***************************************
+    * RANGES
+    ***************************************/
+
+   // reverse swaps the values and leaves the nodes where they were
+   void test_reverse_inPlace()
+   {  // setup
+      Node <int> * pHead = build(5);
+      Node <int> * pSecond = pHead->pNext;
+      // exercise
+      std::ranges::reverse(NodeRange(pHead));
+      // verify
+      assertUnit(join(pHead) == "4 3 2 1 0");
+      assertUnit(pHead->pNext == pSecond);
+      // teardown
+      clear(pHead);
+   }
+
+   // the classic algorithms step back from an end a walk reached
+   void test_reverse_classic()
+   {  // setup
+      Node <int> * pHead = build(5);
+      NodeRange range(pHead);
+      // exercise
+      std::reverse(range.begin(), std::ranges::next(range.begin(), range.end()));
+      // verify
+      assertUnit(join(pHead) == "4 3 2 1 0");
+      // teardown
+      clear(pHead);
+   }
+
+   // the standard views compose over a list
+   void test_views_pipeline()
+   {  // setup
+      Node <int> * pHead = build(10);
+      std::string s;
+      // exercise
+      for (int v : NodeRange(pHead)
+                   | std::views::filter([](int v) { return v % 2 == 1; })
+                   | std::views::transform([](int v) { return v * v; })
+                   | std::views::reverse)
+         s += (s.empty() ? "" : " ") + std::to_string(v);
+      // verify
+      assertUnit(s == "81 49 25 9 1");
+      // teardown
+      clear(pHead);
+   }
+
+   /*************************************************************
+    * BUILD
+    * A list holding 0, 1, ... num - 1
+    *************************************************************/
+   static Node <int> * build(int num)
+   {
+      Node <int> * pHead = nullptr;
+      Node <int> * pTail = nullptr;
+      for (int i = 0; i < num; i++)
+      {
+         pTail = insert(pTail, i, true);
+         if (pHead == nullptr)
+            pHead = pTail;
+      }
+      return pHead;
+   }
+
+   /*************************************************************
+    * JOIN
+    * The values of a list, separated by spaces
+    *************************************************************/
+   static std::string join(const Node <int> * pHead)
+   {
+      std::string s;
+      for (int value : NodeRange(pHead))
+         s += (s.empty() ? "" : " ") + std::to_string(value);
+      return s;
+   }
+};
+
+#endif // DEBUG
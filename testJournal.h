@@ -0,0 +1,574 @@
+/***********************************************************************
+ * Header:
+ *    TEST JOURNAL
+ * Summary:
+ *    Unit tests for the journaled list
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell
+ ************************************************************************/
+
+#pragma once
+
+#if defined(DEBUG) && !defined(_WIN32)
+
+#include "journal.h"    // class under test
+#include "unitTest.h"   // unit test baseclass
+
+#include <cstdio>       // for std::remove
+#include <filesystem>   // for std::filesystem::temp_directory_path
+#include <stdexcept>    // for std::runtime_error
+#include <string>       // for std::string
+
+/***********************************************
+ * FRAGILE
+ * A value whose copy, or whose record, can be
+ * made to throw
+ ***********************************************/
+struct Fragile
+{
+   static inline bool failCopy = false;
+   static inline bool failWrite = false;
+
+   static inline int numLive = 0;
+
+   Fragile(int value = 0) : value(value) { numLive++; }
+   Fragile(const Fragile & rhs) : value(rhs.value)
+   {
+      if (failCopy)
+         throw std::runtime_error("fragile: copy");
+      numLive++;
+   }
+   ~Fragile() { numLive--; }
+   Fragile & operator = (const Fragile & rhs) = default;
+
+   int value;
+};
+
+template <>
+struct Serializer <Fragile>
+{
+   static void write(ByteWriter & out, const Fragile & fragile)
+   {
+      if (Fragile::failWrite)
+         throw std::runtime_error("fragile: write");
+      out.put(fragile.value);
+   }
+   static Fragile read(ByteReader & in)
+   {
+      return Fragile(in.get <int>());
+   }
+};
+
+/***********************************************
+ * TEST JOURNAL
+ * Unit tests for JournaledList
+ ***********************************************/
+class TestJournal : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Construct
+      test_construct_new();
+      test_construct_wrongType();
+
+      // Recover
+      test_recover_inserts();
+      test_recover_middle();
+      test_recover_clear();
+      test_recover_tornGroup();
+      test_recover_strings();
+      test_recover_manyChunks();
+      test_recover_cutCheckpoint();
+
+      // Insert and remove
+      test_insert_copyThrows();
+      test_insert_logThrows();
+      test_remove_checkpointed();
+
+      // Commit
+      test_commit_group();
+
+      // Compact
+      test_compact_standard();
+      test_compact_whileChanging();
+
+      report("Journal");
+   }
+
+   /***************************************
+    * CONSTRUCT
+    ***************************************/
+
+   // no files, no list
+   void test_construct_new()
+   {  // setup
+      std::string path = pathFor("new");
+      // exercise
+      {
+         JournaledList <int> list(path);
+         // verify
+         assertUnit(list.empty());
+         assertUnit(list.head() == nullptr);
+         assertUnit(list.tail() == nullptr);
+         assertUnit(list.segment() == 1);
+         assertUnit(!std::filesystem::exists(path + ".journal.1"));
+         list.insert(nullptr, 26);
+         list.commit();
+         assertUnit(std::filesystem::exists(path + ".journal.1"));
+      }
+      // teardown
+      removeAll(path);
+   }
+
+   // a journal of something else is refused
+   void test_construct_wrongType()
+   {  // setup
+      std::string path = pathFor("wrongType");
+      {
+         JournaledList <int> list(path);
+         list.insert(nullptr, 26);
+      }
+      bool thrown = false;
+      // exercise
+      try
+      {
+         JournaledList <double> list(path);
+      }
+      catch (const std::runtime_error &)
+      {
+         thrown = true;
+      }
+      // verify
+      assertUnit(thrown);
+      // teardown
+      removeAll(path);
+   }
+
+   /***************************************
+    * RECOVER
+    ***************************************/
+
+   // on the back, read back in order
+   void test_recover_inserts()
+   {  // setup
+      std::string path = pathFor("inserts");
+      {
+         JournaledList <int> list(path);
+         for (int value : { 11, 26, 31 })
+            list.insert(nullptr, value, true);
+         list.commit();
+      }
+      // exercise
+      JournaledList <int> list(path);
+      // verify
+      //    +----+   +----+   +----+
+      //    | 11 | - | 26 | - | 31 |
+      //    +----+   +----+   +----+
+      assertUnit(values(list) == "11 26 31");
+      assertUnit(backwards(list) == "31 26 11");
+      assertUnit(list.size() == 3);
+      assertUnit(list.segment() == 2);
+      // teardown
+      removeAll(path);
+   }
+
+   // inserts and removes relative to nodes in the middle, across
+   // three opens, so later records name nodes from earlier ones
+   void test_recover_middle()
+   {  // setup
+      std::string path = pathFor("middle");
+      {
+         JournaledList <int> list(path);
+         list.insert(nullptr, 11, true);
+         const Node <int> * p26 = list.insert(nullptr, 26, true);
+         list.insert(nullptr, 31, true);
+         list.insert(p26, 25);
+         list.insert(p26, 27, true);
+      }
+      {
+         JournaledList <int> list(path);
+         const Node <int> * p26 = list.head()->pNext->pNext;
+         const Node <int> * pReturn = list.remove(p26);
+         list.insert(pReturn, 99, true);
+         list.remove(list.head());
+         list.remove(list.tail());
+      }
+      // exercise
+      JournaledList <int> list(path);
+      // verify
+      assertUnit(values(list) == "25 99 27");
+      assertUnit(backwards(list) == "27 99 25");
+      assertUnit(list.size() == 3);
+      // teardown
+      removeAll(path);
+   }
+
+   // one record wipes out everything before it
+   void test_recover_clear()
+   {  // setup
+      std::string path = pathFor("clear");
+      {
+         JournaledList <int> list(path);
+         for (int i = 0; i < 100; i++)
+            list.insert(nullptr, i, true);
+         list.clear();
+         list.insert(nullptr, 26);
+      }
+      // exercise
+      JournaledList <int> list(path);
+      // verify
+      assertUnit(values(list) == "26");
+      // teardown
+      removeAll(path);
+   }
+
+   // a group cut short by a crash is dropped, and the ones
+   // committed before it are not
+   void test_recover_tornGroup()
+   {  // setup
+      std::string path = pathFor("torn");
+      {
+         JournaledList <int> list(path);
+         list.insert(nullptr, 11, true);
+         list.insert(nullptr, 26, true);
+         list.commit();
+         list.insert(nullptr, 31, true);
+         list.insert(nullptr, 42, true);
+         list.commit();
+      }
+      std::string segment = path + ".journal.1";
+      std::filesystem::resize_file(segment, std::filesystem::file_size(segment) - 3);
+      // exercise
+      {
+         JournaledList <int> list(path);
+         list.insert(nullptr, 99, true);
+      }
+      JournaledList <int> list(path);
+      // verify
+      assertUnit(values(list) == "11 26 99");
+      // teardown
+      removeAll(path);
+   }
+
+   // values that need a Serializer
+   void test_recover_strings()
+   {  // setup
+      std::string path = pathFor("strings");
+      {
+         JournaledList <std::string> list(path);
+         const Node <std::string> * p = list.insert(nullptr, "eleven");
+         list.insert(p, std::string(5000, 'x'), true);
+         list.insert(p, "", true);
+      }
+      // exercise
+      JournaledList <std::string> list(path);
+      // verify
+      assertUnit(list.size() == 3);
+      assertUnit(list.head() && list.head()->data == "eleven");
+      assertUnit(list.head() && list.head()->pNext && list.head()->pNext->data.empty());
+      assertUnit(list.tail() && list.tail()->data == std::string(5000, 'x'));
+      // teardown
+      removeAll(path);
+   }
+
+   // replayed nodes fill chunks in id order; the slots they free are
+   // used again once the list is open, and replay finds them all
+   void test_recover_manyChunks()
+   {  // setup
+      std::string path = pathFor("manyChunks");
+      std::string expected;
+      {
+         JournaledList <int> list(path);
+         for (int i = 0; i < 100000; i++)
+            list.insert(nullptr, i, true);
+         const Node <int> * p = list.head();
+         for (int i = 0; p; i++)
+            p = i % 3 ? p->pNext : list.remove(p)->pNext;
+      }
+      {
+         JournaledList <int> list(path);
+         const Node <int> * p = list.head();
+         for (int i = 0; p; i++)
+         {
+            if (i % 2)
+               p = list.remove(p)->pNext;
+            else if (i % 5 == 0)
+               p = list.insert(p, -i, true)->pNext;
+            else
+               p = p->pNext;
+         }
+         expected = values(list);
+      }
+      // exercise
+      JournaledList <int> list(path);
+      // verify
+      assertUnit(values(list) == expected);
+      assertUnit(backwards(list).size() == expected.size());
+      // teardown
+      removeAll(path);
+   }
+
+   // a checkpoint without all its ids is refused
+   void test_recover_cutCheckpoint()
+   {  // setup
+      std::string path = pathFor("cutCheckpoint");
+      {
+         JournaledList <int> list(path);
+         for (int i = 0; i < 100; i++)
+            list.insert(nullptr, i, true);
+         list.compact().get();
+      }
+      std::string checkpoint = path + ".checkpoint";
+      std::filesystem::resize_file(checkpoint, std::filesystem::file_size(checkpoint) - 8);
+      bool thrown = false;
+      // exercise
+      try
+      {
+         JournaledList <int> list(path);
+      }
+      catch (const std::runtime_error &)
+      {
+         thrown = true;
+      }
+      // verify
+      assertUnit(thrown);
+      // teardown
+      removeAll(path);
+   }
+
+   /***************************************
+    * INSERT AND REMOVE
+    ***************************************/
+
+   // a copy that throws hands out no id, so later records name the right nodes
+   void test_insert_copyThrows()
+   {  // setup
+      std::string path = pathFor("copyThrows");
+      bool thrown = false;
+      {
+         JournaledList <Fragile> list(path);
+         list.insert(nullptr, Fragile(11), true);
+         // exercise
+         Fragile::failCopy = true;
+         try
+         {
+            list.insert(nullptr, Fragile(26), true);
+         }
+         catch (const std::runtime_error &)
+         {
+            thrown = true;
+         }
+         Fragile::failCopy = false;
+         const Node <Fragile> * p = list.insert(nullptr, Fragile(31), true);
+         list.insert(p, Fragile(42));
+         assertUnit(list.size() == 3);
+      }
+      // verify
+      JournaledList <Fragile> list(path);
+      assertUnit(thrown);
+      assertUnit(values(list) == "11 42 31");
+      // teardown
+      removeAll(path);
+   }
+
+   // a record that cannot be written leaves no node and nothing in the group
+   void test_insert_logThrows()
+   {  // setup
+      std::string path = pathFor("logThrows");
+      bool thrown = false;
+      {
+         JournaledList <Fragile> list(path);
+         const Node <Fragile> * p = list.insert(nullptr, Fragile(11), true);
+         // exercise
+         Fragile::failWrite = true;
+         try
+         {
+            list.insert(p, Fragile(26), true);
+         }
+         catch (const std::runtime_error &)
+         {
+            thrown = true;
+         }
+         Fragile::failWrite = false;
+         assertUnit(list.size() == 1);
+         assertUnit(list.tail() == p);
+         p = list.insert(p, Fragile(31), true);
+         list.insert(p, Fragile(42));
+         list.commit();
+      }
+      // verify
+      JournaledList <Fragile> list(path);
+      assertUnit(thrown);
+      assertUnit(values(list) == "11 42 31");
+      // teardown
+      removeAll(path);
+   }
+
+   // a node from the checkpoint gives up its value when removed, and only once
+   void test_remove_checkpointed()
+   {  // setup
+      std::string path = pathFor("removeCheckpointed");
+      {
+         JournaledList <Fragile> list(path);
+         for (int i = 0; i < 3; i++)
+            list.insert(nullptr, Fragile(i), true);
+         list.compact().get();
+      }
+      int numBefore = Fragile::numLive;
+      {
+         JournaledList <Fragile> list(path);
+         assertUnit(Fragile::numLive == numBefore + 3);
+         // exercise
+         list.remove(list.head()->pNext);
+         // verify
+         assertUnit(Fragile::numLive == numBefore + 2);
+         assertUnit(values(list) == "0 2");
+      }
+      assertUnit(Fragile::numLive == numBefore);
+      // teardown
+      removeAll(path);
+   }
+
+   /***************************************
+    * COMMIT
+    ***************************************/
+
+   // many changes, one group
+   void test_commit_group()
+   {  // setup
+      std::string path = pathFor("group");
+      JournaledList <int> list(path, std::chrono::milliseconds(10000));
+      // exercise
+      for (int i = 0; i < 1000; i++)
+         list.insert(nullptr, i, true);
+      list.commit();
+      list.commit();
+      // verify
+      assertUnit(list.numGroups() == 1);
+      assertUnit(std::filesystem::file_size(path + ".journal.1") < 1000 * 8);
+      // teardown
+      removeAll(path);
+   }
+
+   /***************************************
+    * COMPACT
+    ***************************************/
+
+   // the journal goes into the checkpoint and away
+   void test_compact_standard()
+   {  // setup
+      std::string path = pathFor("compact");
+      {
+         JournaledList <int> list(path);
+         for (int i = 0; i < 1000; i++)
+            list.insert(nullptr, i, true);
+         for (int i = 0; i < 500; i++)
+            list.remove(list.head());
+         // exercise
+         size_t num = list.compact().get();
+         // verify
+         assertUnit(num == 500);
+         assertUnit(list.segment() == 2);
+         assertUnit(!std::filesystem::exists(path + ".journal.1"));
+         assertUnit(std::filesystem::exists(path + ".checkpoint"));
+         list.insert(list.head(), -1);
+      }
+      JournaledList <int> list(path);
+      assertUnit(list.size() == 501);
+      assertUnit(list.head() && list.head()->data == -1);
+      assertUnit(list.tail() && list.tail()->data == 999);
+      assertUnit(list.segment() == 3);
+      // teardown
+      removeAll(path);
+   }
+
+   // the list keeps changing, even nodes from the checkpoint,
+   // while the next checkpoint is written
+   void test_compact_whileChanging()
+   {  // setup
+      std::string path = pathFor("whileChanging");
+      std::string expected;
+      {
+         JournaledList <int> list(path);
+         for (int i = 0; i < 10000; i++)
+            list.insert(nullptr, i, true);
+         list.compact().get();
+         list.insert(list.head()->pNext, 5);
+         // exercise
+         std::shared_future <size_t> done = list.compact();
+         for (int i = 0; i < 1000; i++)
+            list.remove(list.head()->pNext);
+         list.insert(list.tail(), 12345);
+         done.get();
+         list.insert(nullptr, -1);
+         expected = values(list);
+      }
+      // verify
+      JournaledList <int> list(path);
+      assertUnit(values(list) == expected);
+      assertUnit(backwards(list).size() == expected.size());
+      assertUnit(list.size() == 10000 + 1 - 1000 + 1 + 1);
+      // teardown
+      removeAll(path);
+   }
+
+   /*************************************************************
+    * PATH FOR
+    * A fresh name in the temporary directory
+    *************************************************************/
+   static std::string pathFor(const std::string & name)
+   {
+      std::string path = (std::filesystem::temp_directory_path() / ("testJournal." + name)).string();
+      removeAll(path);
+      return path;
+   }
+
+   /*************************************************************
+    * REMOVE ALL
+    * The checkpoint and every segment named after path
+    *************************************************************/
+   static void removeAll(const std::string & path)
+   {
+      std::string prefix = std::filesystem::path(path).filename().string() + ".";
+      for (const auto & entry : std::filesystem::directory_iterator(std::filesystem::path(path).parent_path()))
+         if (entry.path().filename().string().compare(0, prefix.size(), prefix) == 0)
+            std::filesystem::remove(entry.path());
+   }
+
+   /*************************************************************
+    * VALUES
+    * Front to back, separated by spaces
+    *************************************************************/
+   static std::string values(const JournaledList <int> & list)
+   {
+      std::string s;
+      for (const Node <int> * p = list.head(); p; p = p->pNext)
+         s += (s.empty() ? "" : " ") + std::to_string(p->data);
+      return s;
+   }
+
+   static std::string values(const JournaledList <Fragile> & list)
+   {
+      std::string s;
+      for (const Node <Fragile> * p = list.head(); p; p = p->pNext)
+         s += (s.empty() ? "" : " ") + std::to_string(p->data.value);
+      return s;
+   }
+
+   /*************************************************************
+    * BACKWARDS
+    * Back to front, separated by spaces
+    *************************************************************/
+   static std::string backwards(const JournaledList <int> & list)
+   {
+      std::string s;
+      for (const Node <int> * p = list.tail(); p; p = p->pPrev)
+         s += (s.empty() ? "" : " ") + std::to_string(p->data);
+      return s;
+   }
+};
+
+#endif // DEBUG && !_WIN32
@@ -0,0 +1,405 @@
+/***********************************************************************
+ * Header:
+ *    TEST MAPPED
+ * Summary:
+ *    Unit tests for the list in a memory-mapped file
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell
+ ************************************************************************/
+
+#pragma once
+
+#if defined(DEBUG) && !defined(_WIN32)
+
+#include "mapped.h"     // class under test
+#include "unitTest.h"   // unit test baseclass
+
+#include <cstddef>      // for offsetof
+#include <cstdint>      // for uint64_t
+#include <cstdio>       // for std::remove
+#include <filesystem>   // for std::filesystem::temp_directory_path
+#include <fstream>      // for std::fstream
+#include <stdexcept>    // for std::runtime_error
+#include <string>       // for std::string
+
+/***********************************************
+ * TEST MAPPED
+ * Unit tests for MappedList
+ ***********************************************/
+class TestMapped : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Construct
+      test_construct_new();
+      test_construct_reopen();
+      test_construct_wrongType();
+      test_construct_corrupt();
+
+      // Insert and remove
+      test_insert_ends();
+      test_insert_middle();
+      test_remove_reuse();
+      test_clear_reuse();
+
+      // Grow
+      test_insert_grow();
+
+      // Copy
+      test_assign_copy();
+      test_copy_corrupt();
+
+      report("Mapped");
+   }
+
+   /***************************************
+    * CONSTRUCT
+    ***************************************/
+
+   // a new file is an empty list
+   void test_construct_new()
+   {  // setup
+      std::string path = pathFor("new");
+      // exercise
+      {
+         MappedList <int> list(path, 16);
+         // verify
+         assertUnit(list.empty());
+         assertUnit(list.size() == 0);
+         assertUnit(list.head() == 0);
+         assertUnit(list.tail() == 0);
+         assertUnit(list.capacity() == 16);
+      }
+      // teardown
+      std::remove(path.c_str());
+   }
+
+   // the list is still there when the file is opened again
+   void test_construct_reopen()
+   {  // setup
+      std::string path = pathFor("reopen");
+      {
+         MappedList <int> list(path);
+         for (int value : { 11, 26, 31 })
+            list.insert(0, value, true);
+         list.sync();
+      }
+      // exercise
+      MappedList <int> list(path);
+      // verify
+      assertUnit(values(list) == "11 26 31");
+      assertUnit(list.size() == 3);
+      assertUnit(list.prev(list.tail()) == list.next(list.head()));
+      // teardown
+      std::remove(path.c_str());
+   }
+
+   // a file that holds something else is refused
+   void test_construct_wrongType()
+   {  // setup
+      std::string path = pathFor("wrongType");
+      {
+         MappedList <int> list(path);
+         list.insert(0, 26);
+      }
+      bool thrown = false;
+      // exercise
+      try
+      {
+         MappedList <double> list(path);
+      }
+      catch (const std::runtime_error &)
+      {
+         thrown = true;
+      }
+      // verify
+      assertUnit(thrown);
+      // teardown
+      std::remove(path.c_str());
+   }
+
+   // a header that does not add up is refused, however big its numbers
+   void test_construct_corrupt()
+   {  // setup
+      std::string path = pathFor("corrupt");
+      {
+         MappedList <int> list(path, 4);
+         for (int value : { 11, 26, 31 })
+            list.insert(0, value, true);
+      }
+      struct Poke
+      {
+         size_t offset;
+         uint64_t value;
+      };
+      Poke pokes[] =
+      {
+         { offsetof(MappedHeader, capacity), UINT64_MAX },       // length overflows
+         { offsetof(MappedHeader, numUsed),  5 },                // more than capacity
+         { offsetof(MappedHeader, num),      4 },                // more than numUsed
+         { offsetof(MappedHeader, head),     7 },                // inside the header
+         { offsetof(MappedHeader, tail),     1 << 20 },          // past the end
+         { offsetof(MappedHeader, free),     sizeof(MappedHeader) + 1 }   // not a slot
+      };
+      // exercise
+      for (const Poke & poke : pokes)
+      {
+         uint64_t old = peek(path, poke.offset);
+         write(path, poke.offset, poke.value);
+         bool thrown = false;
+         try
+         {
+            MappedList <int> list(path);
+         }
+         catch (const std::runtime_error &)
+         {
+            thrown = true;
+         }
+         // verify
+         assertUnit(thrown);
+         write(path, poke.offset, old);
+      }
+      MappedList <int> list(path);
+      assertUnit(values(list) == "11 26 31");
+      // teardown
+      std::remove(path.c_str());
+   }
+
+   /***************************************
+    * INSERT AND REMOVE
+    ***************************************/
+
+   // with no current node, onto the front or the back
+   void test_insert_ends()
+   {  // setup
+      std::string path = pathFor("ends");
+      MappedList <int> list(path);
+      // exercise
+      list.insert(0, 26);
+      list.insert(0, 11);
+      list.insert(0, 31, true);
+      // verify
+      //    +----+   +----+   +----+
+      //    | 11 | - | 26 | - | 31 |
+      //    +----+   +----+   +----+
+      assertUnit(values(list) == "11 26 31");
+      assertUnit(backwards(list) == "31 26 11");
+      assertUnit(list.prev(list.head()) == 0);
+      assertUnit(list.next(list.tail()) == 0);
+      // teardown
+      std::remove(path.c_str());
+   }
+
+   // before and after a node in the middle
+   void test_insert_middle()
+   {  // setup
+      std::string path = pathFor("middle");
+      MappedList <int> list(path);
+      list.insert(0, 11, true);
+      MappedList <int>::Offset p26 = list.insert(0, 26, true);
+      list.insert(0, 31, true);
+      // exercise
+      MappedList <int>::Offset p25 = list.insert(p26, 25);
+      list.insert(p26, 27, true);
+      // verify
+      assertUnit(values(list) == "11 25 26 27 31");
+      assertUnit(backwards(list) == "31 27 26 25 11");
+      assertUnit(list.at(p25) == 25);
+      assertUnit(list.size() == 5);
+      // teardown
+      std::remove(path.c_str());
+   }
+
+   // a removed slot is the next one used
+   void test_remove_reuse()
+   {  // setup
+      std::string path = pathFor("reuse");
+      MappedList <int> list(path, 4);
+      MappedList <int>::Offset p11 = list.insert(0, 11, true);
+      MappedList <int>::Offset p26 = list.insert(0, 26, true);
+      list.insert(0, 31, true);
+      // exercise
+      MappedList <int>::Offset pReturn = list.remove(p26);
+      MappedList <int>::Offset pNew = list.insert(0, 99, true);
+      MappedList <int>::Offset pHeadReturn = list.remove(list.head());
+      // verify
+      assertUnit(pReturn == p11);
+      assertUnit(pNew == p26);
+      assertUnit(pHeadReturn == list.head());
+      assertUnit(values(list) == "31 99");
+      assertUnit(backwards(list) == "99 31");
+      assertUnit(list.capacity() == 4);
+      // teardown
+      std::remove(path.c_str());
+   }
+
+   // everything cleared goes back on the free list
+   void test_clear_reuse()
+   {  // setup
+      std::string path = pathFor("clear");
+      MappedList <int> list(path, 8);
+      for (int i = 0; i < 8; i++)
+         list.insert(0, i, true);
+      // exercise
+      list.clear();
+      for (int i = 0; i < 8; i++)
+         list.insert(0, i * 10, true);
+      // verify
+      assertUnit(list.size() == 8);
+      assertUnit(list.capacity() == 8);
+      assertUnit(values(list) == "0 10 20 30 40 50 60 70");
+      // teardown
+      std::remove(path.c_str());
+   }
+
+   /***************************************
+    * GROW
+    ***************************************/
+
+   // the file grows and moves; offsets stay good
+   void test_insert_grow()
+   {  // setup
+      std::string path = pathFor("grow");
+      MappedList <int>::Offset pFirst;
+      {
+         MappedList <int> list(path, 2);
+         pFirst = list.insert(0, 0, true);
+         // exercise
+         for (int i = 1; i < 1000; i++)
+            list.insert(0, i, true);
+         // verify
+         assertUnit(list.capacity() >= 1000);
+         assertUnit(list.at(pFirst) == 0);
+      }
+      MappedList <int> list(path);
+      assertUnit(list.size() == 1000);
+      assertUnit(list.head() == pFirst);
+      bool inOrder = true;
+      int expected = 0;
+      for (MappedList <int>::Offset p = list.head(); p; p = list.next(p))
+         inOrder = inOrder && list.at(p) == expected++;
+      assertUnit(inOrder);
+      // teardown
+      std::remove(path.c_str());
+   }
+
+   /***************************************
+    * COPY
+    ***************************************/
+
+   // from memory to the file and back again
+   void test_assign_copy()
+   {  // setup
+      std::string path = pathFor("copy");
+      MappedList <int> list(path);
+      for (int value : { 1, 2, 3, 4, 5 })
+         list.insert(0, value, true);
+      Node <int> * pSource = new Node <int>(11);
+      insert(insert(pSource, 26, true), 31, true);
+      // exercise
+      list.assign(pSource);
+      Node <int> * pCopy = list.copy();
+      // verify
+      assertUnit(values(list) == "11 26 31");
+      assertUnit(backwards(list) == "31 26 11");
+      assertUnit(pCopy && pCopy->data == 11);
+      assertUnit(pCopy && pCopy->pNext && pCopy->pNext->data == 26);
+      assertUnit(pCopy && pCopy->pNext && pCopy->pNext->pNext && pCopy->pNext->pNext->data == 31);
+      assertUnit(size(pCopy) == 3);
+      // teardown
+      clear(pSource);
+      clear(pCopy);
+      std::remove(path.c_str());
+   }
+
+   // a corrupt link throws instead of leaving the file, and leaks nothing
+   void test_copy_corrupt()
+   {  // setup
+      std::string path = pathFor("copyCorrupt");
+      MappedList <int>::Offset p26;
+      {
+         MappedList <int> list(path);
+         list.insert(0, 11, true);
+         p26 = list.insert(0, 26, true);
+         list.insert(0, 31, true);
+      }
+      write(path, p26 + offsetof(MappedNode <int>, next), 3);
+      MappedList <int> list(path);
+      bool thrown = false;
+      // exercise
+      try
+      {
+         Node <int> * pCopy = list.copy();
+         clear(pCopy);
+      }
+      catch (const std::runtime_error &)
+      {
+         thrown = true;
+      }
+      // verify
+      assertUnit(thrown);
+      assertUnit(list.next(list.head()) == p26);
+      // teardown
+      std::remove(path.c_str());
+   }
+
+   /*************************************************************
+    * PATH FOR
+    * A fresh file in the temporary directory
+    *************************************************************/
+   static std::string pathFor(const std::string & name)
+   {
+      std::string path = (std::filesystem::temp_directory_path() / ("testMapped." + name)).string();
+      std::remove(path.c_str());
+      return path;
+   }
+
+   /*************************************************************
+    * PEEK / WRITE
+    * Eight bytes of the file, read or written behind
+    * the list's back
+    *************************************************************/
+   static uint64_t peek(const std::string & path, size_t offset)
+   {
+      uint64_t value = 0;
+      std::ifstream file(path, std::ios::binary);
+      file.seekg(offset);
+      file.read(reinterpret_cast <char *> (&value), sizeof(value));
+      return value;
+   }
+   static void write(const std::string & path, size_t offset, uint64_t value)
+   {
+      std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+      file.seekp(offset);
+      file.write(reinterpret_cast <const char *> (&value), sizeof(value));
+   }
+
+   /*************************************************************
+    * VALUES
+    * Front to back, separated by spaces
+    *************************************************************/
+   static std::string values(const MappedList <int> & list)
+   {
+      std::string s;
+      for (MappedList <int>::Offset p = list.head(); p; p = list.next(p))
+         s += (s.empty() ? "" : " ") + std::to_string(list.at(p));
+      return s;
+   }
+
+   /*************************************************************
+    * BACKWARDS
+    * Back to front, separated by spaces
+    *************************************************************/
+   static std::string backwards(const MappedList <int> & list)
+   {
+      std::string s;
+      for (MappedList <int>::Offset p = list.tail(); p; p = list.prev(p))
+         s += (s.empty() ? "" : " ") + std::to_string(list.at(p));
+      return s;
+   }
+};
+
+#endif // DEBUG && !_WIN32
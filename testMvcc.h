@@ -0,0 +1,319 @@
+/***********************************************************************
+ * Header:
+ *    TEST MVCC
+ * Summary:
+ *    Unit tests for the multi-version list
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "mvcc.h"       // class under test
+#include "spy.h"        // for Spy
+#include "unitTest.h"   // unit test baseclass
+
+#include <atomic>       // for std::atomic
+#include <chrono>       // for std::chrono::milliseconds
+#include <string>       // for std::string
+#include <thread>       // for std::thread
+#include <vector>       // for std::vector
+
+/***********************************************
+ * TEST MVCC
+ * Unit tests for MVCCList and MVCCSnapshot
+ ***********************************************/
+class TestMvcc : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Writers
+      test_insert_standard();
+      test_remove_logical();
+      test_update_oneVersion();
+
+      // Snapshots
+      test_snapshot_isolated();
+      test_snapshot_empty();
+
+      // Collection
+      test_collect_unused();
+      test_collect_keepsVisible();
+      test_collect_spy();
+      test_collector_background();
+      test_readers_concurrent();
+
+      report("MVCC");
+   }
+
+   /***************************************
+    * WRITERS
+    ***************************************/
+
+   // build the standard fixture front, back, and middle
+   void test_insert_standard()
+   {  // setup
+      RCUDomain domain;
+      MVCCList <int> list(domain);
+      // exercise
+      auto p31 = list.insert(nullptr, 31);
+      auto p11 = list.insert(p31, 11);
+      list.insert(p11, 26, true /* after */);
+      // verify
+      //    +----+   +----+   +----+
+      //    | 11 | - | 26 | - | 31 |
+      //    +----+   +----+   +----+
+      MVCCSnapshot <int> snap(list);
+      assertUnit(values(snap) == "11 26 31");
+      assertUnit(snap.timestamp() == list.now());
+      assertUnit(p31->pPrev && p31->pPrev->data == 26);
+      assertUnit(p11->pPrev == nullptr);
+   }  // teardown
+
+   // a removed node is hidden but still linked
+   void test_remove_logical()
+   {  // setup
+      RCUDomain domain;
+      MVCCList <int> list(domain);
+      auto p11 = list.insert(nullptr, 11);
+      auto p26 = list.insert(p11, 26, true);
+      list.insert(p26, 31, true);
+      // exercise
+      list.remove(p26);
+      // verify
+      MVCCSnapshot <int> snap(list);
+      assertUnit(values(snap) == "11 31");
+      assertUnit(list.numVersions() == 3);
+      assertUnit(p26->end == list.now());
+   }  // teardown
+
+   // an update is one step: the old and new value are never both visible
+   void test_update_oneVersion()
+   {  // setup
+      RCUDomain domain;
+      MVCCList <int> list(domain);
+      auto p11 = list.insert(nullptr, 11);
+      auto p99 = list.insert(p11, 99, true);
+      list.insert(p99, 31, true);
+      uint64_t before = list.now();
+      // exercise
+      auto p26 = list.update(p99, 26);
+      // verify
+      MVCCSnapshot <int> snap(list);
+      assertUnit(values(snap) == "11 26 31");
+      assertUnit(list.now() == before + 1);
+      assertUnit(p26->begin == p99->end);
+      assertUnit(p99->data == 99);
+   }  // teardown
+
+   /***************************************
+    * SNAPSHOTS
+    ***************************************/
+
+   // a snapshot does not see changes made after it was taken
+   void test_snapshot_isolated()
+   {  // setup
+      RCUDomain domain;
+      MVCCList <int> list(domain);
+      auto p11 = list.insert(nullptr, 11);
+      auto p26 = list.insert(p11, 26, true);
+      auto p31 = list.insert(p26, 31, true);
+      MVCCSnapshot <int> before(list);
+      // exercise
+      list.remove(p11);
+      list.update(p26, 62);
+      list.insert(p31, 44, true);
+      // verify
+      MVCCSnapshot <int> after(list);
+      assertUnit(values(before) == "11 26 31");
+      assertUnit(values(after) == "62 31 44");
+      assertUnit(before.size() == 3);
+      assertUnit(after.size() == 3);
+   }  // teardown
+
+   // a snapshot of an empty list, and of a list emptied after it
+   void test_snapshot_empty()
+   {  // setup
+      RCUDomain domain;
+      MVCCList <int> list(domain);
+      MVCCSnapshot <int> empty(list);
+      // exercise
+      auto p = list.insert(nullptr, 26);
+      MVCCSnapshot <int> full(list);
+      list.remove(p);
+      MVCCSnapshot <int> emptied(list);
+      // verify
+      assertUnit(empty.first() == nullptr);
+      assertUnit(values(full) == "26");
+      assertUnit(emptied.first() == nullptr);
+   }  // teardown
+
+   /***************************************
+    * COLLECTION
+    ***************************************/
+
+   // with no snapshots, every removed node goes
+   void test_collect_unused()
+   {  // setup
+      RCUDomain domain;
+      MVCCList <int> list(domain);
+      auto p11 = list.insert(nullptr, 11);
+      auto p26 = list.insert(p11, 26, true);
+      auto p31 = list.insert(p26, 31, true);
+      list.remove(p11);
+      list.update(p26, 62);
+      list.remove(p31);
+      // exercise
+      size_t num = list.collect();
+      // verify
+      assertUnit(num == 3);
+      assertUnit(list.numVersions() == 1);
+      MVCCSnapshot <int> snap(list);
+      assertUnit(values(snap) == "62");
+      assertUnit(snap.first()->pPrev == nullptr);
+      assertUnit(snap.first()->pNext == nullptr);
+   }  // teardown
+
+   // a version an open snapshot can see survives collection
+   void test_collect_keepsVisible()
+   {  // setup
+      RCUDomain domain;
+      MVCCList <int> list(domain);
+      std::atomic <bool> taken(false);
+      std::atomic <bool> done(false);
+      std::string seen;
+      auto p11 = list.insert(nullptr, 11);
+      auto p26 = list.insert(p11, 26, true);
+      list.remove(p11);                         // gone before the snapshot
+      std::thread reader([&]()
+      {
+         MVCCSnapshot <int> snap(list);
+         taken = true;
+         while (!done)
+            std::this_thread::yield();
+         seen = values(snap);
+      });
+      while (!taken)
+         std::this_thread::yield();
+      list.remove(p26);                         // gone after the snapshot
+      // exercise
+      std::thread collector([&]() { list.collect(); });
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      done = true;
+      collector.join();
+      reader.join();
+      // verify
+      assertUnit(seen == "26");
+      assertUnit(list.numVersions() == 1);      // [26] waits for the next pass
+      assertUnit(list.collect() == 1);
+      assertUnit(list.numVersions() == 0);
+   }  // teardown
+
+   // every collected version is destroyed exactly once
+   void test_collect_spy()
+   {  // setup
+      RCUDomain domain;
+      MVCCList <Spy> list(domain);
+      auto p11 = list.insert(nullptr, Spy(11));
+      list.insert(p11, Spy(26), true);
+      Spy::reset();
+      // exercise
+      list.remove(p11);
+      size_t num = list.collect();
+      // verify
+      assertUnit(num == 1);
+      assertUnit(Spy::numDestructor() == 1);    // destroy [11]
+      assertUnit(Spy::numDelete() == 1);
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(Spy::numCopy() == 0);
+   }  // teardown
+
+   // the background collector gets to old versions by itself
+   void test_collector_background()
+   {  // setup
+      RCUDomain domain;
+      MVCCList <int> list(domain);
+      auto p = list.insert(nullptr, 0);
+      for (int i = 1; i <= 100; i++)
+         p = list.update(p, i);
+      // exercise
+      list.startCollector(std::chrono::milliseconds(1));
+      for (int i = 0; i < 1000 && list.numVersions() > 1; i++)
+         std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      list.stopCollector();
+      // verify
+      assertUnit(list.numVersions() == 1);
+      MVCCSnapshot <int> snap(list);
+      assertUnit(values(snap) == "100");
+   }  // teardown
+
+   // readers always see a whole list while a writer rewrites it.  The
+   // writer moves each node to the next round front to back, one
+   // timestamp per node, so a snapshot sees the first few nodes at
+   // round r and the rest at round r - 1, never anything else.
+   void test_readers_concurrent()
+   {  // setup
+      const int numNodes = 16;
+      RCUDomain domain;
+      MVCCList <int> list(domain);
+      std::vector <const VersionedNode <int> *> nodes;
+      const VersionedNode <int> * pTail = nullptr;
+      for (int i = 0; i < numNodes; i++)
+         nodes.push_back(pTail = list.insert(pTail, 0, true));
+      std::atomic <bool> stop(false);
+      std::atomic <int> numBad(0);
+      std::atomic <int> numScans(0);
+      list.startCollector(std::chrono::milliseconds(1));
+      // exercise
+      std::vector <std::thread> readers;
+      for (int r = 0; r < 3; r++)
+         readers.emplace_back([&]()
+         {
+            while (!stop || numScans == 0)
+            {
+               MVCCSnapshot <int> snap(list);
+               int num = 0;
+               bool consistent = true;
+               const VersionedNode <int> * pFirst = snap.first();
+               for (auto p = pFirst, pPrevious = pFirst; p; pPrevious = p, p = snap.next(p), num++)
+                  consistent = consistent && p->data <= pPrevious->data &&
+                               p->data >= pFirst->data - 1;
+               if (num != numNodes || !consistent)
+                  numBad++;
+               numScans++;
+            }
+         });
+      for (int round = 1; round <= 200; round++)
+         for (auto & p : nodes)
+            p = list.update(p, round);
+      stop = true;
+      for (auto & reader : readers)
+         reader.join();
+      list.stopCollector();
+      // verify
+      assertUnit(numScans > 0);
+      assertUnit(numBad == 0);
+      MVCCSnapshot <int> snap(list);
+      assertUnit(snap.size() == numNodes);
+      assertUnit(snap.first() && snap.first()->data == 200);
+   }  // teardown
+
+   /*************************************************************
+    * VALUES
+    * The values a snapshot sees, separated by spaces
+    *************************************************************/
+   static std::string values(const MVCCSnapshot <int> & snap)
+   {
+      std::string s;
+      for (auto p = snap.first(); p; p = snap.next(p))
+         s += (s.empty() ? "" : " ") + std::to_string(p->data);
+      return s;
+   }
+};
+
+#endif // DEBUG
@@ -13,6 +13,28 @@
 
 #include "testSpy.h"        // for the spy unit tests
 #include "testNode.h"       // for the unit tests
+#include "testPool.h"       // for the node pool unit tests
+#include "testQueue.h"      // for the lock-free queue unit tests
+#include "testRCU.h"        // for the read-copy-update unit tests
+#include "testParallel.h"   // for the parallel algorithm unit tests
+#include "testReclaim.h"    // for the background clear unit tests
+#include "testCursor.h"     // for the resumable copy unit tests
+#include "testCow.h"        // for the copy-on-write unit tests
+#include "testPersistent.h" // for the persistent list unit tests
+#include "testMvcc.h"       // for the multi-version list unit tests
+#include "testSharded.h"    // for the sharded list unit tests
+#include "testCombining.h"  // for the flat-combining unit tests
+#include "testSeqlock.h"    // for the seqlock list unit tests
+#include "testSkiplist.h"   // for the skip list unit tests
+#include "testGenerator.h"  // for the coroutine generator unit tests
+#include "testIterator.h"   // for the list iterator unit tests
+#include "testSerialize.h"  // for the binary serialization unit tests
+#include "testMapped.h"     // for the memory-mapped list unit tests
+#include "testShm.h"        // for the shared-memory list unit tests
+#include "testParse.h"      // for the text parser unit tests
+#include "testCompressed.h" // for the compressed list unit tests
+#include "testWriter.h"     // for the asynchronous writer unit tests
+#include "testJournal.h"    // for the journaled list unit tests
 int Spy::counters[] = {};
 
 /**********************************************************************
@@ -25,6 +47,32 @@ int main()
    // unit tests
    TestSpy().run();
    TestNode().run();
+   TestPool().run();
+   TestQueue().run();
+   TestRCU().run();
+   TestParallel().run();
+   TestReclaim().run();
+   TestCursor().run();
+   TestCow().run();
+   TestPersistent().run();
+   TestMvcc().run();
+   TestSharded().run();
+   TestCombining().run();
+   TestSeqlock().run();
+   TestSkiplist().run();
+   TestGenerator().run();
+   TestIterator().run();
+   TestSerialize().run();
+#ifndef _WIN32
+   TestMapped().run();
+   TestShm().run();
+#endif // _WIN32
+   TestParse().run();
+   TestCompressed().run();
+#ifndef _WIN32
+   TestWriter().run();
+   TestJournal().run();
+#endif // _WIN32
 #endif // DEBUG
   
    return 0;
@@ -15,7 +15,10 @@
 #include "spy.h"
 
 #include <cassert>
+#include <iomanip>
 #include <memory>
+#include <sstream>
+#include <string>
 
 class TestNode : public UnitTest
 {
@@ -65,6 +68,15 @@ public:
       test_size_empty();
       test_size_standard();
       test_size_standardMiddle();
+
+      // Display
+      test_display_empty();
+      test_display_standard();
+      test_display_double();
+      test_display_precision();
+      test_display_formatted();
+      test_display_char();
+      test_display_long();
       
       report("Node");
    }
@@ -1294,6 +1306,142 @@ public:
    }
 
       
+   /***************************************
+    * DISPLAY
+    ***************************************/
+
+   // nothing to show
+   void test_display_empty()
+   {  // setup
+      const Node <int> * pHead = nullptr;
+      std::ostringstream out;
+      // exercise
+      out << pHead;
+      // verify
+      assertUnit(out.str() == "");
+   }  // teardown
+
+   // separated by commas, with none at the end
+   void test_display_standard()
+   {  // setup
+      //    +----+   +----+   +----+
+      //    | 11 | - | 26 | - | 31 |
+      //    +----+   +----+   +----+
+      Node <int> * p11, * p26, * p31;
+      setupStandardFixture(p11, p26, p31);
+      std::ostringstream out;
+      // exercise
+      out << (const Node <int> *)p11;
+      // verify
+      assertUnit(out.str() == "11, 26, 31");
+      assertStandardFixture(p11);
+      // teardown
+      teardownStandardFixture(p11);
+   }
+
+   // floating point the way the stream writes it
+   void test_display_double()
+   {  // setup
+      Node <double> * pHead = new Node <double>(0.1);
+      insert(insert(insert(pHead, 1e20, true), -2.5, true), 1.0 / 3.0, true);
+      std::ostringstream out;
+      // exercise
+      out << (const Node <double> *)pHead;
+      // verify
+      assertUnit(out.str() == "0.1, 1e+20, -2.5, 0.333333");
+      assertUnit(out.str() == slowDisplay(pHead, out));
+      // teardown
+      clear(pHead);
+   }
+
+   // the stream's precision is honored
+   void test_display_precision()
+   {  // setup
+      Node <double> * pHead = new Node <double>(3.14159);
+      insert(insert(pHead, 2.71828, true), 100.0, true);
+      std::ostringstream out;
+      out.precision(3);
+      // exercise
+      out << (const Node <double> *)pHead;
+      // verify
+      assertUnit(out.str() == "3.14, 2.72, 100");
+      // teardown
+      clear(pHead);
+   }
+
+   // a width, a base, or a sign leaves the formatting to the stream
+   void test_display_formatted()
+   {  // setup
+      //    +----+   +----+   +----+
+      //    | 11 | - | 26 | - | 31 |
+      //    +----+   +----+   +----+
+      Node <int> * p11, * p26, * p31;
+      setupStandardFixture(p11, p26, p31);
+      std::ostringstream hex;
+      std::ostringstream wide;
+      std::ostringstream sign;
+      // exercise
+      hex << std::hex << (const Node <int> *)p11;
+      wide << std::setw(5) << (const Node <int> *)p11;
+      sign << std::showpos << (const Node <int> *)p11;
+      // verify
+      assertUnit(hex.str() == "b, 1a, 1f");
+      assertUnit(wide.str() == "   11, 26, 31");
+      assertUnit(sign.str() == "+11, +26, +31");
+      // teardown
+      teardownStandardFixture(p11);
+   }
+
+   // characters are characters, not numbers
+   void test_display_char()
+   {  // setup
+      Node <char> * pHead = new Node <char>('a');
+      insert(pHead, 'b', true);
+      std::ostringstream out;
+      // exercise
+      out << (const Node <char> *)pHead;
+      // verify
+      assertUnit(out.str() == "a, b");
+      // teardown
+      clear(pHead);
+   }
+
+   // more than fits in one buffer
+   void test_display_long()
+   {  // setup
+      Node <long long> * pHead = nullptr;
+      Node <long long> * pTail = nullptr;
+      for (long long i = 0; i < 20000; i++)
+      {
+         pTail = insert(pTail, i * 1000003 - 7000000000LL, true);
+         if (pHead == nullptr)
+            pHead = pTail;
+      }
+      std::ostringstream out;
+      // exercise
+      out << (const Node <long long> *)pHead;
+      // verify
+      assertUnit(out.str() == slowDisplay(pHead, out));
+      assertUnit(out.str().size() > 16384);
+      // teardown
+      clear(pHead);
+   }
+
+   /*************************************************************
+    * SLOW DISPLAY
+    * What the stream writes one value at a time, with the
+    * same formatting as like
+    *************************************************************/
+   template <class T>
+   static std::string slowDisplay(const Node <T> * pHead, const std::ostream & like)
+   {
+      std::ostringstream out;
+      out.copyfmt(like);
+      for (const Node <T> * p = pHead; p; p = p->pNext)
+         out << (p == pHead ? "" : ", ") << p->data;
+      return out.str();
+   }
+
    /***************************************
     * FREE
     ***************************************/
@@ -0,0 +1,390 @@
+/***********************************************************************
+ * Header:
+ *    TEST PARALLEL
+ * Summary:
+ *    Unit tests for the thread pool and the parallel algorithms
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "parallel.h"   // functions under test
+#include "spy.h"        // for Spy
+#include "unitTest.h"   // unit test baseclass
+
+#include <atomic>       // for std::atomic
+#include <stdexcept>    // for std::runtime_error
+#include <string>       // for std::string
+
+/***********************************************
+ * TEST PARALLEL
+ * Unit tests for ThreadPool and the parallel algorithms
+ ***********************************************/
+class TestParallel : public UnitTest
+{
+public:
+   TestParallel() : pool(4) { }
+
+   void run()
+   {
+      reset();
+
+      // Thread pool
+      test_pool_runAll();
+      test_pool_nested();
+      test_pool_exception();
+
+      // Split
+      test_split_empty();
+      test_split_even();
+      test_split_short();
+
+      // Algorithms
+      test_forEach_empty();
+      test_forEach_standard();
+      test_transform_standard();
+      test_reduce_empty();
+      test_reduce_sum();
+      test_reduce_ordered();
+      test_countIf_standard();
+      test_copy_empty();
+      test_copy_standard();
+      test_copy_spy();
+      test_clear_nullptr();
+      test_clear_standard();
+      test_clear_spy();
+
+      report("Parallel");
+   }
+
+   /***************************************
+    * THREAD POOL
+    ***************************************/
+
+   // every task runs exactly once
+   void test_pool_runAll()
+   {  // setup
+      std::vector <std::atomic <int>> ran(1000);
+      // exercise
+      pool.run(ran.size(), [&ran](size_t i) { ran[i]++; });
+      // verify
+      bool allOnce = true;
+      for (auto & r : ran)
+         allOnce = allOnce && r == 1;
+      assertUnit(allOnce);
+      assertUnit(pool.size() == 4);
+   }  // teardown
+
+   // a task can run more tasks on the same pool
+   void test_pool_nested()
+   {  // setup
+      std::atomic <int> total(0);
+      // exercise
+      pool.run(8, [&](size_t)
+      {
+         pool.run(8, [&](size_t) { total++; });
+      });
+      // verify
+      assertUnit(total == 64);
+   }  // teardown
+
+   // an exception in a task comes back to the caller
+   void test_pool_exception()
+   {  // setup
+      bool caught = false;
+      std::atomic <int> numRan(0);
+      // exercise
+      try
+      {
+         pool.run(16, [&](size_t i)
+         {
+            numRan++;
+            if (i == 5)
+               throw std::runtime_error("five");
+         });
+      }
+      catch (const std::runtime_error &)
+      {
+         caught = true;
+      }
+      // verify
+      assertUnit(caught);
+      assertUnit(numRan == 16);      // the others still finish
+   }  // teardown
+
+   /***************************************
+    * SPLIT
+    ***************************************/
+
+   // nothing to split
+   void test_split_empty()
+   {  // setup
+      Node <int> * pHead = nullptr;
+      // exercise
+      std::vector <Node <int> *> starts = split(pHead, 4);
+      // verify
+      assertUnit(starts.empty());
+   }  // teardown
+
+   // 1000 nodes in 4 chunks start at 0, 256, 512, and 768
+   void test_split_even()
+   {  // setup
+      Node <int> * pHead = build(1000);
+      // exercise
+      std::vector <Node <int> *> starts = split(pHead, 4);
+      // verify
+      assertUnit(starts.size() == 4);
+      assertUnit(starts.size() > 0 && starts[0] == pHead);
+      bool increasing = true;
+      for (size_t i = 1; i < starts.size(); i++)
+         increasing = increasing && starts[i]->data > starts[i - 1]->data;
+      assertUnit(increasing);
+      assertUnit(starts.size() == 4 && starts[3]->data - starts[2]->data
+                                    == starts[1]->data - starts[0]->data);
+      // teardown
+      clear(pHead);
+   }
+
+   // fewer nodes than chunks gives one node per chunk
+   void test_split_short()
+   {  // setup
+      Node <int> * pHead = build(3);
+      // exercise
+      std::vector <Node <int> *> starts = split(pHead, 8);
+      // verify
+      assertUnit(starts.size() == 3);
+      assertUnit(starts.size() == 3 && starts[2]->data == 2);
+      // teardown
+      clear(pHead);
+   }
+
+   /***************************************
+    * ALGORITHMS
+    ***************************************/
+
+   // nothing to visit
+   void test_forEach_empty()
+   {  // setup
+      Node <int> * pHead = nullptr;
+      std::atomic <int> numCalls(0);
+      // exercise
+      parallelForEach(pHead, [&](int &) { numCalls++; }, pool);
+      // verify
+      assertUnit(numCalls == 0);
+   }  // teardown
+
+   // every node is visited once
+   void test_forEach_standard()
+   {  // setup
+      Node <int> * pHead = build(10000);
+      // exercise
+      parallelForEach(pHead, [](int & value) { value += 1; }, pool);
+      // verify
+      bool allBumped = true;
+      int expected = 1;
+      for (auto p = pHead; p; p = p->pNext)
+         allBumped = allBumped && p->data == expected++;
+      assertUnit(allBumped);
+      // teardown
+      clear(pHead);
+   }
+
+   // every value is replaced
+   void test_transform_standard()
+   {  // setup
+      Node <int> * pHead = build(10000);
+      // exercise
+      parallelTransform(pHead, [](int value) { return value * 2; }, pool);
+      // verify
+      bool allDoubled = true;
+      int expected = 0;
+      for (auto p = pHead; p; p = p->pNext, expected += 2)
+         allDoubled = allDoubled && p->data == expected;
+      assertUnit(allDoubled);
+      // teardown
+      clear(pHead);
+   }
+
+   // reducing nothing gives back the starting value
+   void test_reduce_empty()
+   {  // setup
+      const Node <int> * pHead = nullptr;
+      // exercise
+      long long sum = parallelReduce(pHead, 42LL, [](long long a, long long b) { return a + b; }, pool);
+      // verify
+      assertUnit(sum == 42);
+   }  // teardown
+
+   // 0 + 1 + ... + 9999
+   void test_reduce_sum()
+   {  // setup
+      Node <int> * pHead = build(10000);
+      // exercise
+      long long sum = parallelReduce((const Node <int> *)pHead, 0LL,
+                                     [](long long a, long long b) { return a + b; }, pool);
+      // verify
+      assertUnit(sum == 9999LL * 10000 / 2);
+      // teardown
+      clear(pHead);
+   }
+
+   // chunks are combined in list order
+   void test_reduce_ordered()
+   {  // setup
+      Node <std::string> * pHead = nullptr;
+      Node <std::string> * pTail = nullptr;
+      std::string expected;
+      for (int i = 0; i < 500; i++)
+      {
+         std::string s(1, (char)('a' + i % 26));
+         pTail = insert(pTail, s, true);
+         if (pHead == nullptr)
+            pHead = pTail;
+         expected += s;
+      }
+      // exercise
+      std::string joined = parallelReduce((const Node <std::string> *)pHead, std::string(">"),
+         [](const std::string & a, const std::string & b) { return a + b; }, pool);
+      // verify
+      assertUnit(joined == ">" + expected);
+      // teardown
+      clear(pHead);
+   }
+
+   // count the even values
+   void test_countIf_standard()
+   {  // setup
+      Node <int> * pHead = build(10001);
+      // exercise
+      size_t numEven = parallelCountIf((const Node <int> *)pHead,
+                                       [](int value) { return value % 2 == 0; }, pool);
+      // verify
+      assertUnit(numEven == 5001);
+      // teardown
+      clear(pHead);
+   }
+
+   // copy nothing
+   void test_copy_empty()
+   {  // setup
+      const Node <int> * pSrc = nullptr;
+      // exercise
+      Node <int> * pDes = parallelCopy(pSrc, pool);
+      // verify
+      assertUnit(pDes == nullptr);
+   }  // teardown
+
+   // the copy is one doubly linked list with the same values
+   void test_copy_standard()
+   {  // setup
+      Node <int> * pSrc = build(10000);
+      // exercise
+      Node <int> * pDes = parallelCopy((const Node <int> *)pSrc, pool);
+      // verify
+      bool same = true;
+      bool linked = true;
+      const Node <int> * pPrevious = nullptr;
+      const Node <int> * p = pDes;
+      for (const Node <int> * q = pSrc; q; q = q->pNext, p = p ? p->pNext : nullptr)
+      {
+         same = same && p != nullptr && p != q && p->data == q->data;
+         linked = linked && p != nullptr && p->pPrev == pPrevious;
+         pPrevious = p;
+      }
+      assertUnit(same);
+      assertUnit(linked);
+      assertUnit(p == nullptr);
+      // teardown
+      clear(pSrc);
+      clear(pDes);
+   }
+
+   // each value is copied exactly once
+   void test_copy_spy()
+   {  // setup
+      //    +----+   +----+   +----+
+      //    | 11 | - | 26 | - | 31 |
+      //    +----+   +----+   +----+
+      Node <Spy> * pSrc = new Node <Spy>(Spy(11));
+      insert(insert(pSrc, Spy(26), true), Spy(31), true);
+      ThreadPool one(1);
+      Spy::reset();
+      // exercise
+      Node <Spy> * pDes = parallelCopy((const Node <Spy> *)pSrc, one);
+      // verify
+      assertUnit(Spy::numCopy() == 3);        // copy [11][26][31]
+      assertUnit(Spy::numAlloc() == 3);
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(Spy::numDelete() == 0);
+      assertUnit(pDes && pDes->data == Spy(11));
+      assertUnit(pDes && pDes->pNext && pDes->pNext->pNext &&
+                 pDes->pNext->pNext->data == Spy(31));
+      assertUnit(size(pDes) == 3);
+      // teardown
+      clear(pSrc);
+      clear(pDes);
+   }
+
+   // clear nothing
+   void test_clear_nullptr()
+   {  // setup
+      Node <int> * pHead = nullptr;
+      // exercise
+      size_t num = parallelClear(pHead, pool);
+      // verify
+      assertUnit(num == 0);
+      assertUnit(pHead == nullptr);
+   }  // teardown
+
+   // every node is freed and counted
+   void test_clear_standard()
+   {  // setup
+      Node <int> * pHead = build(10000);
+      // exercise
+      size_t num = parallelClear(pHead, pool);
+      // verify
+      assertUnit(num == 10000);
+      assertUnit(pHead == nullptr);
+   }  // teardown
+
+   // every value is destroyed exactly once
+   void test_clear_spy()
+   {  // setup
+      Node <Spy> * pHead = new Node <Spy>(Spy(11));
+      insert(insert(pHead, Spy(26), true), Spy(31), true);
+      ThreadPool one(1);
+      Spy::reset();
+      // exercise
+      size_t num = parallelClear(pHead, one);
+      // verify
+      assertUnit(Spy::numDestructor() == 3);   // destroy [11][26][31]
+      assertUnit(Spy::numDelete() == 3);
+      assertUnit(num == 3);
+      assertUnit(pHead == nullptr);
+   }  // teardown
+
+   /*************************************************************
+    * BUILD
+    * A list holding 0, 1, ... num - 1
+    *************************************************************/
+   Node <int> * build(int num)
+   {
+      Node <int> * pHead = nullptr;
+      Node <int> * pTail = nullptr;
+      for (int i = 0; i < num; i++)
+      {
+         pTail = insert(pTail, i, true);
+         if (pHead == nullptr)
+            pHead = pTail;
+      }
+      return pHead;
+   }
+
+private:
+   ThreadPool pool;
+};
+
+#endif // DEBUG
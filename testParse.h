@@ -0,0 +1,278 @@
+/***********************************************************************
+ * Header:
+ *    TEST PARSE
+ * Summary:
+ *    Unit tests for reading a list back from text
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "parse.h"      // functions under test
+#include "unitTest.h"   // unit test baseclass
+
+#include <sstream>      // for std::ostringstream
+#include <string>       // for std::string
+
+/***********************************************
+ * TEST PARSE
+ * Unit tests for parse and parallelParse
+ ***********************************************/
+class TestParse : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Parse
+      test_parse_empty();
+      test_parse_standard();
+      test_parse_roundTrip();
+      test_parse_errors();
+
+      // Stream
+      test_stream_smallBuffer();
+      test_stream_longValue();
+      test_stream_error();
+
+      // Parallel
+      test_parallel_standard();
+      test_parallel_error();
+
+      report("Parse");
+   }
+
+   /***************************************
+    * PARSE
+    ***************************************/
+
+   // no values, no list
+   void test_parse_empty()
+   {  // setup
+      NodePool <int> pool;
+      // exercise
+      Node <int> * pEmpty = parse("", pool);
+      Node <int> * pBlank = parse("  \n", pool);
+      // verify
+      assertUnit(pEmpty == nullptr);
+      assertUnit(pBlank == nullptr);
+   }  // teardown
+
+   // what operator << writes
+   void test_parse_standard()
+   {  // setup
+      NodePool <int> pool;
+      // exercise
+      Node <int> * pHead = parse("11, 26, 31\n", pool);
+      // verify
+      //    +----+   +----+   +----+
+      //    | 11 | - | 26 | - | 31 |
+      //    +----+   +----+   +----+
+      assertUnit(display(pHead) == "11, 26, 31");
+      assertUnit(linked(pHead));
+      // teardown
+      pool.clear(pHead);
+   }
+
+   // doubles written with enough digits come back exactly
+   void test_parse_roundTrip()
+   {  // setup
+      Node <double> * pSource = new Node <double>(0.1);
+      insert(insert(insert(pSource, -1e300, true), 1.0 / 3.0, true), 5e-324, true);
+      std::ostringstream out;
+      out.precision(17);
+      out << (const Node <double> *)pSource;
+      NodePool <double> pool;
+      // exercise
+      Node <double> * pHead = parse(out.str(), pool);
+      // verify
+      bool same = true;
+      const Node <double> * p = pHead;
+      for (const Node <double> * pExpect = pSource; pExpect; pExpect = pExpect->pNext, p = p ? p->pNext : p)
+         same = same && p && p->data == pExpect->data;
+      assertUnit(same);
+      assertUnit(p == nullptr);
+      // teardown
+      clear(pSource);
+      pool.clear(pHead);
+   }
+
+   // not a list of numbers, and where it goes wrong
+   void test_parse_errors()
+   {  // setup
+      NodePool <short> pool(8);
+      // exercise
+      size_t notNumber = errorAt("1, x", pool);
+      size_t missing = errorAt("1,, 2", pool);
+      size_t trailing = errorAt("1, 2,", pool);
+      size_t noComma = errorAt("1 2", pool);
+      size_t tooBig = errorAt("1, 70000", pool);
+      // verify
+      assertUnit(notNumber == 3);
+      assertUnit(missing == 2);
+      assertUnit(trailing == 5);
+      assertUnit(noComma == 2);
+      assertUnit(tooBig == 3);
+      assertUnit(pool.numFree() == 8 * pool.numBlocks());   // nothing left behind
+   }  // teardown
+
+   /***************************************
+    * STREAM
+    ***************************************/
+
+   // values cut across many small buffers
+   void test_stream_smallBuffer()
+   {  // setup
+      std::string text = numbers(1000);
+      std::istringstream in(text);
+      NodePool <int> pool;
+      // exercise
+      Node <int> * pHead = parse(in, pool, 64);
+      // verify
+      assertUnit(display(pHead) == text);
+      assertUnit(linked(pHead));
+      // teardown
+      pool.clear(pHead);
+   }
+
+   // a stretch with no comma longer than the buffer
+   void test_stream_longValue()
+   {  // setup
+      std::istringstream in("1, " + std::string(300, ' ') + "2, 3");
+      NodePool <int> pool;
+      // exercise
+      Node <int> * pHead = parse(in, pool, 64);
+      // verify
+      assertUnit(display(pHead) == "1, 2, 3");
+      // teardown
+      pool.clear(pHead);
+   }
+
+   // the offset counts from the start of the stream
+   void test_stream_error()
+   {  // setup
+      std::string text = numbers(100) + ", oops";
+      std::istringstream in(text);
+      NodePool <int> pool;
+      size_t position = 0;
+      // exercise
+      try
+      {
+         parse(in, pool, 64);
+      }
+      catch (const ParseError & error)
+      {
+         position = error.position();
+      }
+      // verify
+      assertUnit(position == text.size() - 4);
+   }  // teardown
+
+   /***************************************
+    * PARALLEL
+    ***************************************/
+
+   // pieces parsed on four threads come back as one list
+   void test_parallel_standard()
+   {  // setup
+      std::string text = numbers(100000);
+      ThreadPool threads(4);
+      NodePool <int> pool;
+      // exercise
+      Node <int> * pHead = parallelParse(text, pool, threads);
+      // verify
+      assertUnit(size(pHead) == 100000);
+      assertUnit(display(pHead) == text);
+      assertUnit(linked(pHead));
+      assertUnit(pool.numBlocks() > 1);       // taken over from the pieces
+      // teardown
+      pool.clear(pHead);
+   }
+
+   // a bad value deep inside one piece
+   void test_parallel_error()
+   {  // setup
+      std::string text = numbers(100000);
+      size_t bad = text.size() * 2 / 3;
+      while (text[bad] == ',' || text[bad] == ' ')
+         bad++;
+      text[bad] = 'x';
+      ThreadPool threads(4);
+      NodePool <int> pool;
+      size_t position = 0;
+      // exercise
+      try
+      {
+         parallelParse(text, pool, threads);
+      }
+      catch (const ParseError & error)
+      {
+         position = error.position();
+      }
+      // verify
+      assertUnit(position == bad);
+      assertUnit(pool.numBlocks() == 0);
+   }  // teardown
+
+   /*************************************************************
+    * NUMBERS
+    * 0, 1, ... num - 1 as operator << writes them
+    *************************************************************/
+   static std::string numbers(int num)
+   {
+      std::string s;
+      for (int i = 0; i < num; i++)
+         s += (i ? ", " : "") + std::to_string(i);
+      return s;
+   }
+
+   /*************************************************************
+    * DISPLAY
+    * What operator << writes for the list
+    *************************************************************/
+   template <class T>
+   static std::string display(const Node <T> * pHead)
+   {
+      std::ostringstream out;
+      out << pHead;
+      return out.str();
+   }
+
+   /*************************************************************
+    * LINKED
+    * Does every pPrev point back at the node before it?
+    *************************************************************/
+   template <class T>
+   static bool linked(const Node <T> * pHead)
+   {
+      const Node <T> * pPrevious = nullptr;
+      for (const Node <T> * p = pHead; p; pPrevious = p, p = p->pNext)
+         if (p->pPrev != pPrevious)
+            return false;
+      return true;
+   }
+
+   /*************************************************************
+    * ERROR AT
+    * Where parsing the text fails, or -1 if it does not
+    *************************************************************/
+   static size_t errorAt(const std::string & text, NodePool <short> & pool)
+   {
+      try
+      {
+         Node <short> * pHead = parse(text, pool);
+         pool.clear(pHead);
+      }
+      catch (const ParseError & error)
+      {
+         return error.position();
+      }
+      return (size_t)-1;
+   }
+};
+
+#endif // DEBUG
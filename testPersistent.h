@@ -0,0 +1,379 @@
+/***********************************************************************
+ * Header:
+ *    TEST PERSISTENT
+ * Summary:
+ *    Unit tests for the persistent list and its builder
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "persistent.h" // class under test
+#include "spy.h"        // for Spy
+#include "unitTest.h"   // unit test baseclass
+
+#include <deque>        // for std::deque
+#include <stdexcept>    // for std::runtime_error
+#include <string>       // for std::string
+#include <vector>       // for std::vector
+
+/***********************************************
+ * TEST PERSISTENT
+ * Unit tests for PersistentList and TransientList
+ ***********************************************/
+class TestPersistent : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Versions
+      test_create_empty();
+      test_pushFront_sharing();
+      test_pushBack_sharing();
+      test_popFront_front();
+      test_popFront_rear();
+      test_popFront_bounded();
+      test_siblings_bounded();
+      test_mixed_inOrder();
+      test_copy_noCopies();
+      test_release_versions();
+      test_pushBack_throws();
+
+      // Builder
+      test_transient_build();
+      test_transient_fromVersion();
+      test_nodes_roundTrip();
+
+      report("Persistent");
+   }
+
+   /***************************************
+    * VERSIONS
+    ***************************************/
+
+   // a new list has nothing in it
+   void test_create_empty()
+   {  // setup
+      // exercise
+      PersistentList <Spy> list;
+      // verify
+      assertUnit(list.empty());
+      assertUnit(list.size() == 0);
+      assertUnit(values(list) == "");
+   }  // teardown
+
+   // prepending copies one value and leaves the old version alone
+   void test_pushFront_sharing()
+   {  // setup
+      PersistentList <Spy> v1 = standard();
+      Spy s(5);
+      Spy::reset();
+      // exercise
+      PersistentList <Spy> v2 = v1.pushFront(s);
+      // verify
+      assertUnit(Spy::numCopy() == 1);        // copy [5] only
+      assertUnit(Spy::numAlloc() == 1);
+      assertUnit(values(v1) == "11,26,31");
+      assertUnit(values(v2) == "5,11,26,31");
+      assertUnit(v2.front() == Spy(5));
+   }  // teardown
+
+   // appending copies one value and leaves the old version alone
+   void test_pushBack_sharing()
+   {  // setup
+      PersistentList <Spy> v1 = standard();
+      Spy s(42);
+      Spy::reset();
+      // exercise
+      PersistentList <Spy> v2 = v1.pushBack(s);
+      PersistentList <Spy> v3 = v1.pushBack(Spy(43));
+      // verify
+      assertUnit(Spy::numCopy() == 4);        // [42] and [43], and [11] as v1's rotation ends
+      assertUnit(values(v1) == "11,26,31");
+      assertUnit(values(v2) == "11,26,31,42");
+      assertUnit(values(v3) == "11,26,31,43");
+   }  // teardown
+
+   // dropping the front of the front makes nothing
+   void test_popFront_front()
+   {  // setup
+      PersistentList <Spy> v1 = PersistentList <Spy>().pushFront(Spy(31)).pushFront(Spy(26));
+      Spy::reset();
+      // exercise
+      PersistentList <Spy> v2 = v1.popFront();
+      // verify
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numDestructor() == 0);
+      assertUnit(values(v1) == "26,31");
+      assertUnit(values(v2) == "31");
+   }  // teardown
+
+   // dropping the front when it is all rear turns the rear around
+   void test_popFront_rear()
+   {  // setup
+      PersistentList <Spy> v1 = standard();   // all on the rear
+      // exercise
+      PersistentList <Spy> v2 = v1.popFront();
+      PersistentList <Spy> v3 = v2.popFront();
+      // verify
+      assertUnit(values(v1) == "11,26,31");
+      assertUnit(values(v2) == "26,31");
+      assertUnit(values(v3) == "31");
+      assertUnit(v3.popFront().empty());
+      assertUnit(v2.front() == Spy(26));
+   }  // teardown
+
+   // no pop turns a long rear around by itself
+   void test_popFront_bounded()
+   {  // setup
+      PersistentList <Spy> v1;
+      for (int i = 0; i < 100; i++)
+         v1 = v1.pushBack(Spy(i));
+      // exercise
+      for (int i = 0; i < 100; i++)
+      {
+         Spy::reset();
+         PersistentList <Spy> v2 = v1.popFront();
+         assertUnit(Spy::numCopy() <= 4);     // two steps of a rotation
+         assertUnit(v2.size() == (size_t)(99 - i));
+         assertUnit(v1.front() == Spy(i));
+         assertUnit(v2.empty() || v2.front() == Spy(i + 1));
+         v1 = v2;
+      }
+      // verify
+      assertUnit(v1.empty());
+   }  // teardown
+
+   // versions branching off one ancestor each pay only for their own change
+   void test_siblings_bounded()
+   {  // setup
+      PersistentList <Spy> v1;
+      for (int i = 0; i < 100; i++)
+         v1 = v1.pushBack(Spy(i));
+      std::vector <PersistentList <Spy>> siblings;
+      Spy::reset();
+      // exercise
+      for (int i = 0; i < 100; i++)
+      {
+         siblings.push_back(v1.pushBack(Spy(100 + i)).popFront());
+         assertUnit(siblings.back().front() == Spy(1));
+      }
+      // verify
+      assertUnit(Spy::numCopy() <= 100 * 9);  // not 100 reversals of 100
+      assertUnit(Spy::numDestructor() <= 100 * 9);
+      assertUnit(siblings[42].size() == 100);
+      assertUnit(siblings[42].popFront().front() == Spy(2));
+   }  // teardown
+
+   // any mix of changes reads back in order, through every rotation
+   void test_mixed_inOrder()
+   {  // setup
+      PersistentList <Spy> v;
+      std::deque <int> expect;
+      int next = 0;
+      // exercise
+      for (int i = 0; i < 500; i++)
+      {
+         if (i % 7 == 3)
+         {
+            v = v.pushFront(Spy(next));
+            expect.push_front(next++);
+         }
+         else if (i % 3 == 2 && !expect.empty())
+         {
+            v = v.popFront();
+            expect.pop_front();
+         }
+         else
+         {
+            v = v.pushBack(Spy(next));
+            expect.push_back(next++);
+         }
+         // verify
+         assertUnit(v.size() == expect.size());
+         assertUnit(values(v) == values(expect));
+         assertUnit(expect.empty() || v.front() == Spy(expect.front()));
+      }
+   }  // teardown
+
+   // a version is copied without copying any values
+   void test_copy_noCopies()
+   {  // setup
+      PersistentList <Spy> v1 = standard();
+      Spy::reset();
+      // exercise
+      PersistentList <Spy> v2(v1);
+      PersistentList <Spy> v3;
+      v3 = v2;
+      v3 = v3;
+      // verify
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(values(v3) == "11,26,31");
+   }  // teardown
+
+   // a cell lives exactly as long as some version needs it
+   void test_release_versions()
+   {  // setup
+      PersistentList <Spy> * pV1 = new PersistentList <Spy>(standard());
+      PersistentList <Spy> * pV2 = new PersistentList <Spy>(pV1->pushBack(Spy(42)));
+      Spy::reset();
+      // exercise
+      delete pV1;
+      // verify
+      assertUnit(values(*pV2) == "11,26,31,42");
+      int numBefore = Spy::numDestructor();  // only what v2 does not share
+      delete pV2;
+      assertUnit(Spy::numDestructor() - numBefore == 4);  // destroy [11][26][31][42]
+      assertUnit(Spy::numDelete() == Spy::numDestructor());
+   }  // teardown
+
+   // a copy that throws leaves every version whole and nothing held
+   void test_pushBack_throws()
+   {  // setup
+      Brittle::numLive = 0;
+      {
+         PersistentList <Brittle> v1;
+         for (int i = 0; i < 5; i++)
+            v1 = v1.pushBack(Brittle()).pushFront(Brittle());
+         bool thrown = false;
+         // exercise
+         Brittle::copiesLeft = 0;
+         try
+         {
+            v1.pushBack(Brittle());
+         }
+         catch (const std::runtime_error &)
+         {
+            thrown = true;
+         }
+         try
+         {
+            v1.pushFront(Brittle());
+         }
+         catch (const std::runtime_error &)
+         {
+            thrown = true;
+         }
+         Brittle::copiesLeft = -1;
+         // verify
+         assertUnit(thrown);
+         assertUnit(v1.size() == 10);
+         assertUnit(v1.pushBack(Brittle()).size() == 11);
+      }
+      assertUnit(Brittle::numLive == 0);     // every cell was freed
+   }  // teardown
+
+   /***************************************
+    * BUILDER
+    ***************************************/
+
+   // a builder appends in place and freezes into a version
+   void test_transient_build()
+   {  // setup
+      TransientList <Spy> builder;
+      // exercise
+      builder.pushBack(Spy(26));
+      builder.pushBack(Spy(31));
+      builder.pushFront(Spy(11));
+      PersistentList <Spy> v = builder.persistent();
+      // verify
+      assertUnit(values(v) == "11,26,31");
+      assertUnit(v.front() == Spy(11));
+      assertUnit(builder.size() == 0);
+   }  // teardown
+
+   // a builder on top of a version leaves the version alone
+   void test_transient_fromVersion()
+   {  // setup
+      PersistentList <Spy> v1 = PersistentList <Spy>().pushFront(Spy(26));
+      TransientList <Spy> builder(v1);
+      // exercise
+      builder.pushBack(Spy(31));
+      builder.pushFront(Spy(11));
+      PersistentList <Spy> v2 = builder.persistent();
+      // verify
+      assertUnit(values(v1) == "26");
+      assertUnit(values(v2) == "11,26,31");
+   }  // teardown
+
+   // to and from a node.h list
+   void test_nodes_roundTrip()
+   {  // setup
+      Node <Spy> * pHead = new Node <Spy>(Spy(11));
+      insert(insert(pHead, Spy(26), true), Spy(31), true);
+      // exercise
+      PersistentList <Spy> v = PersistentList <Spy>::fromNodes(pHead);
+      Node <Spy> * pCopy = v.pushBack(Spy(42)).toNodes();
+      // verify
+      assertUnit(values(v) == "11,26,31");
+      assertUnit(size(pCopy) == 4);
+      assertUnit(pCopy && pCopy->pNext && pCopy->pNext->pPrev == pCopy);
+      assertUnit(pCopy && pCopy->pNext->pNext->pNext->data == Spy(42));
+      // teardown
+      clear(pHead);
+      clear(pCopy);
+   }
+
+   /*************************************************************
+    * BRITTLE
+    * A value whose copy throws once copiesLeft runs out
+    *************************************************************/
+   struct Brittle
+   {
+      static inline int numLive = 0;
+      static inline int copiesLeft = -1;
+      Brittle() { numLive++; }
+      Brittle(const Brittle &)
+      {
+         if (copiesLeft == 0)
+            throw std::runtime_error("copy");
+         if (copiesLeft > 0)
+            copiesLeft--;
+         numLive++;
+      }
+      ~Brittle() { numLive--; }
+   };
+
+   /*************************************************************
+    * STANDARD
+    * 11, 26, 31 appended one at a time
+    *************************************************************/
+   PersistentList <Spy> standard()
+   {
+      return PersistentList <Spy>().pushBack(Spy(11)).pushBack(Spy(26)).pushBack(Spy(31));
+   }
+
+   /*************************************************************
+    * VALUES
+    * The list as "11,26,31"
+    *************************************************************/
+   std::string values(const PersistentList <Spy> & list)
+   {
+      std::string s;
+      list.forEach([&s](const Spy & spy)
+      {
+         s += (s.empty() ? "" : ",") + std::to_string(spy.get());
+      });
+      return s;
+   }
+
+   /*************************************************************
+    * VALUES
+    * The expected list as "11,26,31"
+    *************************************************************/
+   std::string values(const std::deque <int> & list)
+   {
+      std::string s;
+      for (int i : list)
+         s += (s.empty() ? "" : ",") + std::to_string(i);
+      return s;
+   }
+};
+
+#endif // DEBUG
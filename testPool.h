@@ -0,0 +1,192 @@
+/***********************************************************************
+ * Header:
+ *    TEST POOL
+ * Summary:
+ *    Unit tests for the node pool
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "pool.h"       // class under test
+#include "spy.h"        // for Spy
+#include "unitTest.h"   // unit test baseclass
+
+/***********************************************
+ * TEST POOL
+ * Unit tests for the NodePool class
+ ***********************************************/
+class TestPool : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Acquire
+      test_acquire_copy();
+      test_acquire_move();
+      test_acquire_grow();
+
+      // Release
+      test_release_nullptr();
+      test_release_reuse();
+      test_clear_standard();
+
+      // Adopt
+      test_adopt_standard();
+
+      report("Pool");
+   }
+
+   /***************************************
+    * ACQUIRE
+    ***************************************/
+
+   // acquire copies the value into a fresh, unattached node
+   void test_acquire_copy()
+   {  // setup
+      NodePool <Spy> pool(4);
+      Spy s(99);
+      Spy::reset();
+      // exercise
+      Node <Spy> * p = pool.acquire(s);
+      // verify
+      assertUnit(Spy::numCopy() == 1);       // copy 99 into the node
+      assertUnit(Spy::numAlloc() == 1);      // the copy allocates
+      assertUnit(Spy::numCopyMove() == 0);
+      assertUnit(p->data == Spy(99));
+      assertUnit(p->pNext == nullptr);
+      assertUnit(p->pPrev == nullptr);
+      assertUnit(pool.numBlocks() == 1);
+      assertUnit(pool.numFree() == 3);
+      // teardown
+      pool.release(p);
+   }
+
+   // acquire moves the value into the node
+   void test_acquire_move()
+   {  // setup
+      NodePool <Spy> pool(4);
+      Spy s(99);
+      Spy::reset();
+      // exercise
+      Node <Spy> * p = pool.acquire(std::move(s));
+      // verify
+      assertUnit(Spy::numCopyMove() == 1);   // steal 99
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(p->data == Spy(99));
+      assertUnit(s.empty());
+      // teardown
+      pool.release(p);
+   }
+
+   // running out of slots carves a second block
+   void test_acquire_grow()
+   {  // setup
+      NodePool <int> pool(2);
+      // exercise
+      Node <int> * p1 = pool.acquire(1);
+      Node <int> * p2 = pool.acquire(2);
+      Node <int> * p3 = pool.acquire(3);
+      // verify
+      assertUnit(pool.numBlocks() == 2);
+      assertUnit(pool.numFree() == 1);
+      assertUnit(p1->data == 1 && p2->data == 2 && p3->data == 3);
+      // teardown
+      pool.release(p1);
+      pool.release(p2);
+      pool.release(p3);
+   }
+
+   /***************************************
+    * RELEASE
+    ***************************************/
+
+   // releasing nothing does nothing
+   void test_release_nullptr()
+   {  // setup
+      NodePool <Spy> pool(4);
+      Spy::reset();
+      // exercise
+      pool.release(nullptr);
+      // verify
+      assertUnit(Spy::numDestructor() == 0);
+      assertUnit(pool.numBlocks() == 0);
+   }  // teardown
+
+   // a released slot is handed out again without a new block
+   void test_release_reuse()
+   {  // setup
+      NodePool <Spy> pool(1);
+      Node <Spy> * p = pool.acquire(Spy(26));
+      Spy::reset();
+      // exercise
+      pool.release(p);
+      Node <Spy> * pAgain = pool.acquire(Spy(31));
+      // verify
+      assertUnit(Spy::numDestructor() == 2);  // destroy [26] and the temporary
+      assertUnit(Spy::numDelete() == 1);      // delete [26]
+      assertUnit(pAgain == p);
+      assertUnit(pool.numBlocks() == 1);
+      assertUnit(pAgain->data == Spy(31));
+      // teardown
+      pool.release(pAgain);
+   }
+
+   // clear releases a whole list
+   void test_clear_standard()
+   {  // setup
+      //    +----+   +----+   +----+
+      //    | 11 | - | 26 | - | 31 |
+      //    +----+   +----+   +----+
+      NodePool <Spy> pool(3);
+      Node <Spy> * pHead = pool.acquire(Spy(11));
+      Node <Spy> * p = pHead;
+      p->pNext = pool.acquire(Spy(26));
+      p->pNext->pPrev = p;
+      p = p->pNext;
+      p->pNext = pool.acquire(Spy(31));
+      p->pNext->pPrev = p;
+      Spy::reset();
+      // exercise
+      pool.clear(pHead);
+      // verify
+      assertUnit(Spy::numDestructor() == 3);   // destroy [11][26][31]
+      assertUnit(Spy::numDelete() == 3);
+      assertUnit(pHead == nullptr);
+      assertUnit(pool.numFree() == 3);
+      assertUnit(pool.numBlocks() == 1);
+   }  // teardown
+
+   /***************************************
+    * ADOPT
+    ***************************************/
+
+   // the blocks and free slots move over; nodes from the other
+   // pool are released to this one
+   void test_adopt_standard()
+   {  // setup
+      NodePool <Spy> pool(2);
+      NodePool <Spy> other(4);
+      Node <Spy> * pMine = pool.acquire(Spy(11));
+      Node <Spy> * pTheirs = other.acquire(Spy(26));
+      // exercise
+      pool.adopt(other);
+      // verify
+      assertUnit(pool.numBlocks() == 2);
+      assertUnit(pool.numFree() == 1 + 3);
+      assertUnit(other.numBlocks() == 0);
+      assertUnit(other.numFree() == 0);
+      pool.release(pTheirs);
+      assertUnit(pool.numFree() == 5);
+      // teardown
+      pool.release(pMine);
+   }
+};
+
+#endif // DEBUG
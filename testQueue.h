@@ -0,0 +1,276 @@
+/***********************************************************************
+ * Header:
+ *    TEST QUEUE
+ * Summary:
+ *    Unit tests for the lock-free queues
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "queue.h"      // class under test
+#include "spy.h"        // for Spy
+#include "unitTest.h"   // unit test baseclass
+
+#include <thread>       // for std::thread
+#include <vector>       // for std::vector
+
+/***********************************************
+ * TEST QUEUE
+ * Unit tests for MPSCQueue and SPSCQueue
+ ***********************************************/
+class TestQueue : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // MPSC
+      test_mpsc_empty();
+      test_mpsc_order();
+      test_mpsc_batch();
+      test_mpsc_threads();
+
+      // SPSC
+      test_spsc_empty();
+      test_spsc_order();
+      test_spsc_recycle();
+      test_spsc_batch();
+      test_spsc_threads();
+
+      report("Queue");
+   }
+
+   /***************************************
+    * MPSC
+    ***************************************/
+
+   // a new queue has nothing in it
+   void test_mpsc_empty()
+   {  // setup
+      MPSCQueue <int> queue;
+      // exercise
+      Node <int> * p = queue.pop();
+      // verify
+      assertUnit(p == nullptr);
+      assertUnit(queue.empty());
+   }  // teardown
+
+   // nodes come out in the order they went in, detached
+   void test_mpsc_order()
+   {  // setup
+      MPSCQueue <int> queue;
+      Node <int> * p11 = new Node <int>(11);
+      Node <int> * p26 = new Node <int>(26);
+      Node <int> * p31 = new Node <int>(31);
+      queue.push(p11);
+      queue.push(p26);
+      queue.push(p31);
+      // exercise
+      Node <int> * pFirst  = queue.pop();
+      Node <int> * pSecond = queue.pop();
+      Node <int> * pThird  = queue.pop();
+      // verify
+      assertUnit(pFirst  == p11);
+      assertUnit(pSecond == p26);
+      assertUnit(pThird  == p31);
+      assertUnit(p11->pNext == nullptr);
+      assertUnit(p31->pNext == nullptr);
+      assertUnit(queue.pop() == nullptr);
+      assertUnit(queue.empty());
+      // teardown
+      delete p11;
+      delete p26;
+      delete p31;
+   }
+
+   // a batch comes out as a doubly linked list
+   void test_mpsc_batch()
+   {  // setup
+      MPSCQueue <int> queue;
+      queue.push(new Node <int>(11));
+      queue.push(new Node <int>(26));
+      queue.push(new Node <int>(31));
+      queue.push(new Node <int>(42));
+      size_t num = 0;
+      // exercise
+      Node <int> * pHead = queue.pop(3, num);
+      // verify
+      //    +----+   +----+   +----+
+      //    | 11 | - | 26 | - | 31 |
+      //    +----+   +----+   +----+
+      assertUnit(num == 3);
+      assertStandardFixture(pHead);
+      assertUnit(!queue.empty());
+      // teardown
+      clear(pHead);
+      pHead = queue.pop(10, num);
+      assertUnit(num == 1);
+      assertUnit(pHead && pHead->data == 42);
+      clear(pHead);
+   }
+
+   // many producers, one consumer: nothing lost, per-producer order kept
+   void test_mpsc_threads()
+   {  // setup
+      const int numProducers = 4;
+      const int numEach = 20000;
+      MPSCQueue <int> queue;
+      std::vector <std::thread> producers;
+      // exercise
+      for (int id = 0; id < numProducers; id++)
+         producers.emplace_back([&queue, id, numEach]()
+         {
+            for (int i = 0; i < numEach; i++)
+               queue.push(new Node <int>(id * numEach + i));
+         });
+      std::vector <int> last(numProducers, -1);
+      bool inOrder = true;
+      int numPopped = 0;
+      while (numPopped < numProducers * numEach)
+      {
+         Node <int> * p = queue.pop();
+         if (p == nullptr)
+            continue;
+         int id = p->data / numEach;
+         inOrder = inOrder && p->data % numEach > last[id];
+         last[id] = p->data % numEach;
+         delete p;
+         numPopped++;
+      }
+      for (auto & producer : producers)
+         producer.join();
+      // verify
+      assertUnit(inOrder);
+      assertUnit(numPopped == numProducers * numEach);
+      assertUnit(queue.empty());
+   }  // teardown
+
+   /***************************************
+    * SPSC
+    ***************************************/
+
+   // a new queue has nothing in it
+   void test_spsc_empty()
+   {  // setup
+      SPSCQueue <Spy> queue;
+      Spy s;
+      // exercise
+      bool popped = queue.pop(s);
+      // verify
+      assertUnit(!popped);
+      assertUnit(queue.empty());
+   }  // teardown
+
+   // values come out in the order they went in
+   void test_spsc_order()
+   {  // setup
+      SPSCQueue <int> queue;
+      int a = 0, b = 0, c = 0;
+      // exercise
+      queue.push(11);
+      queue.push(26);
+      queue.push(31);
+      // verify
+      assertUnit(queue.pop(a) && a == 11);
+      assertUnit(queue.pop(b) && b == 26);
+      assertUnit(queue.pop(c) && c == 31);
+      assertUnit(queue.empty());
+   }  // teardown
+
+   // once the consumer has passed a node, the producer reuses it
+   void test_spsc_recycle()
+   {  // setup
+      SPSCQueue <Spy> queue;
+      Spy s;
+      queue.push(Spy(11));
+      queue.push(Spy(26));
+      queue.pop(s);
+      queue.pop(s);
+      Spy value(31);
+      Spy::reset();
+      // exercise
+      queue.push(value);
+      // verify
+      assertUnit(Spy::numAssign() == 1);     // copied into a recycled node
+      assertUnit(Spy::numCopy() == 0);       // no new node
+      assertUnit(Spy::numDefault() == 0);
+      assertUnit(queue.pop(s) && s == Spy(31));
+   }  // teardown
+
+   // a batch pop takes what is there, up to the limit
+   void test_spsc_batch()
+   {  // setup
+      SPSCQueue <int> queue;
+      for (int i = 0; i < 5; i++)
+         queue.push(i);
+      int values[4] = {};
+      // exercise
+      size_t num = queue.pop(values, 4);
+      // verify
+      assertUnit(num == 4);
+      assertUnit(values[0] == 0 && values[3] == 3);
+      assertUnit(queue.pop(values, 4) == 1);
+      assertUnit(values[0] == 4);
+      assertUnit(queue.pop(values, 4) == 0);
+   }  // teardown
+
+   // one producer thread and one consumer thread
+   void test_spsc_threads()
+   {  // setup
+      const int num = 100000;
+      SPSCQueue <int> queue;
+      // exercise
+      std::thread producer([&queue, num]()
+      {
+         for (int i = 0; i < num; i++)
+            queue.push(i);
+      });
+      bool inOrder = true;
+      for (int expected = 0; expected < num; )
+      {
+         int value;
+         if (queue.pop(value))
+            inOrder = inOrder && value == expected++;
+      }
+      producer.join();
+      // verify
+      assertUnit(inOrder);
+      assertUnit(queue.empty());
+   }  // teardown
+
+   /*************************************************************
+    * VERIFY STANDARD FIXTURE
+    *    +----+   +----+   +----+
+    *    | 11 | - | 26 | - | 31 |
+    *    +----+   +----+   +----+
+    *************************************************************/
+   void assertStandardFixtureParameters(const Node <int>* p, int line, const char* function)
+   {
+      assertIndirect(p != nullptr);
+      if (p)
+      {
+         assertIndirect(p->data == 11);
+         assertIndirect(p->pPrev == nullptr);
+         assertIndirect(p->pNext != nullptr);
+         if (p->pNext)
+         {
+            assertIndirect(p->pNext->data == 26);
+            assertIndirect(p->pNext->pPrev == p);
+            assertIndirect(p->pNext->pNext != nullptr);
+            if (p->pNext->pNext)
+            {
+               assertIndirect(p->pNext->pNext->data == 31);
+               assertIndirect(p->pNext->pNext->pPrev == p->pNext);
+               assertIndirect(p->pNext->pNext->pNext == nullptr);
+            }
+         }
+      }
+   }
+};
+
+#endif // DEBUG
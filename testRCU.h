@@ -0,0 +1,253 @@
+/***********************************************************************
+ * Header:
+ *    TEST RCU
+ * Summary:
+ *    Unit tests for the read-copy-update list
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "rcu.h"        // class under test
+#include "spy.h"        // for Spy
+#include "unitTest.h"   // unit test baseclass
+
+#include <atomic>       // for std::atomic
+#include <chrono>       // for std::chrono::milliseconds
+#include <memory>       // for std::unique_ptr
+#include <stdexcept>    // for std::runtime_error
+#include <thread>       // for std::thread
+#include <vector>       // for std::vector
+
+/***********************************************
+ * TEST RCU
+ * Unit tests for RCUDomain, RCUReader, and RCUList
+ ***********************************************/
+class TestRCU : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Insert
+      test_insert_empty();
+      test_insert_standard();
+
+      // Remove
+      test_remove_deferred();
+      test_replace_middle();
+
+      // Grace period
+      test_synchronize_offline();
+      test_synchronize_waitsForReader();
+      test_readers_concurrent();
+      test_readers_tooMany();
+
+      report("RCU");
+   }
+
+   /***************************************
+    * INSERT
+    ***************************************/
+
+   // insert into an empty list
+   void test_insert_empty()
+   {  // setup
+      RCUDomain domain;
+      RCUList <int> list(domain);
+      // exercise
+      const Node <int> * p = list.insert(nullptr, 26);
+      // verify
+      assertUnit(list.head() == p);
+      assertUnit(p->data == 26);
+      assertUnit(p->pNext == nullptr);
+      assertUnit(p->pPrev == nullptr);
+      assertUnit(list.size() == 1);
+   }  // teardown
+
+   // build the standard fixture front, back, and middle
+   void test_insert_standard()
+   {  // setup
+      RCUDomain domain;
+      RCUList <int> list(domain);
+      // exercise
+      const Node <int> * p31 = list.insert(nullptr, 31);
+      const Node <int> * p11 = list.insert(p31, 11);
+      list.insert(p11, 26, true /* after */);
+      // verify
+      //    +----+   +----+   +----+
+      //    | 11 | - | 26 | - | 31 |
+      //    +----+   +----+   +----+
+      const Node <int> * p = list.head();
+      assertUnit(p && p->data == 11);
+      assertUnit(p && (p = rcuNext(p)) && p->data == 26);
+      assertUnit(p && p->pPrev == p11);
+      assertUnit(p && (p = rcuNext(p)) && p->data == 31);
+      assertUnit(p && rcuNext(p) == nullptr);
+      assertUnit(p31->pPrev && p31->pPrev->data == 26);
+   }  // teardown
+
+   /***************************************
+    * REMOVE
+    ***************************************/
+
+   // a removed node lives until the domain reclaims it
+   void test_remove_deferred()
+   {  // setup
+      RCUDomain domain;
+      RCUList <Spy> list(domain);
+      const Node <Spy> * p11 = list.insert(nullptr, Spy(11));
+      list.insert(p11, Spy(26), true);
+      Spy::reset();
+      // exercise
+      list.remove(p11);
+      // verify
+      assertUnit(Spy::numDestructor() == 0);   // still there for readers
+      assertUnit(domain.numRetired() == 1);
+      assertUnit(list.head() && list.head()->data == Spy(26));
+      assertUnit(list.head()->pPrev == nullptr);
+      assertUnit(domain.reclaim() == 1);
+      assertUnit(Spy::numDestructor() == 2);   // [11] and the temporary
+      assertUnit(Spy::numDelete() == 2);
+   }  // teardown
+
+   // replace swaps in a new node holding the new value
+   void test_replace_middle()
+   {  // setup
+      RCUDomain domain;
+      RCUList <int> list(domain);
+      const Node <int> * p11 = list.insert(nullptr, 11);
+      const Node <int> * p26 = list.insert(p11, 99, true);
+      const Node <int> * p31 = list.insert(p26, 31, true);
+      // exercise
+      const Node <int> * pNew = list.replace(p26, 26);
+      // verify
+      assertUnit(pNew != p26);
+      assertUnit(rcuNext(p11) == pNew);
+      assertUnit(pNew->pPrev == p11);
+      assertUnit(rcuNext(pNew) == p31);
+      assertUnit(p31->pPrev == pNew);
+      assertUnit(p26->data == 99);              // old readers still see 99
+      assertUnit(domain.numRetired() == 1);
+   }  // teardown
+
+   /***************************************
+    * GRACE PERIOD
+    ***************************************/
+
+   // an offline reader does not hold up a writer
+   void test_synchronize_offline()
+   {  // setup
+      RCUDomain domain;
+      RCUReader reader(domain);
+      reader.offline();
+      // exercise
+      domain.synchronize();
+      // verify
+      assertUnit(true);                         // we got here
+   }  // teardown
+
+   // memory a reader might see is not freed until it is quiescent
+   void test_synchronize_waitsForReader()
+   {  // setup
+      RCUDomain domain;
+      RCUList <int> list(domain);
+      list.insert(nullptr, 26);
+      std::atomic <bool> reading(false);
+      std::atomic <bool> done(false);
+      std::atomic <int> seen(0);
+      std::thread readerThread([&]()
+      {
+         RCUReader reader(domain);
+         const Node <int> * p = list.head();
+         reading = true;
+         std::this_thread::sleep_for(std::chrono::milliseconds(20));
+         seen = p->data;                        // must still be valid
+         done = true;
+         reader.quiescent();
+      });
+      while (!reading)
+         std::this_thread::yield();
+      // exercise
+      list.remove(list.head());
+      domain.reclaim();
+      // verify
+      assertUnit(done);
+      assertUnit(seen == 26);
+      assertUnit(list.head() == nullptr);
+      // teardown
+      readerThread.join();
+   }
+
+   // readers walk the list while a writer keeps changing it
+   void test_readers_concurrent()
+   {  // setup
+      RCUDomain domain;
+      RCUList <int> list(domain);
+      for (int i = 0; i < 16; i++)
+         list.insert(nullptr, 1);
+      std::atomic <bool> stop(false);
+      std::atomic <bool> allOnes(true);
+      std::vector <std::thread> readers;
+      for (int i = 0; i < 3; i++)
+         readers.emplace_back([&]()
+         {
+            RCUReader reader(domain);
+            while (!stop)
+            {
+               for (auto p = list.head(); p; p = rcuNext(p))
+                  if (p->data != 1)
+                     allOnes = false;
+               reader.quiescent();
+            }
+         });
+      // exercise
+      for (int i = 0; i < 200; i++)
+      {
+         list.remove(list.head());
+         list.insert(nullptr, 1);
+         if (i % 20 == 0)
+            domain.reclaim();
+      }
+      stop = true;
+      for (auto & reader : readers)
+         reader.join();
+      // verify
+      assertUnit(allOnes);
+      assertUnit(list.size() == 16);
+   }  // teardown
+
+   // one reader more than there are slots is refused, and gets in once one leaves
+   void test_readers_tooMany()
+   {  // setup
+      RCUDomain domain;
+      std::vector <std::unique_ptr <RCUReader>> readers;
+      for (int i = 0; i < RCUDomain::MAX_READERS; i++)
+         readers.push_back(std::make_unique <RCUReader>(domain));
+      bool thrown = false;
+      // exercise
+      try
+      {
+         RCUReader reader(domain);
+      }
+      catch (const std::runtime_error &)
+      {
+         thrown = true;
+      }
+      // verify
+      assertUnit(thrown);
+      readers.pop_back();
+      RCUReader reader(domain);
+      reader.offline();
+      for (auto & other : readers)
+         other->offline();
+      domain.synchronize();
+      assertUnit(true);                         // we got here
+   }  // teardown
+};
+
+#endif // DEBUG
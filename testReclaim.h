@@ -0,0 +1,241 @@
+/***********************************************************************
+ * Header:
+ *    TEST RECLAIM
+ * Summary:
+ *    Unit tests for freeing lists off the caller's thread
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "reclaim.h"    // class under test
+#include "spy.h"        // for Spy
+#include "unitTest.h"   // unit test baseclass
+
+#include <chrono>       // for std::chrono::milliseconds
+#include <thread>       // for std::this_thread::sleep_for
+
+/***********************************************
+ * TEST RECLAIM
+ * Unit tests for Reclaimer and clearAsync
+ ***********************************************/
+class TestReclaim : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Clear async
+      test_clearAsync_nullptr();
+      test_clearAsync_standard();
+      test_clearAsync_many();
+
+      // Incremental
+      test_incremental_detach();
+      test_incremental_nodeBudget();
+      test_incremental_timeBudget();
+      test_incremental_timeSlow();
+      test_incremental_insert();
+      test_incremental_destructor();
+
+      report("Reclaim");
+   }
+
+   /***************************************
+    * CLEAR ASYNC
+    ***************************************/
+
+   // nothing to free is done right away
+   void test_clearAsync_nullptr()
+   {  // setup
+      Reclaimer reclaimer;
+      Node <Spy> * pHead = nullptr;
+      Spy::reset();
+      // exercise
+      std::future <size_t> done = clearAsync(pHead, reclaimer);
+      // verify
+      assertUnit(done.get() == 0);
+      assertUnit(pHead == nullptr);
+      assertUnit(reclaimer.numPending() == 0);
+      assertUnit(Spy::numDestructor() == 0);
+   }  // teardown
+
+   // the caller gets NULL at once and the future reports the count
+   void test_clearAsync_standard()
+   {  // setup
+      //    +----+   +----+   +----+
+      //    | 11 | - | 26 | - | 31 |
+      //    +----+   +----+   +----+
+      Reclaimer reclaimer;
+      Node <Spy> * pHead = new Node <Spy>(Spy(11));
+      insert(insert(pHead, Spy(26), true), Spy(31), true);
+      Spy::reset();
+      // exercise
+      std::future <size_t> done = clearAsync(pHead, reclaimer);
+      // verify
+      assertUnit(pHead == nullptr);
+      assertUnit(done.get() == 3);
+      assertUnit(Spy::numDestructor() == 3);   // destroy [11][26][31]
+      assertUnit(Spy::numDelete() == 3);
+      reclaimer.wait();
+      assertUnit(reclaimer.numFreed() == 3);
+      assertUnit(reclaimer.numPending() == 0);
+   }  // teardown
+
+   // many lists queue up and are all freed
+   void test_clearAsync_many()
+   {  // setup
+      Reclaimer reclaimer;
+      std::vector <std::future <size_t>> done;
+      // exercise
+      for (int i = 1; i <= 10; i++)
+      {
+         Node <int> * pHead = nullptr;
+         for (int j = 0; j < i * 100; j++)
+            pHead = insert(pHead, j);
+         done.push_back(clearAsync(pHead, reclaimer));
+         assertUnit(pHead == nullptr);
+      }
+      reclaimer.wait();
+      // verify
+      size_t total = 0;
+      for (auto & future : done)
+         total += future.get();
+      assertUnit(total == 5500);
+      assertUnit(reclaimer.numFreed() == 5500);
+      assertUnit(reclaimer.numPending() == 0);
+   }  // teardown
+
+   /***************************************
+    * INCREMENTAL
+    ***************************************/
+
+   // clear only takes the list away
+   void test_incremental_detach()
+   {  // setup
+      IncrementalReclaimer <Spy> reclaimer;
+      Node <Spy> * pHead = new Node <Spy>(Spy(11));
+      insert(insert(pHead, Spy(26), true), Spy(31), true);
+      Spy::reset();
+      // exercise
+      reclaimer.clear(pHead);
+      // verify
+      assertUnit(pHead == nullptr);
+      assertUnit(Spy::numDestructor() == 0);
+      assertUnit(!reclaimer.empty());
+      // teardown
+      reclaimer.tick(10, std::chrono::microseconds(0));
+      assertUnit(Spy::numDestructor() == 3);   // destroy [11][26][31]
+      assertUnit(reclaimer.empty());
+   }
+
+   // a tick never destroys more than it is allowed
+   void test_incremental_nodeBudget()
+   {  // setup
+      IncrementalReclaimer <Spy> reclaimer;
+      Node <Spy> * pFirst = new Node <Spy>(Spy(11));
+      insert(pFirst, Spy(26), true);
+      Node <Spy> * pSecond = new Node <Spy>(Spy(31));
+      reclaimer.clear(pFirst);
+      reclaimer.clear(pSecond);
+      Spy::reset();
+      // exercise
+      size_t num = reclaimer.tick(2, std::chrono::microseconds(0));
+      // verify
+      assertUnit(num == 2);
+      assertUnit(Spy::numDestructor() == 2);
+      assertUnit(!reclaimer.empty());
+      assertUnit(reclaimer.tick(2, std::chrono::microseconds(0)) == 1);
+      assertUnit(reclaimer.empty());
+      assertUnit(reclaimer.numFreed() == 3);
+   }  // teardown
+
+   // a tick with time to spare frees everything it can
+   void test_incremental_timeBudget()
+   {  // setup
+      IncrementalReclaimer <int> reclaimer;
+      Node <int> * pHead = nullptr;
+      for (int i = 0; i < 1000; i++)
+         pHead = insert(pHead, i);
+      reclaimer.clear(pHead);
+      // exercise
+      size_t num = reclaimer.tick((size_t)-1, std::chrono::microseconds(1000000));
+      // verify
+      assertUnit(num == 1000);
+      assertUnit(reclaimer.empty());
+   }  // teardown
+
+   // a slow destructor ends the tick as soon as the time is up
+   void test_incremental_timeSlow()
+   {  // setup
+      IncrementalReclaimer <Slow> reclaimer;
+      Node <Slow> * pHead = nullptr;
+      for (int i = 0; i < 20; i++)
+         pHead = insert(pHead, Slow());
+      reclaimer.clear(pHead);
+      Slow::delay = true;
+      // exercise
+      size_t num = reclaimer.tick((size_t)-1, std::chrono::microseconds(1000));
+      // verify
+      Slow::delay = false;
+      assertUnit(num == 1);
+      assertUnit(!reclaimer.empty());
+   }  // teardown
+
+   // every insert through the reclaimer pays one installment
+   void test_incremental_insert()
+   {  // setup
+      IncrementalReclaimer <int> reclaimer(4);
+      Node <int> * pOld = nullptr;
+      for (int i = 0; i < 10; i++)
+         pOld = insert(pOld, i);
+      reclaimer.clear(pOld);
+      // exercise
+      Node <int> * pNew = reclaimer.insert(nullptr, 26);
+      // verify
+      assertUnit(reclaimer.numFreed() == 4);
+      assertUnit(pNew && pNew->data == 26);
+      pNew = reclaimer.insert(pNew, 31, true);
+      assertUnit(reclaimer.numFreed() == 8);
+      assertUnit(pNew && pNew->pPrev && pNew->pPrev->data == 26);
+      // teardown
+      Node <int> * pHead = pNew->pPrev;
+      clear(pHead);
+   }
+
+   // nothing is leaked when the reclaimer goes away
+   void test_incremental_destructor()
+   {  // setup
+      Node <Spy> * pHead = new Node <Spy>(Spy(11));
+      insert(insert(pHead, Spy(26), true), Spy(31), true);
+      Spy::reset();
+      // exercise
+      {
+         IncrementalReclaimer <Spy> reclaimer;
+         reclaimer.clear(pHead);
+      }
+      // verify
+      assertUnit(Spy::numDestructor() == 3);   // destroy [11][26][31]
+      assertUnit(Spy::numDelete() == 3);
+   }  // teardown
+
+   /*************************************************************
+    * SLOW
+    * A value whose destructor takes 2ms while delay is set
+    *************************************************************/
+   struct Slow
+   {
+      static inline bool delay = false;
+      ~Slow()
+      {
+         if (delay)
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+      }
+   };
+};
+
+#endif // DEBUG
@@ -0,0 +1,253 @@
+/***********************************************************************
+ * Header:
+ *    TEST SEQLOCK
+ * Summary:
+ *    Unit tests for the seqlock list
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "seqlock.h"    // class under test
+#include "unitTest.h"   // unit test baseclass
+
+#include <atomic>       // for std::atomic
+#include <string>       // for std::string
+#include <thread>       // for std::thread
+#include <vector>       // for std::vector
+
+/***********************************************
+ * TEST SEQLOCK
+ * Unit tests for SeqlockList
+ ***********************************************/
+class TestSeqlock : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Copy
+      test_racy_roundTrip();
+
+      // Writers
+      test_insert_empty();
+      test_insert_standard();
+      test_insert_full();
+      test_remove_reuse();
+      test_update_standard();
+
+      // Readers
+      test_copy_short();
+      test_reduce_noDefault();
+      test_readers_concurrent();
+
+      report("Seqlock");
+   }
+
+   /***************************************
+    * COPY
+    ***************************************/
+
+   // whole words and odd sizes both copy exactly
+   void test_racy_roundTrip()
+   {  // setup
+      Pair pair { 26, 52 };
+      char odd[3] = { 'a', 'b', 'c' };
+      Pair pairCopy { 0, 0 };
+      char oddCopy[3] = { 0, 0, 0 };
+      // exercise
+      racyStore(pairCopy, pair);
+      racyLoad(oddCopy, odd);
+      // verify
+      assertUnit(pairCopy.x == 26 && pairCopy.y == 52);
+      assertUnit(oddCopy[0] == 'a' && oddCopy[2] == 'c');
+   }  // teardown
+
+   /***************************************
+    * WRITERS
+    ***************************************/
+
+   // insert into an empty list
+   void test_insert_empty()
+   {  // setup
+      SeqlockList <int> list;
+      // exercise
+      Node <int> * p = list.insert(nullptr, 26);
+      // verify
+      assertUnit(p && p->data == 26);
+      assertUnit(p && p->pNext == nullptr && p->pPrev == nullptr);
+      assertUnit(list.size() == 1);
+   }  // teardown
+
+   // build the standard fixture front, back, and middle
+   void test_insert_standard()
+   {  // setup
+      SeqlockList <int> list;
+      // exercise
+      Node <int> * p31 = list.insert(nullptr, 31);
+      Node <int> * p11 = list.insert(nullptr, 11);
+      list.insert(p11, 26, true /* after */);
+      // verify
+      //    +----+   +----+   +----+
+      //    | 11 | - | 26 | - | 31 |
+      //    +----+   +----+   +----+
+      assertUnit(values(list) == "11 26 31");
+      assertUnit(p31->pPrev && p31->pPrev->data == 26);
+      assertUnit(list.size() == 3);
+   }  // teardown
+
+   // no room, no node
+   void test_insert_full()
+   {  // setup
+      SeqlockList <int> list(2);
+      list.insert(nullptr, 11);
+      list.insert(nullptr, 26);
+      // exercise
+      Node <int> * p = list.insert(nullptr, 31);
+      // verify
+      assertUnit(p == nullptr);
+      assertUnit(values(list) == "26 11");
+   }  // teardown
+
+   // a removed node comes back for the next insert
+   void test_remove_reuse()
+   {  // setup
+      SeqlockList <int> list(2);
+      Node <int> * p11 = list.insert(nullptr, 11);
+      Node <int> * p26 = list.insert(p11, 26, true);
+      // exercise
+      Node <int> * pParent = list.remove(p26);
+      Node <int> * p31 = list.insert(p11, 31, true);
+      // verify
+      assertUnit(pParent == p11);
+      assertUnit(p31 == p26);                   // the same memory
+      assertUnit(values(list) == "11 31");
+      assertUnit(list.remove(p11) == p31);      // no parent: the next one
+      assertUnit(values(list) == "31");
+      assertUnit(list.remove(nullptr) == nullptr);
+   }  // teardown
+
+   // a value changes in place
+   void test_update_standard()
+   {  // setup
+      SeqlockList <int> list;
+      Node <int> * p11 = list.insert(nullptr, 11);
+      list.insert(p11, 99, true);
+      // exercise
+      list.update(p11->pNext, 26);
+      // verify
+      assertUnit(values(list) == "11 26");
+      assertUnit(list.size() == 2);
+   }  // teardown
+
+   /***************************************
+    * READERS
+    ***************************************/
+
+   // copy stops at the room it is given
+   void test_copy_short()
+   {  // setup
+      SeqlockList <int> list;
+      Node <int> * p = nullptr;
+      for (int i = 0; i < 5; i++)
+         p = list.insert(p, i, true);
+      int out[3] = { -1, -1, -1 };
+      // exercise
+      size_t num = list.copy(out, 3);
+      // verify
+      assertUnit(num == 3);
+      assertUnit(out[0] == 0 && out[1] == 1 && out[2] == 2);
+   }  // teardown
+
+   // a value with no default constructor can still be read
+   void test_reduce_noDefault()
+   {  // setup
+      SeqlockList <Tick> list(4);
+      list.insert(list.insert(nullptr, Tick(26)), Tick(31), true);
+      // exercise
+      int sum = list.reduce(0, [](int sum, const Tick & tick) { return sum + tick.value; });
+      // verify
+      assertUnit(sum == 57);
+   }  // teardown
+
+   // readers never see a torn value or a half-made change
+   void test_readers_concurrent()
+   {  // setup
+      SeqlockList <Pair> list(16);
+      std::vector <Node <Pair> *> nodes;
+      Node <Pair> * p = nullptr;
+      for (long i = 0; i < 8; i++)
+         nodes.push_back(p = list.insert(p, Pair { i, 2 * i }, true));
+      std::atomic <bool> stop(false);
+      std::atomic <int> numBad(0);
+      std::atomic <int> numReads(0);
+      // exercise
+      std::vector <std::thread> readers;
+      for (int r = 0; r < 2; r++)
+         readers.emplace_back([&]()
+         {
+            while (!stop || numReads == 0)
+            {
+               Pair out[16];
+               size_t num = list.copy(out, 16);
+               bool good = num == 8 || num == 9;
+               for (size_t i = 0; i < num; i++)
+                  good = good && out[i].y == 2 * out[i].x;
+               if (!good)
+                  numBad++;
+               numReads++;
+            }
+         });
+      for (long round = 1; round <= 2000; round++)
+      {
+         for (auto pNode : nodes)
+            list.update(pNode, Pair { round, 2 * round });
+         list.remove(list.insert(nodes.back(), Pair { -round, -2 * round }, true));
+      }
+      stop = true;
+      for (auto & reader : readers)
+         reader.join();
+      // verify
+      assertUnit(numReads > 0);
+      assertUnit(numBad == 0);
+      assertUnit(list.size() == 8);
+   }  // teardown
+
+   /*************************************************************
+    * PAIR
+    * Two words that must always agree
+    *************************************************************/
+   struct Pair
+   {
+      long x;
+      long y;
+   };
+
+   /*************************************************************
+    * TICK
+    * Trivially copyable, but with no default constructor
+    *************************************************************/
+   struct Tick
+   {
+      explicit Tick(int value) : value(value) { }
+      int value;
+   };
+
+   /*************************************************************
+    * VALUES
+    * The values front to back, separated by spaces
+    *************************************************************/
+   static std::string values(const SeqlockList <int> & list)
+   {
+      return list.reduce(std::string(), [](const std::string & s, int value)
+      {
+         return s + (s.empty() ? "" : " ") + std::to_string(value);
+      });
+   }
+};
+
+#endif // DEBUG
@@ -0,0 +1,566 @@
+/***********************************************************************
+ * Header:
+ *    TEST SERIALIZE
+ * Summary:
+ *    Unit tests for the binary form of a list
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "serialize.h"  // functions under test
+#include "unitTest.h"   // unit test baseclass
+
+#include <iterator>     // for std::bidirectional_iterator
+#include <numeric>      // for std::accumulate
+#include <ranges>       // for std::views::reverse
+#include <sstream>      // for std::stringstream
+#include <string>       // for std::string
+#include <vector>       // for std::vector
+
+static_assert(std::bidirectional_iterator <FlatListView <int>::iterator>);
+
+/***********************************************
+ * PERSON
+ * Not trivially copyable, so it brings its own
+ * Serializer
+ ***********************************************/
+struct Person
+{
+   std::string name;
+   int age;
+};
+
+template <>
+struct Serializer <Person>
+{
+   static void write(ByteWriter & out, const Person & person)
+   {
+      Serializer <std::string>::write(out, person.name);
+      out.put(person.age);
+   }
+   static Person read(ByteReader & in)
+   {
+      Person person;
+      person.name = Serializer <std::string>::read(in);
+      person.age = in.get <int>();
+      return person;
+   }
+};
+
+/***********************************************
+ * TEST SERIALIZE
+ * Unit tests for serialize, deserialize, and FlatListView
+ ***********************************************/
+class TestSerialize : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Raw
+      test_serialize_empty();
+      test_serialize_rawLayout();
+      test_roundTrip_raw();
+      test_roundTrip_struct();
+
+      // Serializer
+      test_roundTrip_string();
+      test_roundTrip_custom();
+      test_roundTrip_stream();
+
+      // Errors
+      test_deserialize_badMagic();
+      test_deserialize_wrongType();
+      test_deserialize_truncated();
+      test_deserialize_badLength();
+      test_deserialize_badCount();
+
+      // FlatListView
+      test_flat_standard();
+      test_flat_backward();
+      test_flat_empty();
+      test_flat_unaligned();
+      test_flat_frames();
+      test_flat_wrongType();
+
+      report("Serialize");
+   }
+
+   /***************************************
+    * RAW
+    ***************************************/
+
+   // an empty list is a header and nothing else
+   void test_serialize_empty()
+   {  // setup
+      Node <int> * pHead = nullptr;
+      std::vector <char> buffer;
+      NodePool <int> pool;
+      // exercise
+      serialize((const Node <int> *)pHead, buffer);
+      Node <int> * pCopy = deserialize(buffer.data(), buffer.size(), pool);
+      // verify
+      assertUnit(buffer.size() == sizeof(SerialHeader));
+      assertUnit(pCopy == nullptr);
+   }  // teardown
+
+   // trivially copyable values go in back to back
+   void test_serialize_rawLayout()
+   {  // setup
+      //    +----+   +----+   +----+
+      //    | 11 | - | 26 | - | 31 |
+      //    +----+   +----+   +----+
+      Node <int> * pHead = new Node <int>(11);
+      insert(insert(pHead, 26, true), 31, true);
+      std::vector <char> buffer;
+      // exercise
+      serialize((const Node <int> *)pHead, buffer);
+      // verify
+      SerialHeader header;
+      memcpy(&header, buffer.data(), sizeof(header));
+      int values[3];
+      memcpy(values, buffer.data() + sizeof(header), sizeof(values));
+      assertUnit(buffer.size() == sizeof(SerialHeader) + 3 * sizeof(int));
+      assertUnit(header.magic == SerialHeader::MAGIC);
+      assertUnit(header.size == sizeof(int));
+      assertUnit(header.num == 3);
+      assertUnit(header.numBytes == 3 * sizeof(int));
+      assertUnit(values[0] == 11 && values[1] == 26 && values[2] == 31);
+      // teardown
+      clear(pHead);
+   }
+
+   // what goes out comes back, linked both ways
+   void test_roundTrip_raw()
+   {  // setup
+      Node <int> * pHead = build(1000);
+      std::vector <char> buffer;
+      NodePool <int> pool;
+      // exercise
+      serialize((const Node <int> *)pHead, buffer);
+      Node <int> * pCopy = deserialize(buffer.data(), buffer.size(), pool);
+      // verify
+      assertUnit(same(pHead, pCopy));
+      assertUnit(linked(pCopy));
+      assertUnit(pool.numBlocks() == 1);
+      // teardown
+      clear(pHead);
+      pool.clear(pCopy);
+   }
+
+   // a struct with padding in it is still copied whole
+   void test_roundTrip_struct()
+   {  // setup
+      struct Point { char tag; double x; };
+      Node <Point> * pHead = new Node <Point>(Point { 'a', 1.5 });
+      insert(pHead, Point { 'b', -2.25 }, true);
+      std::vector <char> buffer;
+      NodePool <Point> pool;
+      // exercise
+      serialize((const Node <Point> *)pHead, buffer);
+      Node <Point> * pCopy = deserialize(buffer.data(), buffer.size(), pool);
+      // verify
+      assertUnit(pCopy && pCopy->data.tag == 'a' && pCopy->data.x == 1.5);
+      assertUnit(pCopy && pCopy->pNext && pCopy->pNext->data.tag == 'b');
+      assertUnit(pCopy && pCopy->pNext && pCopy->pNext->data.x == -2.25);
+      // teardown
+      clear(pHead);
+      pool.clear(pCopy);
+   }
+
+   /***************************************
+    * SERIALIZER
+    ***************************************/
+
+   // strings carry their length, including the empty one
+   void test_roundTrip_string()
+   {  // setup
+      Node <std::string> * pHead = new Node <std::string>(std::string("eleven"));
+      insert(insert(pHead, std::string(""), true), std::string(100, 'x'), true);
+      std::vector <char> buffer;
+      NodePool <std::string> pool;
+      // exercise
+      serialize((const Node <std::string> *)pHead, buffer);
+      Node <std::string> * pCopy = deserialize(buffer.data(), buffer.size(), pool);
+      // verify
+      SerialHeader header;
+      memcpy(&header, buffer.data(), sizeof(header));
+      assertUnit(header.size == 0);
+      assertUnit(header.num == 3);
+      assertUnit(same(pHead, pCopy));
+      assertUnit(linked(pCopy));
+      // teardown
+      clear(pHead);
+      pool.clear(pCopy);
+   }
+
+   // a Serializer of our own
+   void test_roundTrip_custom()
+   {  // setup
+      Node <Person> * pHead = new Node <Person>(Person { "Ada", 36 });
+      insert(pHead, Person { "Grace", 85 }, true);
+      std::vector <char> buffer;
+      NodePool <Person> pool;
+      // exercise
+      serialize((const Node <Person> *)pHead, buffer);
+      Node <Person> * pCopy = deserialize(buffer.data(), buffer.size(), pool);
+      // verify
+      assertUnit(pCopy && pCopy->data.name == "Ada" && pCopy->data.age == 36);
+      assertUnit(pCopy && pCopy->pNext && pCopy->pNext->data.name == "Grace");
+      assertUnit(pCopy && pCopy->pNext && pCopy->pNext->data.age == 85);
+      assertUnit(pCopy && pCopy->pNext && pCopy->pNext->pNext == nullptr);
+      // teardown
+      clear(pHead);
+      pool.clear(pCopy);
+   }
+
+   // two frames through a stream, read back one at a time
+   void test_roundTrip_stream()
+   {  // setup
+      Node <int> * pFirst = build(5);
+      Node <int> * pSecond = build(3);
+      std::stringstream stream(std::ios::in | std::ios::out | std::ios::binary);
+      NodePool <int> pool;
+      // exercise
+      serialize((const Node <int> *)pFirst, stream);
+      serialize((const Node <int> *)pSecond, stream);
+      Node <int> * pFirstCopy = deserialize(stream, pool);
+      Node <int> * pSecondCopy = deserialize(stream, pool);
+      // verify
+      assertUnit(same(pFirst, pFirstCopy));
+      assertUnit(same(pSecond, pSecondCopy));
+      assertUnit(stream.peek() == std::char_traits <char>::eof());
+      // teardown
+      clear(pFirst);
+      clear(pSecond);
+      pool.clear(pFirstCopy);
+      pool.clear(pSecondCopy);
+   }
+
+   /***************************************
+    * ERRORS
+    ***************************************/
+
+   // something that is not a frame
+   void test_deserialize_badMagic()
+   {  // setup
+      std::vector <char> buffer(64, 'x');
+      NodePool <int> pool;
+      bool thrown = false;
+      // exercise
+      try
+      {
+         deserialize(buffer.data(), buffer.size(), pool);
+      }
+      catch (const SerializeError &)
+      {
+         thrown = true;
+      }
+      // verify
+      assertUnit(thrown);
+   }  // teardown
+
+   // a frame of int read as double
+   void test_deserialize_wrongType()
+   {  // setup
+      Node <int> * pHead = build(4);
+      std::vector <char> buffer;
+      serialize((const Node <int> *)pHead, buffer);
+      NodePool <double> pool;
+      bool thrown = false;
+      // exercise
+      try
+      {
+         deserialize(buffer.data(), buffer.size(), pool);
+      }
+      catch (const SerializeError &)
+      {
+         thrown = true;
+      }
+      // verify
+      assertUnit(thrown);
+      // teardown
+      clear(pHead);
+   }
+
+   // a frame cut short part way through a value gives back
+   // every node it had built
+   void test_deserialize_truncated()
+   {  // setup
+      Node <std::string> * pHead = new Node <std::string>(std::string("eleven"));
+      insert(pHead, std::string("twenty six"), true);
+      std::vector <char> buffer;
+      serialize((const Node <std::string> *)pHead, buffer);
+      SerialHeader header;
+      memcpy(&header, buffer.data(), sizeof(header));
+      header.numBytes -= 3;
+      memcpy(buffer.data(), &header, sizeof(header));
+      NodePool <std::string> pool(16);
+      bool thrown = false;
+      // exercise
+      try
+      {
+         deserialize(buffer.data(), buffer.size() - 3, pool);
+      }
+      catch (const SerializeError &)
+      {
+         thrown = true;
+      }
+      // verify
+      assertUnit(thrown);
+      assertUnit(pool.numBlocks() == 1);
+      assertUnit(pool.numFree() == 16);      // the first string went back
+      // teardown
+      clear(pHead);
+   }
+
+   // a stream whose header claims far more than it holds
+   void test_deserialize_badLength()
+   {
+      for (uint64_t num : { 1ull << 40, 1ull << 61 })
+      {  // setup
+         Node <int> * pHead = build(4);
+         std::vector <char> buffer;
+         serialize((const Node <int> *)pHead, buffer);
+         SerialHeader header;
+         memcpy(&header, buffer.data(), sizeof(header));
+         header.num = num;
+         header.numBytes = num * sizeof(int);
+         memcpy(buffer.data(), &header, sizeof(header));
+         std::stringstream stream(std::string(buffer.begin(), buffer.end()),
+                                  std::ios::in | std::ios::binary);
+         NodePool <int> pool;
+         bool thrown = false;
+         // exercise
+         try
+         {
+            deserialize(stream, pool);
+         }
+         catch (const SerializeError &)
+         {
+            thrown = true;
+         }
+         // verify
+         assertUnit(thrown);
+         // teardown
+         clear(pHead);
+      }
+   }
+
+   // a frame that claims more values than it has bytes is refused
+   // before a single node is built
+   void test_deserialize_badCount()
+   {  // setup
+      Node <std::string> * pHead = new Node <std::string>(std::string("eleven"));
+      insert(pHead, std::string("twenty six"), true);
+      std::vector <char> buffer;
+      serialize((const Node <std::string> *)pHead, buffer);
+      SerialHeader header;
+      memcpy(&header, buffer.data(), sizeof(header));
+      header.num = header.numBytes + 1;
+      memcpy(buffer.data(), &header, sizeof(header));
+      NodePool <std::string> pool;
+      bool thrown = false;
+      // exercise
+      try
+      {
+         deserialize(buffer.data(), buffer.size(), pool);
+      }
+      catch (const SerializeError &)
+      {
+         thrown = true;
+      }
+      // verify
+      assertUnit(thrown);
+      assertUnit(pool.numBlocks() == 0);
+      // teardown
+      clear(pHead);
+   }
+
+   /***************************************
+    * FLAT LIST VIEW
+    ***************************************/
+
+   // the values, read where they lie
+   void test_flat_standard()
+   {  // setup
+      Node <int> * pHead = build(100);
+      std::vector <char> buffer;
+      serialize((const Node <int> *)pHead, buffer);
+      // exercise
+      FlatListView <int> view(buffer);
+      // verify
+      assertUnit(view.size() == 100);
+      assertUnit(!view.empty());
+      assertUnit(view.front() == 0);
+      assertUnit(view.back() == 99);
+      assertUnit(view[42] == 42);
+      assertUnit(std::accumulate(view.begin(), view.end(), 0) == 4950);
+      int expected = 0;
+      bool inOrder = true;
+      for (int value : view)
+         inOrder = inOrder && value == expected++;
+      assertUnit(inOrder);
+      // teardown
+      clear(pHead);
+   }
+
+   // back to front
+   void test_flat_backward()
+   {  // setup
+      Node <int> * pHead = build(5);
+      std::vector <char> buffer;
+      serialize((const Node <int> *)pHead, buffer);
+      FlatListView <int> view(buffer);
+      std::string s;
+      // exercise
+      for (int value : view | std::views::reverse)
+         s += std::to_string(value);
+      FlatListView <int>::iterator it = view.end();
+      --it;
+      // verify
+      assertUnit(s == "43210");
+      assertUnit(*it == 4);
+      assertUnit(*--it == 3);
+      // teardown
+      clear(pHead);
+   }
+
+   // an empty frame is an empty view
+   void test_flat_empty()
+   {  // setup
+      std::vector <char> buffer;
+      serialize((const Node <double> *)nullptr, buffer);
+      // exercise
+      FlatListView <double> view(buffer);
+      // verify
+      assertUnit(view.empty());
+      assertUnit(view.size() == 0);
+      assertUnit(view.begin() == view.end());
+      assertUnit(view.numBytes() == buffer.size());
+   }  // teardown
+
+   // a frame at an odd address, such as inside a network message
+   void test_flat_unaligned()
+   {  // setup
+      Node <double> * pHead = new Node <double>(1.5);
+      insert(pHead, 2.5, true);
+      std::vector <char> frame;
+      serialize((const Node <double> *)pHead, frame);
+      std::vector <char> message(1 + frame.size(), '!');
+      memcpy(message.data() + 1, frame.data(), frame.size());
+      // exercise
+      FlatListView <double> view(message.data() + 1, message.size() - 1);
+      // verify
+      assertUnit(view.size() == 2);
+      assertUnit(view.front() == 1.5);
+      assertUnit(view.back() == 2.5);
+      // teardown
+      clear(pHead);
+   }
+
+   // frames one after another
+   void test_flat_frames()
+   {  // setup
+      Node <int> * pFirst = build(3);
+      Node <int> * pSecond = build(7);
+      std::vector <char> buffer;
+      serialize((const Node <int> *)pFirst, buffer);
+      serialize((const Node <int> *)pSecond, buffer);
+      // exercise
+      FlatListView <int> first(buffer);
+      FlatListView <int> second(buffer.data() + first.numBytes(), buffer.size() - first.numBytes());
+      // verify
+      assertUnit(first.size() == 3);
+      assertUnit(second.size() == 7);
+      assertUnit(second.back() == 6);
+      assertUnit(first.numBytes() + second.numBytes() == buffer.size());
+      // teardown
+      clear(pFirst);
+      clear(pSecond);
+   }
+
+   // a frame of int seen as float
+   void test_flat_wrongType()
+   {  // setup
+      Node <int> * pHead = build(4);
+      std::vector <char> buffer;
+      serialize((const Node <int> *)pHead, buffer);
+      buffer.resize(buffer.size() - 1);
+      bool thrownType = false;
+      bool thrownShort = false;
+      // exercise
+      try
+      {
+         FlatListView <double> view(buffer);
+      }
+      catch (const SerializeError &)
+      {
+         thrownType = true;
+      }
+      try
+      {
+         FlatListView <int> view(buffer);
+      }
+      catch (const SerializeError &)
+      {
+         thrownShort = true;
+      }
+      // verify
+      assertUnit(thrownType);
+      assertUnit(thrownShort);
+      // teardown
+      clear(pHead);
+   }
+
+   /*************************************************************
+    * BUILD
+    * A list holding 0, 1, ... num - 1
+    *************************************************************/
+   static Node <int> * build(int num)
+   {
+      Node <int> * pHead = nullptr;
+      Node <int> * pTail = nullptr;
+      for (int i = 0; i < num; i++)
+      {
+         pTail = insert(pTail, i, true);
+         if (pHead == nullptr)
+            pHead = pTail;
+      }
+      return pHead;
+   }
+
+   /*************************************************************
+    * SAME
+    * Do two lists hold the same values in the same order?
+    *************************************************************/
+   template <class T>
+   static bool same(const Node <T> * pLhs, const Node <T> * pRhs)
+   {
+      for (; pLhs && pRhs; pLhs = pLhs->pNext, pRhs = pRhs->pNext)
+         if (!(pLhs->data == pRhs->data))
+            return false;
+      return pLhs == nullptr && pRhs == nullptr;
+   }
+
+   /*************************************************************
+    * LINKED
+    * Does every pPrev point back at the node before it?
+    *************************************************************/
+   template <class T>
+   static bool linked(const Node <T> * pHead)
+   {
+      const Node <T> * pPrevious = nullptr;
+      for (const Node <T> * p = pHead; p; pPrevious = p, p = p->pNext)
+         if (p->pPrev != pPrevious)
+            return false;
+      return true;
+   }
+};
+
+#endif // DEBUG
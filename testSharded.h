@@ -0,0 +1,229 @@
+/***********************************************************************
+ * Header:
+ *    TEST SHARDED
+ * Summary:
+ *    Unit tests for the sharded list
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "sharded.h"    // class under test
+#include "spy.h"        // for Spy
+#include "unitTest.h"   // unit test baseclass
+
+#include <string>       // for std::string
+#include <thread>       // for std::thread
+#include <vector>       // for std::vector
+
+/***********************************************
+ * TEST SHARDED
+ * Unit tests for ShardedList
+ ***********************************************/
+class TestSharded : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Create
+      test_create_empty();
+      test_create_default();
+
+      // Append
+      test_pushBack_shards();
+      test_pushBack_myShard();
+      test_pushBack_spy();
+      test_pushBack_concurrent();
+
+      // Collect
+      test_collect_empty();
+      test_collect_standard();
+      test_collect_reuse();
+
+      report("Sharded");
+   }
+
+   /***************************************
+    * CREATE
+    ***************************************/
+
+   // a new list has nothing in it
+   void test_create_empty()
+   {  // setup
+      // exercise
+      ShardedList <int> list(4);
+      // verify
+      assertUnit(list.numShards() == 4);
+      assertUnit(list.size() == 0);
+      assertUnit(list.empty());
+      assertUnit(values(list) == "");
+   }  // teardown
+
+   // one shard per core unless told otherwise
+   void test_create_default()
+   {  // setup
+      // exercise
+      ShardedList <int> list;
+      // verify
+      assertUnit(list.numShards() >= 1);
+      assertUnit(list.myShard() < list.numShards());
+   }  // teardown
+
+   /***************************************
+    * APPEND
+    ***************************************/
+
+   // each shard keeps its own order; visiting goes shard by shard
+   void test_pushBack_shards()
+   {  // setup
+      ShardedList <int> list(3);
+      // exercise
+      list.pushBack(2, 31);
+      list.pushBack(0, 11);
+      list.pushBack(2, 32);
+      list.pushBack(1, 26);
+      list.pushBack(0, 12);
+      // verify
+      assertUnit(values(list) == "11 12 26 31 32");
+      assertUnit(list.size() == 5);
+   }  // teardown
+
+   // the same thread always lands on the same shard
+   void test_pushBack_myShard()
+   {  // setup
+      ShardedList <int> list(4);
+      // exercise
+      Node <int> * p11 = list.pushBack(11);
+      Node <int> * p26 = list.pushBack(26);
+      // verify
+      assertUnit(p11->pNext == p26);
+      assertUnit(p26->pPrev == p11);
+      assertUnit(list.size() == 2);
+   }  // teardown
+
+   // appending copies the value once and allocates once
+   void test_pushBack_spy()
+   {  // setup
+      ShardedList <Spy> list(2);
+      Spy s(26);
+      Spy::reset();
+      // exercise
+      list.pushBack(1, s);
+      // verify
+      assertUnit(Spy::numCopy() == 1);
+      assertUnit(Spy::numAlloc() == 1);
+      assertUnit(Spy::numDelete() == 0);
+   }  // teardown
+
+   // many threads append at once; nothing is lost and each
+   // thread's values stay in order
+   void test_pushBack_concurrent()
+   {  // setup
+      const int numThreads = 4;
+      const int numEach = 5000;
+      ShardedList <int> list(numThreads);
+      std::vector <std::thread> threads;
+      // exercise
+      for (int t = 0; t < numThreads; t++)
+         threads.emplace_back([&list, t]()
+         {
+            for (int i = 0; i < numEach; i++)
+               list.pushBack(t * numEach + i);
+         });
+      for (auto & thread : threads)
+         thread.join();
+      // verify
+      assertUnit(list.size() == numThreads * numEach);
+      std::vector <int> last(numThreads, -1);
+      bool ordered = true;
+      long long sum = 0;
+      list.forEach([&](int value)
+      {
+         int t = value / numEach;
+         ordered = ordered && value > last[t];
+         last[t] = value;
+         sum += value;
+      });
+      long long n = numThreads * numEach;
+      assertUnit(ordered);
+      assertUnit(sum == n * (n - 1) / 2);
+   }  // teardown
+
+   /***************************************
+    * COLLECT
+    ***************************************/
+
+   // nothing to collect
+   void test_collect_empty()
+   {  // setup
+      ShardedList <int> list(4);
+      // exercise
+      Node <int> * pHead = list.collect();
+      // verify
+      assertUnit(pHead == nullptr);
+   }  // teardown
+
+   // the shards become one doubly linked list, empty shards skipped
+   void test_collect_standard()
+   {  // setup
+      ShardedList <Spy> list(4);
+      list.pushBack(1, Spy(11));
+      list.pushBack(3, Spy(26));
+      list.pushBack(3, Spy(31));
+      Spy::reset();
+      // exercise
+      Node <Spy> * pHead = list.collect();
+      // verify
+      //    +----+   +----+   +----+
+      //    | 11 | - | 26 | - | 31 |
+      //    +----+   +----+   +----+
+      assertUnit(Spy::numCopy() == 0);
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(pHead && pHead->data == Spy(11));
+      assertUnit(pHead && pHead->pPrev == nullptr);
+      assertUnit(pHead && pHead->pNext && pHead->pNext->data == Spy(26));
+      assertUnit(pHead && pHead->pNext && pHead->pNext->pPrev == pHead);
+      assertUnit(size(pHead) == 3);
+      assertUnit(list.size() == 0);
+      // teardown
+      clear(pHead);
+   }
+
+   // the shards can be filled again after a collect
+   void test_collect_reuse()
+   {  // setup
+      ShardedList <int> list(2);
+      list.pushBack(0, 11);
+      Node <int> * pFirst = list.collect();
+      // exercise
+      list.pushBack(1, 26);
+      list.pushBack(0, 31);
+      // verify
+      assertUnit(values(list) == "31 26");
+      assertUnit(list.size() == 2);
+      assertUnit(size(pFirst) == 1);
+      // teardown
+      clear(pFirst);
+   }
+
+   /*************************************************************
+    * VALUES
+    * The values in visiting order, separated by spaces
+    *************************************************************/
+   static std::string values(ShardedList <int> & list)
+   {
+      std::string s;
+      list.forEach([&s](int value)
+      {
+         s += (s.empty() ? "" : " ") + std::to_string(value);
+      });
+      return s;
+   }
+};
+
+#endif // DEBUG
@@ -0,0 +1,345 @@
+/***********************************************************************
+ * Header:
+ *    TEST SHM
+ * Summary:
+ *    Unit tests for the list in shared memory
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell
+ ************************************************************************/
+
+#pragma once
+
+#if defined(DEBUG) && !defined(_WIN32)
+
+#include "shm.h"     // class under test
+#include "unitTest.h"   // unit test baseclass
+
+#include <cerrno>       // for EAGAIN
+#include <chrono>       // for std::chrono::steady_clock
+#include <string>       // for std::string
+#include <system_error> // for std::system_error
+#include <fcntl.h>      // for O_CREAT
+#include <sys/mman.h>   // for shm_open
+#include <sys/wait.h>   // for waitpid
+#include <unistd.h>     // for fork
+
+/***********************************************
+ * TEST SHM
+ * Unit tests for ShmList
+ ***********************************************/
+class TestShm : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Construct
+      test_construct_new();
+      test_construct_missing();
+      test_construct_notReady();
+      test_construct_wrongType();
+      test_construct_taken();
+      test_construct_replace();
+      test_destruct_unlinks();
+
+      // Append
+      test_pushBack_open();
+      test_pushBack_full();
+      test_pushBack_seenLater();
+
+      // Processes
+      test_fork_readWhileAppending();
+
+      report("Shm");
+   }
+
+   /***************************************
+    * CONSTRUCT
+    ***************************************/
+
+   // a new segment is an empty list
+   void test_construct_new()
+   {  // setup
+      std::string name = nameFor("new");
+      // exercise
+      ShmList <int> list(name, 16);
+      // verify
+      assertUnit(list.empty());
+      assertUnit(list.head() == 0);
+      assertUnit(list.capacity() == 16);
+      assertUnit(list.isAppender());
+   }  // teardown
+
+   // nothing by that name
+   void test_construct_missing()
+   {  // setup
+      bool thrown = false;
+      // exercise
+      try
+      {
+         ShmList <int> list(nameFor("missing"));
+      }
+      catch (const std::system_error &)
+      {
+         thrown = true;
+      }
+      // verify
+      assertUnit(thrown);
+   }  // teardown
+
+   // a segment caught before its appender wrote the header is not ready, not wrong
+   void test_construct_notReady()
+   {  // setup
+      std::string name = nameFor("notReady");
+      int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+      assertUnit(fd >= 0);
+      // exercise
+      int errorEmpty = errorOpening(name);
+      assertUnit(::ftruncate(fd, 4096) == 0);
+      int errorNoMagic = errorOpening(name);
+      // verify
+      assertUnit(errorEmpty == EAGAIN);
+      assertUnit(errorNoMagic == EAGAIN);
+      // teardown
+      ::close(fd);
+      ::shm_unlink(name.c_str());
+   }
+
+   // a segment that holds something else is refused
+   void test_construct_wrongType()
+   {  // setup
+      std::string name = nameFor("wrongType");
+      ShmList <int> list(name, 4);
+      bool thrown = false;
+      // exercise
+      try
+      {
+         ShmList <double> reader(name);
+      }
+      catch (const std::runtime_error &)
+      {
+         thrown = true;
+      }
+      // verify
+      assertUnit(thrown);
+   }  // teardown
+
+   // a name another appender holds is left alone
+   void test_construct_taken()
+   {  // setup
+      std::string name = nameFor("taken");
+      ShmList <int> list(name, 4);
+      list.pushBack(26);
+      int error = 0;
+      // exercise
+      try
+      {
+         ShmList <int> other(name, 4);
+      }
+      catch (const std::system_error & e)
+      {
+         error = e.code().value();
+      }
+      // verify
+      assertUnit(error == EEXIST);
+      list.pushBack(31);
+      ShmList <int> reader(name);
+      assertUnit(values(reader) == "26 31");
+   }  // teardown
+
+   // asked to, a new appender takes the name over
+   void test_construct_replace()
+   {  // setup
+      std::string name = nameFor("replace");
+      ShmList <int> * pOld = new ShmList <int>(name, 4);
+      pOld->pushBack(26);
+      // exercise
+      ShmList <int> list(name, 4, true /* replace */);
+      // verify
+      ShmList <int> reader(name);
+      assertUnit(reader.empty());
+      assertUnit(pOld->size() == 1);
+      delete pOld;
+      ShmList <int> stillThere(name);       // the old appender left our name alone
+      assertUnit(stillThere.empty());
+   }  // teardown
+
+   // the name goes away with the appender
+   void test_destruct_unlinks()
+   {  // setup
+      std::string name = nameFor("unlinks");
+      bool thrown = false;
+      // exercise
+      {
+         ShmList <int> list(name, 4);
+         list.pushBack(26);
+      }
+      try
+      {
+         ShmList <int> reader(name);
+      }
+      catch (const std::system_error &)
+      {
+         thrown = true;
+      }
+      // verify
+      assertUnit(thrown);
+   }  // teardown
+
+   /***************************************
+    * APPEND
+    ***************************************/
+
+   // another mapping of the segment sees the same list
+   void test_pushBack_open()
+   {  // setup
+      std::string name = nameFor("open");
+      ShmList <int> list(name, 16);
+      // exercise
+      list.pushBack(11);
+      list.pushBack(26);
+      ShmList <int>::Offset p31 = list.pushBack(31);
+      ShmList <int> reader(name);
+      // verify
+      //    +----+   +----+   +----+
+      //    | 11 | - | 26 | - | 31 |
+      //    +----+   +----+   +----+
+      assertUnit(!reader.isAppender());
+      assertUnit(values(reader) == "11 26 31");
+      assertUnit(reader.size() == 3);
+      assertUnit(reader.at(reader.prev(p31)) == 26);
+      Node <int> * pCopy = reader.copy();
+      assertUnit(size(pCopy) == 3);
+      assertUnit(pCopy && pCopy->pNext && pCopy->pNext->data == 26);
+      // teardown
+      clear(pCopy);
+   }
+
+   // a full segment takes no more
+   void test_pushBack_full()
+   {  // setup
+      std::string name = nameFor("full");
+      ShmList <int> list(name, 2);
+      list.pushBack(11);
+      list.pushBack(26);
+      // exercise
+      ShmList <int>::Offset p = list.pushBack(31);
+      // verify
+      assertUnit(p == 0);
+      assertUnit(list.size() == 2);
+      assertUnit(values(list) == "11 26");
+   }  // teardown
+
+   // a reader that opened early sees what came later
+   void test_pushBack_seenLater()
+   {  // setup
+      std::string name = nameFor("later");
+      ShmList <int> list(name, 16);
+      ShmList <int> reader(name);
+      list.pushBack(11);
+      ShmList <int>::Offset p11 = reader.head();
+      // exercise
+      list.pushBack(26);
+      // verify
+      assertUnit(reader.next(p11) != 0);
+      assertUnit(reader.next(p11) && reader.at(reader.next(p11)) == 26);
+      assertUnit(values(reader) == "11 26");
+   }  // teardown
+
+   /***************************************
+    * PROCESSES
+    ***************************************/
+
+   // a child process walks the list while the parent appends;
+   // it must always see 0, 1, 2, ... with no gaps or garbage
+   void test_fork_readWhileAppending()
+   {  // setup
+      const int num = 20000;
+      std::string name = nameFor("fork");
+      ShmList <int> list(name, num);
+      list.pushBack(0);
+      // exercise
+      pid_t pid = ::fork();
+      if (pid == 0)
+         ::_exit(readUntil(name, num));
+      for (int i = 1; i < num; i++)
+         list.pushBack(i);
+      int status = -1;
+      ::waitpid(pid, &status, 0);
+      // verify
+      assertUnit(pid > 0);
+      assertUnit(WIFEXITED(status));
+      assertUnit(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+   }  // teardown
+
+   /*************************************************************
+    * READ UNTIL
+    * In the child: walk the list over and over until it holds
+    * num values.  The exit status is 0 if every walk was in
+    * order, 1 if one was not, 2 if it took too long.
+    *************************************************************/
+   static int readUntil(const std::string & name, int num)
+   {
+      try
+      {
+         ShmList <int> reader(name);
+         auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+         for (;;)
+         {
+            int expected = 0;
+            bool inOrder = true;
+            reader.forEach([&](int value) { inOrder = inOrder && value == expected++; });
+            if (!inOrder)
+               return 1;
+            if (expected == num)
+               return 0;
+            if (std::chrono::steady_clock::now() > deadline)
+               return 2;
+         }
+      }
+      catch (...)
+      {
+         return 3;
+      }
+   }
+
+   /*************************************************************
+    * NAME FOR
+    * A segment name this process alone will use
+    *************************************************************/
+   static std::string nameFor(const std::string & test)
+   {
+      return "/testShm." + std::to_string(::getpid()) + "." + test;
+   }
+
+   /*************************************************************
+    * ERROR OPENING
+    * The errno a reader of the name fails with, or 0
+    *************************************************************/
+   static int errorOpening(const std::string & name)
+   {
+      try
+      {
+         ShmList <int> reader(name);
+      }
+      catch (const std::system_error & e)
+      {
+         return e.code().value();
+      }
+      return 0;
+   }
+
+   /*************************************************************
+    * VALUES
+    * Front to back, separated by spaces
+    *************************************************************/
+   static std::string values(const ShmList <int> & list)
+   {
+      std::string s;
+      list.forEach([&s](int value) { s += (s.empty() ? "" : " ") + std::to_string(value); });
+      return s;
+   }
+};
+
+#endif // DEBUG && !_WIN32
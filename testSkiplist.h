@@ -0,0 +1,362 @@
+/***********************************************************************
+ * Header:
+ *    TEST SKIPLIST
+ * Summary:
+ *    Unit tests for the lock-free skip list
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell
+ ************************************************************************/
+
+#pragma once
+
+#ifdef DEBUG
+
+#include "skiplist.h"   // class under test
+#include "spy.h"        // for Spy
+#include "unitTest.h"   // unit test baseclass
+
+#include <atomic>       // for std::atomic
+#include <string>       // for std::string
+#include <thread>       // for std::thread
+#include <vector>       // for std::vector
+
+/***********************************************
+ * TEST SKIPLIST
+ * Unit tests for SkipList
+ ***********************************************/
+class TestSkiplist : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Insert
+      test_insert_empty();
+      test_insert_sorted();
+      test_insert_duplicate();
+      test_insert_many();
+
+      // Remove
+      test_remove_missing();
+      test_remove_deferred();
+
+      // Search
+      test_find_standard();
+      test_scan_range();
+
+      // Concurrent
+      test_insert_concurrent();
+      test_mixed_concurrent();
+      test_sameKeys_concurrent();
+
+      report("Skiplist");
+   }
+
+   /***************************************
+    * INSERT
+    ***************************************/
+
+   // insert into an empty set
+   void test_insert_empty()
+   {  // setup
+      RCUDomain domain;
+      SkipList <int> set(domain);
+      // exercise
+      bool inserted = set.insert(26);
+      // verify
+      assertUnit(inserted);
+      assertUnit(set.head() && set.head()->data == 26);
+      assertUnit(set.head() && set.head()->pNext == nullptr);
+      assertUnit(set.size() == 1);
+   }  // teardown
+
+   // the bottom level is a sorted, doubly linked node.h list
+   void test_insert_sorted()
+   {  // setup
+      RCUDomain domain;
+      SkipList <int> set(domain);
+      // exercise
+      set.insert(31);
+      set.insert(11);
+      set.insert(26);
+      // verify
+      //    +----+   +----+   +----+
+      //    | 11 | - | 26 | - | 31 |
+      //    +----+   +----+   +----+
+      assertUnit(values(set) == "11 26 31");
+      Node <int> * pHead = set.head();
+      assertUnit(size(pHead) == 3);
+      assertUnit(pHead && pHead->pPrev == nullptr);
+      assertUnit(pHead && pHead->pNext && pHead->pNext->pPrev == pHead);
+   }  // teardown
+
+   // a set holds each value once
+   void test_insert_duplicate()
+   {  // setup
+      RCUDomain domain;
+      SkipList <Spy> set(domain);
+      Spy s(26);
+      set.insert(s);
+      Spy::reset();
+      // exercise
+      bool inserted = set.insert(s);
+      // verify
+      assertUnit(!inserted);
+      assertUnit(Spy::numCopy() == 0);        // found before building a node
+      assertUnit(Spy::numAlloc() == 0);
+      assertUnit(set.size() == 1);
+   }  // teardown
+
+   // enough values to build tall towers; every one can be found
+   void test_insert_many()
+   {  // setup
+      RCUDomain domain;
+      SkipList <int> set(domain);
+      // exercise
+      for (int i = 0; i < 5000; i++)
+         set.insert((i * 7919) % 5000);
+      // verify
+      bool allFound = true;
+      for (int i = 0; i < 5000; i++)
+         allFound = allFound && set.contains(i);
+      assertUnit(allFound);
+      assertUnit(!set.contains(5000));
+      assertUnit(set.size() == 5000);
+      bool sorted = true;
+      for (Node <int> * p = set.head(); p && p->pNext; p = p->pNext)
+         sorted = sorted && p->data < p->pNext->data;
+      assertUnit(sorted);
+   }  // teardown
+
+   /***************************************
+    * REMOVE
+    ***************************************/
+
+   // removing what is not there
+   void test_remove_missing()
+   {  // setup
+      RCUDomain domain;
+      SkipList <int> set(domain);
+      set.insert(11);
+      // exercise
+      bool removed = set.remove(26);
+      // verify
+      assertUnit(!removed);
+      assertUnit(values(set) == "11");
+      assertUnit(domain.numRetired() == 0);
+   }  // teardown
+
+   // a removed node lives until the domain reclaims it
+   void test_remove_deferred()
+   {  // setup
+      RCUDomain domain;
+      SkipList <Spy> set(domain);
+      set.insert(Spy(11));
+      set.insert(Spy(26));
+      set.insert(Spy(31));
+      Spy s26(26);
+      Spy::reset();
+      // exercise
+      bool removed = set.remove(s26);
+      // verify
+      assertUnit(removed);
+      assertUnit(Spy::numDelete() == 0);        // still there for readers
+      assertUnit(domain.numRetired() == 1);
+      assertUnit(set.size() == 2);
+      assertUnit(!set.contains(s26));
+      Node <Spy> * pHead = set.head();
+      assertUnit(pHead && pHead->pNext && pHead->pNext->data.get() == 31);
+      assertUnit(pHead && pHead->pNext && pHead->pNext->pPrev == pHead);
+      assertUnit(domain.reclaim() == 1);
+      assertUnit(Spy::numDelete() == 1);        // delete [26]
+   }  // teardown
+
+   /***************************************
+    * SEARCH
+    ***************************************/
+
+   // find hands back the bottom node
+   void test_find_standard()
+   {  // setup
+      RCUDomain domain;
+      SkipList <int> set(domain);
+      for (int value : { 11, 26, 31 })
+         set.insert(value);
+      // exercise
+      const Node <int> * p26 = set.find(26);
+      const Node <int> * p27 = set.find(27);
+      // verify
+      assertUnit(p26 && p26->data == 26);
+      assertUnit(p26 && p26->pNext && p26->pNext->data == 31);
+      assertUnit(p27 == nullptr);
+   }  // teardown
+
+   // a range scan includes low and stops before high
+   void test_scan_range()
+   {  // setup
+      RCUDomain domain;
+      SkipList <int> set(domain);
+      for (int i = 0; i < 100; i += 5)
+         set.insert(i);
+      std::string seen;
+      // exercise
+      size_t num = set.scan(20, 40, [&seen](int value)
+      {
+         seen += (seen.empty() ? "" : " ") + std::to_string(value);
+      });
+      // verify
+      assertUnit(num == 4);
+      assertUnit(seen == "20 25 30 35");
+      assertUnit(set.scan(21, 24, [](int) { }) == 0);
+      assertUnit(set.scan(90, 1000, [](int) { }) == 2);
+   }  // teardown
+
+   /***************************************
+    * CONCURRENT
+    ***************************************/
+
+   // threads insert interleaved values; all end up in order
+   void test_insert_concurrent()
+   {  // setup
+      const int numThreads = 4;
+      const int numEach = 2000;
+      RCUDomain domain;
+      SkipList <int> set(domain);
+      std::vector <std::thread> threads;
+      // exercise
+      for (int t = 0; t < numThreads; t++)
+         threads.emplace_back([&set, &domain, t]()
+         {
+            RCUReader reader(domain);
+            for (int i = 0; i < numEach; i++)
+            {
+               set.insert(i * numThreads + t);
+               reader.quiescent();
+            }
+         });
+      for (auto & thread : threads)
+         thread.join();
+      // verify
+      assertUnit(set.size() == numThreads * numEach);
+      bool inOrder = true;
+      int expected = 0;
+      for (Node <int> * p = set.head(); p; p = p->pNext)
+         inOrder = inOrder && p->data == expected++;
+      assertUnit(inOrder);
+   }  // teardown
+
+   // threads race to insert and remove the same values; what is left
+   // is a well formed list once pPrev is fixed
+   void test_mixed_concurrent()
+   {  // setup
+      const int numThreads = 4;
+      RCUDomain domain;
+      SkipList <int> set(domain);
+      std::atomic <int> numInserted(0);
+      std::atomic <int> numRemoved(0);
+      std::vector <std::thread> threads;
+      // exercise
+      for (int t = 0; t < numThreads; t++)
+         threads.emplace_back([&, t]()
+         {
+            RCUReader reader(domain);
+            unsigned seed = 17 + t;
+            for (int i = 0; i < 5000; i++)
+            {
+               seed = seed * 1103515245 + 12345;
+               int value = (seed >> 8) % 256;
+               if (seed & 0x10000)
+                  numInserted += set.insert(value);
+               else
+                  numRemoved += set.remove(value);
+               reader.quiescent();
+               if (i % 512 == 0)
+               {
+                  reader.offline();
+                  domain.reclaim();
+                  reader.online();
+               }
+            }
+         });
+      for (auto & thread : threads)
+         thread.join();
+      set.fixPrev();
+      // verify
+      assertUnit(set.size() == (size_t)(numInserted - numRemoved));
+      bool sorted = true;
+      bool linked = true;
+      Node <int> * pPrevious = nullptr;
+      for (Node <int> * p = set.head(); p; pPrevious = p, p = p->pNext)
+      {
+         sorted = sorted && (pPrevious == nullptr || pPrevious->data < p->data);
+         linked = linked && p->pPrev == pPrevious;
+      }
+      assertUnit(sorted);
+      assertUnit(linked);
+   }  // teardown
+
+   // threads insert and remove a handful of keys over and over, so
+   // towers are removed while they are still being raised; nothing
+   // retired may still be linked when the domain frees it
+   void test_sameKeys_concurrent()
+   {  // setup
+      const int numThreads = 8;
+      const int numKeys = 4;
+      RCUDomain domain;
+      SkipList <int> set(domain);
+      std::atomic <int> numInserted(0);
+      std::atomic <int> numRemoved(0);
+      std::vector <std::thread> threads;
+      // exercise
+      for (int t = 0; t < numThreads; t++)
+         threads.emplace_back([&, t]()
+         {
+            RCUReader reader(domain);
+            for (int i = 0; i < 20000; i++)
+            {
+               int value = (i + t) % numKeys;
+               if ((i + t) % 2)
+                  numInserted += set.insert(value);
+               else
+                  numRemoved += set.remove(value);
+               numInserted += set.insert(numKeys - 1 - value);
+               reader.quiescent();
+               if (i % 64 == 0)
+               {
+                  reader.offline();
+                  domain.reclaim();
+                  reader.online();
+               }
+            }
+         });
+      for (auto & thread : threads)
+         thread.join();
+      domain.reclaim();
+      set.fixPrev();
+      // verify
+      assertUnit(set.size() == (size_t)(numInserted - numRemoved));
+      bool found = true;
+      for (Node <int> * p = set.head(); p; p = p->pNext)
+         found = found && set.find(p->data) == p;
+      assertUnit(found);
+      for (int value = 0; value < numKeys; value++)
+         set.remove(value);
+      assertUnit(set.size() == 0);
+      assertUnit(set.head() == nullptr);
+   }  // teardown
+
+   /*************************************************************
+    * VALUES
+    * The bottom level, front to back, separated by spaces
+    *************************************************************/
+   static std::string values(SkipList <int> & set)
+   {
+      std::string s;
+      for (Node <int> * p = set.head(); p; p = p->pNext)
+         s += (s.empty() ? "" : " ") + std::to_string(p->data);
+      return s;
+   }
+};
+
+#endif // DEBUG
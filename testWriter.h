@@ -0,0 +1,312 @@
+/***********************************************************************
+ * Header:
+ *    TEST WRITER
+ * Summary:
+ *    Unit tests for the double-buffered asynchronous writer
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell
+ ************************************************************************/
+
+#pragma once
+
+#if defined(DEBUG) && !defined(_WIN32)
+
+#include "writer.h"     // class under test
+#include "unitTest.h"   // unit test baseclass
+
+#include <cstdio>       // for std::remove
+#include <filesystem>   // for std::filesystem::temp_directory_path
+#include <fstream>      // for std::ifstream
+#include <iterator>     // for std::istreambuf_iterator
+#include <sstream>      // for std::istringstream
+#include <string>       // for std::string
+
+/***********************************************
+ * TEST WRITER
+ * Unit tests for AsyncWriter and checkpointAsync
+ ***********************************************/
+class TestWriter : public UnitTest
+{
+public:
+   void run()
+   {
+      reset();
+
+      // Write
+      test_write_small();
+      test_write_manyBuffers();
+      test_write_direct();
+      test_write_openFails();
+
+      // Rewrite
+      test_rewrite_inBuffer();
+      test_rewrite_onDisk();
+
+      // Lists
+      test_writeList_ints();
+      test_writeList_strings();
+      test_checkpoint_whileChanging();
+      test_checkpoint_letsGo();
+
+      report("Writer");
+   }
+
+   /***************************************
+    * WRITE
+    ***************************************/
+
+   // less than a buffer goes out on finish()
+   void test_write_small()
+   {  // setup
+      std::string path = pathFor("small");
+      AsyncWriter out(path);
+      // exercise
+      out.write("11, 26, 31", 10);
+      uint64_t size = out.finish();
+      // verify
+      assertUnit(size == 10);
+      assertUnit(!out.isOpen());
+      assertUnit(contents(path) == "11, 26, 31");
+      // teardown
+      std::remove(path.c_str());
+   }
+
+   // odd-sized pieces across many small buffers
+   void test_write_manyBuffers()
+   {  // setup
+      std::string path = pathFor("many");
+      std::string expected = pattern(100000);
+      AsyncWriter out(path, 4096);
+      // exercise
+      for (size_t i = 0; i < expected.size(); i += 777)
+         out.write(expected.data() + i, std::min <size_t> (777, expected.size() - i));
+      uint64_t size = out.finish();
+      // verify
+      assertUnit(size == expected.size());
+      assertUnit(contents(path) == expected);
+      // teardown
+      std::remove(path.c_str());
+   }
+
+   // the padded last block is cut off again
+   void test_write_direct()
+   {  // setup
+      std::string path = pathFor("direct");
+      std::string expected = pattern(3 * 4096 + 100);
+      AsyncWriter out(path, 4096, true);
+      // exercise
+      out.write(expected.data(), expected.size());
+      uint64_t size = out.finish();
+      // verify
+      assertUnit(size == expected.size());
+      assertUnit(contents(path) == expected);
+      // teardown
+      std::remove(path.c_str());
+   }
+
+   // a file that cannot be made
+   void test_write_openFails()
+   {  // setup
+      std::string path = pathFor("missing") + "/no/such/directory";
+      bool thrown = false;
+      // exercise
+      try
+      {
+         AsyncWriter out(path);
+      }
+      catch (const std::system_error &)
+      {
+         thrown = true;
+      }
+      // verify
+      assertUnit(thrown);
+   }  // teardown
+
+   /***************************************
+    * REWRITE
+    ***************************************/
+
+   // bytes not yet handed off change in the buffer
+   void test_rewrite_inBuffer()
+   {  // setup
+      std::string path = pathFor("inBuffer");
+      AsyncWriter out(path);
+      out.write("11, 26, 31", 10);
+      // exercise
+      out.rewrite(4, "99", 2);
+      out.finish();
+      // verify
+      assertUnit(contents(path) == "11, 99, 31");
+      // teardown
+      std::remove(path.c_str());
+   }
+
+   // bytes already written change on disk, both ways, even
+   // across the edge of the buffer
+   void test_rewrite_onDisk()
+   {
+      for (bool direct : { false, true })
+      {  // setup
+         std::string path = pathFor("onDisk");
+         std::string expected = pattern(3 * 4096 + 100);
+         AsyncWriter out(path, 4096, direct);
+         out.write(expected.data(), expected.size());
+         // exercise
+         out.rewrite(10, "abc", 3);
+         out.rewrite(3 * 4096 - 2, "wxyz", 4);
+         out.finish();
+         // verify
+         expected.replace(10, 3, "abc");
+         expected.replace(3 * 4096 - 2, 4, "wxyz");
+         assertUnit(contents(path) == expected);
+         // teardown
+         std::remove(path.c_str());
+      }
+   }
+
+   /***************************************
+    * LISTS
+    ***************************************/
+
+   // the same bytes serialize() makes
+   void test_writeList_ints()
+   {  // setup
+      std::string path = pathFor("ints");
+      Node <int> * pHead = build(10000);
+      std::vector <char> expected;
+      serialize((const Node <int> *)pHead, expected);
+      // exercise
+      {
+         AsyncWriter out(path, 4096, true);
+         writeList((const Node <int> *)pHead, out);
+         out.finish();
+      }
+      // verify
+      assertUnit(contents(path) == std::string(expected.begin(), expected.end()));
+      // teardown
+      clear(pHead);
+      std::remove(path.c_str());
+   }
+
+   // values that need a Serializer, read back with deserialize()
+   void test_writeList_strings()
+   {  // setup
+      std::string path = pathFor("strings");
+      Node <std::string> * pHead = new Node <std::string>("eleven");
+      insert(insert(pHead, std::string(5000, 'x'), true), std::string(), true);
+      // exercise
+      {
+         AsyncWriter out(path, 4096);
+         writeList((const Node <std::string> *)pHead, out);
+         out.finish();
+      }
+      // verify
+      std::istringstream in(contents(path));
+      NodePool <std::string> pool;
+      Node <std::string> * pCopy = deserialize(in, pool);
+      assertUnit(pCopy && pCopy->data == "eleven");
+      assertUnit(pCopy && pCopy->pNext && pCopy->pNext->data == std::string(5000, 'x'));
+      assertUnit(pCopy && pCopy->pNext && pCopy->pNext->pNext && pCopy->pNext->pNext->data.empty());
+      assertUnit(size(pCopy) == 3);
+      // teardown
+      pool.clear(pCopy);
+      clear(pHead);
+      std::remove(path.c_str());
+   }
+
+   // the file holds the list as it was when the checkpoint started
+   void test_checkpoint_whileChanging()
+   {  // setup
+      std::string path = pathFor("checkpoint");
+      SharedList <int> list(build(100000));
+      // exercise
+      std::future <uint64_t> done = checkpointAsync(list, path, 1 << 16);
+      for (int i = 0; i < 1000; i++)
+         list.insert(list.head(), -i);
+      uint64_t size = done.get();
+      // verify
+      std::string text = contents(path);
+      std::istringstream in(text);
+      NodePool <int> pool;
+      Node <int> * pCopy = deserialize(in, pool);
+      assertUnit(size == text.size());
+      assertUnit(::size(pCopy) == 100000);
+      bool inOrder = true;
+      int expected = 0;
+      for (const Node <int> * p = pCopy; p; p = p->pNext)
+         inOrder = inOrder && p->data == expected++;
+      assertUnit(inOrder);
+      assertUnit(list.size() == 101000);
+      assertUnit(!std::filesystem::exists(path + ".tmp"));
+      // teardown
+      pool.clear(pCopy);
+      std::remove(path.c_str());
+   }
+
+   // the snapshot is let go once written, while the future is still held
+   void test_checkpoint_letsGo()
+   {  // setup
+      std::string path = pathFor("letsGo");
+      SharedList <int> list(build(1000));
+      // exercise
+      std::future <uint64_t> done = checkpointAsync(list, path);
+      done.wait();
+      // verify
+      assertUnit(!list.isShared());
+      assertUnit(done.get() > 0);
+      // teardown
+      std::remove(path.c_str());
+   }
+
+   /*************************************************************
+    * PATH FOR
+    * A fresh file in the temporary directory
+    *************************************************************/
+   static std::string pathFor(const std::string & name)
+   {
+      std::string path = (std::filesystem::temp_directory_path() / ("testWriter." + name)).string();
+      std::remove(path.c_str());
+      return path;
+   }
+
+   /*************************************************************
+    * CONTENTS
+    * Everything in a file
+    *************************************************************/
+   static std::string contents(const std::string & path)
+   {
+      std::ifstream in(path, std::ios::binary);
+      return std::string(std::istreambuf_iterator <char> (in), std::istreambuf_iterator <char> ());
+   }
+
+   /*************************************************************
+    * PATTERN
+    * num bytes that are not all the same
+    *************************************************************/
+   static std::string pattern(size_t num)
+   {
+      std::string s(num, '\0');
+      for (size_t i = 0; i < num; i++)
+         s[i] = (char)('a' + i * 7 % 26);
+      return s;
+   }
+
+   /*************************************************************
+    * BUILD
+    * 0, 1, ... num - 1
+    *************************************************************/
+   static Node <int> * build(int num)
+   {
+      Node <int> * pHead = nullptr;
+      Node <int> * pTail = nullptr;
+      for (int i = 0; i < num; i++)
+      {
+         pTail = insert(pTail, i, true);
+         if (pHead == nullptr)
+            pHead = pTail;
+      }
+      return pHead;
+   }
+};
+
+#endif // DEBUG && !_WIN32
@@ -0,0 +1,521 @@
+/***********************************************************************
+ * Header:
+ *    WRITER
+ * Summary:
+ *    Writing a list to a file without waiting on the disk.  AsyncWriter
+ *    has two buffers: the caller fills one while a background thread
+ *    pwrite()s the other, so encoding and I/O overlap and the caller
+ *    only blocks when it gets a whole buffer ahead of the disk.  Full
+ *    buffers go out at offsets that are multiples of the buffer size,
+ *    which is what O_DIRECT asks for; with direct set the page cache is
+ *    bypassed, where the file system allows it.
+ *
+ *    checkpointAsync() goes one step further and takes the encoding off
+ *    the caller too.  It holds a copy-on-write handle to the list, which
+ *    costs O(1), and writes it from a thread of its own; the owner keeps
+ *    changing its handle, paying for one copy of the list on its first
+ *    change.  The checkpoint is written beside the file and renamed over
+ *    it when complete, so a crash leaves the old checkpoint or the new
+ *    one, never half of one; the directory is synced after the rename,
+ *    so once the future is ready a crash leaves the new one.  POSIX
+ *    only.
+ *
+ *    This will contain the class definition of:
+ *        AsyncWriter     : A double-buffered file writer
+ *    and the functions:
+ *        writeList       : A serialize.h frame into an AsyncWriter
+ *        syncDirectory   : Make the names in a file's directory durable
+ *        checkpointAsync : A SharedList to a file, on another thread
+ * Author
+ *    Stephen Costigan, Alexander Dohms, Jonathan Colwell
+ ************************************************************************/
+
+#pragma once
+
+#ifndef _WIN32
+
+#include <algorithm>          // for std::min
+#include <cerrno>             // for errno
+#include <condition_variable> // for std::condition_variable
+#include <cstdint>            // for uint64_t
+#include <cstdio>             // for std::rename and std::remove
+#include <cstdlib>            // for std::aligned_alloc
+#include <cstring>            // for memcpy
+#include <filesystem>         // for std::filesystem::path
+#include <future>             // for std::async
+#include <mutex>              // for std::mutex
+#include <new>                // for std::bad_alloc
+#include <string>             // for std::string
+#include <system_error>       // for std::system_error
+#include <thread>             // for std::thread
+#include <type_traits>        // for std::is_trivially_copyable
+#include <vector>             // for std::vector
+#include <fcntl.h>            // for open
+#include <unistd.h>           // for pwrite
+#include "cow.h"              // for SharedList
+#include "node.h"             // for Node
+#include "serialize.h"        // for SerialHeader
+
+/*************************************************
+ * ASYNC WRITER
+ * Appends bytes to a new file through two buffers
+ * and a background thread.  An error on that thread
+ * is thrown by the next call that waits for it.  One
+ * AsyncWriter belongs to one thread.
+ *************************************************/
+class AsyncWriter
+{
+public:
+   static constexpr size_t ALIGNMENT = 4096;   // what O_DIRECT needs, at most
+
+   //
+   // Construct: create or truncate the file and start the thread
+   //
+   AsyncWriter(const std::string & path, size_t bufferSize = 1 << 20, bool direct = false);
+   AsyncWriter(const AsyncWriter &) = delete;
+   AsyncWriter & operator = (const AsyncWriter &) = delete;
+   ~AsyncWriter();
+
+   //
+   // Write
+   //
+   void write(const void * p, size_t num);
+   template <class U>
+   void put(const U & u)
+   {
+      static_assert(std::is_trivially_copyable <U>::value, "write the parts one by one");
+      write(&u, sizeof(U));
+   }
+   void rewrite(uint64_t offset, const void * p, size_t num);
+   uint64_t finish();
+
+   //
+   // Status
+   //
+   uint64_t size()   const { return fillOffset + numFill; }
+   bool isDirect()   const { return direct;               }
+   bool isOpen()     const { return fd >= 0;              }
+
+private:
+   void handOff(size_t num);
+   void waitIdle();
+   void stopThread();
+   void work();
+   static int writeAll(int fd, const char * p, size_t num, uint64_t offset);
+
+   int fd;                       // the file
+   bool direct;                  // opened with O_DIRECT
+   size_t bufferSize;            // a multiple of ALIGNMENT
+   char * buffers[2];
+   int iFill;                    // the buffer the caller is filling
+   size_t numFill;               // bytes in it
+   uint64_t fillOffset;          // where it goes in the file
+
+   // shared with the thread
+   std::mutex mutex;
+   std::condition_variable wake;
+   std::condition_variable idle;
+   const char * pWrite;          // the buffer being written
+   size_t numWrite;
+   uint64_t writeOffset;
+   bool busy;                    // is the thread writing it?
+   bool stop;
+   int error;                    // errno of the first failed write
+   std::thread thread;
+};
+
+/***********************************************
+ * ASYNC WRITER :: CONSTRUCTOR
+ * Open the file and start the thread.  When direct
+ * is asked for but the file system refuses it, the
+ * file is opened the ordinary way; isDirect() says
+ * which happened.
+ *   INPUT  : the path, the size of each buffer, and
+ *            whether to bypass the page cache
+ **********************************************/
+inline AsyncWriter :: AsyncWriter(const std::string & path, size_t bufferSize, bool direct) :
+   fd(-1), direct(false), bufferSize((std::max(bufferSize, ALIGNMENT) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT),
+   buffers { nullptr, nullptr }, iFill(0), numFill(0), fillOffset(0),
+   pWrite(nullptr), numWrite(0), writeOffset(0), busy(false), stop(false), error(0)
+{
+#ifdef O_DIRECT
+   if (direct)
+   {
+      fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+      this->direct = fd >= 0;
+   }
+#endif // O_DIRECT
+   if (fd < 0)
+      fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+   if (fd < 0)
+      throw std::system_error(errno, std::generic_category(), "writer: open " + path);
+#ifdef F_NOCACHE
+   if (direct && ::fcntl(fd, F_NOCACHE, 1) == 0)
+      this->direct = true;
+#endif // F_NOCACHE
+
+   buffers[0] = (char *)std::aligned_alloc(ALIGNMENT, this->bufferSize);
+   buffers[1] = (char *)std::aligned_alloc(ALIGNMENT, this->bufferSize);
+   if (!buffers[0] || !buffers[1])
+   {
+      std::free(buffers[0]);
+      std::free(buffers[1]);
+      ::close(fd);
+      throw std::bad_alloc();
+   }
+   thread = std::thread([this]() { work(); });
+}
+
+/***********************************************
+ * ASYNC WRITER :: DESTRUCTOR
+ * finish() if nobody did.  An error then has nowhere
+ * to go; call finish() to hear about it.
+ **********************************************/
+inline AsyncWriter :: ~AsyncWriter()
+{
+   try
+   {
+      finish();
+   }
+   catch (...)
+   {
+   }
+   std::free(buffers[0]);
+   std::free(buffers[1]);
+}
+
+/***********************************************
+ * ASYNC WRITER :: WORK
+ * Write each buffer handed over until told to stop
+ **********************************************/
+inline void AsyncWriter :: work()
+{
+   std::unique_lock <std::mutex> lock(mutex);
+   for (;;)
+   {
+      wake.wait(lock, [this]() { return stop || busy; });
+      if (!busy)
+         return;
+
+      const char * p = pWrite;
+      size_t num = numWrite;
+      uint64_t offset = writeOffset;
+      lock.unlock();
+      int result = writeAll(fd, p, num, offset);
+      lock.lock();
+      if (result && !error)
+         error = result;
+      busy = false;
+      idle.notify_all();
+   }
+}
+
+/***********************************************
+ * ASYNC WRITER :: WRITE ALL
+ * pwrite() until every byte is out
+ *   INPUT  : the file, the bytes, and where they go
+ *   OUTPUT : 0, or the errno of the failure
+ **********************************************/
+inline int AsyncWriter :: writeAll(int fd, const char * p, size_t num, uint64_t offset)
+{
+   while (num)
+   {
+      ssize_t done = ::pwrite(fd, p, num, (off_t)offset);
+      if (done < 0 && errno == EINTR)
+         continue;
+      if (done <= 0)
+         return done < 0 ? errno : EIO;
+      p += done;
+      num -= done;
+      offset += done;
+   }
+   return 0;
+}
+
+/***********************************************
+ * ASYNC WRITER :: WAIT IDLE
+ * Until the thread is done with its buffer, then
+ * throw if any write has failed
+ **********************************************/
+inline void AsyncWriter :: waitIdle()
+{
+   std::unique_lock <std::mutex> lock(mutex);
+   idle.wait(lock, [this]() { return !busy; });
+   if (error)
+      throw std::system_error(error, std::generic_category(), "writer: pwrite");
+}
+
+/***********************************************
+ * ASYNC WRITER :: HAND OFF
+ * Give the buffer being filled to the thread, once
+ * it has finished the other one, and fill that
+ *   INPUT  : how much of the buffer to write
+ **********************************************/
+inline void AsyncWriter :: handOff(size_t num)
+{
+   waitIdle();
+   {
+      std::lock_guard <std::mutex> lock(mutex);
+      pWrite = buffers[iFill];
+      numWrite = num;
+      writeOffset = fillOffset;
+      busy = true;
+   }
+   wake.notify_one();
+
+   fillOffset += numFill;
+   numFill = 0;
+   iFill ^= 1;
+}
+
+/***********************************************
+ * ASYNC WRITER :: WRITE
+ * Append bytes, handing off each buffer that fills
+ *   INPUT  : the bytes
+ *   COST   : O(num), plus waiting when the disk is
+ *            a whole buffer behind
+ **********************************************/
+inline void AsyncWriter :: write(const void * p, size_t num)
+{
+   const char * pFrom = (const char *)p;
+   while (num)
+   {
+      size_t numCopy = std::min(num, bufferSize - numFill);
+      memcpy(buffers[iFill] + numFill, pFrom, numCopy);
+      numFill += numCopy;
+      pFrom += numCopy;
+      num -= numCopy;
+      if (numFill == bufferSize)
+         handOff(bufferSize);
+   }
+}
+
+/***********************************************
+ * ASYNC WRITER :: REWRITE
+ * Change bytes already written, such as a header
+ * whose counts were not known at the start.  Bytes
+ * still in the buffer are changed there; older ones
+ * are written again in place, a whole aligned block
+ * at a time when direct.
+ *   INPUT  : where, and the new bytes, all of which
+ *            must be before size()
+ **********************************************/
+inline void AsyncWriter :: rewrite(uint64_t offset, const void * p, size_t num)
+{
+   const char * pFrom = (const char *)p;
+   if (offset + num > fillOffset)
+   {
+      uint64_t start = std::max(offset, fillOffset);
+      memcpy(buffers[iFill] + (start - fillOffset), pFrom + (start - offset), offset + num - start);
+      num = start - offset;
+   }
+   if (num == 0)
+      return;
+
+   // the rest is on disk, or about to be
+   waitIdle();
+   if (!direct)
+   {
+      int result = writeAll(fd, pFrom, num, offset);
+      if (result)
+         throw std::system_error(result, std::generic_category(), "writer: pwrite");
+      return;
+   }
+
+   uint64_t first = offset / ALIGNMENT * ALIGNMENT;
+   uint64_t last = (offset + num + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+   char * pBlock = (char *)std::aligned_alloc(ALIGNMENT, last - first);
+   if (pBlock == nullptr)
+      throw std::bad_alloc();
+   int result = 0;
+   ssize_t numRead = ::pread(fd, pBlock, last - first, (off_t)first);
+   if (numRead != (ssize_t)(last - first))
+      result = numRead < 0 ? errno : EIO;
+   else
+   {
+      memcpy(pBlock + (offset - first), pFrom, num);
+      result = writeAll(fd, pBlock, last - first, first);
+   }
+   std::free(pBlock);
+   if (result)
+      throw std::system_error(result, std::generic_category(), "writer: rewrite");
+}
+
+/***********************************************
+ * ASYNC WRITER :: STOP THREAD
+ **********************************************/
+inline void AsyncWriter :: stopThread()
+{
+   {
+      std::lock_guard <std::mutex> lock(mutex);
+      stop = true;
+   }
+   wake.notify_all();
+   if (thread.joinable())
+      thread.join();
+}
+
+/***********************************************
+ * ASYNC WRITER :: FINISH
+ * Write what is left, wait for it to reach the disk,
+ * and close the file.  When direct, the last buffer
+ * goes out padded to a whole block and the file is
+ * cut back to size.
+ *   OUTPUT : how many bytes the file holds
+ **********************************************/
+inline uint64_t AsyncWriter :: finish()
+{
+   if (fd < 0)
+      return size();
+
+   uint64_t total = size();
+   int result = 0;
+   try
+   {
+      if (numFill)
+      {
+         size_t num = numFill;
+         if (direct)
+         {
+            num = (numFill + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+            memset(buffers[iFill] + numFill, 0, num - numFill);
+         }
+         handOff(num);
+      }
+      waitIdle();
+   }
+   catch (const std::system_error & e)
+   {
+      result = e.code().value();
+   }
+   stopThread();
+
+   if (!result && direct && ::ftruncate(fd, (off_t)total) != 0)
+      result = errno;
+   if (!result && ::fsync(fd) != 0)
+      result = errno;
+   ::close(fd);
+   fd = -1;
+   if (result)
+      throw std::system_error(result, std::generic_category(), "writer: finish");
+   return total;
+}
+
+/***********************************************
+ * WRITE LIST
+ * Append the list as one frame, the same bytes
+ * serialize() makes, so deserialize() reads it back.
+ * The header is written first as a placeholder and
+ * rewritten once the counts are known.
+ *   INPUT  : pointer to the head of the linked list,
+ *            and the writer
+ *   COST   : O(n)
+ **********************************************/
+template <class T>
+void writeList(const Node <T> * pHead, AsyncWriter & out)
+{
+   static_assert(HasSerializer <T> || std::is_trivially_copyable <T>::value,
+                 "T needs a Serializer <T>");
+
+   uint64_t start = out.size();
+   SerialHeader header = { SerialHeader::MAGIC, 0, 0, 0, 0 };
+   out.put(header);
+
+   if constexpr (isRawSerial <T>)
+   {
+      header.size = sizeof(T);
+      for (const Node <T> * p = pHead; p; p = p->pNext)
+      {
+         out.write(&p->data, sizeof(T));
+         header.num++;
+      }
+   }
+   else
+   {
+      std::vector <char> buffer;
+      ByteWriter bytes(buffer);
+      for (const Node <T> * p = pHead; p; p = p->pNext)
+      {
+         buffer.clear();
+         Serializer <T>::write(bytes, p->data);
+         out.write(buffer.data(), buffer.size());
+         header.num++;
+      }
+   }
+
+   header.numBytes = out.size() - start - sizeof(SerialHeader);
+   out.rewrite(start, &header, sizeof(SerialHeader));
+}
+
+/***********************************************
+ * SYNC DIRECTORY
+ * fsync() the directory that holds a file, so that
+ * creating, renaming, or removing it survives a
+ * crash; syncing the file alone does not cover its
+ * name
+ *   INPUT  : the file
+ **********************************************/
+inline void syncDirectory(const std::string & path)
+{
+   std::string directory = std::filesystem::path(path).parent_path().string();
+   if (directory.empty())
+      directory = ".";
+
+   int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+   if (fd < 0)
+      throw std::system_error(errno, std::generic_category(), "writer: open " + directory);
+   if (::fsync(fd) != 0)
+   {
+      int error = errno;
+      ::close(fd);
+      throw std::system_error(error, std::generic_category(), "writer: fsync " + directory);
+   }
+   ::close(fd);
+}
+
+/***********************************************
+ * CHECKPOINT ASYNC
+ * Write a snapshot of the list to a file on another
+ * thread.  The snapshot is a handle of its own, so
+ * the caller may change the list the moment this
+ * returns.  The frame goes to path + ".tmp", which
+ * replaces path once it is all on disk.  The rename
+ * is synced too, so when the future is ready the new
+ * checkpoint survives a crash.  The snapshot is let
+ * go before then, not when the last future goes, so
+ * the owner's next change is not a copy for nothing.
+ *   INPUT  : the list, the file, the buffer size,
+ *            and whether to bypass the page cache
+ *   OUTPUT : a future holding the size of the file,
+ *            or the error that stopped it
+ *   COST   : O(1) here, O(n) on the other thread
+ **********************************************/
+template <class T>
+std::future <uint64_t> checkpointAsync(SharedList <T> snapshot, const std::string & path,
+                                       size_t bufferSize = 1 << 20, bool direct = false)
+{
+   return std::async(std::launch::async, [snapshot = std::move(snapshot), path, bufferSize, direct]() mutable
+   {
+      // the task itself lives as long as the future, so hold the list here
+      SharedList <T> mine(std::move(snapshot));
+      std::string pathTemp = path + ".tmp";
+      uint64_t size;
+      try
+      {
+         AsyncWriter out(pathTemp, bufferSize, direct);
+         writeList(mine.head(), out);
+         size = out.finish();
+      }
+      catch (...)
+      {
+         std::remove(pathTemp.c_str());
+         throw;
+      }
+      if (std::rename(pathTemp.c_str(), path.c_str()) != 0)
+         throw std::system_error(errno, std::generic_category(), "writer: rename " + pathTemp);
+      syncDirectory(path);
+      return size;
+   });
+}
+
+#endif // _WIN32